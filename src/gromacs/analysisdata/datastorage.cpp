@@ -55,6 +55,7 @@
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/mutex.h"
 
 namespace gmx
 {
@@ -270,6 +271,15 @@ class AnalysisDataStorageImpl
          * frame (see \a frames_).
          */
         int                     nextIndex_;
+        /*! \brief
+         * Protects the frame bookkeeping for concurrent frames.
+         *
+         * Held in the public AnalysisDataStorage methods that start and
+         * finish frames, so that frames can be built in different threads
+         * with startParallelDataStorage().  Values within a frame are set
+         * without locking, as each frame is built by a single thread.
+         */
+        Mutex                   mutex_;
 };
 
 /********************************************************************
@@ -865,6 +875,7 @@ AnalysisDataStorageFrame &
 AnalysisDataStorage::startFrame(const AnalysisDataFrameHeader &header)
 {
     GMX_ASSERT(header.isValid(), "Invalid header");
+    lock_guard<Mutex>                       lock(impl_->mutex_);
     internal::AnalysisDataStorageFrameData *storedFrame;
     if (impl_->storeAll())
     {
@@ -908,6 +919,7 @@ AnalysisDataStorage::startFrame(int index, real x, real dx)
 AnalysisDataStorageFrame &
 AnalysisDataStorage::currentFrame(int index)
 {
+    lock_guard<Mutex> lock(impl_->mutex_);
     const int storageIndex = impl_->computeStorageLocation(index);
     GMX_RELEASE_ASSERT(storageIndex >= 0, "Out of bounds frame index");
 
@@ -925,6 +937,7 @@ AnalysisDataStorage::currentFrame(int index)
 void
 AnalysisDataStorage::finishFrame(int index)
 {
+    lock_guard<Mutex> lock(impl_->mutex_);
     impl_->finishFrame(index);
 }
 
@@ -933,6 +946,7 @@ AnalysisDataStorage::finishFrameSerial(int index)
 {
     if (impl_->pendingLimit_ > 1)
     {
+        lock_guard<Mutex> lock(impl_->mutex_);
         impl_->finishFrameSerial(index);
     }
 }
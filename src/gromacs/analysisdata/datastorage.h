@@ -257,8 +257,11 @@ class AnalysisDataStorageFrame
  * AnalysisDataStorageFrame::finishPointSet()) take the responsibility of
  * calling all the notification methods in AnalysisDataModuleManager,
  *
- * \todo
- * Proper multi-threaded implementation.
+ * With startParallelDataStorage(), startFrame(), currentFrame(),
+ * finishFrame() and finishFrameSerial() can be called concurrently from
+ * different threads for different frames.  Modules that handle data in
+ * parallel are then also notified concurrently for different frames.
+ * Each frame should only be built from a single thread.
  *
  * \inlibraryapi
  * \ingroup module_analysisdata
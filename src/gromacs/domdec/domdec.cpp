@@ -1300,8 +1300,8 @@ void dd_collect_vec(gmx_domdec_t           *dd,
 }
 
 
-void dd_collect_state(gmx_domdec_t *dd,
-                      const t_state *state_local, t_state *state)
+void dd_collect_state_globals(gmx_domdec_t *dd,
+                              const t_state *state_local, t_state *state)
 {
     int nh = state_local->nhchainlength;
 
@@ -1341,6 +1341,13 @@ void dd_collect_state(gmx_domdec_t *dd,
         }
         state->baros_integral = state_local->baros_integral;
     }
+}
+
+void dd_collect_state(gmx_domdec_t *dd,
+                      const t_state *state_local, t_state *state)
+{
+    dd_collect_state_globals(dd, state_local, state);
+
     if (state_local->flags & (1 << estX))
     {
         dd_collect_vec(dd, state_local, &state_local->x, &state->x);
@@ -5627,6 +5634,17 @@ static void make_pp_communicator(FILE                 *fplog,
 
     comm = dd->comm;
 
+    if (cr->nnodes == 1)
+    {
+        /* A single domain, no communicators are needed */
+        dd->mpi_comm_all = cr->mpi_comm_mygroup;
+        dd->rank         = 0;
+        dd->masterrank   = 0;
+        clear_ivec(dd->ci);
+        clear_ivec(dd->master_ci);
+        return;
+    }
+
     if (comm->bCartesianPP)
     {
         /* Set up cartesian communication for the particle-particle part */
@@ -6222,6 +6240,17 @@ static int determineInitialDlbState(FILE *fplog, t_commrec *cr,
         default: gmx_incons("Invalid dlbOption enum value");
     }
 
+    /* With a single domain there is no load to balance */
+    if (cr->nnodes == 1)
+    {
+        std::string reasonStr = "there is only a single domain.";
+        if (dlbState == edlbsOnUser)
+        {
+            return forceDlbOffOrBail(dlbState, reasonStr, cr, fplog);
+        }
+        return edlbsOffForever;
+    }
+
     /* Reruns don't support DLB: bail or override auto mode */
     if (mdrunOptions.rerun)
     {
@@ -6461,8 +6490,11 @@ static void set_dd_limits_and_grid(FILE *fplog, t_commrec *cr, gmx_domdec_t *dd,
                                       options.checkBondedInteractions,
                                       &r_2b, &r_mb);
             }
-            gmx_bcast(sizeof(r_2b), &r_2b, cr);
-            gmx_bcast(sizeof(r_mb), &r_mb, cr);
+            if (PAR(cr))
+            {
+                gmx_bcast(sizeof(r_2b), &r_2b, cr);
+                gmx_bcast(sizeof(r_mb), &r_mb, cr);
+            }
 
             /* We use an initial margin of 10% for the minimum cell size,
              * except when we are just below the non-bonded cut-off.
@@ -7354,7 +7386,10 @@ static gmx_bool test_dd_cutoff(t_commrec *cr,
             LocallyLimited = 1;
         }
 
-        gmx_sumi(1, &LocallyLimited, cr);
+        if (PAR(cr))
+        {
+            gmx_sumi(1, &LocallyLimited, cr);
+        }
 
         if (LocallyLimited > 0)
         {
@@ -9122,7 +9157,10 @@ void print_dd_statistics(t_commrec *cr, const t_inputrec *ir, FILE *fplog)
 
     comm = cr->dd->comm;
 
-    gmx_sumd(ddnatNR-ddnatZONE, comm->sum_nat, cr);
+    if (PAR(cr))
+    {
+        gmx_sumd(ddnatNR-ddnatZONE, comm->sum_nat, cr);
+    }
 
     if (fplog == nullptr)
     {
@@ -261,6 +261,14 @@ void dd_collect_vec(struct gmx_domdec_t    *dd,
                     const PaddedRVecVector *lv,
                     PaddedRVecVector       *v);
 
+/*! \brief Copies the entries of \p state_local that are not per atom to \p state on the master rank
+ *
+ * This does not communicate. It is used when the atom data is not
+ * collected, such as for checkpoints written as per-rank sections.
+ */
+void dd_collect_state_globals(struct gmx_domdec_t *dd,
+                              const t_state *state_local, t_state *state);
+
 /*! \brief Collects the local state \p state_local to \p state on the master rank */
 void dd_collect_state(struct gmx_domdec_t *dd,
                       const t_state *state_local, t_state *state);
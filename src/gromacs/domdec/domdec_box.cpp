@@ -102,7 +102,7 @@ static void calc_cgcm_av_stddev(const t_block *cgs, int n, const rvec *x,
         }
     }
 
-    if (cr_sum != nullptr)
+    if (cr_sum != nullptr && PAR(cr_sum))
     {
         for (d = 0; d < DIM; d++)
         {
@@ -312,5 +312,8 @@ void set_ddbox_cr(t_commrec *cr, const ivec *dd_nc,
         low_set_ddbox(ir, dd_nc, box, TRUE, cgs->nr, cgs, x, nullptr, ddbox);
     }
 
-    gmx_bcast(sizeof(gmx_ddbox_t), ddbox, cr);
+    if (PAR(cr))
+    {
+        gmx_bcast(sizeof(gmx_ddbox_t), ddbox, cr);
+    }
 }
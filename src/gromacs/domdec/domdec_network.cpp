@@ -273,11 +273,22 @@ void dd_scatter(gmx_domdec_t gmx_unused *dd, int gmx_unused nbytes, const void g
 void dd_gather(gmx_domdec_t gmx_unused *dd, int gmx_unused nbytes, const void gmx_unused *src, void gmx_unused *dest)
 {
 #if GMX_MPI
-    /* Some MPI implementions don't specify const */
-    MPI_Gather(const_cast<void *>(src), nbytes, MPI_BYTE,
-               dest, nbytes, MPI_BYTE,
-               DDMASTERRANK(dd), dd->mpi_comm_all);
+    if (dd->nnodes > 1)
+    {
+        /* Some MPI implementions don't specify const */
+        MPI_Gather(const_cast<void *>(src), nbytes, MPI_BYTE,
+                   dest, nbytes, MPI_BYTE,
+                   DDMASTERRANK(dd), dd->mpi_comm_all);
+    }
+    else
 #endif
+    {
+        /* 1 rank, either we copy everything, or dest=src: nothing to do */
+        if (dest != src)
+        {
+            memcpy(dest, src, nbytes);
+        }
+    }
 }
 
 void dd_scatterv(gmx_domdec_t gmx_unused *dd,
@@ -317,14 +328,25 @@ void dd_gatherv(gmx_domdec_t gmx_unused *dd,
 #if GMX_MPI
     int dum;
 
-    if (scount == 0)
+    if (dd->nnodes > 1)
     {
-        /* MPI does not allow NULL pointers */
-        sbuf = &dum;
+        if (scount == 0)
+        {
+            /* MPI does not allow NULL pointers */
+            sbuf = &dum;
+        }
+        /* Some MPI implementions don't specify const */
+        MPI_Gatherv(const_cast<void *>(sbuf), scount, MPI_BYTE,
+                    rbuf, rcounts, disps, MPI_BYTE,
+                    DDMASTERRANK(dd), dd->mpi_comm_all);
     }
-    /* Some MPI implementions don't specify const */
-    MPI_Gatherv(const_cast<void *>(sbuf), scount, MPI_BYTE,
-                rbuf, rcounts, disps, MPI_BYTE,
-                DDMASTERRANK(dd), dd->mpi_comm_all);
+    else
 #endif
+    {
+        /* 1 rank, either we copy everything, or rbuf=sbuf: nothing to do */
+        if (rbuf != sbuf)
+        {
+            memcpy(rbuf, sbuf, scount);
+        }
+    }
 }
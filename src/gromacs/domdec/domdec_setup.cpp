@@ -828,10 +828,16 @@ real dd_choose_grid(FILE *fplog,
         limit = 0;
     }
     /* Communicate the information set by the master to all nodes */
-    gmx_bcast(sizeof(dd->nc), dd->nc, cr);
+    if (PAR(cr))
+    {
+        gmx_bcast(sizeof(dd->nc), dd->nc, cr);
+    }
     if (EEL_PME(ir->coulombtype))
     {
-        gmx_bcast(sizeof(cr->npmenodes), &cr->npmenodes, cr);
+        if (PAR(cr))
+        {
+            gmx_bcast(sizeof(cr->npmenodes), &cr->npmenodes, cr);
+        }
     }
     else
     {
@@ -245,7 +245,10 @@ static void print_missing_interactions_mb(FILE *fplog, t_commrec *cr,
         }
     }
 
-    gmx_sumi(nmol*nril_mol, assigned, cr);
+    if (PAR(cr))
+    {
+        gmx_sumi(nmol*nril_mol, assigned, cr);
+    }
 
     int nprint = 10;
     int i      = 0;
@@ -362,7 +365,10 @@ void dd_print_missing_interactions(FILE *fplog, t_commrec *cr,
         cl[ftype] = top_local->idef.il[ftype].nr/(1+nral);
     }
 
-    gmx_sumi(F_NRE, cl, cr);
+    if (PAR(cr))
+    {
+        gmx_sumi(F_NRE, cl, cr);
+    }
 
     if (DDMASTER(dd))
     {
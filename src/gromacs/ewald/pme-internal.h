@@ -253,6 +253,7 @@ struct gmx_pme_t {
     int        nkx, nky, nkz; /* Grid dimensions */
     gmx_bool   bP3M;          /* Do P3M: optimize the influence function */
     int        pme_order;
+    gmx_bool   bMixedPrecision; /* Solve in single precision, only used with GMX_DOUBLE */
     real       ewaldcoeff_q;  /* Ewald splitting coefficient for Coulomb */
     real       ewaldcoeff_lj; /* Ewald splitting coefficient for r^-6 */
     real       epsilon_r;
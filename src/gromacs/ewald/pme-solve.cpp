@@ -74,6 +74,13 @@ struct pme_solve_work_t
     real *   tmp2;
     real *   eterm;
     real *   m2inv;
+#if GMX_DOUBLE
+    /* Single precision work arrays for the mixed-precision solve */
+    float *  denomF;
+    float *  tmp1F;
+    float *  tmp2F;
+    float *  etermF;
+#endif
 
     real     energy_q;
     matrix   vir_q;
@@ -88,6 +95,14 @@ constexpr int c_simdWidth = GMX_SIMD_REAL_WIDTH;
 constexpr int c_simdWidth = 4;
 #endif
 
+#if GMX_DOUBLE
+#if GMX_SIMD_HAVE_FLOAT
+constexpr int c_simdWidthFloat = GMX_SIMD_FLOAT_WIDTH;
+#else
+constexpr int c_simdWidthFloat = 4;
+#endif
+#endif
+
 /* Returns the smallest number >= \p that is a multiple of \p factor, \p factor must be a power of 2 */
 template <unsigned int factor>
 static size_t roundUpToMultipleOfFactor(size_t number)
@@ -110,6 +125,15 @@ static void reallocSimdAlignedAndPadded(real **ptr, int unpaddedNumElements)
     snew_aligned(*ptr, roundUpToMultipleOfFactor<c_simdWidth>(unpaddedNumElements), c_simdWidth*sizeof(real));
 }
 
+#if GMX_DOUBLE
+/* As reallocSimdAlignedAndPadded, but for single precision SIMD */
+static void reallocSimdAlignedAndPaddedFloat(float **ptr, int unpaddedNumElements)
+{
+    sfree_aligned(*ptr);
+    snew_aligned(*ptr, roundUpToMultipleOfFactor<c_simdWidthFloat>(unpaddedNumElements), c_simdWidthFloat*sizeof(float));
+}
+#endif
+
 static void realloc_work(struct pme_solve_work_t *work, int nkx)
 {
     if (nkx > work->nalloc)
@@ -132,6 +156,17 @@ static void realloc_work(struct pme_solve_work_t *work, int nkx)
         {
             work->denom[i] = 1;
         }
+
+#if GMX_DOUBLE
+        reallocSimdAlignedAndPaddedFloat(&work->denomF, work->nalloc);
+        reallocSimdAlignedAndPaddedFloat(&work->tmp1F, work->nalloc);
+        reallocSimdAlignedAndPaddedFloat(&work->tmp2F, work->nalloc);
+        reallocSimdAlignedAndPaddedFloat(&work->etermF, work->nalloc);
+        for (size_t i = 0; i < roundUpToMultipleOfFactor<c_simdWidthFloat>(work->nalloc); i++)
+        {
+            work->denomF[i] = 1;
+        }
+#endif
     }
 }
 
@@ -166,6 +201,12 @@ static void free_work(struct pme_solve_work_t *work)
         sfree_aligned(work->tmp2);
         sfree_aligned(work->eterm);
         sfree(work->m2inv);
+#if GMX_DOUBLE
+        sfree_aligned(work->denomF);
+        sfree_aligned(work->tmp1F);
+        sfree_aligned(work->tmp2F);
+        sfree_aligned(work->etermF);
+#endif
     }
 }
 
@@ -313,6 +354,103 @@ gmx_inline static void calc_exponentials_lj(int start, int end, ArrayRef<real> r
 }
 #endif
 
+#if GMX_DOUBLE
+/* Calculate the exponentials for the Coulomb solve in single precision.
+ * The input is converted to float and the result back to double,
+ * so only the influence function has single precision accuracy.
+ */
+static void calc_exponentials_q_mixed(int start, int end, real f,
+                                      pme_solve_work_t *work,
+                                      const real *d, const real *r, real *e)
+{
+    float *dF = work->denomF;
+    float *rF = work->tmp1F;
+    float *eF = work->etermF;
+    int    kx;
+
+    for (kx = start; kx < end; kx++)
+    {
+        dF[kx] = d[kx];
+        rF[kx] = r[kx];
+    }
+#if GMX_SIMD_HAVE_FLOAT
+    /* Clear padding elements to avoid (harmless) fp exceptions */
+    for (; kx < static_cast<int>(roundUpToMultipleOfFactor<c_simdWidthFloat>(end)); kx++)
+    {
+        rF[kx] = 0;
+        dF[kx] = 1;
+    }
+    /* As in the double SIMD version, we start at 0 for aligned access */
+    const SimdFloat fSimd(f);
+    for (kx = 0; kx < end; kx += GMX_SIMD_FLOAT_WIDTH)
+    {
+        SimdFloat tmpR = gmx::exp(load<SimdFloat>(rF + kx));
+        store(eF + kx, fSimd / load<SimdFloat>(dF + kx) * tmpR);
+    }
+#else
+    for (kx = start; kx < end; kx++)
+    {
+        eF[kx] = f*std::exp(rF[kx])/dF[kx];
+    }
+#endif
+    for (kx = start; kx < end; kx++)
+    {
+        e[kx] = eF[kx];
+    }
+}
+
+/* Calculate the exponentials for the LJ solve in single precision,
+ * in place, as calc_exponentials_lj does.
+ */
+static void calc_exponentials_lj_mixed(int start, int end,
+                                       pme_solve_work_t *work,
+                                       real *r, real *factor, real *d)
+{
+    float *rF   = work->tmp1F;
+    float *facF = work->tmp2F;
+    float *dF   = work->denomF;
+    int    kx;
+
+    for (kx = start; kx < end; kx++)
+    {
+        rF[kx]   = r[kx];
+        facF[kx] = factor[kx];
+        dF[kx]   = d[kx];
+    }
+#if GMX_SIMD_HAVE_FLOAT
+    /* Clear padding elements to avoid (harmless) fp exceptions */
+    for (; kx < static_cast<int>(roundUpToMultipleOfFactor<c_simdWidthFloat>(end)); kx++)
+    {
+        rF[kx]   = 0;
+        facF[kx] = 0;
+        dF[kx]   = 1;
+    }
+    const SimdFloat sqrtPi = sqrt(SimdFloat(M_PI));
+    for (kx = 0; kx < end; kx += GMX_SIMD_FLOAT_WIDTH)
+    {
+        SimdFloat mk = load<SimdFloat>(facF + kx);
+        store(dF + kx, SimdFloat(1.0f) / load<SimdFloat>(dF + kx));
+        store(rF + kx, gmx::exp(load<SimdFloat>(rF + kx)));
+        store(facF + kx, sqrtPi * mk * erfc(mk));
+    }
+#else
+    for (kx = start; kx < end; kx++)
+    {
+        float mk = facF[kx];
+        dF[kx]   = 1.0f/dF[kx];
+        rF[kx]   = std::exp(rF[kx]);
+        facF[kx] = std::sqrt(static_cast<float>(M_PI))*mk*std::erfc(mk);
+    }
+#endif
+    for (kx = start; kx < end; kx++)
+    {
+        r[kx]      = rF[kx];
+        factor[kx] = facF[kx];
+        d[kx]      = dF[kx];
+    }
+}
+#endif
+
 #if defined PME_SIMD_SOLVE
 using PME_T = SimdReal;
 #else
@@ -472,10 +610,19 @@ int solve_pme_yzx(const gmx_pme_t *pme, t_complex *grid, real vol,
                 m2inv[kx] = 1.0/m2[kx];
             }
 
-            calc_exponentials_q(kxstart, kxend, elfac,
-                                ArrayRef<PME_T>(denom, denom+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
-                                ArrayRef<PME_T>(tmp1, tmp1+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
-                                ArrayRef<PME_T>(eterm, eterm+roundUpToMultipleOfFactor<c_simdWidth>(kxend)));
+#if GMX_DOUBLE
+            if (pme->bMixedPrecision)
+            {
+                calc_exponentials_q_mixed(kxstart, kxend, elfac, work, denom, tmp1, eterm);
+            }
+            else
+#endif
+            {
+                calc_exponentials_q(kxstart, kxend, elfac,
+                                    ArrayRef<PME_T>(denom, denom+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
+                                    ArrayRef<PME_T>(tmp1, tmp1+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
+                                    ArrayRef<PME_T>(eterm, eterm+roundUpToMultipleOfFactor<c_simdWidth>(kxend)));
+            }
 
             for (kx = kxstart; kx < kxend; kx++, p0++)
             {
@@ -537,10 +684,19 @@ int solve_pme_yzx(const gmx_pme_t *pme, t_complex *grid, real vol,
                 tmp1[kx]  = -factor*m2k;
             }
 
-            calc_exponentials_q(kxstart, kxend, elfac,
-                                ArrayRef<PME_T>(denom, denom+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
-                                ArrayRef<PME_T>(tmp1, tmp1+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
-                                ArrayRef<PME_T>(eterm, eterm+roundUpToMultipleOfFactor<c_simdWidth>(kxend)));
+#if GMX_DOUBLE
+            if (pme->bMixedPrecision)
+            {
+                calc_exponentials_q_mixed(kxstart, kxend, elfac, work, denom, tmp1, eterm);
+            }
+            else
+#endif
+            {
+                calc_exponentials_q(kxstart, kxend, elfac,
+                                    ArrayRef<PME_T>(denom, denom+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
+                                    ArrayRef<PME_T>(tmp1, tmp1+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
+                                    ArrayRef<PME_T>(eterm, eterm+roundUpToMultipleOfFactor<c_simdWidth>(kxend)));
+            }
 
 
             for (kx = kxstart; kx < kxend; kx++, p0++)
@@ -715,10 +871,19 @@ int solve_pme_lj_yzx(const gmx_pme_t *pme, t_complex **grid, gmx_bool bLB, real
                 tmp2[kx] = 0;
             }
 
-            calc_exponentials_lj(kxstart, kxend,
-                                 ArrayRef<PME_T>(tmp1, tmp1+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
-                                 ArrayRef<PME_T>(tmp2, tmp2+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
-                                 ArrayRef<PME_T>(denom, denom+roundUpToMultipleOfFactor<c_simdWidth>(kxend)));
+#if GMX_DOUBLE
+            if (pme->bMixedPrecision)
+            {
+                calc_exponentials_lj_mixed(kxstart, kxend, work, tmp1, tmp2, denom);
+            }
+            else
+#endif
+            {
+                calc_exponentials_lj(kxstart, kxend,
+                                     ArrayRef<PME_T>(tmp1, tmp1+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
+                                     ArrayRef<PME_T>(tmp2, tmp2+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
+                                     ArrayRef<PME_T>(denom, denom+roundUpToMultipleOfFactor<c_simdWidth>(kxend)));
+            }
 
             for (kx = kxstart; kx < kxend; kx++)
             {
@@ -858,10 +1023,19 @@ int solve_pme_lj_yzx(const gmx_pme_t *pme, t_complex **grid, gmx_bool bLB, real
                 tmp2[kx] = 0;
             }
 
-            calc_exponentials_lj(kxstart, kxend,
-                                 ArrayRef<PME_T>(tmp1, tmp1+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
-                                 ArrayRef<PME_T>(tmp2, tmp2+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
-                                 ArrayRef<PME_T>(denom, denom+roundUpToMultipleOfFactor<c_simdWidth>(kxend)));
+#if GMX_DOUBLE
+            if (pme->bMixedPrecision)
+            {
+                calc_exponentials_lj_mixed(kxstart, kxend, work, tmp1, tmp2, denom);
+            }
+            else
+#endif
+            {
+                calc_exponentials_lj(kxstart, kxend,
+                                     ArrayRef<PME_T>(tmp1, tmp1+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
+                                     ArrayRef<PME_T>(tmp2, tmp2+roundUpToMultipleOfFactor<c_simdWidth>(kxend)),
+                                     ArrayRef<PME_T>(denom, denom+roundUpToMultipleOfFactor<c_simdWidth>(kxend)));
+            }
 
             for (kx = kxstart; kx < kxend; kx++)
             {
@@ -59,6 +59,12 @@
 
 /* TODO consider split of pme-spline from this file */
 
+/*! \brief The number of atoms for which we compute splines before spreading
+ *
+ * With this block size the spline data for order 5 fits in L1 cache.
+ */
+static const int c_pmeSpreadSplineBlockSize = 64;
+
 static void calc_interpolation_idx(const gmx_pme_t *pme, const pme_atomcomm_t *atc,
                                    int start, int grid_index, int end, int thread)
 {
@@ -262,15 +268,118 @@ static void make_thread_local_ind(const pme_atomcomm_t *atc,
         }                                          \
     }
 
+#if GMX_SIMD_HAVE_REAL
+/* Computes the splines for local atoms start to end, SIMD version.
+ *
+ * This performs the same operations as CALC_SPLINE, but for
+ * GMX_SIMD_REAL_WIDTH atoms at once, with the order known at compile time
+ * so all loops are unrolled and the data stays in registers.
+ * We compute splines for all atoms, also for those with zero coefficients,
+ * since that is cheaper than masking.
+ */
+template <int order>
+static void make_bsplines_simd(splinevec theta, splinevec dtheta,
+                               rvec fractx[], int start, int end, const int ind[])
+{
+    using namespace gmx;
+
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) dr_aligned[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) theta_aligned[order*GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) dtheta_aligned[order*GMX_SIMD_REAL_WIDTH];
+
+    const SimdReal one_S(1.0);
+
+    for (int i0 = start; i0 < end; i0 += GMX_SIMD_REAL_WIDTH)
+    {
+        const int nlane = std::min(GMX_SIMD_REAL_WIDTH, end - i0);
+
+        for (int j = 0; j < DIM; j++)
+        {
+            for (int l = 0; l < GMX_SIMD_REAL_WIDTH; l++)
+            {
+                dr_aligned[l] = (l < nlane ? fractx[ind[i0 + l]][j] : 0);
+            }
+            /* dr is relative offset from lower cell limit */
+            SimdReal dr_S = load<SimdReal>(dr_aligned);
+            SimdReal data_S[order];
+
+            data_S[order - 1] = setZero();
+            data_S[1]         = dr_S;
+            data_S[0]         = one_S - dr_S;
+
+            for (int k = 3; k < order; k++)
+            {
+                const SimdReal div_S(static_cast<real>(1.0/(k - 1.0)));
+
+                data_S[k - 1] = div_S*dr_S*data_S[k - 2];
+                for (int l = 1; l < k - 1; l++)
+                {
+                    data_S[k - l - 1] = div_S*((dr_S + SimdReal(l))*data_S[k - l - 2] +
+                                               (SimdReal(k - l) - dr_S)*data_S[k - l - 1]);
+                }
+                data_S[0] = div_S*(one_S - dr_S)*data_S[0];
+            }
+            /* differentiate */
+            store(dtheta_aligned, -data_S[0]);
+            for (int k = 1; k < order; k++)
+            {
+                store(dtheta_aligned + k*GMX_SIMD_REAL_WIDTH, data_S[k - 1] - data_S[k]);
+            }
+
+            const SimdReal div_S(static_cast<real>(1.0/(order - 1)));
+
+            data_S[order - 1] = div_S*dr_S*data_S[order - 2];
+            for (int l = 1; l < order - 1; l++)
+            {
+                data_S[order - l - 1] = div_S*((dr_S + SimdReal(l))*data_S[order - l - 2] +
+                                               (SimdReal(order - l) - dr_S)*data_S[order - l - 1]);
+            }
+            data_S[0] = div_S*(one_S - dr_S)*data_S[0];
+
+            for (int k = 0; k < order; k++)
+            {
+                store(theta_aligned + k*GMX_SIMD_REAL_WIDTH, data_S[k]);
+            }
+
+            /* Transpose to the atom-major spline layout */
+            for (int l = 0; l < nlane; l++)
+            {
+                for (int k = 0; k < order; k++)
+                {
+                    theta[j][(i0 + l)*order + k]  = theta_aligned[k*GMX_SIMD_REAL_WIDTH + l];
+                    dtheta[j][(i0 + l)*order + k] = dtheta_aligned[k*GMX_SIMD_REAL_WIDTH + l];
+                }
+            }
+        }
+    }
+}
+#endif
+
+/* Computes the splines for local atoms start to end */
 static void make_bsplines(splinevec theta, splinevec dtheta, int order,
-                          rvec fractx[], int nr, int ind[], real coefficient[],
+                          rvec fractx[], int start, int end, int ind[], real coefficient[],
                           gmx_bool bDoSplines)
 {
+#if GMX_SIMD_HAVE_REAL
+    /* Use SIMD for the common orders */
+    switch (order)
+    {
+        case 4:
+            make_bsplines_simd<4>(theta, dtheta, fractx, start, end, ind);
+            return;
+        case 5:
+            make_bsplines_simd<5>(theta, dtheta, fractx, start, end, ind);
+            return;
+        default:
+            break;
+    }
+#endif
+
     /* construct splines for local atoms */
     int   i, ii;
     real *xptr;
 
-    for (i = 0; i < nr; i++)
+    for (i = start; i < end; i++)
     {
         /* With free energy we do not use the coefficient check.
          * In most cases this will be more efficient than calling make_bsplines
@@ -312,27 +421,41 @@ static void make_bsplines(splinevec theta, splinevec dtheta, int order,
     }
 
 
+/* Clears the (thread-local) grid before spreading */
+static void clear_pmegrid_thread(const pmegrid_t *pmegrid)
+{
+    int   ndatatot = pmegrid->s[XX]*pmegrid->s[YY]*pmegrid->s[ZZ];
+    real *grid     = pmegrid->grid;
+
+    for (int i = 0; i < ndatatot; i++)
+    {
+        grid[i] = 0;
+    }
+}
+
+/* Spreads the coefficients of local atoms start to end, the grid should be cleared */
 static void spread_coefficients_bsplines_thread(const pmegrid_t                   *pmegrid,
                                                 const pme_atomcomm_t              *atc,
                                                 splinedata_t                      *spline,
+                                                int                                start,
+                                                int                                end,
                                                 struct pme_spline_work gmx_unused *work)
 {
 
     /* spread coefficients from home atoms to local grid */
     real          *grid;
-    int            i, nn, n, ithx, ithy, ithz, i0, j0, k0;
+    int            nn, n, ithx, ithy, ithz, i0, j0, k0;
     int       *    idxptr;
     int            order, norder, index_x, index_xy, index_xyz;
     real           valx, valxy, coefficient;
     real          *thx, *thy, *thz;
-    int            pnx, pny, pnz, ndatatot;
+    int            pny, pnz;
     int            offx, offy, offz;
 
 #if defined PME_SIMD4_SPREAD_GATHER && !defined PME_SIMD4_UNALIGNED
     GMX_ALIGNED(real, GMX_SIMD4_WIDTH)  thz_aligned[GMX_SIMD4_WIDTH*2];
 #endif
 
-    pnx = pmegrid->s[XX];
     pny = pmegrid->s[YY];
     pnz = pmegrid->s[ZZ];
 
@@ -340,16 +463,11 @@ static void spread_coefficients_bsplines_thread(const pmegrid_t
     offy = pmegrid->offset[YY];
     offz = pmegrid->offset[ZZ];
 
-    ndatatot = pnx*pny*pnz;
     grid     = pmegrid->grid;
-    for (i = 0; i < ndatatot; i++)
-    {
-        grid[i] = 0;
-    }
 
     order = pmegrid->order;
 
-    for (nn = 0; nn < spline->n; nn++)
+    for (nn = start; nn < end; nn++)
     {
         n           = spline->ind[nn];
         coefficient = atc->coefficient[n];
@@ -934,10 +1052,10 @@ void spread_on_grid(const gmx_pme_t *pme,
                 }
             }
 
-            if (bCalcSplines)
+            if (bCalcSplines && !bSpread)
             {
                 make_bsplines(spline->theta, spline->dtheta, pme->pme_order,
-                              atc->fractx, spline->n, spline->ind, atc->coefficient, bDoSplines);
+                              atc->fractx, 0, spline->n, spline->ind, atc->coefficient, bDoSplines);
             }
 
             if (bSpread)
@@ -948,7 +1066,26 @@ void spread_on_grid(const gmx_pme_t *pme,
 #ifdef PME_TIME_SPREAD
                 ct1a = omp_cyc_start();
 #endif
-                spread_coefficients_bsplines_thread(grid, atc, spline, pme->spline_work);
+                clear_pmegrid_thread(grid);
+
+                /* When computing splines, we do this in blocks of atoms
+                 * and spread each block directly after, so the spline
+                 * data is still in cache.
+                 */
+                int blockSize = (bCalcSplines ? c_pmeSpreadSplineBlockSize : spline->n);
+                for (int start = 0; start < spline->n; start += blockSize)
+                {
+                    int end = std::min(start + blockSize, spline->n);
+
+                    if (bCalcSplines)
+                    {
+                        make_bsplines(spline->theta, spline->dtheta, pme->pme_order,
+                                      atc->fractx, start, end, spline->ind, atc->coefficient, bDoSplines);
+                    }
+
+                    spread_coefficients_bsplines_thread(grid, atc, spline, start, end,
+                                                        pme->spline_work);
+                }
 
                 if (pme->bUseThreads)
                 {
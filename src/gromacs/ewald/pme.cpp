@@ -657,13 +657,14 @@ int gmx_pme_init(struct gmx_pme_t   **pmedata,
     pme->bFEP_q        = ((ir->efep != efepNO) && bFreeEnergy_q);
     pme->bFEP_lj       = ((ir->efep != efepNO) && bFreeEnergy_lj);
     pme->bFEP          = (pme->bFEP_q || pme->bFEP_lj);
-    pme->nkx           = ir->nkx;
-    pme->nky           = ir->nky;
-    pme->nkz           = ir->nkz;
-    pme->bP3M          = (ir->coulombtype == eelP3M_AD || getenv("GMX_PME_P3M") != nullptr);
-    pme->pme_order     = ir->pme_order;
-    pme->ewaldcoeff_q  = ewaldcoeff_q;
-    pme->ewaldcoeff_lj = ewaldcoeff_lj;
+    pme->nkx             = ir->nkx;
+    pme->nky             = ir->nky;
+    pme->nkz             = ir->nkz;
+    pme->bP3M            = (ir->coulombtype == eelP3M_AD || getenv("GMX_PME_P3M") != nullptr);
+    pme->pme_order       = ir->pme_order;
+    pme->bMixedPrecision = (GMX_DOUBLE && getenv("GMX_PME_MIXED_PRECISION_SOLVE") != nullptr);
+    pme->ewaldcoeff_q    = ewaldcoeff_q;
+    pme->ewaldcoeff_lj   = ewaldcoeff_lj;
 
     /* Always constant electrostatics coefficients */
     pme->epsilon_r     = ir->epsilon_r;
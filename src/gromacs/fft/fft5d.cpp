@@ -89,6 +89,18 @@ static gmx::Mutex big_fftw_mutex;
 #define FFTW_UNLOCK try { big_fftw_mutex.unlock(); } GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
 #endif /* GMX_FFT_FFTW3 */
 
+/* Overlapping the transposes with the FFTs requires non-blocking
+ * collectives, which are part of MPI 3, but not of thread-MPI.
+ */
+#if GMX_LIB_MPI && MPI_VERSION >= 3
+#define FFT5D_PIPELINE_SUPPORTED 1
+#else
+#define FFT5D_PIPELINE_SUPPORTED 0
+#endif
+
+/* The number of z-slabs the pipelined FFT+transpose steps are split into */
+static const int c_fft5dNumSlabs = 4;
+
 #if GMX_MPI
 /* largest factor smaller than sqrt */
 static int lfactor(int z)
@@ -133,6 +145,14 @@ static int vmax(int* a, int s)
 }
 
 
+/* Returns whether lout2 and lout3 need their own buffers, instead of
+ * reusing lin and lout
+ */
+static bool fft5d_separate_transpose_buffers(int flags, int nthreads)
+{
+    return nthreads > 1 || (flags&FFT5D_PIPELINE);
+}
+
 /* NxMxK the size of the data
  * comm communicator to use for fft5d
  * P0 number of processor in 1st axes (can be null for automatic)
@@ -382,13 +402,20 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
     /* int lsize = fmax(N[0]*M[0]*K[0]*nP[0],N[1]*M[1]*K[1]*nP[1]); */
     lsize = std::max(N[0]*M[0]*K[0]*nP[0], std::max(N[1]*M[1]*K[1]*nP[1], C[2]*M[2]*K[2]));
     /* int lsize = fmax(C[0]*M[0]*K[0],fmax(C[1]*M[1]*K[1],C[2]*M[2]*K[2])); */
+    if (!FFT5D_PIPELINE_SUPPORTED)
+    {
+        flags &= ~FFT5D_PIPELINE;
+    }
     if (!(flags&FFT5D_NOMALLOC))
     {
         snew_aligned(lin, lsize, 32);
         snew_aligned(lout, lsize, 32);
-        if (nthreads > 1)
+        if (fft5d_separate_transpose_buffers(flags, nthreads))
         {
-            /* We need extra transpose buffers to avoid OpenMP barriers */
+            /* We need extra transpose buffers to avoid OpenMP barriers,
+             * and with pipelining because the FFTs of the next slab
+             * still read lin and write lout while we transpose.
+             */
             snew_aligned(lout2, lsize, 32);
             snew_aligned(lout3, lsize, 32);
         }
@@ -403,7 +430,7 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
     {
         lin  = *rlin;
         lout = *rlout;
-        if (nthreads > 1)
+        if (fft5d_separate_transpose_buffers(flags, nthreads))
         {
             lout2 = *rlout2;
             lout3 = *rlout3;
@@ -600,6 +627,72 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
     {
         plan->cart[1] = comm[0]; plan->cart[0] = comm[1];
     }
+
+    /* Set up the 1D plans for the pipelined transposes. We split the local
+     * data in slabs along the major dimension z. The FFTs within a slab are
+     * divided over the threads. The slab boundaries are determined from
+     * the maximum local size K, so they are identical on all ranks.
+     * We can only pipeline when the alltoall blocks have the same layout
+     * as the output of splitaxes.
+     */
+    plan->nslab = c_fft5dNumSlabs;
+    for (s = 0; s < 2; s++)
+    {
+        int blockSize;
+        if ((s == 0 && !(flags&FFT5D_ORDER_YZ)) || (s == 1 && (flags&FFT5D_ORDER_YZ)))
+        {
+            blockSize = N[s]*pM[s]*K[s];
+        }
+        else
+        {
+            blockSize = N[s]*M[s]*pK[s];
+        }
+        plan->p1dslab[s] = nullptr;
+        if (!(flags&FFT5D_PIPELINE) || nP[s] <= 1 || blockSize != N[s]*M[s]*K[s])
+        {
+            continue;
+        }
+
+        plan->p1dslab[s] = (gmx_fft_t*)malloc(sizeof(gmx_fft_t)*plan->nslab*nthreads);
+        for (int c = 0; c < plan->nslab; c++)
+        {
+            int z0    = std::min((c  )*K[s]/plan->nslab, pK[s]);
+            int z1    = std::min((c+1)*K[s]/plan->nslab, pK[s]);
+            int nline = (z1 - z0)*pM[s];
+
+#pragma omp parallel for num_threads(nthreads) schedule(static) ordered
+            for (t = 0; t < nthreads; t++)
+            {
+#pragma omp ordered
+                {
+                    try
+                    {
+                        int tsize = ((t+1)*nline/nthreads)-(t*nline/nthreads);
+
+                        if ((flags&FFT5D_REALCOMPLEX) && !(flags&FFT5D_BACKWARD) && s == 0)
+                        {
+                            gmx_fft_init_many_1d_real( &plan->p1dslab[s][c*nthreads + t], rC[s], tsize, (flags&FFT5D_NOMEASURE) ? GMX_FFT_FLAG_CONSERVATIVE : 0 );
+                        }
+                        else
+                        {
+                            gmx_fft_init_many_1d     ( &plan->p1dslab[s][c*nthreads + t],  C[s], tsize, (flags&FFT5D_NOMEASURE) ? GMX_FFT_FLAG_CONSERVATIVE : 0 );
+                        }
+                    }
+                    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+                }
+            }
+        }
+    }
+    if (plan->p1dslab[0] != nullptr || plan->p1dslab[1] != nullptr)
+    {
+        /* Each slab needs its own counts and displacements, since MPI does
+         * not allow modifying them before the non-blocking call completes.
+         */
+        plan->slabcount = (int*)malloc(sizeof(int)*plan->nslab*std::max(nP[0], nP[1]));
+        plan->slabdispl = (int*)malloc(sizeof(int)*plan->nslab*std::max(nP[0], nP[1]));
+        plan->slabreq   = (MPI_Request*)malloc(sizeof(MPI_Request)*plan->nslab);
+    }
+
 #ifdef FFT5D_MPI_TRANSPOSE
     FFTW_LOCK;
     for (s = 0; s < 2; s++)
@@ -937,6 +1030,88 @@ static void print_localdata(const t_complex* lin, const char* txt, int s, fft5d_
     }
 }
 
+/*FFT along the first axis and split + transpose for stage s, pipelined over
+   z-slabs: the communication of a slab is overlapped with the FFTs of the next.
+   The result in lout3 is identical to the non-pipelined path.*/
+static void fft5d_execute_pipelined(fft5d_plan plan, int s, int thread, fft5d_time times)
+{
+#if FFT5D_PIPELINE_SUPPORTED
+    t_complex *lin   = plan->lin;
+    t_complex *lout  = plan->lout;
+    t_complex *lout2 = plan->lout2;
+    t_complex *lout3 = plan->lout3;
+    int       *N     = plan->N, *M = plan->M, *K = plan->K, *pM = plan->pM, *pK = plan->pK,
+    *C               = plan->C, *P = plan->P, **iNout = plan->iNout, **oNout = plan->oNout;
+    int        nslab = plan->nslab;
+    /* The size of a z-plane of a block for one rank, in reals */
+    int        planeSize = N[s]*M[s]*sizeof(t_complex)/sizeof(real);
+
+    for (int c = 0; c < nslab; c++)
+    {
+        int z0    = std::min((c  )*K[s]/nslab, pK[s]);
+        int z1    = std::min((c+1)*K[s]/nslab, pK[s]);
+        int nline = (z1 - z0)*pM[s];
+        int l0    = z0*pM[s] + ( thread   *nline/plan->nthreads);
+        int l1    = z0*pM[s] + ((thread+1)*nline/plan->nthreads);
+
+        if (l1 > l0)
+        {
+            gmx_fft_t p1d = plan->p1dslab[s][c*plan->nthreads + thread];
+            if ((plan->flags&FFT5D_REALCOMPLEX) && !(plan->flags&FFT5D_BACKWARD) && s == 0)
+            {
+                gmx_fft_many_1d_real(p1d, GMX_FFT_REAL_TO_COMPLEX, lin+l0*C[s], lout+l0*C[s]);
+            }
+            else
+            {
+                gmx_fft_many_1d(     p1d, (plan->flags&FFT5D_BACKWARD) ? GMX_FFT_BACKWARD : GMX_FFT_FORWARD, lin+l0*C[s], lout+l0*C[s]);
+            }
+
+            splitaxes(lout2, lout, N[s], M[s], K[s], pM[s], P[s], C[s], iNout[s], oNout[s], l0%pM[s], l0/pM[s], l1%pM[s], l1/pM[s]);
+        }
+#pragma omp barrier /*all data of this slab has to be split before sending*/
+
+        if (thread == 0)
+        {
+            wallcycle_start(times, ewcPME_FFTCOMM);
+            /* We send the whole slab, including the padding, as the alltoall does */
+            int  zs0   = (c  )*K[s]/nslab;
+            int  zs1   = (c+1)*K[s]/nslab;
+            /* The arrays of this slab are in use until its request completes */
+            int *count = plan->slabcount + c*P[s];
+            int *displ = plan->slabdispl + c*P[s];
+            for (int i = 0; i < P[s]; i++)
+            {
+                count[i] = (zs1 - zs0)*planeSize;
+                displ[i] = (i*K[s] + zs0)*planeSize;
+            }
+            MPI_Ialltoallv((real *)lout2, count, displ, GMX_MPI_REAL,
+                           (real *)lout3, count, displ, GMX_MPI_REAL,
+                           plan->cart[s], &plan->slabreq[c]);
+            if (c > 0)
+            {
+                /* Give MPI the opportunity to progress the previous slabs */
+                int flag;
+                MPI_Testall(c, plan->slabreq, &flag, MPI_STATUSES_IGNORE);
+            }
+            wallcycle_stop(times, ewcPME_FFTCOMM);
+        }
+    }
+
+    if (thread == 0)
+    {
+        wallcycle_start(times, ewcPME_FFTCOMM);
+        MPI_Waitall(nslab, plan->slabreq, MPI_STATUSES_IGNORE);
+        wallcycle_stop(times, ewcPME_FFTCOMM);
+    }
+#else
+    GMX_UNUSED_VALUE(plan);
+    GMX_UNUSED_VALUE(s);
+    GMX_UNUSED_VALUE(thread);
+    GMX_UNUSED_VALUE(times);
+    gmx_incons("fft5d pipelining called without MPI 3 support");
+#endif
+}
+
 void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
 {
     t_complex  *lin   = plan->lin;
@@ -957,7 +1132,7 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
 #endif
     int   *N = plan->N, *M = plan->M, *K = plan->K, *pN = plan->pN, *pM = plan->pM, *pK = plan->pK,
     *C       = plan->C, *P = plan->P, **iNin = plan->iNin, **oNin = plan->oNin, **iNout = plan->iNout, **oNout = plan->oNout;
-    int    s = 0, tstart, tend, bParallelDim;
+    int    s = 0, tstart, tend, bParallelDim, bPipelined;
 
 
 #if GMX_FFT_FFTW3
@@ -1005,6 +1180,13 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
             bParallelDim = 0;
         }
 
+        bPipelined = (bParallelDim && plan->p1dslab[s] != nullptr);
+        if (bPipelined)
+        {
+            /* FFT, split and transpose overlapped, the result is in lout3 */
+            fft5d_execute_pipelined(plan, s, thread, times);
+        }
+
         /* ---------- START FFT ------------ */
 #ifdef NOGMX
         if (times != 0 && thread == 0)
@@ -1030,7 +1212,11 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
         }
 
         tstart = (thread*pM[s]*pK[s]/plan->nthreads)*C[s];
-        if ((plan->flags&FFT5D_REALCOMPLEX) && !(plan->flags&FFT5D_BACKWARD) && s == 0)
+        if (bPipelined)
+        {
+            /* Already done in fft5d_execute_pipelined */
+        }
+        else if ((plan->flags&FFT5D_REALCOMPLEX) && !(plan->flags&FFT5D_BACKWARD) && s == 0)
         {
             gmx_fft_many_1d_real(p1d[s][thread], (plan->flags&FFT5D_BACKWARD) ? GMX_FFT_COMPLEX_TO_REAL : GMX_FFT_REAL_TO_COMPLEX, lin+tstart, fftout+tstart);
         }
@@ -1053,7 +1239,7 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
         /* ---------- END FFT ------------ */
 
         /* ---------- START SPLIT + TRANSPOSE------------ (if parallel in in this dimension)*/
-        if (bParallelDim)
+        if (bParallelDim && !bPipelined)
         {
 #ifdef NOGMX
             if (times != NULL && thread == 0)
@@ -1221,6 +1407,21 @@ void fft5d_destroy(fft5d_plan plan)
 {
     int s, t;
 
+    for (s = 0; s < 2; s++)
+    {
+        if (plan->p1dslab[s])
+        {
+            for (t = 0; t < plan->nslab*plan->nthreads; t++)
+            {
+                gmx_many_fft_destroy(plan->p1dslab[s][t]);
+            }
+            free(plan->p1dslab[s]);
+        }
+    }
+    free(plan->slabcount);
+    free(plan->slabdispl);
+    free(plan->slabreq);
+
     for (s = 0; s < 3; s++)
     {
         if (plan->p1d[s])
@@ -1271,7 +1472,7 @@ void fft5d_destroy(fft5d_plan plan)
     {
         sfree_aligned(plan->lin);
         sfree_aligned(plan->lout);
-        if (plan->nthreads > 1)
+        if (fft5d_separate_transpose_buffers(plan->flags, plan->nthreads))
         {
             sfree_aligned(plan->lout2);
             sfree_aligned(plan->lout3);
@@ -86,7 +86,8 @@ typedef enum fft5d_flags_t {
     FFT5D_DEBUG       = 8,
     FFT5D_NOMEASURE   = 16,
     FFT5D_INPLACE     = 32,
-    FFT5D_NOMALLOC    = 64
+    FFT5D_NOMALLOC    = 64,
+    FFT5D_PIPELINE    = 128
 } fft5d_flags;
 
 struct fft5d_plan_t {
@@ -117,6 +118,13 @@ struct fft5d_plan_t {
     /*int P[2];*/
     int coor[2];
     int nthreads;
+
+    /* Data for overlapping the transposes with the 1D FFTs, set with FFT5D_PIPELINE */
+    int          nslab;        /*number of z-slabs the pipelined transposes are split into*/
+    gmx_fft_t   *p1dslab[2];   /*1D plans per slab and thread, NULL when not pipelining stage s*/
+    int         *slabcount;    /*alltoallv counts, a separate set of size P per slab*/
+    int         *slabdispl;    /*alltoallv displacements, a separate set of size P per slab*/
+    MPI_Request *slabreq;      /*requests for the communication of each slab*/
 };
 
 typedef struct fft5d_plan_t *fft5d_plan;
@@ -0,0 +1,213 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that the pipelined transposes of the parallel 3D FFT give the
+ * same result as the non-pipelined ones.
+ *
+ * The pipelining is only active with an MPI 3 library. Otherwise the
+ * tests compare two runs of the non-pipelined path.
+ *
+ * \ingroup module_fft
+ */
+#include "gmxpre.h"
+
+#include <cstdlib>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "config.h"
+
+#include "gromacs/fft/parallel_3dfft.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/basenetwork.h"
+#include "gromacs/utility/gmxmpi.h"
+#include "gromacs/utility/real.h"
+
+#include "testutils/mpitest.h"
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+//! Sets or unsets the GMX_PME_FFT_PIPELINE environment variable
+void setFftPipelineEnv(bool bSet)
+{
+#ifdef _MSC_VER
+    _putenv(bSet ? "GMX_PME_FFT_PIPELINE=1" : "GMX_PME_FFT_PIPELINE=");
+#else
+    if (bSet)
+    {
+        setenv("GMX_PME_FFT_PIPELINE", "1", 1);
+    }
+    else
+    {
+        unsetenv("GMX_PME_FFT_PIPELINE");
+    }
+#endif
+}
+
+/*! \brief Does a forward and a backward 3D FFT decomposed over all ranks
+ *
+ * \param[in]  ndata      The global grid size
+ * \param[in]  decompDim  The index of the communicator that decomposes the grid
+ * \param[in]  pipeline   Whether to set GMX_PME_FFT_PIPELINE
+ * \param[out] forward    The local part of the complex grid after the forward FFT
+ * \param[out] backward   The local part of the real grid after the backward FFT
+ */
+void runParallel3dFft(ivec ndata, int decompDim, bool pipeline,
+                      std::vector<real> *forward, std::vector<real> *backward)
+{
+    MPI_Comm             comm[] = {MPI_COMM_NULL, MPI_COMM_NULL};
+    gmx_parallel_3dfft_t fft;
+    real                *rdata;
+    t_complex           *cdata;
+    ivec                 local_ndata, offset, rsize, csize, complex_order;
+
+    comm[decompDim] = MPI_COMM_WORLD;
+
+    /* All ranks need to take the same path. With thread-MPI the ranks
+     * share the environment, so only one of them changes it.
+     */
+    const bool changeEnv = (!GMX_THREAD_MPI || gmx_node_rank() == 0);
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (changeEnv)
+    {
+        setFftPipelineEnv(pipeline);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    gmx_parallel_3dfft_init(&fft, ndata, &rdata, &cdata, comm, TRUE, 1);
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (changeEnv)
+    {
+        setFftPipelineEnv(false);
+    }
+
+    gmx_parallel_3dfft_real_limits(fft, local_ndata, offset, rsize);
+    for (int i = 0; i < local_ndata[XX]; i++)
+    {
+        for (int j = 0; j < local_ndata[YY]; j++)
+        {
+            for (int k = 0; k < local_ndata[ZZ]; k++)
+            {
+                int gi = offset[XX] + i;
+                int gj = offset[YY] + j;
+                int gk = offset[ZZ] + k;
+
+                rdata[(i*rsize[YY] + j)*rsize[ZZ] + k] = ((gi*7 + gj*3 + gk*5) % 19)*0.5 - 4.5;
+            }
+        }
+    }
+
+    gmx_parallel_3dfft_execute(fft, GMX_FFT_REAL_TO_COMPLEX, 0, nullptr);
+
+    gmx_parallel_3dfft_complex_limits(fft, complex_order, local_ndata, offset, csize);
+    const int d0 = complex_order[0];
+    const int d1 = complex_order[1];
+    const int d2 = complex_order[2];
+    forward->clear();
+    for (int i = 0; i < local_ndata[d0]; i++)
+    {
+        for (int j = 0; j < local_ndata[d1]; j++)
+        {
+            for (int k = 0; k < local_ndata[d2]; k++)
+            {
+                const t_complex &c = cdata[(i*csize[d1] + j)*csize[d2] + k];
+                forward->push_back(c.re);
+                forward->push_back(c.im);
+            }
+        }
+    }
+
+    gmx_parallel_3dfft_execute(fft, GMX_FFT_COMPLEX_TO_REAL, 0, nullptr);
+
+    gmx_parallel_3dfft_real_limits(fft, local_ndata, offset, rsize);
+    backward->clear();
+    for (int i = 0; i < local_ndata[XX]; i++)
+    {
+        for (int j = 0; j < local_ndata[YY]; j++)
+        {
+            for (int k = 0; k < local_ndata[ZZ]; k++)
+            {
+                backward->push_back(rdata[(i*rsize[YY] + j)*rsize[ZZ] + k]);
+            }
+        }
+    }
+
+    gmx_parallel_3dfft_destroy(fft);
+}
+
+//! Checks that pipelined and non-pipelined FFTs decomposed along \p decompDim agree
+void checkPipelinedFftMatches(int decompDim)
+{
+    /* All dimensions, including the complex one, divide evenly over
+     * the ranks, so the transposes can be pipelined. */
+    ivec              ndata = {8, 12, 14};
+    std::vector<real> refForward, refBackward;
+    std::vector<real> testForward, testBackward;
+
+    runParallel3dFft(ndata, decompDim, false, &refForward, &refBackward);
+    runParallel3dFft(ndata, decompDim, true, &testForward, &testBackward);
+
+    /* The values are sums over the grid, the tolerance is relative
+     * to their typical magnitude. */
+    gmx::test::FloatingPointTolerance tolerance(gmx::test::relativeToleranceAsUlp(1000.0, 64));
+    ASSERT_EQ(refForward.size(), testForward.size());
+    for (size_t i = 0; i < refForward.size(); i++)
+    {
+        EXPECT_REAL_EQ_TOL(refForward[i], testForward[i], tolerance) << "forward element " << i;
+    }
+    ASSERT_EQ(refBackward.size(), testBackward.size());
+    for (size_t i = 0; i < refBackward.size(); i++)
+    {
+        EXPECT_REAL_EQ_TOL(refBackward[i], testBackward[i], tolerance) << "backward element " << i;
+    }
+}
+
+TEST(ParallelFFTTest, PipelinedMatchesNonPipelinedWithMajorDecomposition)
+{
+    GMX_MPI_TEST(2);
+    checkPipelinedFftMatches(0);
+}
+
+TEST(ParallelFFTTest, PipelinedMatchesNonPipelinedWithMinorDecomposition)
+{
+    GMX_MPI_TEST(2);
+    checkPipelinedFftMatches(1);
+}
+
+} // namespace
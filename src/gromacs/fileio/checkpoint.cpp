@@ -45,6 +45,9 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <string>
+#include <vector>
+
 #include <fcntl.h>
 #if GMX_NATIVE_WINDOWS
 #include <io.h>
@@ -80,6 +83,7 @@
 #include "gromacs/utility/int64_to_int.h"
 #include "gromacs/utility/programcontext.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/sysinfo.h"
 #include "gromacs/utility/txtdump.h"
 
@@ -91,13 +95,21 @@
 #define CPT_MAGIC2 171819
 #define CPTSTRLEN 1024
 
+/* Magic number at the start of checkpoint atom section files */
+#define CPT_SECTION_MAGIC 171821
+
+/* The state entries that are stored in atom section files,
+ * when a checkpoint is written as sections
+ */
+#define CPT_ATOM_ENTRIES ((1<<estX) | (1<<estV))
+
 /* cpt_version should normally only be changed
  * when the header or footer format changes.
  * The state data format itself is backward and forward compatible.
  * But old code can not read a new entry that is present in the file
  * (but can read a new format when new entries are not present).
  */
-static const int cpt_version = 16;
+static const int cpt_version = 17;
 
 
 const char *est_names[estNR] =
@@ -846,7 +858,7 @@ static void do_cpt_header(XDR *xd, gmx_bool bRead, int *file_version,
                           int *natoms, int *ngtc, int *nnhpres, int *nhchainlength,
                           int *nlambda, int *flags_state,
                           int *flags_eks, int *flags_enh, int *flags_dfh,
-                          int *nED, int *eSwapCoords,
+                          int *nED, int *eSwapCoords, int *nAtomSections,
                           FILE *list)
 {
     bool_t res = 0;
@@ -996,6 +1008,14 @@ static void do_cpt_header(XDR *xd, gmx_bool bRead, int *file_version,
     {
         *eSwapCoords = eswapNO;
     }
+    if (*file_version >= 17)
+    {
+        do_cpt_int_err(xd, "#atom sections", nAtomSections, list);
+    }
+    else
+    {
+        *nAtomSections = 0;
+    }
 }
 
 static int do_cpt_footer(XDR *xd, int file_version)
@@ -1554,12 +1574,250 @@ static int do_cpt_files(XDR *xd, gmx_bool bRead,
 }
 
 
+/* Returns the name, to be freed, of the file the checkpoint at step
+ * is written to before it is renamed to fn
+ */
+static char *cpt_step_filename(const char *fn, gmx_int64_t step)
+{
+    char *fntemp;
+
+#if !GMX_NO_RENAME
+    char  suffix[5+STEPSTRSIZE], sbuf[STEPSTRSIZE];
+
+    /* make the new temporary filename */
+    snew(fntemp, std::strlen(fn)+5+STEPSTRSIZE);
+    std::strcpy(fntemp, fn);
+    fntemp[std::strlen(fn) - std::strlen(ftp2ext(fn2ftp(fn))) - 1] = '\0';
+    sprintf(suffix, "_%s%s", "step", gmx_step_str(step, sbuf));
+    std::strcat(fntemp, suffix);
+    std::strcat(fntemp, fn+std::strlen(fn) - std::strlen(ftp2ext(fn2ftp(fn))) - 1);
+#else
+    /* if we can't rename, we just overwrite the cpt file.
+     * dangerous if interrupted.
+     */
+    GMX_UNUSED_VALUE(step);
+    fntemp = gmx_strdup(fn);
+#endif
+
+    return fntemp;
+}
+
+/* Returns the name of atom section file section of checkpoint file fn,
+ * which is fn with _rank<section> inserted before the extension
+ */
+static std::string cpt_section_filename(const char *fn, int section)
+{
+    std::string name(fn);
+    size_t      extPos = name.size() - std::strlen(ftp2ext(fn2ftp(fn))) - 1;
+
+    return name.substr(0, extPos) + gmx::formatString("_rank%d", section) + name.substr(extPos);
+}
+
+/* Removes the atom section files of checkpoint file fn with index
+ * firstSection and higher, which are left over from earlier runs
+ * with more sections
+ */
+static void remove_cpt_sections(const char *fn, int firstSection)
+{
+    for (int s = firstSection; gmx_fexist(cpt_section_filename(fn, s).c_str()); s++)
+    {
+        remove(cpt_section_filename(fn, s).c_str());
+    }
+}
+
+static void do_cpt_section_header(XDR *xd, gmx_bool bRead, int *file_version,
+                                  gmx_int64_t *step, int *section, int *nsections,
+                                  int *natoms, int *flags_state, FILE *list)
+{
+    int magic;
+
+    magic = bRead ? -1 : CPT_SECTION_MAGIC;
+    if (xdr_int(xd, &magic) == 0)
+    {
+        gmx_fatal(FARGS, "The checkpoint atom section file is empty/corrupted, or maybe you are out of disk space?");
+    }
+    if (magic != CPT_SECTION_MAGIC)
+    {
+        gmx_fatal(FARGS, "Start of file magic number mismatch, checkpoint atom section file has %d, should be %d\n"
+                  "The file is corrupted or not a checkpoint atom section file",
+                  magic, CPT_SECTION_MAGIC);
+    }
+    *file_version = cpt_version;
+    do_cpt_int_err(xd, "checkpoint file version", file_version, list);
+    if (*file_version > cpt_version)
+    {
+        gmx_fatal(FARGS, "Attempting to read a checkpoint file of version %d with code of version %d\n", *file_version, cpt_version);
+    }
+    do_cpt_step_err(xd, "step", step, list);
+    do_cpt_int_err(xd, "atom section", section, list);
+    do_cpt_int_err(xd, "#atom sections", nsections, list);
+    do_cpt_int_err(xd, "#atoms", natoms, list);
+    do_cpt_int_err(xd, "state flags", flags_state, list);
+}
+
+static int do_cpt_atom_index(XDR *xd, int natoms, int *index, FILE *list)
+{
+    if (xdr_vector(xd, reinterpret_cast<char *>(index), natoms, sizeof(int),
+                   (xdrproc_t)xdr_int) == 0)
+    {
+        return -1;
+    }
+    if (list)
+    {
+        pr_ivec(list, 0, "global atom index", index, natoms, TRUE);
+    }
+
+    return 0;
+}
+
+void write_checkpoint_atom_section(const char *fn, int section, int nsections,
+                                   gmx_int64_t step, int natoms, const int *globalIndex,
+                                   t_state *state)
+{
+    char             *fntemp      = cpt_step_filename(fn, step);
+    std::string       fnSection   = cpt_section_filename(fntemp, section);
+    int               flags_state = (state->flags & CPT_ATOM_ENTRIES);
+    int               file_version;
+    std::vector<int>  index(natoms);
+    t_fileio         *fp;
+    XDR              *xd;
+
+    for (int i = 0; i < natoms; i++)
+    {
+        index[i] = (globalIndex ? globalIndex[i] : i);
+    }
+
+    fp = gmx_fio_open(fnSection.c_str(), "w");
+    xd = gmx_fio_getxdr(fp);
+    do_cpt_section_header(xd, FALSE, &file_version, &step, &section, &nsections,
+                          &natoms, &flags_state, nullptr);
+    if ((do_cpt_atom_index(xd, natoms, index.data(), nullptr) < 0) ||
+        ((flags_state & (1<<estX)) &&
+         doPaddedRvecVector(xd, StatePart::microState, estX, flags_state, &state->x, natoms, nullptr) < 0) ||
+        ((flags_state & (1<<estV)) &&
+         doPaddedRvecVector(xd, StatePart::microState, estV, flags_state, &state->v, natoms, nullptr) < 0))
+    {
+        gmx_file("Cannot read/write checkpoint; corrupt file, or maybe you are out of disk space?");
+    }
+    do_cpt_footer(xd, file_version);
+
+    if (gmx_fio_fsync(fp) != 0)
+    {
+        char buf[STRLEN];
+        sprintf(buf,
+                "Cannot fsync '%s'; maybe you are out of disk space?",
+                fnSection.c_str());
+
+        if (getenv(GMX_IGNORE_FSYNC_FAILURE_ENV) == nullptr)
+        {
+            gmx_file(buf);
+        }
+        else
+        {
+            gmx_warning(buf);
+        }
+    }
+    if (gmx_fio_close(fp) != 0)
+    {
+        gmx_file("Cannot read/write checkpoint; corrupt file, or maybe you are out of disk space?");
+    }
+
+    sfree(fntemp);
+}
+
+/* Reads the atom entries of the state at step from the nsections atom
+ * section files of checkpoint file fn, or lists them when list!=NULL
+ */
+static void read_cpt_atom_sections(const char *fn, int nsections, gmx_int64_t step,
+                                   int fflags, t_state *state, FILE *list)
+{
+    std::vector<gmx_bool> bPresent(list == nullptr ? state->natoms : 0, FALSE);
+    int                   natomsRead = 0;
+
+    for (int s = 0; s < nsections; s++)
+    {
+        std::string           fnSection = cpt_section_filename(fn, s);
+        int                   file_version, section, nsections_f, natoms, flags_f;
+        gmx_int64_t           step_f;
+        std::vector<int>      index;
+        gmx::PaddedRVecVector buf;
+        t_fileio             *fp;
+        XDR                  *xd;
+        int                   ret;
+
+        if (list)
+        {
+            fprintf(list, "\nAtom section file %s\n", fnSection.c_str());
+        }
+        fp = gmx_fio_open(fnSection.c_str(), "r");
+        xd = gmx_fio_getxdr(fp);
+        do_cpt_section_header(xd, TRUE, &file_version, &step_f, &section, &nsections_f,
+                              &natoms, &flags_f, list);
+        if (step_f != step || section != s || nsections_f != nsections ||
+            flags_f != (fflags & CPT_ATOM_ENTRIES))
+        {
+            gmx_fatal(FARGS, "Checkpoint atom section file %s does not belong to checkpoint file %s",
+                      fnSection.c_str(), fn);
+        }
+
+        index.resize(natoms);
+        buf.resize(natoms);
+        ret = do_cpt_atom_index(xd, natoms, index.data(), list);
+        if (ret == 0 && list == nullptr)
+        {
+            for (int i = 0; i < natoms; i++)
+            {
+                if (index[i] < 0 || index[i] >= state->natoms || bPresent[index[i]])
+                {
+                    gmx_fatal(FARGS, "Checkpoint atom section file %s contains an invalid or duplicate atom index %d",
+                              fnSection.c_str(), index[i] + 1);
+                }
+                bPresent[index[i]] = TRUE;
+            }
+            natomsRead += natoms;
+        }
+        for (int e : { estX, estV })
+        {
+            if (ret == 0 && (flags_f & (1<<e)))
+            {
+                ret = doPaddedRvecVector(xd, StatePart::microState, e, state->flags, &buf, natoms, list);
+                if (ret == 0 && list == nullptr)
+                {
+                    gmx::PaddedRVecVector *v = (e == estX ? &state->x : &state->v);
+                    for (int i = 0; i < natoms; i++)
+                    {
+                        copy_rvec(buf[i], (*v)[index[i]]);
+                    }
+                }
+            }
+        }
+        if (ret == 0)
+        {
+            ret = do_cpt_footer(xd, file_version);
+        }
+        if (ret)
+        {
+            cp_error();
+        }
+        if (gmx_fio_close(fp) != 0)
+        {
+            gmx_file("Cannot read/write checkpoint; corrupt file, or maybe you are out of disk space?");
+        }
+    }
+
+    if (list == nullptr && natomsRead != state->natoms)
+    {
+        gmx_fatal(FARGS, "The atom section files of checkpoint file %s contain %d atoms, while the checkpoint is for %d atoms",
+                  fn, natomsRead, state->natoms);
+    }
+}
+
 void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
                       FILE *fplog, t_commrec *cr,
                       ivec domdecCells, int nppnodes,
                       int eIntegrator, int simulation_part,
                       gmx_bool bExpanded, int elamstats,
-                      gmx_int64_t step, double t,
+                      gmx_int64_t step, double t, int nAtomSections,
                       t_state *state, ObservablesHistory *observablesHistory)
 {
     t_fileio            *fp;
@@ -1573,7 +1831,7 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
     char                *fntemp; /* the temporary checkpoint file name */
     char                 timebuf[STRLEN];
     int                  npmenodes;
-    char                 buf[1024], suffix[5+STEPSTRSIZE], sbuf[STEPSTRSIZE];
+    char                 buf[1024];
     gmx_file_position_t *outputfiles;
     int                  noutputfiles;
     char                *ftime;
@@ -1588,21 +1846,7 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
         npmenodes = 0;
     }
 
-#if !GMX_NO_RENAME
-    /* make the new temporary filename */
-    snew(fntemp, std::strlen(fn)+5+STEPSTRSIZE);
-    std::strcpy(fntemp, fn);
-    fntemp[std::strlen(fn) - std::strlen(ftp2ext(fn2ftp(fn))) - 1] = '\0';
-    sprintf(suffix, "_%s%s", "step", gmx_step_str(step, sbuf));
-    std::strcat(fntemp, suffix);
-    std::strcat(fntemp, fn+std::strlen(fn) - std::strlen(ftp2ext(fn2ftp(fn))) - 1);
-#else
-    /* if we can't rename, we just overwrite the cpt file.
-     * dangerous if interrupted.
-     */
-    snew(fntemp, std::strlen(fn));
-    std::strcpy(fntemp, fn);
-#endif
+    fntemp = cpt_step_filename(fn, step);
     gmx_format_current_time(timebuf, STRLEN);
 
     if (fplog)
@@ -1701,7 +1945,7 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
                   DOMAINDECOMP(cr) ? domdecCells : nullptr, &npmenodes,
                   &state->natoms, &state->ngtc, &state->nnhpres,
                   &state->nhchainlength, &nlambda, &state->flags, &flags_eks, &flags_enh, &flags_dfh,
-                  &nED, &eSwapCoords,
+                  &nED, &eSwapCoords, &nAtomSections,
                   nullptr);
 
     sfree(version);
@@ -1710,7 +1954,9 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
     sfree(bhost);
     sfree(fprog);
 
-    if ((do_cpt_state(gmx_fio_getxdr(fp), state->flags, state, nullptr) < 0)        ||
+    /* With atom sections, the atom entries have been written to separate files */
+    int flags_state = (nAtomSections > 0 ? (state->flags & ~CPT_ATOM_ENTRIES) : state->flags);
+    if ((do_cpt_state(gmx_fio_getxdr(fp), flags_state, state, nullptr) < 0)        ||
         (do_cpt_ekinstate(gmx_fio_getxdr(fp), flags_eks, &state->ekinstate, nullptr) < 0) ||
         (do_cpt_enerhist(gmx_fio_getxdr(fp), FALSE, flags_enh, enerhist, nullptr) < 0)  ||
         (do_cpt_df_hist(gmx_fio_getxdr(fp), flags_dfh, nlambda, &state->dfhist, nullptr) < 0)  ||
@@ -1774,15 +2020,43 @@ void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
             /* We don't really care if this fails:
              * there's already a new checkpoint.
              */
+            int s;
+            for (s = 0; gmx_fexist(cpt_section_filename(fn, s).c_str()); s++)
+            {
+                gmx_file_copy(cpt_section_filename(fn, s).c_str(),
+                              cpt_section_filename(buf, s).c_str(), FALSE);
+            }
 #else
             gmx_file_rename(fn, buf);
+            int s;
+            for (s = 0; gmx_fexist(cpt_section_filename(fn, s).c_str()); s++)
+            {
+                gmx_file_rename(cpt_section_filename(fn, s).c_str(),
+                                cpt_section_filename(buf, s).c_str());
+            }
 #endif
+            remove_cpt_sections(buf, s);
+        }
+        /* Rename the atom sections first, the step in their headers
+         * catches a mismatch with the main file after an interruption.
+         */
+        for (int s = 0; s < nAtomSections; s++)
+        {
+            if (gmx_file_rename(cpt_section_filename(fntemp, s).c_str(),
+                                cpt_section_filename(fn, s).c_str()) != 0)
+            {
+                gmx_file("Cannot rename checkpoint file; maybe you are out of disk space?");
+            }
         }
         if (gmx_file_rename(fntemp, fn) != 0)
         {
             gmx_file("Cannot rename checkpoint file; maybe you are out of disk space?");
         }
+        /* A restart with fewer ranks leaves more sections behind */
+        remove_cpt_sections(fn, nAtomSections);
     }
+#else
+    remove_cpt_sections(fn, nAtomSections);
 #endif  /* GMX_NO_RENAME */
 
     sfree(outputfiles);
@@ -1973,7 +2247,7 @@ static void read_checkpoint(const char *fn, FILE **pfplog,
     int                  eIntegrator_f, nppnodes_f, npmenodes_f;
     ivec                 dd_nc_f;
     int                  natoms, ngtc, nnhpres, nhchainlength, nlambda, fflags, flags_eks, flags_enh, flags_dfh;
-    int                  nED, eSwapCoords;
+    int                  nED, eSwapCoords, nAtomSections;
     int                  ret;
     gmx_file_position_t *outputfiles;
     int                  nfiles;
@@ -2004,7 +2278,7 @@ static void read_checkpoint(const char *fn, FILE **pfplog,
                   &nppnodes_f, dd_nc_f, &npmenodes_f,
                   &natoms, &ngtc, &nnhpres, &nhchainlength, &nlambda,
                   &fflags, &flags_eks, &flags_enh, &flags_dfh,
-                  &nED, &eSwapCoords, nullptr);
+                  &nED, &eSwapCoords, &nAtomSections, nullptr);
 
     if (bAppendOutputFiles &&
         file_version >= 13 && double_prec != GMX_DOUBLE)
@@ -2115,7 +2389,19 @@ static void read_checkpoint(const char *fn, FILE **pfplog,
                         reproducibilityRequested);
         }
     }
-    ret             = do_cpt_state(gmx_fio_getxdr(fp), fflags, state, nullptr);
+    if (nAtomSections > 0)
+    {
+        ret = do_cpt_state(gmx_fio_getxdr(fp), fflags & ~CPT_ATOM_ENTRIES, state, nullptr);
+        if (ret == 0)
+        {
+            /* Any number of ranks can continue, since we assemble the global state */
+            read_cpt_atom_sections(fn, nAtomSections, *step, fflags, state, nullptr);
+        }
+    }
+    else
+    {
+        ret = do_cpt_state(gmx_fio_getxdr(fp), fflags, state, nullptr);
+    }
     *init_fep_state = state->fep_state;  /* there should be a better way to do this than setting it here.
                                             Investigate for 5.0. */
     if (ret)
@@ -2395,7 +2681,7 @@ void read_checkpoint_part_and_step(const char  *filename,
     int       flags_eks, flags_enh, flags_dfh;
     double    t;
     t_state   state;
-    int       nED, eSwapCoords;
+    int       nED, eSwapCoords, nAtomSections;
     t_fileio *fp;
 
     if (filename == nullptr ||
@@ -2416,7 +2702,7 @@ void read_checkpoint_part_and_step(const char  *filename,
                   &eIntegrator, simulation_part, step, &t, &nppnodes, dd_nc, &npme,
                   &state.natoms, &state.ngtc, &state.nnhpres, &state.nhchainlength,
                   &nlambda, &state.flags, &flags_eks, &flags_enh, &flags_dfh,
-                  &nED, &eSwapCoords, nullptr);
+                  &nED, &eSwapCoords, &nAtomSections, nullptr);
 
     gmx_fio_close(fp);
 }
@@ -2433,7 +2719,7 @@ static void read_checkpoint_data(t_fileio *fp, int *simulation_part,
     ivec                 dd_nc;
     int                  nlambda;
     int                  flags_eks, flags_enh, flags_dfh;
-    int                  nED, eSwapCoords;
+    int                  nED, eSwapCoords, nAtomSections;
     int                  nfiles_loc;
     gmx_file_position_t *files_loc = nullptr;
     int                  ret;
@@ -2443,9 +2729,20 @@ static void read_checkpoint_data(t_fileio *fp, int *simulation_part,
                   &eIntegrator, simulation_part, step, t, &nppnodes, dd_nc, &npme,
                   &state->natoms, &state->ngtc, &state->nnhpres, &state->nhchainlength,
                   &nlambda, &state->flags, &flags_eks, &flags_enh, &flags_dfh,
-                  &nED, &eSwapCoords, nullptr);
-    ret =
-        do_cpt_state(gmx_fio_getxdr(fp), state->flags, state, nullptr);
+                  &nED, &eSwapCoords, &nAtomSections, nullptr);
+    if (nAtomSections > 0)
+    {
+        ret = do_cpt_state(gmx_fio_getxdr(fp), state->flags & ~CPT_ATOM_ENTRIES, state, nullptr);
+        if (ret == 0)
+        {
+            read_cpt_atom_sections(gmx_fio_getname(fp), nAtomSections, *step,
+                                   state->flags, state, nullptr);
+        }
+    }
+    else
+    {
+        ret = do_cpt_state(gmx_fio_getxdr(fp), state->flags, state, nullptr);
+    }
     if (ret)
     {
         cp_error();
@@ -2581,7 +2878,7 @@ void list_checkpoint(const char *fn, FILE *out)
     ivec                 dd_nc;
     int                  nlambda;
     int                  flags_eks, flags_enh, flags_dfh;
-    int                  nED, eSwapCoords;
+    int                  nED, eSwapCoords, nAtomSections;
     int                  ret;
     gmx_file_position_t *outputfiles;
     int                  nfiles;
@@ -2595,8 +2892,10 @@ void list_checkpoint(const char *fn, FILE *out)
                   &state.natoms, &state.ngtc, &state.nnhpres, &state.nhchainlength,
                   &nlambda, &state.flags,
                   &flags_eks, &flags_enh, &flags_dfh, &nED, &eSwapCoords,
-                  out);
-    ret = do_cpt_state(gmx_fio_getxdr(fp), state.flags, &state, out);
+                  &nAtomSections, out);
+    ret = do_cpt_state(gmx_fio_getxdr(fp),
+                       nAtomSections > 0 ? (state.flags & ~CPT_ATOM_ENTRIES) : state.flags,
+                       &state, out);
     if (ret)
     {
         cp_error();
@@ -2639,6 +2938,11 @@ void list_checkpoint(const char *fn, FILE *out)
         ret = do_cpt_footer(gmx_fio_getxdr(fp), file_version);
     }
 
+    if (ret == 0 && nAtomSections > 0)
+    {
+        read_cpt_atom_sections(fn, nAtomSections, step, state.flags, &state, out);
+    }
+
     if (ret)
     {
         cp_warning(out);
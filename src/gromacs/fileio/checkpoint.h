@@ -62,15 +62,31 @@ struct t_trxframe;
 /* Write a checkpoint to <fn>.cpt
  * Appends the _step<step>.cpt with bNumberAndKeep,
  * otherwise moves the previous <fn>.cpt to <fn>_prev.cpt
+ * With nAtomSections > 0, the atom entries of the state are not written,
+ * but all ranks should have written them with write_checkpoint_atom_section
+ * for sections 0 to nAtomSections-1. These files are renamed along with
+ * the checkpoint file.
  */
 void write_checkpoint(const char *fn, gmx_bool bNumberAndKeep,
                       FILE *fplog, t_commrec *cr,
                       ivec domdecCells, int nppnodes,
                       int eIntegrator, int simulation_part,
                       gmx_bool bExpanded, int elamstats,
-                      gmx_int64_t step, double t,
+                      gmx_int64_t step, double t, int nAtomSections,
                       t_state *state, ObservablesHistory *observablesHistory);
 
+/* Write the atom entries of the first natoms atoms in state to atom
+ * section file <fn>_rank<section>.cpt of the checkpoint at step.
+ * globalIndex contains the global atom indices, NULL means 0 to natoms-1.
+ * This can be called by all ranks in parallel, before the master rank
+ * writes the rest of the checkpoint with write_checkpoint.
+ * All checkpoint reading functions assemble the state from the sections,
+ * so a run can be continued with any number of ranks.
+ */
+void write_checkpoint_atom_section(const char *fn, int section, int nsections,
+                                   gmx_int64_t step, int natoms, const int *globalIndex,
+                                   t_state *state);
+
 /* Loads a checkpoint from fn for run continuation.
  * Generates a fatal error on system size mismatch.
  * The master node reads the file
@@ -92,6 +92,12 @@ struct ener_file
     t_fileio  *fio;
     int        framenr;
     real       frametime;
+    gmx_bool   bDouble;       /* The reals in the file are doubles */
+    gmx_bool  *bSel;          /* Selected terms for do_enx_selected */
+    int        sel_alloc;     /* Allocation size of bSel */
+    int        nframe_index;  /* Number of frames in the frame index */
+    gmx_off_t *frame_offset;  /* Offset in the file of each indexed frame */
+    double    *frame_time;    /* Time of each indexed frame */
 };
 
 static void enxsubblock_init(t_enxsubblock *sb)
@@ -756,6 +762,9 @@ void close_enx(ener_file_t ef)
     {
         gmx_file("Cannot close energy file; it might be corrupt, or maybe you are out of disk space?");
     }
+    sfree(ef->bSel);
+    sfree(ef->frame_offset);
+    sfree(ef->frame_time);
 }
 
 void done_ener_file(ener_file_t ef)
@@ -840,6 +849,7 @@ ener_file_t open_enx(const char *fn, const char *mode)
             {
                 fprintf(stderr, "Opened %s as double precision energy file\n",
                         fn);
+                ef->bDouble = TRUE;
             }
             else
             {
@@ -944,12 +954,51 @@ static void convert_full_sums(ener_old_t *ener_old, t_enxframe *fr)
     ener_old->step_prev = fr->step;
 }
 
-gmx_bool do_enx(ener_file_t ef, t_enxframe *fr)
+/* Skips nbytes of frame data when reading. Since seeking past the end of
+   the file does not fail, the last skipped byte is read to detect
+   incomplete frames, as decoding the data would. */
+static gmx_bool enx_skip(ener_file_t ef, gmx_off_t nbytes)
+{
+    FILE *fp;
+
+    if (nbytes == 0)
+    {
+        return TRUE;
+    }
+    fp = gmx_fio_getfp(ef->fio);
+
+    return (gmx_fseek(fp, nbytes - 1, SEEK_CUR) == 0 && fgetc(fp) != EOF);
+}
+
+/* Returns the size in the file of the data of subblock sub,
+   or -1 when the size is not known from the header */
+static gmx_off_t enxsubblock_file_size(const t_enxsubblock *sub)
+{
+    switch (sub->type)
+    {
+        case xdr_datatype_int:
+        case xdr_datatype_float:
+        case xdr_datatype_char: /* XDR pads each char to 4 bytes */
+            return 4*static_cast<gmx_off_t>(sub->nr);
+        case xdr_datatype_double:
+        case xdr_datatype_int64:
+            return 8*static_cast<gmx_off_t>(sub->nr);
+        default:
+            return -1;
+    }
+}
+
+/* Reads or writes a frame. When reading with nmask >= 0 only the energy
+   terms i < nmask with bSel[i] set are decoded, and when bBlocks is FALSE
+   the blocks are skipped; skipped data is seeked over instead of decoded. */
+static gmx_bool do_enx_int(ener_file_t ef, t_enxframe *fr,
+                           const gmx_bool *bSel, int nmask, gmx_bool bBlocks)
 {
     int           file_version = -1;
     int           i, b;
     gmx_bool      bRead, bOK, bOK1, bSane;
     real          tmp1, tmp2, rdum;
+    gmx_off_t     realSize, termSize, skip;
     /*int       d_size;*/
 
     bOK   = TRUE;
@@ -1018,8 +1067,27 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe *fr)
         fr->e_alloc = fr->nre;
     }
 
+    realSize = ef->bDouble ? sizeof(double) : sizeof(float);
+    termSize = realSize;
+    if (file_version == 1 ||
+        (bRead && fr->nsum > 0) || fr->nsum > 1)
+    {
+        termSize += (file_version == 1 ? 3 : 2)*realSize;
+    }
+    skip = 0;
     for (i = 0; i < fr->nre; i++)
     {
+        if (nmask >= 0 && (i >= nmask || !bSel[i]))
+        {
+            fr->ener[i].e    = 0;
+            fr->ener[i].eav  = 0;
+            fr->ener[i].esum = 0;
+            skip            += termSize;
+            continue;
+        }
+        bOK  = bOK && enx_skip(ef, skip);
+        skip = 0;
+
         bOK = bOK && gmx_fio_do_real(ef->fio, fr->ener[i].e);
 
         /* Do not store sums of length 1,
@@ -1051,6 +1119,7 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe *fr)
             }
         }
     }
+    bOK = bOK && enx_skip(ef, skip);
 
     /* Here we can not check for file_version==1, since one could have
      * continued an old format simulation with a new one with mdrun -append.
@@ -1071,6 +1140,11 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe *fr)
         {
             t_enxsubblock *sub = &(fr->block[b].sub[i]); /* shortcut */
 
+            if (bRead && !bBlocks && enxsubblock_file_size(sub) >= 0)
+            {
+                bOK = bOK && enx_skip(ef, enxsubblock_file_size(sub));
+                continue;
+            }
             if (bRead)
             {
                 enxsubblock_alloc(sub);
@@ -1104,6 +1178,12 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe *fr)
         }
     }
 
+    if (bRead && !bBlocks)
+    {
+        /* The skipped blocks have no data, so they should not be used */
+        fr->nblock = 0;
+    }
+
     if (!bRead)
     {
         if (gmx_fio_flush(ef->fio) != 0)
@@ -1131,6 +1211,118 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe *fr)
     return TRUE;
 }
 
+gmx_bool do_enx(ener_file_t ef, t_enxframe *fr)
+{
+    return do_enx_int(ef, fr, nullptr, -1, TRUE);
+}
+
+gmx_bool do_enx_selected(ener_file_t ef, t_enxframe *fr,
+                         int nsel, const int sel[], gmx_bool bBlocks)
+{
+    int nmask, i;
+
+    if (!gmx_fio_getread(ef->fio))
+    {
+        gmx_incons("do_enx_selected can only be used for reading");
+    }
+
+    /* The number of terms is only known after reading the frame header,
+       terms beyond the mask are not selected */
+    nmask = 0;
+    for (i = 0; i < nsel; i++)
+    {
+        nmask = std::max(nmask, sel[i] + 1);
+    }
+    if (nmask > ef->sel_alloc)
+    {
+        srenew(ef->bSel, nmask);
+        ef->sel_alloc = nmask;
+    }
+    for (i = 0; i < nmask; i++)
+    {
+        ef->bSel[i] = FALSE;
+    }
+    for (i = 0; i < nsel; i++)
+    {
+        ef->bSel[sel[i]] = TRUE;
+    }
+
+    return do_enx_int(ef, fr, ef->bSel, nmask, bBlocks);
+}
+
+int enx_build_frame_index(ener_file_t ef)
+{
+    t_enxframe fr;
+    gmx_off_t  start, offset;
+    int        framenr, nalloc;
+    real       frametime;
+
+    if (ef->eo.bOldFileOpen)
+    {
+        gmx_fatal(FARGS, "Frame indices are not supported for old energy file %s",
+                  gmx_fio_getname(ef->fio));
+    }
+
+    start     = gmx_fio_ftell(ef->fio);
+    framenr   = ef->framenr;
+    frametime = ef->frametime;
+
+    sfree(ef->frame_offset);
+    sfree(ef->frame_time);
+    ef->frame_offset = nullptr;
+    ef->frame_time   = nullptr;
+    nalloc           = 0;
+
+    init_enxframe(&fr);
+    ef->nframe_index = 0;
+    offset           = start;
+    while (do_enx_selected(ef, &fr, 0, nullptr, FALSE))
+    {
+        if (ef->nframe_index == nalloc)
+        {
+            nalloc = over_alloc_large(ef->nframe_index + 1);
+            srenew(ef->frame_offset, nalloc);
+            srenew(ef->frame_time, nalloc);
+        }
+        ef->frame_offset[ef->nframe_index] = offset;
+        ef->frame_time[ef->nframe_index]   = fr.t;
+        ef->nframe_index++;
+        offset = gmx_fio_ftell(ef->fio);
+    }
+    free_enxframe(&fr);
+
+    gmx_fio_seek(ef->fio, start);
+    ef->framenr   = framenr;
+    ef->frametime = frametime;
+
+    return ef->nframe_index;
+}
+
+double enx_frame_index_time(ener_file_t ef, int frame)
+{
+    if (frame < 0 || frame >= ef->nframe_index)
+    {
+        gmx_fatal(FARGS, "Frame %d is not in the frame index of energy file %s",
+                  frame, gmx_fio_getname(ef->fio));
+    }
+
+    return ef->frame_time[frame];
+}
+
+void enx_seek_frame(ener_file_t ef, int frame)
+{
+    if (frame < 0 || frame >= ef->nframe_index)
+    {
+        gmx_fatal(FARGS, "Frame %d is not in the frame index of energy file %s",
+                  frame, gmx_fio_getname(ef->fio));
+    }
+    if (gmx_fio_seek(ef->fio, ef->frame_offset[frame]) != 0)
+    {
+        gmx_file("Cannot seek in energy file");
+    }
+    ef->framenr = frame;
+}
+
 static real find_energy(const char *name, int nre, gmx_enxnm_t *enm,
                         t_enxframe *fr)
 {
@@ -188,6 +188,30 @@ void free_enxnms(int n, gmx_enxnm_t *nms);
 gmx_bool do_enx(ener_file_t ef, t_enxframe *fr);
 /* Reads enx_frames, memory in fr is (re)allocated if necessary */
 
+gmx_bool do_enx_selected(ener_file_t ef, t_enxframe *fr,
+                         int nsel, const int sel[], gmx_bool bBlocks);
+/* Reads the next frame as do_enx, but only decodes the nsel energy terms
+ * with indices sel, the other terms are seeked over and set to zero.
+ * When bBlocks is FALSE, the blocks are also seeked over and fr->nblock
+ * is set to zero. This is much faster than do_enx when only a few terms
+ * of large frames are needed.
+ */
+
+int enx_build_frame_index(ener_file_t ef);
+/* Scans the rest of the file, starting at the current position (which
+ * should be after the energy names), without decoding the frame contents,
+ * and stores the file offset and time of each frame in ef.
+ * The file position is restored. Returns the number of frames found.
+ */
+
+double enx_frame_index_time(ener_file_t ef, int frame);
+/* Returns the time of frame number frame in the frame index */
+
+void enx_seek_frame(ener_file_t ef, int frame);
+/* Positions ef such that the next read returns frame number frame
+ * of the frame index.
+ */
+
 void get_enx_state(const char *fn, real t,
                    const gmx_groups_t *groups, t_inputrec *ir,
                    t_state *state);
@@ -38,9 +38,12 @@
 
 #include "gmxfio-xdr.h"
 
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 
+#include <algorithm>
+
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/xdrf.h"
 #include "gromacs/utility/fatalerror.h"
@@ -101,6 +104,118 @@ static void gmx_fio_fe(t_fileio *fio, int eio, const char *desc,
               srcfile, line);
 }
 
+/* Number of rvecs converted per block by do_xdr_rvecs() */
+static const int c_xdrRvecBlockSize = 1024;
+
+/* Conversion between XDR, i.e. big-endian IEEE, and native floating point.
+ * Assembling the value from bytes is independent of the native byte
+ * order and compiles to (vectorized) byte swaps.
+ */
+static inline std::uint32_t xdr_to_uint32(const unsigned char *b)
+{
+    return ((static_cast<std::uint32_t>(b[0]) << 24) | (static_cast<std::uint32_t>(b[1]) << 16) |
+            (static_cast<std::uint32_t>(b[2]) <<  8) | static_cast<std::uint32_t>(b[3]));
+}
+
+static inline float xdr_to_float(const unsigned char *b)
+{
+    std::uint32_t u = xdr_to_uint32(b);
+    float         f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static inline double xdr_to_double(const unsigned char *b)
+{
+    /* XDR stores the most significant word first */
+    std::uint64_t u = ((static_cast<std::uint64_t>(xdr_to_uint32(b)) << 32) | xdr_to_uint32(b + 4));
+    double        d;
+    std::memcpy(&d, &u, sizeof(d));
+    return d;
+}
+
+static inline void float_to_xdr(float f, unsigned char *b)
+{
+    std::uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    b[0] = u >> 24;
+    b[1] = u >> 16;
+    b[2] = u >> 8;
+    b[3] = u;
+}
+
+static inline void double_to_xdr(double d, unsigned char *b)
+{
+    std::uint64_t u;
+    std::memcpy(&u, &d, sizeof(u));
+    for (int i = 0; i < 8; i++)
+    {
+        b[i] = u >> (56 - 8*i);
+    }
+}
+
+/* Reads or writes n rvecs with one fread/fwrite call per block and
+ * converts the values in a tight loop, instead of calling xdr_float
+ * or xdr_double for every single value. With item=NULL the values
+ * are read and discarded.
+ */
+static gmx_bool do_xdr_rvecs(t_fileio *fio, rvec *item, int n)
+{
+    const size_t  valueSize = (fio->bDouble ? sizeof(double) : sizeof(float));
+    unsigned char buf[c_xdrRvecBlockSize*DIM*sizeof(double)];
+
+    for (int start = 0; start < n; start += c_xdrRvecBlockSize)
+    {
+        size_t nvalues = std::min(c_xdrRvecBlockSize, n - start)*DIM;
+        real  *r       = (item ? item[start] : nullptr);
+
+        if (fio->bRead)
+        {
+            if (fread(buf, valueSize, nvalues, fio->fp) != nvalues)
+            {
+                return FALSE;
+            }
+            if (r && fio->bDouble)
+            {
+                for (size_t i = 0; i < nvalues; i++)
+                {
+                    r[i] = xdr_to_double(buf + i*sizeof(double));
+                }
+            }
+            else if (r)
+            {
+                for (size_t i = 0; i < nvalues; i++)
+                {
+                    r[i] = xdr_to_float(buf + i*sizeof(float));
+                }
+            }
+        }
+        else
+        {
+            if (fio->bDouble)
+            {
+                for (size_t i = 0; i < nvalues; i++)
+                {
+                    double_to_xdr(r[i], buf + i*sizeof(double));
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < nvalues; i++)
+                {
+                    float_to_xdr(r[i], buf + i*sizeof(float));
+                }
+            }
+            if (fwrite(buf, valueSize, nvalues, fio->fp) != nvalues)
+            {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
 /* This is the part that reads xdr files.  */
 
 static gmx_bool do_xdr(t_fileio *fio, void *item, int nitem, int eio,
@@ -264,6 +379,11 @@ static gmx_bool do_xdr(t_fileio *fio, void *item, int nitem, int eio,
             }
             break;
         case eioNRVEC:
+            if (fio->fp && (item || fio->bRead))
+            {
+                res = do_xdr_rvecs(fio, (rvec *) item, nitem);
+                break;
+            }
             ptr = nullptr;
             res = 1;
             for (j = 0; (j < nitem) && res; j++)
@@ -39,6 +39,7 @@
 #include <climits>
 #include <cmath>
 #include <cstdio>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 
@@ -107,27 +108,27 @@ static void sendbits(int buf[], int num_of_bits, int num)
     unsigned int    cnt, lastbyte;
     int             lastbits;
     unsigned char * cbuf;
+    std::uint64_t   acc;
 
     cbuf     = (reinterpret_cast<unsigned char *>(buf)) + 3 * sizeof(*buf);
     cnt      = static_cast<unsigned int>(buf[0]);
     lastbits = buf[1];
     lastbyte = static_cast<unsigned int>(buf[2]);
-    while (num_of_bits >= 8)
+
+    /* Append num to the pending bits in a 64-bit accumulator and flush
+     * all complete bytes at once. There are at most 7 pending bits and
+     * num_of_bits is at most 32, so the accumulator can not overflow.
+     */
+    acc       = ((static_cast<std::uint64_t>(lastbyte) & ((1u << lastbits) - 1)) << num_of_bits) |
+        static_cast<unsigned int>(num);
+    lastbits += num_of_bits;
+    while (lastbits >= 8)
     {
-        lastbyte     = (lastbyte << 8) | ((num >> (num_of_bits -8)) /* & 0xff*/);
-        cbuf[cnt++]  = lastbyte >> lastbits;
-        num_of_bits -= 8;
-    }
-    if (num_of_bits > 0)
-    {
-        lastbyte  = (lastbyte << num_of_bits) | num;
-        lastbits += num_of_bits;
-        if (lastbits >= 8)
-        {
-            lastbits   -= 8;
-            cbuf[cnt++] = lastbyte >> lastbits;
-        }
+        lastbits   -= 8;
+        cbuf[cnt++] = static_cast<unsigned char>(acc >> lastbits);
     }
+    lastbyte = static_cast<unsigned int>(acc);
+
     buf[0] = cnt;
     buf[1] = lastbits;
     buf[2] = lastbyte;
@@ -227,6 +228,37 @@ static void sendints(int buf[], const int num_of_ints, const int num_of_bits,
     int          i, num_of_bytes, bytecnt;
     unsigned int bytes[32], tmp;
 
+    if (num_of_bits <= 64)
+    {
+        /* The product of the sizes fits in 64 bits, so we can form the
+         * multibyte integer directly. The bytes are sent least significant
+         * first, exactly as in the general code below.
+         */
+        std::uint64_t value = nums[0];
+        int           nbits;
+
+        for (i = 1; i < num_of_ints; i++)
+        {
+            if (nums[i] >= sizes[i])
+            {
+                fprintf(stderr, "major breakdown in sendints num %u doesn't "
+                        "match size %u\n", nums[i], sizes[i]);
+                exit(1);
+            }
+            value = value * sizes[i] + nums[i];
+        }
+        for (nbits = num_of_bits; nbits >= 8; nbits -= 8)
+        {
+            sendbits(buf, 8, static_cast<int>(value & 0xff));
+            value >>= 8;
+        }
+        if (nbits > 0)
+        {
+            sendbits(buf, nbits, static_cast<int>(value));
+        }
+        return;
+    }
+
     tmp          = nums[0];
     num_of_bytes = 0;
     do
@@ -290,38 +322,32 @@ static void sendints(int buf[], const int num_of_ints, const int num_of_bits,
 static int receivebits(int buf[], int num_of_bits)
 {
 
-    int             cnt, num, lastbits;
+    int             cnt, lastbits;
     unsigned int    lastbyte;
     unsigned char * cbuf;
-    int             mask = (1 << num_of_bits) -1;
+    std::uint64_t   acc;
 
     cbuf     = reinterpret_cast<unsigned char *>(buf) + 3 * sizeof(*buf);
     cnt      = buf[0];
     lastbits = static_cast<unsigned int>(buf[1]);
     lastbyte = static_cast<unsigned int>(buf[2]);
 
-    num = 0;
-    while (num_of_bits >= 8)
-    {
-        lastbyte     = ( lastbyte << 8 ) | cbuf[cnt++];
-        num         |=  (lastbyte >> lastbits) << (num_of_bits - 8);
-        num_of_bits -= 8;
-    }
-    if (num_of_bits > 0)
+    /* Load as many whole bytes as needed behind the unused bits of the
+     * previous byte and extract num_of_bits (at most 32) in one go.
+     */
+    acc = static_cast<std::uint64_t>(lastbyte) & ((1u << lastbits) - 1);
+    while (lastbits < num_of_bits)
     {
-        if (lastbits < num_of_bits)
-        {
-            lastbits += 8;
-            lastbyte  = (lastbyte << 8) | cbuf[cnt++];
-        }
-        lastbits -= num_of_bits;
-        num      |= (lastbyte >> lastbits) & ((1 << num_of_bits) -1);
+        acc       = (acc << 8) | cbuf[cnt++];
+        lastbits += 8;
     }
-    num   &= mask;
+    lastbits -= num_of_bits;
+    lastbyte  = static_cast<unsigned int>(acc);
+
     buf[0] = cnt;
     buf[1] = lastbits;
     buf[2] = lastbyte;
-    return num;
+    return static_cast<int>((acc >> lastbits) & ((static_cast<std::uint64_t>(1) << num_of_bits) - 1));
 }
 
 /*____________________________________________________________________________
@@ -341,6 +367,31 @@ static void receiveints(int buf[], const int num_of_ints, int num_of_bits,
     int bytes[32];
     int i, j, num_of_bytes, p, num;
 
+    if (num_of_bits <= 64)
+    {
+        /* Same as below, but with the multibyte integer in 64 bits */
+        std::uint64_t value = 0;
+        int           shift = 0;
+
+        while (num_of_bits > 8)
+        {
+            value       |= static_cast<std::uint64_t>(receivebits(buf, 8)) << shift;
+            shift       += 8;
+            num_of_bits -= 8;
+        }
+        if (num_of_bits > 0)
+        {
+            value |= static_cast<std::uint64_t>(receivebits(buf, num_of_bits)) << shift;
+        }
+        for (i = num_of_ints-1; i > 0; i--)
+        {
+            nums[i] = static_cast<int>(value % sizes[i]);
+            value  /= sizes[i];
+        }
+        nums[0] = static_cast<int>(value);
+        return;
+    }
+
     bytes[0]     = bytes[1] = bytes[2] = bytes[3] = 0;
     num_of_bytes = 0;
     while (num_of_bits > 8)
@@ -407,7 +458,7 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
     int          we_should_free = 0;
 
     int          minint[3], maxint[3], mindiff, *lip, diff;
-    int          lint1, lint2, lint3, oldlint1, oldlint2, oldlint3, smallidx;
+    int          overflow, smallidx;
     int          minidx, maxidx;
     unsigned     sizeint[3], sizesmall[3], bitsizeint[3], size3, *luip;
     int          flag, k;
@@ -479,93 +530,35 @@ int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision)
         minint[0] = minint[1] = minint[2] = INT_MAX;
         maxint[0] = maxint[1] = maxint[2] = INT_MIN;
         prevrun   = -1;
-        lfp       = fp;
-        lip       = ip;
-        mindiff   = INT_MAX;
-        oldlint1  = oldlint2 = oldlint3 = 0;
-        while (lfp < fp + size3)
-        {
-            /* find nearest integer */
-            if (*lfp >= 0.0)
-            {
-                lf = *lfp * *precision + 0.5;
-            }
-            else
-            {
-                lf = *lfp * *precision - 0.5;
-            }
-            if (fabs(lf) > MAXABS)
-            {
-                /* scaling would cause overflow */
-                errval = 0;
-            }
-            lint1 = static_cast<int>(lf);
-            if (lint1 < minint[0])
-            {
-                minint[0] = lint1;
-            }
-            if (lint1 > maxint[0])
-            {
-                maxint[0] = lint1;
-            }
-            *lip++ = lint1;
-            lfp++;
-            if (*lfp >= 0.0)
-            {
-                lf = *lfp * *precision + 0.5;
-            }
-            else
-            {
-                lf = *lfp * *precision - 0.5;
-            }
-            if (fabs(lf) > MAXABS)
-            {
-                /* scaling would cause overflow */
-                errval = 0;
-            }
-            lint2 = static_cast<int>(lf);
-            if (lint2 < minint[1])
-            {
-                minint[1] = lint2;
-            }
-            if (lint2 > maxint[1])
-            {
-                maxint[1] = lint2;
-            }
-            *lip++ = lint2;
-            lfp++;
-            if (*lfp >= 0.0)
-            {
-                lf = *lfp * *precision + 0.5;
-            }
-            else
-            {
-                lf = *lfp * *precision - 0.5;
-            }
-            if (std::abs(lf) > MAXABS)
+        /* Convert to the nearest integers and determine the range in a
+         * branch-free loop that the compiler can vectorize. Note that the
+         * rounding offset is a double, as it always was; changing this
+         * would change the output for values right at the rounding edge.
+         */
+        overflow = 0;
+        for (i = 0; i < *size; i++)
+        {
+            for (k = 0; k < 3; k++)
             {
+                lf          = fp[3*i + k] * *precision + (fp[3*i + k] >= 0.0 ? 0.5 : -0.5);
                 /* scaling would cause overflow */
-                errval = 0;
-            }
-            lint3 = static_cast<int>(lf);
-            if (lint3 < minint[2])
-            {
-                minint[2] = lint3;
-            }
-            if (lint3 > maxint[2])
-            {
-                maxint[2] = lint3;
-            }
-            *lip++ = lint3;
-            lfp++;
-            diff = std::abs(oldlint1-lint1)+std::abs(oldlint2-lint2)+std::abs(oldlint3-lint3);
-            if (diff < mindiff && lfp > fp + 3)
-            {
-                mindiff = diff;
+                overflow   |= (std::fabs(static_cast<double>(lf)) > MAXABS);
+                ip[3*i + k] = static_cast<int>(lf);
+                minint[k]   = std::min(minint[k], ip[3*i + k]);
+                maxint[k]   = std::max(maxint[k], ip[3*i + k]);
             }
-            oldlint1 = lint1;
-            oldlint2 = lint2;
-            oldlint3 = lint3;
+        }
+        if (overflow)
+        {
+            errval = 0;
+        }
+        mindiff = INT_MAX;
+        for (i = 1; i < *size; i++)
+        {
+            diff    = (std::abs(ip[3*i - 3] - ip[3*i    ]) +
+                       std::abs(ip[3*i - 2] - ip[3*i + 1]) +
+                       std::abs(ip[3*i - 1] - ip[3*i + 2]));
+            mindiff = std::min(mindiff, diff);
         }
         if ( (xdr_int(xdrs, &(minint[0])) == 0) ||
              (xdr_int(xdrs, &(minint[1])) == 0) ||
@@ -0,0 +1,220 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for selective reading of energy files
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/enxio.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+//! Number of energy terms in the test file
+const int c_numTerms = 12;
+//! Number of frames in the test file
+const int c_numFrames = 7;
+//! Number of values in the test block
+const int c_numBlockValues = 1000;
+
+//! Value of energy term \p i in frame \p frame
+real termValue(int frame, int i)
+{
+    return 100*frame + i;
+}
+
+class EnxSelectTest : public ::testing::Test
+{
+    public:
+        EnxSelectTest() : fn_(fileManager_.getTemporaryFilePath(".edr"))
+        {
+            gmx_enxnm_t *enm;
+            t_enxframe   fr;
+            int          nre = c_numTerms;
+
+            snew(enm, c_numTerms);
+            for (int i = 0; i < c_numTerms; i++)
+            {
+                enm[i].name = gmx_strdup(gmx::formatString("Term %d", i).c_str());
+                enm[i].unit = gmx_strdup("kJ/mol");
+            }
+            ener_file_t ef = open_enx(fn_.c_str(), "w");
+            do_enxnms(ef, &nre, &enm);
+            free_enxnms(c_numTerms, enm);
+
+            init_enxframe(&fr);
+            fr.nre     = c_numTerms;
+            fr.e_alloc = c_numTerms;
+            snew(fr.ener, c_numTerms);
+            add_blocks_enxframe(&fr, 1);
+            fr.block[0].id = enxDH;
+            add_subblocks_enxblock(&fr.block[0], 2);
+            fr.block[0].sub[0].type = xdr_datatype_float;
+            fr.block[0].sub[0].nr   = c_numBlockValues;
+            snew(fr.block[0].sub[0].fval, c_numBlockValues);
+            fr.block[0].sub[1].type = xdr_datatype_int;
+            fr.block[0].sub[1].nr   = 1;
+            snew(fr.block[0].sub[1].ival, 1);
+            for (int frame = 0; frame < c_numFrames; frame++)
+            {
+                fr.t    = 0.5*frame;
+                fr.step = 10*frame;
+                fr.nsum = 10;
+                for (int i = 0; i < c_numTerms; i++)
+                {
+                    fr.ener[i].e    = termValue(frame, i);
+                    fr.ener[i].eav  = 2*termValue(frame, i);
+                    fr.ener[i].esum = 3*termValue(frame, i);
+                }
+                for (int i = 0; i < c_numBlockValues; i++)
+                {
+                    fr.block[0].sub[0].fval[i] = frame + 0.001*i;
+                }
+                fr.block[0].sub[1].ival[0] = frame;
+                do_enx(ef, &fr);
+            }
+            sfree(fr.block[0].sub[0].fval);
+            sfree(fr.block[0].sub[1].ival);
+            free_enxframe(&fr);
+            done_ener_file(ef);
+        }
+
+        //! Opens the test file for reading, positioned after the names
+        ener_file_t openForReading()
+        {
+            gmx_enxnm_t *enm = nullptr;
+            int          nre;
+
+            ener_file_t  ef = open_enx(fn_.c_str(), "r");
+            do_enxnms(ef, &nre, &enm);
+            EXPECT_EQ(c_numTerms, nre);
+            free_enxnms(nre, enm);
+
+            return ef;
+        }
+
+        gmx::test::TestFileManager fileManager_;
+        std::string                fn_;
+};
+
+TEST_F(EnxSelectTest, DecodesOnlySelectedTerms)
+{
+    const int   sel[] = { 7, 2 };
+    ener_file_t ef    = openForReading();
+    t_enxframe  fr;
+
+    init_enxframe(&fr);
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        ASSERT_TRUE(do_enx_selected(ef, &fr, 2, sel, FALSE));
+        EXPECT_EQ(0.5*frame, fr.t);
+        EXPECT_EQ(10*frame, fr.step);
+        ASSERT_EQ(c_numTerms, fr.nre);
+        EXPECT_EQ(0, fr.nblock);
+        for (int i = 0; i < c_numTerms; i++)
+        {
+            real ref = (i == 2 || i == 7) ? termValue(frame, i) : 0;
+            EXPECT_EQ(ref, fr.ener[i].e);
+            EXPECT_EQ(2*ref, fr.ener[i].eav);
+            EXPECT_EQ(3*ref, fr.ener[i].esum);
+        }
+    }
+    EXPECT_FALSE(do_enx_selected(ef, &fr, 2, sel, FALSE));
+    free_enxframe(&fr);
+    done_ener_file(ef);
+}
+
+TEST_F(EnxSelectTest, DecodesBlocksWithoutTerms)
+{
+    ener_file_t ef = openForReading();
+    t_enxframe  fr;
+
+    init_enxframe(&fr);
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        ASSERT_TRUE(do_enx_selected(ef, &fr, 0, nullptr, TRUE));
+        EXPECT_EQ(0, fr.ener[c_numTerms - 1].e);
+        ASSERT_EQ(1, fr.nblock);
+        ASSERT_EQ(2, fr.block[0].nsub);
+        EXPECT_FLOAT_EQ(frame + 0.001*(c_numBlockValues - 1),
+                        fr.block[0].sub[0].fval[c_numBlockValues - 1]);
+        EXPECT_EQ(frame, fr.block[0].sub[1].ival[0]);
+    }
+    free_enxframe(&fr);
+    done_ener_file(ef);
+}
+
+TEST_F(EnxSelectTest, FrameIndexSeeksToFrames)
+{
+    const int   sel[] = { 5 };
+    ener_file_t ef    = openForReading();
+    t_enxframe  fr;
+
+    ASSERT_EQ(c_numFrames, enx_build_frame_index(ef));
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        EXPECT_EQ(0.5*frame, enx_frame_index_time(ef, frame));
+    }
+
+    init_enxframe(&fr);
+    // The file position is kept, so we read the first frame
+    ASSERT_TRUE(do_enx(ef, &fr));
+    EXPECT_EQ(0, fr.step);
+    for (int frame : { 4, 1, 6 })
+    {
+        enx_seek_frame(ef, frame);
+        ASSERT_TRUE(do_enx_selected(ef, &fr, 1, sel, FALSE));
+        EXPECT_EQ(10*frame, fr.step);
+        EXPECT_EQ(termValue(frame, 5), fr.ener[5].e);
+    }
+    free_enxframe(&fr);
+    done_ener_file(ef);
+}
+
+} // namespace
@@ -0,0 +1,79 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements the helpers for writing test trajectories.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "testtrajectory.h"
+
+#include "gromacs/fileio/xtcio.h"
+
+namespace gmx
+{
+namespace test
+{
+
+std::vector<RVec> testTrajectoryCoordinates(int numAtoms, int frame)
+{
+    std::vector<RVec> x(numAtoms);
+
+    for (int i = 0; i < numAtoms; i++)
+    {
+        x[i] = RVec(0.1*i, 0.01*frame, 1.0);
+    }
+
+    return x;
+}
+
+void writeTestXtcFrames(const std::string &fn, const char *mode,
+                        int numAtoms, int firstFrame, int numFrames)
+{
+    matrix    box = {{2, 0, 0}, {0, 2, 0}, {0, 0, 2}};
+    t_fileio *fio = open_xtc(fn.c_str(), mode);
+
+    for (int frame = firstFrame; frame < firstFrame + numFrames; frame++)
+    {
+        std::vector<RVec> x = testTrajectoryCoordinates(numAtoms, frame);
+        write_xtc(fio, numAtoms, frame, 2*frame, box, as_rvec_array(x.data()), 1000);
+    }
+    close_xtc(fio);
+}
+
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,75 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Helpers for writing the test trajectories of the fileio tests.
+ *
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_TESTS_TESTTRAJECTORY_H
+#define GMX_FILEIO_TESTS_TESTTRAJECTORY_H
+
+#include <string>
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+
+namespace gmx
+{
+namespace test
+{
+
+/*! \brief
+ * Returns the coordinates of frame \p frame of the test trajectories
+ *
+ * Atom i is at (0.1 i, 0.01 frame, 1), so the frame can be identified
+ * from the y coordinate of any atom.
+ */
+std::vector<RVec> testTrajectoryCoordinates(int numAtoms, int frame);
+
+/*! \brief
+ * Writes test trajectory frames to the xtc file \p fn
+ *
+ * Frames \p firstFrame to \p firstFrame + \p numFrames - 1 are written
+ * with step frame and time 2 frame in a cubic box with 2 nm edges.
+ * \p mode is passed to open_xtc(), so "a" appends to an existing file.
+ */
+void writeTestXtcFrames(const std::string &fn, const char *mode,
+                        int numAtoms, int firstFrame, int numFrames);
+
+} // namespace test
+} // namespace gmx
+
+#endif
@@ -44,13 +44,22 @@
 #include "gromacs/fileio/tngio.h"
 
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/trajectory/trajectoryframe.h"
 #include "gromacs/utility/path.h"
+#include "gromacs/utility/smalloc.h"
 
+#include "testutils/testasserts.h"
 #include "testutils/testfilemanager.h"
 
+#include "testtrajectory.h"
+
 namespace
 {
 
@@ -78,4 +87,52 @@ TEST_F(TngTest, CloseBeforeOpenIsNotFatal)
     gmx_tng_close(&tng);
 }
 
+TEST_F(TngTest, WriteThreadWritesAllFrames)
+{
+    const int                numAtoms  = 6;
+    const int                numFrames = 25;
+    std::string              fn        = fileManager_.getTemporaryFilePath(".tng");
+    std::vector<gmx::RVec>   x(numAtoms);
+    matrix                   box       = {{3, 0, 0}, {0, 3, 0}, {0, 0, 3}};
+    tng_trajectory_t         input, tng;
+    t_inputrec               ir;
+    gmx_tng_write_settings_t settings;
+
+    /* Take the molecules from an existing file, and write every step
+     * in frame sets smaller than the number of frames */
+    gmx_tng_open(fileManager_.getInputFilePath("spc2-traj.tng").c_str(), 'r', &input);
+    gmx_prepare_tng_writing(fn.c_str(), 'w', &input, &tng, numAtoms,
+                            nullptr, nullptr, nullptr);
+    gmx_tng_close(&input);
+    ir.nstxout                 = 1;
+    ir.delta_t                 = 0.5;
+    gmx_tng_write_settings_init(&settings);
+    settings.framesPerFrameSet = 10;
+    settings.bThreadedWriting  = TRUE;
+    gmx_tng_prepare_md_writing(tng, nullptr, &ir, &settings);
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        x = gmx::test::testTrajectoryCoordinates(numAtoms, frame);
+        gmx_fwrite_tng(tng, FALSE, frame, 0.5*frame, 0, box, numAtoms,
+                       as_rvec_array(x.data()), nullptr, nullptr);
+    }
+    // Closing writes the queued frames and the last frame set
+    gmx_tng_close(&tng);
+
+    t_trxframe fr;
+    clear_trxframe(&fr, TRUE);
+    fr.step = -1;
+    gmx_tng_open(fn.c_str(), 'r', &tng);
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        ASSERT_TRUE(gmx_read_next_tng_frame(tng, &fr, nullptr, 0));
+        EXPECT_EQ(frame, fr.step);
+        ASSERT_TRUE(fr.bX);
+        EXPECT_REAL_EQ_TOL(0.01*frame, fr.x[numAtoms - 1][YY],
+                           gmx::test::defaultRealTolerance());
+    }
+    gmx_tng_close(&tng);
+    sfree(fr.x);
+}
+
 } // namespace
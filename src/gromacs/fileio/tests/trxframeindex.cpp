@@ -0,0 +1,262 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the trajectory frame index
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/trxframeindex.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/filetypes.h"
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/timecontrol.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/futil.h"
+
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+
+#include "testtrajectory.h"
+
+namespace
+{
+
+//! Number of atoms in the test frames, more than the uncompressed xtc limit
+const int c_numAtoms = 20;
+
+//! The step and time of a frame
+typedef std::pair<gmx_int64_t, real> StepAndTime;
+
+class TrxFrameIndexTest : public ::testing::Test
+{
+    public:
+        TrxFrameIndexTest() : x_(gmx::test::testTrajectoryCoordinates(c_numAtoms, 0)),
+                              box_ {{2, 0, 0}, {0, 2, 0}, {0, 0, 2}}
+        {
+        }
+        ~TrxFrameIndexTest()
+        {
+            unsetTimeValue(TBEGIN);
+            unsetTimeValue(TEND);
+            unsetTimeValue(TDELTA);
+        }
+        //! Writes xtc frames firstFrame to firstFrame + numFrames - 1 at time 2*frame
+        void writeXtcFrames(const std::string &fn, const char *mode, int firstFrame, int numFrames)
+        {
+            gmx::test::writeTestXtcFrames(fn, mode, c_numAtoms, firstFrame, numFrames);
+        }
+
+        /*! \brief Reads fn with read_first_frame() and read_next_frame()
+         *
+         * Returns the steps and times of the frames read. For xtc files,
+         * also checks that the coordinates are those of the frame.
+         */
+        std::vector<StepAndTime> readFrames(const std::string &fn, int flags)
+        {
+            gmx_output_env_t        *oenv;
+            t_trxstatus             *status;
+            t_trxframe               fr;
+            std::vector<StepAndTime> frames;
+
+            output_env_init_default(&oenv);
+            if (read_first_frame(oenv, &status, fn.c_str(), &fr, flags))
+            {
+                do
+                {
+                    frames.push_back(StepAndTime(fr.step, fr.time));
+                    if (fn2ftp(fn.c_str()) == efXTC)
+                    {
+                        EXPECT_REAL_EQ_TOL(0.01*fr.step, fr.x[c_numAtoms - 1][YY],
+                                           gmx::test::absoluteTolerance(0.001));
+                    }
+                }
+                while (read_next_frame(oenv, status, &fr));
+            }
+            close_trx(status);
+            done_frame(&fr);
+            output_env_done(oenv);
+
+            return frames;
+        }
+        /*! \brief Checks that the current time selection reads the same frames as sequential reading
+         *
+         * A time selection with -b or -dt uses the frame index, so we
+         * compare with all frames that pass the selection in a sequential
+         * read without a time selection.
+         */
+        void checkSkippedFrames(const std::string &fn, int flags,
+                                real tBegin, real tEnd, real tDelta)
+        {
+            std::vector<StepAndTime> allFrames = readFrames(fn, flags);
+            ASSERT_FALSE(allFrames.empty());
+
+            setTimeValue(TBEGIN, tBegin);
+            setTimeValue(TEND, tEnd);
+            setTimeValue(TDELTA, tDelta);
+            std::vector<StepAndTime> expected;
+            for (const StepAndTime &frame : allFrames)
+            {
+                if (check_times2(frame.second, allFrames[0].second, FALSE) == 0)
+                {
+                    expected.push_back(frame);
+                }
+            }
+            EXPECT_EQ(expected, readFrames(fn, flags));
+
+            unsetTimeValue(TBEGIN);
+            unsetTimeValue(TEND);
+            unsetTimeValue(TDELTA);
+        }
+
+        gmx::test::TestFileManager fileManager_;
+        std::vector<gmx::RVec>     x_;
+        matrix                     box_;
+};
+
+TEST_F(TrxFrameIndexTest, IndexesXtcFrames)
+{
+    std::string fn = fileManager_.getTemporaryFilePath(".xtc");
+    fileManager_.getTemporaryFilePath(".xtc" TRXFRAMEINDEX_SUFFIX);
+    writeXtcFrames(fn, "w", 0, 5);
+
+    t_trxframeindex *index = trxframeindex_open(fn.c_str(), efXTC, TRUE);
+    ASSERT_NE(nullptr, index);
+    ASSERT_EQ(5, index->nframes);
+    EXPECT_EQ(0, index->frame[0].offset);
+    for (int i = 0; i < index->nframes; i++)
+    {
+        EXPECT_EQ(2*i, index->frame[i].time);
+        EXPECT_EQ(TRXFRAMEINDEX_X, index->frame[i].flags);
+        if (i > 0)
+        {
+            EXPECT_LT(index->frame[i - 1].offset, index->frame[i].offset);
+        }
+    }
+    trxframeindex_done(index);
+    EXPECT_TRUE(gmx_fexist((fn + TRXFRAMEINDEX_SUFFIX).c_str()));
+}
+
+TEST_F(TrxFrameIndexTest, ExtendsCachedIndexAfterAppending)
+{
+    std::string fn = fileManager_.getTemporaryFilePath(".xtc");
+    fileManager_.getTemporaryFilePath(".xtc" TRXFRAMEINDEX_SUFFIX);
+    writeXtcFrames(fn, "w", 0, 3);
+    trxframeindex_done(trxframeindex_open(fn.c_str(), efXTC, TRUE));
+    writeXtcFrames(fn, "a", 3, 2);
+
+    t_trxframeindex *index = trxframeindex_open(fn.c_str(), efXTC, TRUE);
+    ASSERT_NE(nullptr, index);
+    ASSERT_EQ(5, index->nframes);
+    for (int i = 0; i < index->nframes; i++)
+    {
+        EXPECT_EQ(2*i, index->frame[i].time);
+    }
+    trxframeindex_done(index);
+}
+
+TEST_F(TrxFrameIndexTest, IndexesTrrFrameContents)
+{
+    std::string fn = fileManager_.getTemporaryFilePath(".trr");
+    fileManager_.getTemporaryFilePath(".trr" TRXFRAMEINDEX_SUFFIX);
+    t_fileio   *fio = gmx_trr_open(fn.c_str(), "w");
+    gmx_trr_write_frame(fio, 0, 0, 0, box_, c_numAtoms, as_rvec_array(x_.data()), nullptr, nullptr);
+    gmx_trr_write_frame(fio, 1, 1, 0, box_, c_numAtoms, nullptr, as_rvec_array(x_.data()), nullptr);
+    gmx_trr_write_frame(fio, 2, 2, 0, box_, c_numAtoms, as_rvec_array(x_.data()), nullptr, as_rvec_array(x_.data()));
+    gmx_trr_close(fio);
+
+    t_trxframeindex *index = trxframeindex_open(fn.c_str(), efTRR, TRUE);
+    ASSERT_NE(nullptr, index);
+    ASSERT_EQ(3, index->nframes);
+    EXPECT_EQ(TRXFRAMEINDEX_X, index->frame[0].flags & ~TRXFRAMEINDEX_DOUBLE);
+    EXPECT_EQ(TRXFRAMEINDEX_V, index->frame[1].flags & ~TRXFRAMEINDEX_DOUBLE);
+    EXPECT_EQ(TRXFRAMEINDEX_X | TRXFRAMEINDEX_F, index->frame[2].flags & ~TRXFRAMEINDEX_DOUBLE);
+    EXPECT_EQ(2, index->frame[2].time);
+    trxframeindex_done(index);
+}
+
+TEST_F(TrxFrameIndexTest, DoesNotWriteCacheWhenNotRequested)
+{
+    std::string fn = fileManager_.getTemporaryFilePath(".xtc");
+    writeXtcFrames(fn, "w", 0, 3);
+
+    t_trxframeindex *index = trxframeindex_open(fn.c_str(), efXTC, FALSE);
+    ASSERT_NE(nullptr, index);
+    EXPECT_EQ(3, index->nframes);
+    trxframeindex_done(index);
+    EXPECT_FALSE(gmx_fexist((fn + TRXFRAMEINDEX_SUFFIX).c_str()));
+}
+
+TEST_F(TrxFrameIndexTest, SkipsXtcFramesLikeSequentialReading)
+{
+    std::string fn = fileManager_.getTemporaryFilePath(".xtc");
+    writeXtcFrames(fn, "w", 0, 20);
+
+    checkSkippedFrames(fn, TRX_NEED_X, 5, 1000, 2);
+    checkSkippedFrames(fn, TRX_NEED_X, 0, 1000, 6);
+    checkSkippedFrames(fn, TRX_NEED_X, 5, 31, 6);
+    checkSkippedFrames(fn, TRX_NEED_X, 100, 1000, 2);
+}
+
+TEST_F(TrxFrameIndexTest, SkipsTrrFramesLikeSequentialReading)
+{
+    std::string fn  = fileManager_.getTemporaryFilePath(".trr");
+    t_fileio   *fio = gmx_trr_open(fn.c_str(), "w");
+    for (int frame = 0; frame < 20; frame++)
+    {
+        /* Only every third frame has velocities */
+        const rvec *v = (frame % 3 == 0 ? as_rvec_array(x_.data()) : nullptr);
+        gmx_trr_write_frame(fio, frame, 2*frame, 0, box_, c_numAtoms, as_rvec_array(x_.data()), v, nullptr);
+    }
+    gmx_trr_close(fio);
+
+    checkSkippedFrames(fn, TRX_NEED_X, 5, 1000, 2);
+    checkSkippedFrames(fn, TRX_NEED_V, 5, 1000, 2);
+    checkSkippedFrames(fn, TRX_NEED_V, 0, 31, 4);
+    checkSkippedFrames(fn, TRX_NEED_X | TRX_NEED_V, 7, 1000, 6);
+}
+
+} // namespace
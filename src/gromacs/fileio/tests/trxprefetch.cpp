@@ -0,0 +1,168 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for reading trajectory frames ahead
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/trxprefetch.h"
+
+#include <cstdio>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+
+#include "testtrajectory.h"
+
+namespace
+{
+
+//! Number of atoms in the test frames
+const int c_numAtoms = 20;
+//! Number of frames in the test trajectory
+const int c_numFrames = 10;
+
+//! Read function for the prefetcher that reads xtc frames
+gmx_bool readXtcFrame(void *data, t_trxframe *fr)
+{
+    gmx_bool bOK;
+
+    if (fr->x == nullptr)
+    {
+        snew(fr->x, fr->natoms);
+    }
+    fr->bX = read_next_xtc(static_cast<t_fileio *>(data), fr->natoms, &fr->step, &fr->time,
+                           fr->box, fr->x, &fr->prec, &bOK);
+    fr->bTime = fr->bX;
+
+    return fr->bX;
+}
+
+class TrxPrefetchTest : public ::testing::Test
+{
+    public:
+        TrxPrefetchTest() : fn_(fileManager_.getTemporaryFilePath(".xtc"))
+        {
+            gmx::test::writeTestXtcFrames(fn_, "w", c_numAtoms, 0, c_numFrames);
+        }
+
+        gmx::test::TestFileManager fileManager_;
+        std::string                fn_;
+};
+
+TEST_F(TrxPrefetchTest, ReturnsFramesInOrder)
+{
+    t_fileio      *fio = open_xtc(fn_.c_str(), "r");
+    t_trxprefetch *pf  = trxprefetch_init(3, c_numAtoms, fio, readXtcFrame, fio);
+    t_trxframe     fr;
+
+    clear_trxframe(&fr, TRUE);
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        ASSERT_TRUE(trxprefetch_next(pf, &fr));
+        ASSERT_TRUE(fr.bX);
+        ASSERT_NE(nullptr, fr.x);
+        EXPECT_EQ(frame, fr.step);
+        EXPECT_EQ(2*frame, fr.time);
+        EXPECT_REAL_EQ_TOL(0.01*frame, fr.x[c_numAtoms - 1][YY], gmx::test::absoluteTolerance(0.001));
+    }
+    EXPECT_FALSE(trxprefetch_next(pf, &fr));
+    EXPECT_FALSE(trxprefetch_next(pf, &fr));
+    trxprefetch_done(pf);
+    done_frame(&fr);
+    close_xtc(fio);
+}
+
+TEST_F(TrxPrefetchTest, ReturnsOffsetAfterLastReturnedFrame)
+{
+    t_fileio      *fio = open_xtc(fn_.c_str(), "r");
+    t_trxprefetch *pf  = trxprefetch_init(4, c_numAtoms, fio, readXtcFrame, fio);
+    t_trxframe     fr;
+
+    clear_trxframe(&fr, TRUE);
+    ASSERT_TRUE(trxprefetch_next(pf, &fr));
+    ASSERT_TRUE(trxprefetch_next(pf, &fr));
+    gmx_fio_seek(fio, trxprefetch_done(pf));
+
+    /* Reading without the prefetcher continues with the third frame */
+    EXPECT_TRUE(readXtcFrame(fio, &fr));
+    EXPECT_EQ(2, fr.step);
+    done_frame(&fr);
+    close_xtc(fio);
+}
+
+TEST_F(TrxPrefetchTest, RethrowsReadErrorsOnTheConsumerThread)
+{
+    /* Append data that does not start with the xtc magic number */
+    FILE *fp = gmx_ffopen(fn_.c_str(), "ab");
+    for (int i = 0; i < 64; i++)
+    {
+        std::fputc(1, fp);
+    }
+    gmx_ffclose(fp);
+
+    t_fileio      *fio = open_xtc(fn_.c_str(), "r");
+    t_trxprefetch *pf  = trxprefetch_init(3, c_numAtoms, fio, readXtcFrame, fio);
+    t_trxframe     fr;
+
+    clear_trxframe(&fr, TRUE);
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        ASSERT_TRUE(trxprefetch_next(pf, &fr));
+    }
+    EXPECT_THROW_GMX(trxprefetch_next(pf, &fr), gmx::FileIOError);
+    EXPECT_THROW_GMX(trxprefetch_next(pf, &fr), gmx::FileIOError);
+    trxprefetch_done(pf);
+    done_frame(&fr);
+    close_xtc(fio);
+}
+
+} // namespace
@@ -92,3 +92,12 @@ void setTimeValue(int tcontrol, real value)
     timecontrol[tcontrol].bSet = TRUE;
     tMPI_Thread_mutex_unlock(&tc_mutex);
 }
+
+void unsetTimeValue(int tcontrol)
+{
+    tMPI_Thread_mutex_lock(&tc_mutex);
+    range_check(tcontrol, 0, TNR);
+    timecontrol[tcontrol].t    = 0;
+    timecontrol[tcontrol].bSet = FALSE;
+    tMPI_Thread_mutex_unlock(&tc_mutex);
+}
@@ -41,8 +41,13 @@
 #include <cmath>
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #if GMX_USE_TNG
@@ -51,12 +56,14 @@
 
 #include "gromacs/math/units.h"
 #include "gromacs/math/utilities.h"
+#include "gromacs/math/vec.h"
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/topology/ifunc.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/trajectory/trajectoryframe.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/baseversion.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
@@ -87,6 +94,367 @@ static const char *modeToVerb(char mode)
     return p;
 }
 
+const char *etngcomp_names[etngcompNR] = { "gzip", "none" };
+
+void gmx_tng_write_settings_init(gmx_tng_write_settings_t *settings)
+{
+    settings->framesPerFrameSet = 0;
+    settings->compression       = etngcompGZIP;
+    settings->bThreadedWriting  = TRUE;
+}
+
+#if GMX_USE_TNG
+/*! \brief Write a frame to a TNG file, see gmx_fwrite_tng
+ *
+ * Returns FALSE when writing failed. */
+static gmx_bool tng_write_frame(tng_trajectory_t tng,
+                                const gmx_bool   bUseLossyCompression,
+                                gmx_int64_t      step,
+                                real             elapsedPicoSeconds,
+                                real             lambda,
+                                const rvec      *box,
+                                int              nAtoms,
+                                const rvec      *x,
+                                const rvec      *v,
+                                const rvec      *f)
+{
+    typedef tng_function_status (*write_data_func_pointer)(tng_trajectory_t,
+                                                           const gmx_int64_t,
+                                                           const double,
+                                                           const real*,
+                                                           const gmx_int64_t,
+                                                           const gmx_int64_t,
+                                                           const char*,
+                                                           const char,
+                                                           const char);
+#if GMX_DOUBLE
+    static write_data_func_pointer           write_data           = tng_util_generic_with_time_double_write;
+#else
+    static write_data_func_pointer           write_data           = tng_util_generic_with_time_write;
+#endif
+    double                                   elapsedSeconds = elapsedPicoSeconds * PICO;
+    gmx_int64_t                              nParticles;
+    char                                     compression;
+
+
+    tng_num_particles_get(tng, &nParticles);
+    if (nAtoms != (int)nParticles)
+    {
+        tng_implicit_num_particles_set(tng, nAtoms);
+    }
+
+    if (bUseLossyCompression)
+    {
+        compression = TNG_TNG_COMPRESSION;
+    }
+    else
+    {
+        compression = TNG_GZIP_COMPRESSION;
+    }
+
+    /* The writing is done using write_data, which writes float or double
+     * depending on the GROMACS compilation. */
+    if (x)
+    {
+        GMX_ASSERT(box, "Need a non-NULL box if positions are written");
+
+        if (write_data(tng, step, elapsedSeconds,
+                       reinterpret_cast<const real *>(x),
+                       3, TNG_TRAJ_POSITIONS, "POSITIONS",
+                       TNG_PARTICLE_BLOCK_DATA,
+                       compression) != TNG_SUCCESS)
+        {
+            return FALSE;
+        }
+    }
+
+    if (v)
+    {
+        if (write_data(tng, step, elapsedSeconds,
+                       reinterpret_cast<const real *>(v),
+                       3, TNG_TRAJ_VELOCITIES, "VELOCITIES",
+                       TNG_PARTICLE_BLOCK_DATA,
+                       compression) != TNG_SUCCESS)
+        {
+            return FALSE;
+        }
+    }
+
+    if (f)
+    {
+        /* TNG-MF1 compression only compresses positions and velocities. Use lossless
+         * compression for forces regardless of output mode */
+        if (write_data(tng, step, elapsedSeconds,
+                       reinterpret_cast<const real *>(f),
+                       3, TNG_TRAJ_FORCES, "FORCES",
+                       TNG_PARTICLE_BLOCK_DATA,
+                       TNG_GZIP_COMPRESSION) != TNG_SUCCESS)
+        {
+            return FALSE;
+        }
+    }
+
+    /* TNG-MF1 compression only compresses positions and velocities. Use lossless
+     * compression for lambdas and box shape regardless of output mode */
+    if (write_data(tng, step, elapsedSeconds,
+                   reinterpret_cast<const real *>(box),
+                   9, TNG_TRAJ_BOX_SHAPE, "BOX SHAPE",
+                   TNG_NON_PARTICLE_BLOCK_DATA,
+                   TNG_GZIP_COMPRESSION) != TNG_SUCCESS)
+    {
+        return FALSE;
+    }
+
+    if (write_data(tng, step, elapsedSeconds,
+                   reinterpret_cast<const real *>(&lambda),
+                   1, TNG_GMX_LAMBDA, "LAMBDAS",
+                   TNG_NON_PARTICLE_BLOCK_DATA,
+                   TNG_GZIP_COMPRESSION) != TNG_SUCCESS)
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+namespace
+{
+
+//! Maximum number of frames queued for a TNG writing thread
+const size_t c_maxQueuedTngFrames = 10;
+
+/*! \brief A copy of the frame data passed to gmx_fwrite_tng */
+struct TngQueuedFrame
+{
+    gmx_bool               bUseLossyCompression;
+    gmx_int64_t            step;
+    real                   elapsedPicoSeconds;
+    real                   lambda;
+    matrix                 box;
+    int                    nAtoms;
+    bool                   haveBox, haveX, haveV, haveF;
+    std::vector<gmx::RVec> x, v, f;
+};
+
+/*! \brief Thread that makes the TNG library calls for queued frames
+ *
+ * The TNG library compresses and writes a frame set when it is full,
+ * which takes long for large frame sets. Doing that here keeps the
+ * simulation from stalling at frame-set boundaries. All library calls
+ * on the trajectory are made by this thread while it exists; callers
+ * in other threads should first wait for the queue to drain.
+ * After a failed write, the remaining queued frames are discarded and
+ * push() and drain() return false. The caller should then remove and
+ * join the thread before reporting the error, since reporting might
+ * exit and destroy the thread while mutex_ is held.
+ */
+class TngWriteThread
+{
+    public:
+        explicit TngWriteThread(tng_trajectory_t tng) :
+            tng_(tng), bBusy_(false), bStop_(false), bFailed_(false),
+            thread_(&TngWriteThread::run, this)
+        {
+        }
+        ~TngWriteThread()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                bStop_ = true;
+            }
+            cond_.notify_all();
+            thread_.join();
+        }
+
+        //! Copies the frame data and queues the frame for writing, returns false when writing failed
+        bool push(const gmx_bool bUseLossyCompression, gmx_int64_t step,
+                  real elapsedPicoSeconds, real lambda, const rvec *box,
+                  int nAtoms, const rvec *x, const rvec *v, const rvec *f)
+        {
+            TngQueuedFrame frame;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this]{ return bFailed_ || queue_.size() < c_maxQueuedTngFrames; });
+                if (bFailed_)
+                {
+                    return false;
+                }
+                /* Reuse the buffers of written frames */
+                if (!spare_.empty())
+                {
+                    frame = std::move(spare_.back());
+                    spare_.pop_back();
+                }
+            }
+
+            frame.bUseLossyCompression = bUseLossyCompression;
+            frame.step                 = step;
+            frame.elapsedPicoSeconds   = elapsedPicoSeconds;
+            frame.lambda               = lambda;
+            frame.haveBox = (box != nullptr);
+            if (box)
+            {
+                copy_mat(box, frame.box);
+            }
+            frame.nAtoms = nAtoms;
+            frame.haveX  = (x != nullptr);
+            frame.haveV  = (v != nullptr);
+            frame.haveF  = (f != nullptr);
+            copyVector(x, nAtoms, &frame.x);
+            copyVector(v, nAtoms, &frame.v);
+            copyVector(f, nAtoms, &frame.f);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queue_.push_back(std::move(frame));
+            }
+            cond_.notify_all();
+
+            return true;
+        }
+
+        //! Waits until all queued frames have been written, returns false when writing failed
+        bool drain()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this]{ return bFailed_ || (queue_.empty() && !bBusy_); });
+
+            return !bFailed_;
+        }
+
+    private:
+        //! Copies n rvecs from src into dest, when src is not NULL
+        static void copyVector(const rvec *src, int n, std::vector<gmx::RVec> *dest)
+        {
+            if (src != nullptr)
+            {
+                dest->assign(src, src + n);
+            }
+        }
+
+        //! The loop of the writing thread
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true)
+            {
+                cond_.wait(lock, [this]{ return bStop_ || !queue_.empty(); });
+                if (queue_.empty())
+                {
+                    break;
+                }
+                TngQueuedFrame frame = std::move(queue_.front());
+                queue_.pop_front();
+                if (bFailed_)
+                {
+                    spare_.push_back(std::move(frame));
+                    continue;
+                }
+                bBusy_ = true;
+                lock.unlock();
+
+                gmx_bool bOK = tng_write_frame(tng_, frame.bUseLossyCompression, frame.step,
+                                               frame.elapsedPicoSeconds, frame.lambda,
+                                               frame.haveBox ? frame.box : nullptr, frame.nAtoms,
+                                               frame.haveX ? as_rvec_array(frame.x.data()) : nullptr,
+                                               frame.haveV ? as_rvec_array(frame.v.data()) : nullptr,
+                                               frame.haveF ? as_rvec_array(frame.f.data()) : nullptr);
+
+                lock.lock();
+                bBusy_ = false;
+                if (!bOK)
+                {
+                    bFailed_ = true;
+                }
+                spare_.push_back(std::move(frame));
+                cond_.notify_all();
+            }
+        }
+
+        tng_trajectory_t            tng_;
+        std::mutex                  mutex_;
+        std::condition_variable     cond_;
+        std::deque<TngQueuedFrame>  queue_;
+        std::vector<TngQueuedFrame> spare_;
+        bool                        bBusy_;
+        bool                        bStop_;
+        bool                        bFailed_;
+        std::thread                 thread_;
+};
+
+//! Protects tngWriteThreads
+std::mutex                                                   tngWriteThreadsMutex;
+//! The writing threads of the trajectories that use threaded writing
+std::map<tng_trajectory_t, std::unique_ptr<TngWriteThread> > tngWriteThreads;
+
+//! Returns the writing thread of tng, or nullptr when it has none
+TngWriteThread *getTngWriteThread(tng_trajectory_t tng)
+{
+    std::lock_guard<std::mutex> lock(tngWriteThreadsMutex);
+    auto                        it = tngWriteThreads.find(tng);
+
+    return (it != tngWriteThreads.end() ? it->second.get() : nullptr);
+}
+
+//! Removes the writing thread of tng from tngWriteThreads and returns it, can return nullptr
+std::unique_ptr<TngWriteThread> removeTngWriteThread(tng_trajectory_t tng)
+{
+    std::unique_ptr<TngWriteThread> writeThread;
+    std::lock_guard<std::mutex>     lock(tngWriteThreadsMutex);
+    auto                            it = tngWriteThreads.find(tng);
+
+    if (it != tngWriteThreads.end())
+    {
+        writeThread = std::move(it->second);
+        tngWriteThreads.erase(it);
+    }
+
+    return writeThread;
+}
+
+//! Throws the error for a failed frame write of tng
+gmx_noreturn void throwTngWriteError()
+{
+    GMX_THROW(gmx::FileIOError("Cannot write TNG trajectory frame; maybe you are out of disk space?"));
+}
+
+/*! \brief Stops and joins the writing thread of tng after a failed write and throws
+ *
+ * No locks are held here, so the static tngWriteThreads can be
+ * destroyed during the exit after the error without deadlocking.
+ */
+gmx_noreturn void stopFailedTngWriteThread(tng_trajectory_t tng)
+{
+    removeTngWriteThread(tng).reset();
+    throwTngWriteError();
+}
+
+//! Waits until all frames queued for tng, if any, have been written
+void drainTngWriteThread(tng_trajectory_t tng)
+{
+    TngWriteThread *writeThread = getTngWriteThread(tng);
+
+    if (writeThread != nullptr && !writeThread->drain())
+    {
+        stopFailedTngWriteThread(tng);
+    }
+}
+
+/*! \brief Stops the writing thread of tng, if any, after writing all queued frames
+ *
+ * \returns false when writing a frame failed.
+ */
+bool stopTngWriteThread(tng_trajectory_t tng)
+{
+    std::unique_ptr<TngWriteThread> writeThread = removeTngWriteThread(tng);
+
+    return (writeThread == nullptr || writeThread->drain());
+}
+
+} // namespace
+#endif
+
 void gmx_tng_open(const char       *filename,
                   char              mode,
                   tng_trajectory_t *tng)
@@ -174,7 +542,12 @@ void gmx_tng_close(tng_trajectory_t *tng)
 #if GMX_USE_TNG
     if (tng)
     {
+        bool bWriteOK = stopTngWriteThread(*tng);
         tng_util_trajectory_close(tng);
+        if (!bWriteOK)
+        {
+            throwTngWriteError();
+        }
     }
 #else
     GMX_UNUSED_VALUE(tng);
@@ -368,7 +741,8 @@ const int defaultFramesPerFrameSet = 100;
  * that is written most often. */
 static void tng_set_frames_per_frame_set(tng_trajectory_t  tng,
                                          const gmx_bool    bUseLossyCompression,
-                                         const t_inputrec *ir)
+                                         const t_inputrec *ir,
+                                         int               framesPerFrameSet)
 {
     int     gcd = -1;
 
@@ -390,14 +764,19 @@ static void tng_set_frames_per_frame_set(tng_trajectory_t  tng,
         return;
     }
 
-    tng_num_frames_per_frame_set_set(tng, gcd * defaultFramesPerFrameSet);
+    if (framesPerFrameSet <= 0)
+    {
+        framesPerFrameSet = defaultFramesPerFrameSet;
+    }
+    tng_num_frames_per_frame_set_set(tng, gcd * framesPerFrameSet);
 }
 
 /*! \libinternal \brief Set the data-writing intervals, and number of
  * frames per frame set */
-static void set_writing_intervals(tng_trajectory_t  tng,
-                                  const gmx_bool    bUseLossyCompression,
-                                  const t_inputrec *ir)
+static void set_writing_intervals(tng_trajectory_t                tng,
+                                  const gmx_bool                  bUseLossyCompression,
+                                  const t_inputrec               *ir,
+                                  const gmx_tng_write_settings_t *settings)
 {
     /* Define pointers to specific writing functions depending on if we
      * write float or double data */
@@ -415,9 +794,12 @@ static void set_writing_intervals(tng_trajectory_t  tng,
 #endif
     int  xout, vout, fout;
     int  gcd = -1, lowest = -1;
-    char compression;
+    char compression, losslessCompression;
 
-    tng_set_frames_per_frame_set(tng, bUseLossyCompression, ir);
+    tng_set_frames_per_frame_set(tng, bUseLossyCompression, ir,
+                                 settings->framesPerFrameSet);
+    losslessCompression = (settings->compression == etngcompNONE ?
+                           TNG_UNCOMPRESSED : TNG_GZIP_COMPRESSION);
 
     if (bUseLossyCompression)
     {
@@ -442,7 +824,7 @@ static void set_writing_intervals(tng_trajectory_t  tng,
         xout        = ir->nstxout;
         vout        = ir->nstvout;
         fout        = ir->nstfout;
-        compression = TNG_GZIP_COMPRESSION;
+        compression = losslessCompression;
     }
     if (xout)
     {
@@ -477,7 +859,7 @@ static void set_writing_intervals(tng_trajectory_t  tng,
     {
         set_writing_interval(tng, fout, 3, TNG_TRAJ_FORCES,
                              "FORCES", TNG_PARTICLE_BLOCK_DATA,
-                             TNG_GZIP_COMPRESSION);
+                             losslessCompression);
 
         gcd = greatest_common_divisor_if_positive(gcd, fout);
         if (lowest < 0 || fout < lowest)
@@ -491,11 +873,11 @@ static void set_writing_intervals(tng_trajectory_t  tng,
            denominator of other output */
         set_writing_interval(tng, gcd, 1, TNG_GMX_LAMBDA,
                              "LAMBDAS", TNG_NON_PARTICLE_BLOCK_DATA,
-                             TNG_GZIP_COMPRESSION);
+                             losslessCompression);
 
         set_writing_interval(tng, gcd, 9, TNG_TRAJ_BOX_SHAPE,
                              "BOX SHAPE", TNG_NON_PARTICLE_BLOCK_DATA,
-                             TNG_GZIP_COMPRESSION);
+                             losslessCompression);
         if (gcd < lowest / 10)
         {
             gmx_warning("The lowest common denominator of trajectory output is "
@@ -506,18 +888,31 @@ static void set_writing_intervals(tng_trajectory_t  tng,
 }
 #endif
 
-void gmx_tng_prepare_md_writing(tng_trajectory_t  tng,
-                                const gmx_mtop_t *mtop,
-                                const t_inputrec *ir)
+void gmx_tng_prepare_md_writing(tng_trajectory_t                tng,
+                                const gmx_mtop_t               *mtop,
+                                const t_inputrec               *ir,
+                                const gmx_tng_write_settings_t *settings)
 {
 #if GMX_USE_TNG
+    gmx_tng_write_settings_t defaultSettings;
+
+    if (settings == nullptr)
+    {
+        gmx_tng_write_settings_init(&defaultSettings);
+        settings = &defaultSettings;
+    }
     gmx_tng_add_mtop(tng, mtop);
-    set_writing_intervals(tng, FALSE, ir);
+    set_writing_intervals(tng, FALSE, ir, settings);
     tng_time_per_frame_set(tng, ir->delta_t * PICO);
+    if (settings->bThreadedWriting)
+    {
+        gmx_tng_start_write_thread(tng);
+    }
 #else
     GMX_UNUSED_VALUE(tng);
     GMX_UNUSED_VALUE(mtop);
     GMX_UNUSED_VALUE(ir);
+    GMX_UNUSED_VALUE(settings);
 #endif
 }
 
@@ -726,6 +1121,7 @@ void gmx_tng_set_compression_precision(tng_trajectory_t tng,
                                        real             prec)
 {
 #if GMX_USE_TNG
+    drainTngWriteThread(tng);
     tng_compression_precision_set(tng, prec);
 #else
     GMX_UNUSED_VALUE(tng);
@@ -733,20 +1129,47 @@ void gmx_tng_set_compression_precision(tng_trajectory_t tng,
 #endif
 }
 
-void gmx_tng_prepare_low_prec_writing(tng_trajectory_t  tng,
-                                      const gmx_mtop_t *mtop,
-                                      const t_inputrec *ir)
+void gmx_tng_prepare_low_prec_writing(tng_trajectory_t                tng,
+                                      const gmx_mtop_t               *mtop,
+                                      const t_inputrec               *ir,
+                                      const gmx_tng_write_settings_t *settings)
 {
 #if GMX_USE_TNG
+    gmx_tng_write_settings_t defaultSettings;
+
+    if (settings == nullptr)
+    {
+        gmx_tng_write_settings_init(&defaultSettings);
+        settings = &defaultSettings;
+    }
     gmx_tng_add_mtop(tng, mtop);
     add_selection_groups(tng, mtop);
-    set_writing_intervals(tng, TRUE, ir);
+    set_writing_intervals(tng, TRUE, ir, settings);
     tng_time_per_frame_set(tng, ir->delta_t * PICO);
     gmx_tng_set_compression_precision(tng, ir->x_compression_precision);
+    if (settings->bThreadedWriting)
+    {
+        gmx_tng_start_write_thread(tng);
+    }
 #else
     GMX_UNUSED_VALUE(tng);
     GMX_UNUSED_VALUE(mtop);
     GMX_UNUSED_VALUE(ir);
+    GMX_UNUSED_VALUE(settings);
+#endif
+}
+
+void gmx_tng_start_write_thread(tng_trajectory_t tng)
+{
+#if GMX_USE_TNG
+    std::lock_guard<std::mutex> lock(tngWriteThreadsMutex);
+
+    if (tng && tngWriteThreads.find(tng) == tngWriteThreads.end())
+    {
+        tngWriteThreads[tng].reset(new TngWriteThread(tng));
+    }
+#else
+    GMX_UNUSED_VALUE(tng);
 #endif
 }
 
@@ -762,24 +1185,7 @@ void gmx_fwrite_tng(tng_trajectory_t tng,
                     const rvec      *f)
 {
 #if GMX_USE_TNG
-    typedef tng_function_status (*write_data_func_pointer)(tng_trajectory_t,
-                                                           const gmx_int64_t,
-                                                           const double,
-                                                           const real*,
-                                                           const gmx_int64_t,
-                                                           const gmx_int64_t,
-                                                           const char*,
-                                                           const char,
-                                                           const char);
-#if GMX_DOUBLE
-    static write_data_func_pointer           write_data           = tng_util_generic_with_time_double_write;
-#else
-    static write_data_func_pointer           write_data           = tng_util_generic_with_time_write;
-#endif
-    double                                   elapsedSeconds = elapsedPicoSeconds * PICO;
-    gmx_int64_t                              nParticles;
-    char                                     compression;
-
+    TngWriteThread *writeThread;
 
     if (!tng)
     {
@@ -789,81 +1195,19 @@ void gmx_fwrite_tng(tng_trajectory_t tng,
         return;
     }
 
-    tng_num_particles_get(tng, &nParticles);
-    if (nAtoms != (int)nParticles)
-    {
-        tng_implicit_num_particles_set(tng, nAtoms);
-    }
-
-    if (bUseLossyCompression)
-    {
-        compression = TNG_TNG_COMPRESSION;
-    }
-    else
-    {
-        compression = TNG_GZIP_COMPRESSION;
-    }
-
-    /* The writing is done using write_data, which writes float or double
-     * depending on the GROMACS compilation. */
-    if (x)
+    writeThread = getTngWriteThread(tng);
+    if (writeThread != nullptr)
     {
-        GMX_ASSERT(box, "Need a non-NULL box if positions are written");
-
-        if (write_data(tng, step, elapsedSeconds,
-                       reinterpret_cast<const real *>(x),
-                       3, TNG_TRAJ_POSITIONS, "POSITIONS",
-                       TNG_PARTICLE_BLOCK_DATA,
-                       compression) != TNG_SUCCESS)
+        if (!writeThread->push(bUseLossyCompression, step, elapsedPicoSeconds, lambda,
+                               box, nAtoms, x, v, f))
         {
-            gmx_file("Cannot write TNG trajectory frame; maybe you are out of disk space?");
+            stopFailedTngWriteThread(tng);
         }
     }
-
-    if (v)
-    {
-        if (write_data(tng, step, elapsedSeconds,
-                       reinterpret_cast<const real *>(v),
-                       3, TNG_TRAJ_VELOCITIES, "VELOCITIES",
-                       TNG_PARTICLE_BLOCK_DATA,
-                       compression) != TNG_SUCCESS)
-        {
-            gmx_file("Cannot write TNG trajectory frame; maybe you are out of disk space?");
-        }
-    }
-
-    if (f)
-    {
-        /* TNG-MF1 compression only compresses positions and velocities. Use lossless
-         * compression for forces regardless of output mode */
-        if (write_data(tng, step, elapsedSeconds,
-                       reinterpret_cast<const real *>(f),
-                       3, TNG_TRAJ_FORCES, "FORCES",
-                       TNG_PARTICLE_BLOCK_DATA,
-                       TNG_GZIP_COMPRESSION) != TNG_SUCCESS)
-        {
-            gmx_file("Cannot write TNG trajectory frame; maybe you are out of disk space?");
-        }
-    }
-
-    /* TNG-MF1 compression only compresses positions and velocities. Use lossless
-     * compression for lambdas and box shape regardless of output mode */
-    if (write_data(tng, step, elapsedSeconds,
-                   reinterpret_cast<const real *>(box),
-                   9, TNG_TRAJ_BOX_SHAPE, "BOX SHAPE",
-                   TNG_NON_PARTICLE_BLOCK_DATA,
-                   TNG_GZIP_COMPRESSION) != TNG_SUCCESS)
-    {
-        gmx_file("Cannot write TNG trajectory frame; maybe you are out of disk space?");
-    }
-
-    if (write_data(tng, step, elapsedSeconds,
-                   reinterpret_cast<const real *>(&lambda),
-                   1, TNG_GMX_LAMBDA, "LAMBDAS",
-                   TNG_NON_PARTICLE_BLOCK_DATA,
-                   TNG_GZIP_COMPRESSION) != TNG_SUCCESS)
+    else if (!tng_write_frame(tng, bUseLossyCompression, step, elapsedPicoSeconds,
+                              lambda, box, nAtoms, x, v, f))
     {
-        gmx_file("Cannot write TNG trajectory frame; maybe you are out of disk space?");
+        throwTngWriteError();
     }
 #else
     GMX_UNUSED_VALUE(tng);
@@ -886,6 +1230,7 @@ void fflush_tng(tng_trajectory_t tng)
     {
         return;
     }
+    drainTngWriteThread(tng);
     tng_frame_set_premature_write(tng, TNG_USE_HASH);
 #else
     GMX_UNUSED_VALUE(tng);
@@ -899,6 +1244,7 @@ float gmx_tng_get_time_of_final_frame(tng_trajectory_t tng)
     double      time;
     float       fTime;
 
+    drainTngWriteThread(tng);
     tng_num_frames_get(tng, &nFrames);
     tng_util_time_of_frame_get(tng, nFrames - 1, &time);
 
@@ -48,6 +48,28 @@ struct tng_trajectory;
 typedef struct tng_trajectory *tng_trajectory_t;
 struct t_trxframe;
 
+/*! \brief Lossless compression algorithms for TNG data blocks */
+enum {
+    etngcompGZIP, etngcompNONE, etngcompNR
+};
+
+/*! \brief Names of the TNG lossless compression algorithms */
+extern const char *etngcomp_names[etngcompNR];
+
+/*! \brief Settings for TNG trajectory writing during MD simulations */
+typedef struct gmx_tng_write_settings_t
+{
+    //! Number of frames of the most frequent output per frame set, <= 0 for the default
+    int      framesPerFrameSet;
+    //! Compression of the lossless data blocks, from the etngcomp enum
+    int      compression;
+    //! Hand the frames to a separate thread that compresses and writes them
+    gmx_bool bThreadedWriting;
+} gmx_tng_write_settings_t;
+
+/*! \brief Set the default TNG writing settings */
+void gmx_tng_write_settings_init(gmx_tng_write_settings_t *settings);
+
 /*! \brief Open a TNG trajectory file
  *
  * \param filename   Name of file to open
@@ -75,13 +97,15 @@ void gmx_tng_add_mtop(tng_trajectory_t  tng,
 /*! \brief Do all TNG preparation for full-precision whole-system
  * trajectory writing during MD simulations.
  *
- * \param tng   Valid handle to a TNG trajectory
- * \param mtop  Global topology
- * \param ir    Input settings (for writing frequencies)
+ * \param tng      Valid handle to a TNG trajectory
+ * \param mtop     Global topology
+ * \param ir       Input settings (for writing frequencies)
+ * \param settings Frame-set size, compression and threading, NULL for the defaults
  */
-void gmx_tng_prepare_md_writing(tng_trajectory_t  tng,
-                                const gmx_mtop_t *mtop,
-                                const t_inputrec *ir);
+void gmx_tng_prepare_md_writing(tng_trajectory_t                tng,
+                                const gmx_mtop_t               *mtop,
+                                const t_inputrec               *ir,
+                                const gmx_tng_write_settings_t *settings);
 
 /*! \brief Set the default compression precision for TNG writing
  *
@@ -93,13 +117,24 @@ void gmx_tng_set_compression_precision(tng_trajectory_t tng,
 /*! \brief Do all TNG preparation for low-precision selection-based
  * trajectory writing during MD simulations.
  *
- * \param tng   Valid handle to a TNG trajectory
- * \param mtop  Global topology
- * \param ir    Input settings (for writing frequencies)
+ * \param tng      Valid handle to a TNG trajectory
+ * \param mtop     Global topology
+ * \param ir       Input settings (for writing frequencies)
+ * \param settings Frame-set size, compression and threading, NULL for the defaults.
+ *                 The positions and velocities always use lossy compression.
+ */
+void gmx_tng_prepare_low_prec_writing(tng_trajectory_t                tng,
+                                      const gmx_mtop_t               *mtop,
+                                      const t_inputrec               *ir,
+                                      const gmx_tng_write_settings_t *settings);
+
+/*! \brief Start a thread that compresses and writes the frames
+ * passed to gmx_fwrite_tng for tng. The thread is stopped by gmx_tng_close.
+ *
+ * This is done by the prepare functions when requested in their settings,
+ * call this directly when appending to a file.
  */
-void gmx_tng_prepare_low_prec_writing(tng_trajectory_t  tng,
-                                      const gmx_mtop_t *mtop,
-                                      const t_inputrec *ir);
+void gmx_tng_start_write_thread(tng_trajectory_t tng);
 
 /*! \brief Write a frame to a TNG file
  *
@@ -115,7 +150,14 @@ void gmx_tng_prepare_low_prec_writing(tng_trajectory_t  tng,
  * \param f                    Vector of forces
  *
  * The pointers tng, x, v, f may be NULL, which triggers not writing
- * (that component). box can only be NULL if x is also NULL. */
+ * (that component). box can only be NULL if x is also NULL.
+ *
+ * With threaded writing the data is copied and queued, and the TNG
+ * library calls, including the compression of full frame sets, are
+ * done on the writing thread. A failed write on that thread is thrown
+ * by the next call of gmx_fwrite_tng(), fflush_tng() or gmx_tng_close().
+ *
+ * \throws gmx::FileIOError when a frame can not be written. */
 void gmx_fwrite_tng(tng_trajectory_t tng,
                     const gmx_bool   bUseLossyCompression,
                     gmx_int64_t      step,
@@ -128,7 +170,7 @@ void gmx_fwrite_tng(tng_trajectory_t tng,
                     const rvec      *f);
 
 /*! \brief Write the current frame set to disk. Perform compression
- * etc.
+ * etc. Waits for all queued frames to be written first.
  *
  * \param tng Valid handle to a TNG trajectory
  */
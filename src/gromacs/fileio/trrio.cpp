@@ -43,9 +43,11 @@
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/gmxfio-xdr.h"
 #include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
 
 #define BUFSIZE     128
 
@@ -71,12 +73,12 @@ static int nFloatSize(gmx_trr_header_t *sh)
     }
     else
     {
-        gmx_file("Can not determine precision of trr file");
+        GMX_THROW(gmx::FileIOError("Can not determine precision of trr file"));
     }
 
     if (((nflsize != sizeof(float)) && (nflsize != sizeof(double))))
     {
-        gmx_fatal(FARGS, "Float size %d. Maybe different CPU?", nflsize);
+        GMX_THROW(gmx::FileIOError(gmx::formatString("Float size %d. Maybe different CPU?", nflsize)));
     }
 
     return nflsize;
@@ -111,8 +113,7 @@ do_trr_frame_header(t_fileio *fio, bool bRead, gmx_trr_header_t *sh, gmx_bool *b
     if (magic != magicValue)
     {
         *bOK = FALSE;
-        gmx_fatal(FARGS, "Failed to find GROMACS magic number in trr frame header, so this is not a trr file!\n");
-        return *bOK;
+        GMX_THROW(gmx::FileIOError("Failed to find GROMACS magic number in trr frame header, so this is not a trr file!"));
     }
 
     if (bRead)
@@ -299,7 +300,7 @@ void gmx_trr_write_frame(t_fileio *fio, gmx_int64_t step, real t, real lambda,
 {
     if (!do_trr_frame(fio, false, &step, &t, &lambda, const_cast<rvec *>(box), &natoms, const_cast<rvec *>(x), const_cast<rvec *>(v), const_cast<rvec *>(f)))
     {
-        gmx_file("Cannot write trajectory frame; maybe you are out of disk space?");
+        GMX_THROW(gmx::FileIOError("Cannot write trajectory frame; maybe you are out of disk space?"));
     }
 }
 
@@ -316,6 +317,15 @@ gmx_bool gmx_trr_read_frame_data(t_fileio *fio, gmx_trr_header_t *header,
     return do_trr_frame_data(fio, header, box, x, v, f);
 }
 
+gmx_bool gmx_trr_skip_frame_data(t_fileio *fio, gmx_trr_header_t *header)
+{
+    /* The sizes in the header are the XDR sizes in bytes */
+    gmx_off_t nbytes = (static_cast<gmx_off_t>(header->box_size) + header->vir_size + header->pres_size +
+                        static_cast<gmx_off_t>(header->x_size) + header->v_size + header->f_size);
+
+    return (gmx_fio_seek(fio, gmx_fio_ftell(fio) + nbytes) == 0);
+}
+
 t_fileio *gmx_trr_open(const char *fn, const char *mode)
 {
     return gmx_fio_open(fn, mode);
@@ -115,16 +115,24 @@ gmx_bool gmx_trr_read_frame_data(struct t_fileio *fio, gmx_trr_header_t *sh,
  * Return FALSE on error
  */
 
+gmx_bool gmx_trr_skip_frame_data(struct t_fileio *fio, gmx_trr_header_t *header);
+/* Seek past the data of a frame of which the header was just read,
+ * without reading the data. Return FALSE on error
+ */
+
 gmx_bool gmx_trr_read_frame(struct t_fileio *fio, gmx_int64_t *step, real *t, real *lambda,
                             rvec *box, int *natoms, rvec *x, rvec *v, rvec *f);
 /* Read a trr frame, including the header from fp. box, x, v, f may
  * be NULL, in which case the data will be skipped over.
- * return FALSE on error
+ * return FALSE on error, throws gmx::FileIOError when the frame header
+ * is corrupted.
  */
 
 void gmx_trr_write_frame(struct t_fileio *fio, gmx_int64_t step, real t, real lambda,
                          const rvec *box, int natoms, const rvec *x, const rvec *v, const rvec *f);
-/* Write a trr frame to file fp, box, x, v, f may be NULL */
+/* Write a trr frame to file fp, box, x, v, f may be NULL.
+ * Throws gmx::FileIOError when the frame can not be written.
+ */
 
 void gmx_trr_read_single_header(const char *fn, gmx_trr_header_t *header);
 /* Read the header of a trr file from fn, and close the file afterwards.
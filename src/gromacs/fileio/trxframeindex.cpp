@@ -0,0 +1,314 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+#include "gmxpre.h"
+
+#include "trxframeindex.h"
+
+#include <climits>
+#include <cstdio>
+
+#include <string>
+
+#include "gromacs/fileio/filetypes.h"
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/gmxfio-xdr.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/smalloc.h"
+
+/* Magic number and version of the cache file */
+#define TRXFRAMEINDEX_MAGIC   0x47584649
+#define TRXFRAMEINDEX_VERSION 1
+
+/* Same as in trrio.cpp */
+#define TRR_MAGIC 1993
+
+static gmx_off_t trajectory_file_size(t_fileio *fio)
+{
+    FILE     *fp = gmx_fio_getfp(fio);
+    gmx_off_t pos, size;
+
+    pos  = gmx_ftell(fp);
+    gmx_fseek(fp, 0, SEEK_END);
+    size = gmx_ftell(fp);
+    gmx_fseek(fp, pos, SEEK_SET);
+
+    return size;
+}
+
+/* Reads the header of the frame at the current file position into entry
+ * and seeks past the frame data. Returns FALSE at the end of the file or
+ * when the frame is not complete.
+ */
+static gmx_bool scan_frame(t_fileio *fio, int ftp, gmx_off_t fileSize,
+                           t_trxframeindex_entry *entry)
+{
+    entry->offset = gmx_fio_ftell(fio);
+    if (entry->offset >= fileSize)
+    {
+        return FALSE;
+    }
+
+    if (ftp == efXTC)
+    {
+        real time;
+
+        if (!xtc_skip_frame(fio, &time))
+        {
+            return FALSE;
+        }
+        entry->time  = time;
+        entry->flags = TRXFRAMEINDEX_X;
+    }
+    else
+    {
+        gmx_trr_header_t sh;
+        gmx_bool         bOK;
+        int              magic;
+
+        /* The trr header reading is fatal on a wrong magic number,
+         * but we might be looking at a stale offset from the cache.
+         */
+        if (xdr_int(gmx_fio_getxdr(fio), &magic) == 0 || magic != TRR_MAGIC ||
+            gmx_fio_seek(fio, entry->offset) != 0)
+        {
+            return FALSE;
+        }
+        if (!gmx_trr_read_frame_header(fio, &sh, &bOK) || !bOK ||
+            !gmx_trr_skip_frame_data(fio, &sh))
+        {
+            return FALSE;
+        }
+        entry->time  = sh.t;
+        entry->flags = ((sh.x_size > 0 ? TRXFRAMEINDEX_X : 0) |
+                        (sh.v_size > 0 ? TRXFRAMEINDEX_V : 0) |
+                        (sh.f_size > 0 ? TRXFRAMEINDEX_F : 0) |
+                        (sh.bDouble ? TRXFRAMEINDEX_DOUBLE : 0));
+    }
+
+    return (gmx_fio_ftell(fio) <= fileSize);
+}
+
+/* Adds all complete frames after index->end to the index */
+static void scan_trajectory(t_fileio *fio, t_trxframeindex *index, gmx_off_t fileSize)
+{
+    t_trxframeindex_entry entry;
+
+    if (gmx_fio_seek(fio, index->end) != 0)
+    {
+        return;
+    }
+    while (scan_frame(fio, index->ftp, fileSize, &entry))
+    {
+        if (index->nframes == index->nalloc)
+        {
+            index->nalloc = over_alloc_large(index->nframes + 1);
+            srenew(index->frame, index->nalloc);
+        }
+        index->frame[index->nframes++] = entry;
+        index->end                     = gmx_fio_ftell(fio);
+    }
+}
+
+/* Checks that the first and last frame of a cached index are still
+ * present in the trajectory at the recorded offsets.
+ */
+static gmx_bool check_cached_index(t_fileio *fio, const t_trxframeindex *index,
+                                   gmx_off_t fileSize)
+{
+    t_trxframeindex_entry entry;
+    int                   check[2] = { 0, index->nframes - 1 };
+
+    if (index->nframes == 0 || index->end > fileSize)
+    {
+        return FALSE;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        const t_trxframeindex_entry *cached = &index->frame[check[i]];
+
+        if (gmx_fio_seek(fio, cached->offset) != 0 ||
+            !scan_frame(fio, index->ftp, fileSize, &entry) ||
+            entry.time != cached->time || entry.flags != cached->flags)
+        {
+            return FALSE;
+        }
+    }
+
+    return (gmx_fio_ftell(fio) == index->end);
+}
+
+static gmx_bool read_cache(const char *fn, t_trxframeindex *index)
+{
+    FILE       *fp;
+    int         header[3];
+    gmx_int64_t nframes, end;
+    gmx_bool    bOK;
+
+    fp = fopen(fn, "rb");
+    if (fp == nullptr)
+    {
+        return FALSE;
+    }
+    bOK = (fread(header, sizeof(header[0]), 3, fp) == 3 &&
+           header[0] == TRXFRAMEINDEX_MAGIC &&
+           header[1] == TRXFRAMEINDEX_VERSION &&
+           header[2] == index->ftp &&
+           fread(&nframes, sizeof(nframes), 1, fp) == 1 &&
+           fread(&end, sizeof(end), 1, fp) == 1 &&
+           nframes > 0 && nframes < INT_MAX);
+    if (bOK)
+    {
+        index->nframes = nframes;
+        index->nalloc  = nframes;
+        index->end     = end;
+        snew(index->frame, index->nalloc);
+        for (int i = 0; i < index->nframes && bOK; i++)
+        {
+            t_trxframeindex_entry *entry = &index->frame[i];
+            gmx_int64_t            offset;
+
+            bOK           = (fread(&offset, sizeof(offset), 1, fp) == 1 &&
+                             fread(&entry->time, sizeof(entry->time), 1, fp) == 1 &&
+                             fread(&entry->flags, sizeof(entry->flags), 1, fp) == 1);
+            entry->offset = offset;
+        }
+    }
+    fclose(fp);
+
+    return bOK;
+}
+
+static void write_cache(const char *fn, const t_trxframeindex *index)
+{
+    FILE       *fp;
+    int         header[3] = { TRXFRAMEINDEX_MAGIC, TRXFRAMEINDEX_VERSION, index->ftp };
+    gmx_int64_t nframes   = index->nframes;
+    gmx_int64_t end       = index->end;
+    gmx_bool    bOK;
+
+    /* The cache is optional, so we silently continue without it
+     * when it can not be written, e.g. in a read-only directory.
+     */
+    fp = fopen(fn, "wb");
+    if (fp == nullptr)
+    {
+        if (debug)
+        {
+            fprintf(debug, "Could not write the trajectory frame index %s\n", fn);
+        }
+        return;
+    }
+    bOK = (fwrite(header, sizeof(header[0]), 3, fp) == 3 &&
+           fwrite(&nframes, sizeof(nframes), 1, fp) == 1 &&
+           fwrite(&end, sizeof(end), 1, fp) == 1);
+    for (int i = 0; i < index->nframes && bOK; i++)
+    {
+        const t_trxframeindex_entry *entry  = &index->frame[i];
+        gmx_int64_t                  offset = entry->offset;
+
+        bOK = (fwrite(&offset, sizeof(offset), 1, fp) == 1 &&
+               fwrite(&entry->time, sizeof(entry->time), 1, fp) == 1 &&
+               fwrite(&entry->flags, sizeof(entry->flags), 1, fp) == 1);
+    }
+    if (fclose(fp) != 0 || !bOK)
+    {
+        /* Don't leave a truncated cache behind */
+        remove(fn);
+    }
+}
+
+t_trxframeindex *trxframeindex_open(const char *fn, int ftp, gmx_bool bUseCache)
+{
+    t_trxframeindex *index;
+    t_fileio        *fio;
+    gmx_off_t        fileSize;
+    gmx_bool         bCached;
+    int              nframesCached;
+
+    if (ftp != efXTC && ftp != efTRR)
+    {
+        return nullptr;
+    }
+
+    std::string cacheFileName = std::string(fn) + TRXFRAMEINDEX_SUFFIX;
+
+    snew(index, 1);
+    index->ftp = ftp;
+
+    fio      = gmx_fio_open(fn, "r");
+    fileSize = trajectory_file_size(fio);
+    bCached  = (bUseCache &&
+                read_cache(cacheFileName.c_str(), index) &&
+                check_cached_index(fio, index, fileSize));
+    if (!bCached)
+    {
+        index->nframes = 0;
+        index->end     = 0;
+    }
+    nframesCached = index->nframes;
+
+    /* Index the whole file, or the frames appended since the cache was written */
+    scan_trajectory(fio, index, fileSize);
+    gmx_fio_close(fio);
+
+    if (debug)
+    {
+        fprintf(debug, "Trajectory frame index for %s: %d frames, %d from %s\n",
+                fn, index->nframes, nframesCached, cacheFileName.c_str());
+    }
+
+    if (index->nframes == 0)
+    {
+        trxframeindex_done(index);
+        return nullptr;
+    }
+    if (bUseCache && index->nframes > nframesCached)
+    {
+        write_cache(cacheFileName.c_str(), index);
+    }
+
+    return index;
+}
+
+void trxframeindex_done(t_trxframeindex *index)
+{
+    if (index)
+    {
+        sfree(index->frame);
+        sfree(index);
+    }
+}
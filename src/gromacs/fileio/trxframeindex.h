@@ -0,0 +1,85 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+#ifndef GMX_FILEIO_TRXFRAMEINDEX_H
+#define GMX_FILEIO_TRXFRAMEINDEX_H
+
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/futil.h"
+
+/* Frame offset index for random access to xtc and trr trajectories.
+ *
+ * The index stores the file offset, time and contents of each frame.
+ * It is built by reading only the frame headers. Optionally it is cached
+ * in a file with the trajectory file name plus TRXFRAMEINDEX_SUFFIX,
+ * so later reads of the same trajectory do not need to scan it again.
+ * A cached index is checked against the trajectory and extended
+ * when frames have been appended since it was written.
+ */
+
+#define TRXFRAMEINDEX_SUFFIX ".fidx"
+
+/* Flags for the contents of an indexed frame */
+#define TRXFRAMEINDEX_X       (1<<0)
+#define TRXFRAMEINDEX_V       (1<<1)
+#define TRXFRAMEINDEX_F       (1<<2)
+#define TRXFRAMEINDEX_DOUBLE  (1<<3)
+
+typedef struct {
+    gmx_off_t offset; /* File offset of the frame header */
+    double    time;   /* Time of the frame */
+    int       flags;  /* TRXFRAMEINDEX_* flags */
+} t_trxframeindex_entry;
+
+typedef struct {
+    int                    ftp;     /* The file type, efXTC or efTRR */
+    int                    nframes; /* The number of indexed frames */
+    int                    nalloc;  /* Allocation size of frame */
+    gmx_off_t              end;     /* File offset after the last frame */
+    t_trxframeindex_entry *frame;   /* The frames */
+} t_trxframeindex;
+
+t_trxframeindex *trxframeindex_open(const char *fn, int ftp, gmx_bool bUseCache);
+/* Returns the frame index for trajectory file fn of type ftp by scanning
+ * the trajectory. With bUseCache, the index is read from the cache file
+ * when it is valid and the cache file is written or extended otherwise.
+ * Returns NULL when ftp is not xtc or trr or the trajectory can not
+ * be scanned.
+ */
+
+void trxframeindex_done(t_trxframeindex *index);
+/* Frees the index */
+
+#endif
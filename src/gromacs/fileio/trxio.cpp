@@ -42,6 +42,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 
 #include "gromacs/fileio/checkpoint.h"
@@ -57,6 +58,8 @@
 #include "gromacs/fileio/tngio.h"
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/trxframeindex.h"
+#include "gromacs/fileio/trxprefetch.h"
 #include "gromacs/fileio/xdrf.h"
 #include "gromacs/fileio/xtcio.h"
 #include "gromacs/math/vec.h"
@@ -93,6 +96,10 @@ struct t_trxstatus
     double                  DT, BOX[3];
     gmx_bool                bReadBox;
     char                   *persistent_line; /* Persistent line for reading g96 trajectories */
+    t_trxframeindex        *frameindex;      /* Frame offsets for skipping frames, can be NULL */
+    int                     frameindex_next; /* The index of the next frame in the file       */
+    t_trxprefetch          *prefetch;        /* Reads frames ahead, can be NULL               */
+    int                     nprefetch;       /* The number of frames to read ahead            */
 #if GMX_USE_PLUGINS
     gmx_vmdplugin_t        *vmdplugin;
 #endif
@@ -175,6 +182,10 @@ static void status_init(t_trxstatus *status)
     status->tf              = 0;
     status->persistent_line = nullptr;
     status->tng             = nullptr;
+    status->frameindex      = nullptr;
+    status->frameindex_next = 0;
+    status->prefetch        = nullptr;
+    status->nprefetch       = 0;
 }
 
 
@@ -241,8 +252,24 @@ real ndec2prec(int ndec)
     return pow(10.0, ndec);
 }
 
+/* Stops reading ahead and positions the file after the last frame
+ * returned by read_next_frame.
+ */
+static void stop_prefetch(t_trxstatus *status)
+{
+    if (status->prefetch)
+    {
+        gmx_fio_seek(status->fio, trxprefetch_done(status->prefetch));
+        status->prefetch = nullptr;
+    }
+}
+
 t_fileio *trx_get_fileio(t_trxstatus *status)
 {
+    /* The caller might access the file directly, so stop reading ahead */
+    stop_prefetch(status);
+    status->nprefetch       = 0;
+
     return status->fio;
 }
 
@@ -624,12 +651,17 @@ void close_trx(t_trxstatus *status)
     {
         return;
     }
+    if (status->prefetch)
+    {
+        trxprefetch_done(status->prefetch);
+    }
     gmx_tng_close(&status->tng);
     if (status->fio)
     {
         gmx_fio_close(status->fio);
     }
     sfree(status->persistent_line);
+    trxframeindex_done(status->frameindex);
 #if GMX_USE_PLUGINS
     sfree(status->vmdplugin);
 #endif
@@ -716,6 +748,105 @@ static gmx_bool gmx_next_frame(t_trxstatus *status, t_trxframe *fr)
     return bRet;
 }
 
+/* Uses the frame index to skip, without reading them, all frames
+ * that read_next_frame would read and then skip because of missing
+ * data or the -b/-dt time selection.
+ */
+static void skip_indexed_frames(const gmx_output_env_t *oenv, t_trxstatus *status)
+{
+    const t_trxframeindex *index = status->frameindex;
+    int                    i     = status->frameindex_next;
+
+    while (i < index->nframes)
+    {
+        const t_trxframeindex_entry *frame = &index->frame[i];
+        gmx_bool                     bMissingData;
+
+        bMissingData = (((status->flags & TRX_NEED_X) && !(frame->flags & TRXFRAMEINDEX_X)) ||
+                        ((status->flags & TRX_NEED_V) && !(frame->flags & TRXFRAMEINDEX_V)) ||
+                        ((status->flags & TRX_NEED_F) && !(frame->flags & TRXFRAMEINDEX_F)));
+        if (!bMissingData)
+        {
+            int ct = check_times2(frame->time, status->t0, (frame->flags & TRXFRAMEINDEX_DOUBLE) != 0);
+            if (ct >= 0 || (status->flags & TRX_DONT_SKIP))
+            {
+                /* This frame will be read */
+                break;
+            }
+            printcount(status, oenv, frame->time, TRUE);
+        }
+        i++;
+    }
+
+    if (i != status->frameindex_next)
+    {
+        gmx_fio_seek(status->fio, i < index->nframes ? index->frame[i].offset : index->end);
+        status->frameindex_next = i;
+    }
+}
+
+static gmx_bool xtc_next_frame(t_trxstatus *status, t_trxframe *fr)
+{
+    gmx_bool bOK, bRet;
+
+    bRet = read_next_xtc(status->fio, fr->natoms, &fr->step, &fr->time, fr->box,
+                         fr->x, &fr->prec, &bOK);
+    fr->bPrec = (bRet && fr->prec > 0);
+    fr->bStep = bRet;
+    fr->bTime = bRet;
+    fr->bX    = bRet;
+    fr->bBox  = bRet;
+    if (!bOK)
+    {
+        /* Actually the header could also be not ok,
+           but from bOK from read_next_xtc this can't be distinguished */
+        fr->not_ok = DATA_NOT_OK;
+    }
+
+    return bRet;
+}
+
+/* Reads the next xtc or trr frame on the prefetch thread */
+static gmx_bool prefetch_read_frame(void *data, t_trxframe *fr)
+{
+    t_trxstatus *status = static_cast<t_trxstatus *>(data);
+
+    if (gmx_fio_getftp(status->fio) == efXTC)
+    {
+        if (fr->x == nullptr)
+        {
+            snew(fr->x, fr->natoms);
+        }
+        return xtc_next_frame(status, fr);
+    }
+    else
+    {
+        return gmx_next_frame(status, fr);
+    }
+}
+
+/* Starts reading frames ahead when requested and possible. Frames are
+ * only read ahead from xtc and trr files in sequence, so not when
+ * the frame index or an xtc time search is used to skip frames.
+ */
+static void start_prefetch(t_trxstatus *status)
+{
+    int ftp;
+
+    if (status->nprefetch <= 0 || status->tng || status->frameindex ||
+        status->natoms <= 0)
+    {
+        return;
+    }
+    ftp = gmx_fio_getftp(status->fio);
+    if ((ftp == efXTC && !(bTimeSet(TBEGIN) && status->tf < rTimeValue(TBEGIN))) ||
+        ftp == efTRR)
+    {
+        status->prefetch = trxprefetch_init(status->nprefetch, status->natoms,
+                                            status->fio, prefetch_read_frame, status);
+    }
+}
+
 static gmx_bool pdb_next_x(t_trxstatus *status, FILE *fp, t_trxframe *fr)
 {
     t_atoms   atoms;
@@ -814,7 +945,7 @@ gmx_bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status, t_tr
 {
     real     pt;
     int      ct;
-    gmx_bool bOK, bRet, bMissingData = FALSE, bSkip = FALSE;
+    gmx_bool bRet, bMissingData = FALSE, bSkip = FALSE;
     int      ftp;
 
     bRet = FALSE;
@@ -836,6 +967,15 @@ gmx_bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status, t_tr
         switch (ftp)
         {
             case efTRR:
+                if (status->prefetch)
+                {
+                    bRet = trxprefetch_next(status->prefetch, fr);
+                    break;
+                }
+                if (status->frameindex)
+                {
+                    skip_indexed_frames(oenv, status);
+                }
                 bRet = gmx_next_frame(status, fr);
                 break;
             case efCPT:
@@ -850,7 +990,16 @@ gmx_bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status, t_tr
                 break;
             }
             case efXTC:
-                if (bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)))
+                if (status->prefetch)
+                {
+                    bRet = trxprefetch_next(status->prefetch, fr);
+                    break;
+                }
+                if (status->frameindex)
+                {
+                    skip_indexed_frames(oenv, status);
+                }
+                else if (bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)))
                 {
                     if (xtc_seek_time(status->fio, rTimeValue(TBEGIN), fr->natoms, TRUE))
                     {
@@ -859,19 +1008,7 @@ gmx_bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status, t_tr
                     }
                     initcount(status);
                 }
-                bRet = read_next_xtc(status->fio, fr->natoms, &fr->step, &fr->time, fr->box,
-                                     fr->x, &fr->prec, &bOK);
-                fr->bPrec = (bRet && fr->prec > 0);
-                fr->bStep = bRet;
-                fr->bTime = bRet;
-                fr->bX    = bRet;
-                fr->bBox  = bRet;
-                if (!bOK)
-                {
-                    /* Actually the header could also be not ok,
-                       but from bOK from read_next_xtc this can't be distinguished */
-                    fr->not_ok = DATA_NOT_OK;
-                }
+                bRet = xtc_next_frame(status, fr);
                 break;
             case efTNG:
                 bRet = gmx_read_next_tng_frame(status->tng, fr, nullptr, 0);
@@ -892,6 +1029,10 @@ gmx_bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status, t_tr
 #endif
         }
         status->tf = fr->time;
+        if (status->frameindex)
+        {
+            status->frameindex_next++;
+        }
 
         if (bRet)
         {
@@ -959,6 +1100,19 @@ int read_first_frame(const gmx_output_env_t *oenv, t_trxstatus **status,
     {
         fio = (*status)->fio = gmx_fio_open(fn, "r");
     }
+    /* With a time selection, use a frame index to skip frames without
+     * reading them. This indexes the whole file, so only do this when
+     * frames might need to be skipped. The index is only cached next to
+     * the trajectory on request, since we should not silently write
+     * files in the directories of the user.
+     */
+    if ((ftp == efXTC || ftp == efTRR) && !(flags & TRX_DONT_SKIP) &&
+        (bTimeSet(TBEGIN) || bTimeSet(TDELTA)) &&
+        getenv("GMX_NO_TRAJ_FRAME_INDEX") == nullptr)
+    {
+        (*status)->frameindex = trxframeindex_open(fn, ftp,
+                                                   getenv("GMX_TRAJ_FRAME_INDEX_CACHE") != nullptr);
+    }
     switch (ftp)
     {
         case efTRR:
@@ -1011,7 +1165,8 @@ int read_first_frame(const gmx_output_env_t *oenv, t_trxstatus **status,
                 fr->bBox  = TRUE;
                 printcount(*status, oenv, fr->time, FALSE);
             }
-            bFirst = FALSE;
+            (*status)->frameindex_next = 1;
+            bFirst                     = FALSE;
             break;
         case efTNG:
             fr->step = -1;
@@ -1085,6 +1240,14 @@ int read_first_frame(const gmx_output_env_t *oenv, t_trxstatus **status,
      */
     (*status)->natoms = fr->natoms;
 
+    /* Optionally read the next frames ahead on a separate thread */
+    const char *env = getenv("GMX_TRAJ_PREFETCH");
+    if (env != nullptr)
+    {
+        (*status)->nprefetch = strtol(env, nullptr, 10);
+        start_prefetch(*status);
+    }
+
     return (fr->natoms > 0);
 }
 
@@ -1123,8 +1286,15 @@ gmx_bool read_next_x(const gmx_output_env_t *oenv, t_trxstatus *status, real *t,
 void rewind_trj(t_trxstatus *status)
 {
     initcount(status);
+    status->frameindex_next = 0;
 
+    if (status->prefetch)
+    {
+        trxprefetch_done(status->prefetch);
+        status->prefetch = nullptr;
+    }
     gmx_fio_rewind(status->fio);
+    start_prefetch(status);
 }
 
 /***** T O P O L O G Y   S T U F F ******/
@@ -0,0 +1,229 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+#include "gmxpre.h"
+
+#include "trxprefetch.h"
+
+#include <cstring>
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/smalloc.h"
+
+struct t_trxprefetch_frame
+{
+    t_trxframe         fr;        /* The frame, owns x, v and f */
+    gmx_bool           bRet;      /* The return value of the read function */
+    std::exception_ptr exception; /* Thrown by the read function, or null */
+    gmx_off_t          offset;    /* The file offset after the frame */
+};
+
+struct t_trxprefetch
+{
+    t_fileio                        *fio;
+    trxprefetch_read_t               read;
+    void                            *data;
+    std::vector<t_trxprefetch_frame> ring;
+    int                              first;  /* Ring index of the next frame to return */
+    int                              nready; /* Number of frames read and not returned */
+    gmx_bool                         bEnd;   /* The thread read the last frame */
+    gmx_bool                         bStop;  /* The thread should stop */
+    gmx_off_t                        offset; /* Offset after the last returned frame */
+    std::mutex                       mutex;
+    std::condition_variable          cond;
+    std::thread                      thread;
+};
+
+static void trxprefetch_thread(t_trxprefetch *pf)
+{
+    std::unique_lock<std::mutex> lock(pf->mutex);
+    int                          nslots = static_cast<int>(pf->ring.size());
+
+    while (!pf->bStop && !pf->bEnd)
+    {
+        pf->cond.wait(lock, [pf, nslots]{ return pf->bStop || pf->nready < nslots; });
+        if (pf->bStop)
+        {
+            break;
+        }
+        t_trxprefetch_frame *slot = &pf->ring[(pf->first + pf->nready) % nslots];
+        lock.unlock();
+
+        /* The caller does not access the free slots, so we read unlocked */
+        clear_trxframe(&slot->fr, FALSE);
+        slot->exception = nullptr;
+        try
+        {
+            slot->bRet = pf->read(pf->data, &slot->fr);
+        }
+        catch (...)
+        {
+            slot->exception = std::current_exception();
+            slot->bRet      = FALSE;
+        }
+        slot->offset = gmx_fio_ftell(pf->fio);
+
+        lock.lock();
+        pf->bEnd = (!slot->bRet);
+        pf->nready++;
+        pf->cond.notify_all();
+    }
+}
+
+t_trxprefetch *trxprefetch_init(int nframes, int natoms, t_fileio *fio,
+                                trxprefetch_read_t read, void *data)
+{
+    t_trxprefetch *pf = new t_trxprefetch;
+
+    pf->fio  = fio;
+    pf->read = read;
+    pf->data = data;
+    pf->ring.resize(nframes);
+    for (t_trxprefetch_frame &slot : pf->ring)
+    {
+        clear_trxframe(&slot.fr, TRUE);
+        slot.fr.natoms = natoms;
+        slot.bRet      = FALSE;
+        slot.offset    = 0;
+    }
+    pf->first  = 0;
+    pf->nready = 0;
+    pf->bEnd   = FALSE;
+    pf->bStop  = FALSE;
+    pf->offset = gmx_fio_ftell(fio);
+    pf->thread = std::thread(trxprefetch_thread, pf);
+
+    return pf;
+}
+
+/* Copies natoms vectors from src to dest, allocates dest when NULL */
+static void copy_frame_rvecs(rvec **dest, const rvec *src, int natoms)
+{
+    if (*dest == nullptr)
+    {
+        snew(*dest, natoms);
+    }
+    std::memcpy(*dest, src, natoms*sizeof(rvec));
+}
+
+gmx_bool trxprefetch_next(t_trxprefetch *pf, t_trxframe *fr)
+{
+    std::unique_lock<std::mutex> lock(pf->mutex);
+
+    pf->cond.wait(lock, [pf]{ return pf->nready > 0; });
+
+    t_trxprefetch_frame *slot = &pf->ring[pf->first];
+    if (slot->exception)
+    {
+        std::rethrow_exception(slot->exception);
+    }
+    if (!slot->bRet)
+    {
+        /* Keep the last slot, so later calls also return FALSE */
+        fr->not_ok = slot->fr.not_ok;
+        return FALSE;
+    }
+
+    /* The thread does not write to the ready slots, so we copy unlocked */
+    lock.unlock();
+    const t_trxframe *src = &slot->fr;
+    fr->not_ok    = src->not_ok;
+    fr->bDouble   = src->bDouble;
+    fr->natoms    = src->natoms;
+    fr->bStep     = src->bStep;
+    fr->step      = src->step;
+    fr->bTime     = src->bTime;
+    fr->time      = src->time;
+    fr->bLambda   = src->bLambda;
+    fr->bFepState = src->bFepState;
+    fr->lambda    = src->lambda;
+    fr->fep_state = src->fep_state;
+    fr->bPrec     = src->bPrec;
+    fr->prec      = src->prec;
+    fr->bX        = src->bX;
+    fr->bV        = src->bV;
+    fr->bF        = src->bF;
+    fr->bBox      = src->bBox;
+    copy_mat(src->box, fr->box);
+    if (src->bX)
+    {
+        copy_frame_rvecs(&fr->x, src->x, src->natoms);
+    }
+    if (src->bV)
+    {
+        copy_frame_rvecs(&fr->v, src->v, src->natoms);
+    }
+    if (src->bF)
+    {
+        copy_frame_rvecs(&fr->f, src->f, src->natoms);
+    }
+    lock.lock();
+
+    pf->offset = slot->offset;
+    pf->first  = (pf->first + 1) % static_cast<int>(pf->ring.size());
+    pf->nready--;
+    pf->cond.notify_all();
+
+    return TRUE;
+}
+
+gmx_off_t trxprefetch_done(t_trxprefetch *pf)
+{
+    {
+        std::lock_guard<std::mutex> lock(pf->mutex);
+        pf->bStop = TRUE;
+        pf->cond.notify_all();
+    }
+    pf->thread.join();
+
+    gmx_off_t offset = pf->offset;
+    for (t_trxprefetch_frame &slot : pf->ring)
+    {
+        sfree(slot.fr.x);
+        sfree(slot.fr.v);
+        sfree(slot.fr.f);
+    }
+    delete pf;
+
+    return offset;
+}
@@ -0,0 +1,80 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+#ifndef GMX_FILEIO_TRXPREFETCH_H
+#define GMX_FILEIO_TRXPREFETCH_H
+
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/futil.h"
+
+struct t_fileio;
+struct t_trxframe;
+
+/* Read-ahead of trajectory frames on a background thread.
+ *
+ * A prefetcher owns a ring buffer of frames and a thread that reads
+ * the next frames from a file into the buffer, while the caller
+ * processes earlier frames. The frames are handed to the caller in
+ * file order. While a prefetcher is active, only the prefetch thread
+ * accesses the file.
+ */
+
+typedef struct t_trxprefetch t_trxprefetch;
+
+typedef gmx_bool (*trxprefetch_read_t)(void *data, t_trxframe *fr);
+/* Reads the next frame into fr, returns FALSE at the end of the file.
+ * The buffer frames start out with natoms set and x, v and f NULL.
+ */
+
+t_trxprefetch *trxprefetch_init(int nframes, int natoms, t_fileio *fio,
+                                trxprefetch_read_t read, void *data);
+/* Starts reading up to nframes frames with natoms atoms ahead from fio,
+ * using read with data as the first argument.
+ */
+
+gmx_bool trxprefetch_next(t_trxprefetch *pf, t_trxframe *fr);
+/* Waits for the next frame and copies it into fr, allocating the x, v
+ * and f arrays of fr when they are NULL and the frame contains them.
+ * Returns the return value of the read function for the frame.
+ * Exceptions thrown by the read function are rethrown here.
+ */
+
+gmx_off_t trxprefetch_done(t_trxprefetch *pf);
+/* Stops the prefetch thread and frees pf. Returns the file offset
+ * after the last frame returned by trxprefetch_next, to which the file
+ * should be positioned to continue reading without the prefetcher.
+ */
+
+#endif
@@ -44,12 +44,17 @@
 #include "gromacs/fileio/gmxfio-xdr.h"
 #include "gromacs/fileio/xdrf.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
 
 #define XTC_MAGIC 1995
 
+/* The size of an int and a float in XDR */
+#define XDR_INT_SIZE 4
+
 
 static int xdr_r2f(XDR *xdrs, real *r, gmx_bool gmx_unused bRead)
 {
@@ -88,8 +93,8 @@ static void check_xtc_magic(int magic)
 {
     if (magic != XTC_MAGIC)
     {
-        gmx_fatal(FARGS, "Magic Number Error in XTC file (read %d, should be %d)",
-                  magic, XTC_MAGIC);
+        GMX_THROW(gmx::FileIOError(gmx::formatString("Magic Number Error in XTC file (read %d, should be %d)",
+                                                     magic, XTC_MAGIC)));
     }
 }
 
@@ -282,11 +287,60 @@ int read_next_xtc(t_fileio* fio,
 
     if (n > natoms)
     {
-        gmx_fatal(FARGS, "Frame contains more atoms (%d) than expected (%d)",
-                  n, natoms);
+        GMX_THROW(gmx::FileIOError(gmx::formatString("Frame contains more atoms (%d) than expected (%d)",
+                                                     n, natoms)));
     }
 
     *bOK = xtc_coord(xd, &natoms, box, x, prec, TRUE);
 
     return *bOK;
 }
+
+int xtc_skip_frame(t_fileio *fio, real *time)
+{
+    int         magic, natoms, nbytes;
+    gmx_int64_t step;
+    matrix      box;
+    gmx_bool    bOK;
+    XDR        *xd;
+    gmx_off_t   skip;
+
+    xd = gmx_fio_getxdr(fio);
+
+    if (!xtc_header(xd, &magic, &natoms, &step, time, TRUE, &bOK) || magic != XTC_MAGIC)
+    {
+        return 0;
+    }
+    for (int i = 0; i < DIM; i++)
+    {
+        for (int j = 0; j < DIM; j++)
+        {
+            if (!xdr_r2f(xd, &box[i][j], TRUE))
+            {
+                return 0;
+            }
+        }
+    }
+    /* Skip the compressed coordinates, see xdr3dfcoord() for the layout */
+    if (xdr_int(xd, &natoms) == 0)
+    {
+        return 0;
+    }
+    if (natoms <= 9)
+    {
+        skip = natoms*DIM*XDR_INT_SIZE;
+    }
+    else
+    {
+        /* precision, minint[3], maxint[3] and smallidx */
+        if (gmx_fio_seek(fio, gmx_fio_ftell(fio) + 8*XDR_INT_SIZE) != 0 ||
+            xdr_int(xd, &nbytes) == 0)
+        {
+            return 0;
+        }
+        /* xdr_opaque pads the data to a multiple of four bytes */
+        skip = ((nbytes + XDR_INT_SIZE - 1)/XDR_INT_SIZE)*XDR_INT_SIZE;
+    }
+
+    return (gmx_fio_seek(fio, gmx_fio_ftell(fio) + skip) == 0);
+}
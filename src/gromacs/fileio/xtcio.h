@@ -73,13 +73,20 @@ int read_first_xtc(struct t_fileio *fio,
 int read_next_xtc(struct t_fileio *fio,
                   int natoms, gmx_int64_t *step, real *time,
                   matrix box, rvec *x, real *prec, gmx_bool *bOK);
-/* Read subsequent frames */
+/* Read subsequent frames.
+ * Throws gmx::FileIOError when the frame header is corrupted.
+ */
 
 int write_xtc(struct t_fileio *fio,
               int natoms, gmx_int64_t step, real time,
               const rvec *box, const rvec *x, real prec);
 /* Write a frame to xtc file */
 
+int xtc_skip_frame(struct t_fileio *fio, real *time);
+/* Read the header of the next frame and return its time, then seek
+ * past the coordinates without decompressing them.
+ */
+
 #ifdef __cplusplus
 }
 #endif
@@ -1242,7 +1242,7 @@ static void fec(const char *ene2fn, const char *runavgfn,
          */
         do
         {
-            bCont = do_enx(enx, fr);
+            bCont = do_enx_selected(enx, fr, nset, set, FALSE);
 
             if (bCont)
             {
@@ -1883,7 +1883,10 @@ int gmx_energy(int argc, char *argv[])
          */
         do
         {
-            bCont = do_enx(fp, &(frame[NEXT]));
+            /* Only decode the selected terms, and the blocks only when
+             * we need the free-energy data.
+             */
+            bCont = do_enx_selected(fp, &(frame[NEXT]), nset, set, bDHDL);
             if (bCont)
             {
                 timecheck = check_times(frame[NEXT].t);
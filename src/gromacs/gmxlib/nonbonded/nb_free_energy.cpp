@@ -49,7 +49,481 @@
 #include "gromacs/math/vec.h"
 #include "gromacs/mdtypes/forcerec.h"
 #include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/simd/simd_math.h"
+#include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/real.h"
+
+#if GMX_SIMD_HAVE_REAL
+/* Returns whether nb_free_energy_kernel_simd() supports the setup in fr.
+ * This covers the Verlet scheme with soft-core r-power 6 and without
+ * potential-switch modifiers, i.e. with all interactions in the form of
+ * the plain cut-off, reaction-field or converted Ewald ones below.
+ */
+static gmx_bool nb_free_energy_simd_supported(const t_forcerec *fr)
+{
+    const interaction_const_t *ic = fr->ic;
+
+    return (fr->use_simd_kernels &&
+            fr->cutoff_scheme == ecutsVERLET &&
+            fr->sc_r_power == 6 &&
+            ic->coulomb_modifier != eintmodPOTSWITCH &&
+            ic->vdw_modifier != eintmodPOTSWITCH &&
+            (ic->eeltype == eelCUT || EEL_RF(ic->eeltype) || EEL_PME_EWALD(ic->eeltype)));
+}
+
+/* SIMD version of gmx_nb_free_energy_kernel for the setups accepted by
+ * nb_free_energy_simd_supported(). The j-particles of each i-particle
+ * within the cut-off are packed in batches of GMX_SIMD_REAL_WIDTH, after
+ * which the soft-core radii, the interactions in both states and dV/dl
+ * are computed for the whole batch in SIMD registers. Unused lanes
+ * of the last batch have zero parameters and are masked out.
+ * The Ewald correction is computed analytically, as in the nbnxn
+ * SIMD kernels, the LJ-Ewald grid correction with the table.
+ */
+static void
+nb_free_energy_kernel_simd(const t_nblist * gmx_restrict    nlist,
+                           rvec * gmx_restrict              xx,
+                           rvec * gmx_restrict              ff,
+                           t_forcerec * gmx_restrict        fr,
+                           const t_mdatoms * gmx_restrict   mdatoms,
+                           nb_kernel_data_t * gmx_restrict  kernel_data,
+                           t_nrnb * gmx_restrict            nrnb)
+{
+    using namespace gmx;
+
+#define  STATE_A  0
+#define  STATE_B  1
+#define  NSTATES  2
+    const int                  width = GMX_SIMD_REAL_WIDTH;
+    const interaction_const_t *ic    = fr->ic;
+
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) dxB[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) dyB[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) dzB[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) rsqB[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) qqB[NSTATES*GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) c6B[NSTATES*GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) c12B[NSTATES*GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) c6gridB[NSTATES*GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) pairB[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) exclB[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) selfB[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) ljEwaldVB[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) ljEwaldFB[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) fB[DIM*GMX_SIMD_REAL_WIDTH];
+    int                                    jB[GMX_SIMD_REAL_WIDTH];
+
+    const real   *x              = xx[0];
+    real         *f              = ff[0];
+    real         *fshift         = fr->fshift[0];
+    const real   *shiftvec       = fr->shift_vec[0];
+    const real   *chargeA        = mdatoms->chargeA;
+    const real   *chargeB        = mdatoms->chargeB;
+    const int    *typeA          = mdatoms->typeA;
+    const int    *typeB          = mdatoms->typeB;
+    const int     ntype          = fr->ntype;
+    const real   *nbfp           = fr->nbfp;
+    const real   *nbfp_grid      = fr->ljpme_c6grid;
+    const real    facel          = ic->epsfac;
+    const real    lambda_coul    = kernel_data->lambda[efptCOUL];
+    const real    lambda_vdw     = kernel_data->lambda[efptVDW];
+    const real    lam_power      = fr->sc_power;
+    const real    sc_r_power     = fr->sc_r_power;
+    const real    sigma6_def     = fr->sc_sigma6_def;
+    const real    sigma6_min     = fr->sc_sigma6_min;
+    const real    rcutoff_max2   = gmx::square(std::max(ic->rcoulomb, ic->rvdw));
+    const real    ewtabscale     = ic->tabq_scale;
+    const real    ewtabhalfspace = 0.5/ewtabscale;
+    const real   *tab_ewald_F_lj = ic->tabq_vdw_F;
+    const real   *tab_ewald_V_lj = ic->tabq_vdw_V;
+    const bool    bDoForces      = (kernel_data->flags & GMX_NONBONDED_DO_FORCE);
+    const bool    bDoShiftForces = (kernel_data->flags & GMX_NONBONDED_DO_SHIFTFORCE);
+    const bool    bDoPotential   = (kernel_data->flags & GMX_NONBONDED_DO_POTENTIAL);
+    /* Without potential-switch modifiers Ewald is always converted to
+     * plain Coulomb and LJ-Ewald to LJ, see gmx_nb_free_energy_kernel.
+     */
+    const bool    bEwald         = EEL_PME_EWALD(ic->eeltype);
+    const bool    bEwaldLJ       = EVDW_PME(ic->vdwtype);
+    real          LFC[NSTATES], LFV[NSTATES], DLF[NSTATES];
+    real          lfac_coul[NSTATES], dlfac_coul[NSTATES], lfac_vdw[NSTATES], dlfac_vdw[NSTATES];
+    double        dvdl_coul      = 0;
+    double        dvdl_vdw       = 0;
+
+    LFC[STATE_A] = 1 - lambda_coul;
+    LFV[STATE_A] = 1 - lambda_vdw;
+    LFC[STATE_B] = lambda_coul;
+    LFV[STATE_B] = lambda_vdw;
+    DLF[STATE_A] = -1;
+    DLF[STATE_B] = 1;
+    for (int i = 0; i < NSTATES; i++)
+    {
+        lfac_coul[i]  = (lam_power == 2 ? (1-LFC[i])*(1-LFC[i]) : (1-LFC[i]));
+        dlfac_coul[i] = DLF[i]*lam_power/sc_r_power*(lam_power == 2 ? (1-LFC[i]) : 1);
+        lfac_vdw[i]   = (lam_power == 2 ? (1-LFV[i])*(1-LFV[i]) : (1-LFV[i]));
+        dlfac_vdw[i]  = DLF[i]*lam_power/sc_r_power*(lam_power == 2 ? (1-LFV[i]) : 1);
+    }
+
+    const SimdReal zero_S(0.0);
+    const SimdReal half_S(0.5);
+    const SimdReal two_S(2.0);
+    const SimdReal onetwelfth_S(1.0/12.0);
+    const SimdReal onesixth_S(1.0/6.0);
+    const SimdReal minusonesixth_S(-1.0/6.0);
+    /* Lower bound for the soft-core r^6, only reached for overlapping
+     * particles without soft-core and in lanes that are masked out.
+     */
+    const SimdReal minRp_S(GMX_REAL_MIN);
+    const SimdReal alpha_coul_S(fr->sc_alphacoul);
+    const SimdReal alpha_vdw_S(fr->sc_alphavdw);
+    const SimdReal sigma6_def_S(sigma6_def);
+    const SimdReal sigma6_min_S(sigma6_min);
+    const SimdReal rcoulomb_S(ic->rcoulomb);
+    const SimdReal rvdw_S(ic->rvdw);
+    const SimdReal krf_S(ic->k_rf);
+    const SimdReal crf_S(ic->c_rf);
+    const SimdReal sh_ewald_S(ic->sh_ewald);
+    const SimdReal sh_invrc6_S(ic->sh_invrc6);
+    const SimdReal sh_invrc12_S(ic->sh_invrc6*ic->sh_invrc6);
+    const SimdReal sh_lj_ewald_S(ic->sh_lj_ewald);
+    const SimdReal beta_S(ic->ewaldcoeff_q);
+    const SimdReal beta2_S(ic->ewaldcoeff_q*ic->ewaldcoeff_q);
+    const SimdReal beta3_S(ic->ewaldcoeff_q*ic->ewaldcoeff_q*ic->ewaldcoeff_q);
+
+    for (int n = 0; n < nlist->nri; n++)
+    {
+        const int  is3   = 3*nlist->shift[n];
+        const int  nj1   = nlist->jindex[n+1];
+        const int  ii    = nlist->iinr[n];
+        const int  ii3   = 3*ii;
+        const real ix    = shiftvec[is3]   + x[ii3];
+        const real iy    = shiftvec[is3+1] + x[ii3+1];
+        const real iz    = shiftvec[is3+2] + x[ii3+2];
+        const real iqA   = facel*chargeA[ii];
+        const real iqB   = facel*chargeB[ii];
+        const int  ntiA  = 2*ntype*typeA[ii];
+        const int  ntiB  = 2*ntype*typeB[ii];
+        int        npair_within_cutoff = 0;
+        SimdReal   vctot_S             = zero_S;
+        SimdReal   vvtot_S             = zero_S;
+        SimdReal   dvdl_coul_S         = zero_S;
+        SimdReal   dvdl_vdw_S          = zero_S;
+        SimdReal   fix_S               = zero_S;
+        SimdReal   fiy_S               = zero_S;
+        SimdReal   fiz_S               = zero_S;
+        int        k                   = nlist->jindex[n];
+
+        while (k < nj1)
+        {
+            /* Pack the next batch of pairs within the cut-off */
+            int nlane = 0;
+            for (; k < nj1 && nlane < width; k++)
+            {
+                const int  jnr = nlist->jjnr[k];
+                const int  j3  = 3*jnr;
+                const real dx  = ix - x[j3];
+                const real dy  = iy - x[j3+1];
+                const real dz  = iz - x[j3+2];
+                const real rsq = dx*dx + dy*dy + dz*dz;
+
+                if (rsq >= rcutoff_max2)
+                {
+                    /* The soft-core distance is always larger than r,
+                     * so pairs beyond the cut-off do not interact.
+                     */
+                    continue;
+                }
+
+                const int  tjA = ntiA + 2*typeA[jnr];
+                const int  tjB = ntiB + 2*typeB[jnr];
+                const bool bPair = (nlist->excl_fep == nullptr || nlist->excl_fep[k]);
+
+                jB[nlane]                   = jnr;
+                dxB[nlane]                  = dx;
+                dyB[nlane]                  = dy;
+                dzB[nlane]                  = dz;
+                rsqB[nlane]                 = rsq;
+                qqB[nlane]                  = iqA*chargeA[jnr];
+                qqB[width + nlane]          = iqB*chargeB[jnr];
+                c6B[nlane]                  = nbfp[tjA];
+                c6B[width + nlane]          = nbfp[tjB];
+                c12B[nlane]                 = nbfp[tjA + 1];
+                c12B[width + nlane]         = nbfp[tjB + 1];
+                pairB[nlane]                = bPair ? 1 : 0;
+                /* Excluded pairs only interact through the reaction-field
+                 * correction, without soft-core.
+                 */
+                exclB[nlane]                = (!bPair && !bEwald) ? 1 : 0;
+                /* Self-interactions occur twice, so count these half */
+                selfB[nlane]                = (ii == jnr) ? 0.5 : 1;
+                ljEwaldVB[nlane]            = 0;
+                ljEwaldFB[nlane]            = 0;
+                if (bEwaldLJ)
+                {
+                    c6gridB[nlane]          = nbfp_grid[tjA];
+                    c6gridB[width + nlane]  = nbfp_grid[tjB];
+
+                    const real rinv = (rsq > 0 ? gmx::invsqrt(rsq) : 0);
+                    const real r    = rsq*rinv;
+                    if (r < ic->rvdw)
+                    {
+                        /* Subtract the reciprocal-space LJ-Ewald part,
+                         * see gmx_nb_free_energy_kernel.
+                         */
+                        const real rs   = r*ewtabscale;
+                        const int  ri   = static_cast<int>(rs);
+                        const real frac = rs - ri;
+                        const real f_lr = (1 - frac)*tab_ewald_F_lj[ri] + frac*tab_ewald_F_lj[ri+1];
+
+                        ljEwaldFB[nlane] = f_lr*rinv/6;
+                        ljEwaldVB[nlane] = selfB[nlane]*(tab_ewald_V_lj[ri] - ewtabhalfspace*frac*(tab_ewald_F_lj[ri] + f_lr))/6;
+                    }
+                }
+                else
+                {
+                    c6gridB[nlane]          = 0;
+                    c6gridB[width + nlane]  = 0;
+                }
+                nlane++;
+            }
+            if (nlane == 0)
+            {
+                break;
+            }
+            npair_within_cutoff += nlane;
+            for (int s = nlane; s < width; s++)
+            {
+                dxB[s]               = 0;
+                dyB[s]               = 0;
+                dzB[s]               = 0;
+                rsqB[s]              = 1;
+                qqB[s]               = 0;
+                qqB[width + s]       = 0;
+                c6B[s]               = 0;
+                c6B[width + s]       = 0;
+                c12B[s]              = 0;
+                c12B[width + s]      = 0;
+                c6gridB[s]           = 0;
+                c6gridB[width + s]   = 0;
+                pairB[s]             = 0;
+                exclB[s]             = 0;
+                selfB[s]             = 1;
+                ljEwaldVB[s]         = 0;
+                ljEwaldFB[s]         = 0;
+            }
+
+            const SimdReal rsq_S   = load<SimdReal>(rsqB);
+            const SimdBool pair_S  = (zero_S < load<SimdReal>(pairB));
+            const SimdReal rinv_S  = maskzInvsqrt(rsq_S, zero_S < rsq_S);
+            const SimdReal r_S     = rsq_S*rinv_S;
+            const SimdReal rpm2_S  = rsq_S*rsq_S;
+            const SimdReal rp_S    = rpm2_S*rsq_S;
+            SimdReal       qq_S[NSTATES], c6_S[NSTATES], c12_S[NSTATES], c6grid_S[NSTATES];
+            SimdReal       fscal_S = zero_S;
+
+            for (int i = 0; i < NSTATES; i++)
+            {
+                qq_S[i]     = load<SimdReal>(qqB + i*width);
+                c6_S[i]     = load<SimdReal>(c6B + i*width);
+                c12_S[i]    = load<SimdReal>(c12B + i*width);
+                c6grid_S[i] = load<SimdReal>(c6gridB + i*width);
+            }
+
+            /* Only use soft-core if one of the states has a zero end state */
+            const SimdBool bothC12_S      = (zero_S < c12_S[STATE_A]) && (zero_S < c12_S[STATE_B]);
+            const SimdReal alpha_coul_eff = selectByNotMask(alpha_coul_S, bothC12_S);
+            const SimdReal alpha_vdw_eff  = selectByNotMask(alpha_vdw_S, bothC12_S);
+
+            for (int i = 0; i < NSTATES; i++)
+            {
+                const SimdBool bLJ_S      = (zero_S < c6_S[i]) && (zero_S < c12_S[i]);
+                /* c12 is stored scaled with 12.0 and c6 is scaled with 6.0 - correct for this */
+                const SimdReal sigma6_S   = blend(sigma6_def_S,
+                                                  max(half_S*c12_S[i]*maskzInv(c6_S[i], bLJ_S), sigma6_min_S),
+                                                  bLJ_S);
+                const SimdBool bVdw_S     = pair_S && ((c6_S[i] != zero_S) || (c12_S[i] != zero_S));
+                const SimdBool bCoul_S    = pair_S && (qq_S[i] != zero_S);
+
+                /* Soft-core r^-6, r^-1 and r for Coulomb and VdW */
+                SimdReal       rpC_S      = max(fma(alpha_coul_eff*SimdReal(lfac_coul[i]), sigma6_S, rp_S), minRp_S);
+                SimdReal       rpV_S      = max(fma(alpha_vdw_eff*SimdReal(lfac_vdw[i]), sigma6_S, rp_S), minRp_S);
+                const SimdReal rpinvC_S   = inv(rpC_S);
+                const SimdReal rpinvV_S   = inv(rpV_S);
+                const SimdReal rinvC_S    = exp(minusonesixth_S*log(rpC_S));
+                const SimdReal rinvV_S    = exp(minusonesixth_S*log(rpV_S));
+                const SimdReal rC_S       = inv(rinvC_S);
+                const SimdReal rV_S       = inv(rinvV_S);
+
+                SimdReal       vcoul_S, fscalC_S;
+                SimdBool       bCoulCut_S;
+                if (bEwald)
+                {
+                    /* Ewald FEP is done only on the 1/r part */
+                    vcoul_S    = qq_S[i]*(rinvC_S - sh_ewald_S);
+                    fscalC_S   = qq_S[i]*rinvC_S;
+                    bCoulCut_S = (r_S < rcoulomb_S);
+                }
+                else
+                {
+                    const SimdReal rC2_S = rC_S*rC_S;
+                    vcoul_S    = qq_S[i]*(rinvC_S + fms(krf_S, rC2_S, crf_S));
+                    fscalC_S   = qq_S[i]*fnma(two_S*krf_S, rC2_S, rinvC_S);
+                    bCoulCut_S = (rC_S < rcoulomb_S);
+                }
+                vcoul_S  = selectByMask(vcoul_S, bCoul_S && bCoulCut_S);
+                fscalC_S = selectByMask(fscalC_S*rpinvC_S, bCoul_S && bCoulCut_S);
+
+                const SimdReal vvdw6_S   = c6_S[i]*rpinvV_S;
+                const SimdReal vvdw12_S  = c12_S[i]*rpinvV_S*rpinvV_S;
+                const SimdBool bVdwCut_S = (bEwaldLJ ? r_S < rvdw_S : rV_S < rvdw_S);
+                SimdReal       vvdw_S    = ((vvdw12_S - c12_S[i]*sh_invrc12_S)*onetwelfth_S -
+                                            (vvdw6_S - c6_S[i]*sh_invrc6_S - c6grid_S[i]*sh_lj_ewald_S)*onesixth_S);
+                SimdReal       fscalV_S  = vvdw12_S - vvdw6_S;
+                vvdw_S   = selectByMask(vvdw_S, bVdw_S && bVdwCut_S);
+                fscalV_S = selectByMask(fscalV_S*rpinvV_S, bVdw_S && bVdwCut_S);
+
+                /* Assemble A and B states */
+                const SimdReal lfc_S = SimdReal(LFC[i]);
+                const SimdReal lfv_S = SimdReal(LFV[i]);
+                vctot_S     = fma(lfc_S, vcoul_S, vctot_S);
+                vvtot_S     = fma(lfv_S, vvdw_S, vvtot_S);
+                fscal_S     = fma(fma(lfc_S, fscalC_S, lfv_S*fscalV_S), rpm2_S, fscal_S);
+                dvdl_coul_S = fma(SimdReal(DLF[i]), vcoul_S, dvdl_coul_S);
+                dvdl_coul_S = fma(lfc_S*SimdReal(dlfac_coul[i])*alpha_coul_eff, fscalC_S*sigma6_S, dvdl_coul_S);
+                dvdl_vdw_S  = fma(SimdReal(DLF[i]), vvdw_S, dvdl_vdw_S);
+                dvdl_vdw_S  = fma(lfv_S*SimdReal(dlfac_vdw[i])*alpha_vdw_eff, fscalV_S*sigma6_S, dvdl_vdw_S);
+            }
+
+            if (bEwald)
+            {
+                /* Subtract the reciprocal-space Ewald part of all pairs,
+                 * including the excluded ones.
+                 */
+                const SimdReal brsq_S = beta2_S*rsq_S;
+                const SimdBool bCut_S = (r_S < rcoulomb_S);
+                const SimdReal v_lr_S = selectByMask(load<SimdReal>(selfB)*beta_S*pmePotentialCorrection(brsq_S), bCut_S);
+                const SimdReal f_lr_S = selectByMask(-beta3_S*pmeForceCorrection(brsq_S), bCut_S);
+
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    const SimdReal lfcqq_S = SimdReal(LFC[i])*qq_S[i];
+                    vctot_S     = fnma(lfcqq_S, v_lr_S, vctot_S);
+                    fscal_S     = fnma(lfcqq_S, f_lr_S, fscal_S);
+                    dvdl_coul_S = fnma(SimdReal(DLF[i])*qq_S[i], v_lr_S, dvdl_coul_S);
+                }
+            }
+            else
+            {
+                /* Reaction-field correction for excluded pairs */
+                const SimdBool bExcl_S = (zero_S < load<SimdReal>(exclB));
+                const SimdReal vv_S    = selectByMask(load<SimdReal>(selfB)*fms(krf_S, rsq_S, crf_S), bExcl_S);
+                const SimdReal ff_S    = selectByMask(-two_S*krf_S, bExcl_S);
+
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    const SimdReal lfcqq_S = SimdReal(LFC[i])*qq_S[i];
+                    vctot_S     = fma(lfcqq_S, vv_S, vctot_S);
+                    fscal_S     = fma(lfcqq_S, ff_S, fscal_S);
+                    dvdl_coul_S = fma(SimdReal(DLF[i])*qq_S[i], vv_S, dvdl_coul_S);
+                }
+            }
+
+            if (bEwaldLJ)
+            {
+                const SimdReal vv_S = load<SimdReal>(ljEwaldVB);
+                const SimdReal ff_S = load<SimdReal>(ljEwaldFB);
+
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    const SimdReal lfvc6_S = SimdReal(LFV[i])*c6grid_S[i];
+                    vvtot_S    = fma(lfvc6_S, vv_S, vvtot_S);
+                    fscal_S    = fma(lfvc6_S, ff_S, fscal_S);
+                    dvdl_vdw_S = fma(SimdReal(DLF[i])*c6grid_S[i], vv_S, dvdl_vdw_S);
+                }
+            }
+
+            if (bDoForces)
+            {
+                const SimdReal tx_S = fscal_S*load<SimdReal>(dxB);
+                const SimdReal ty_S = fscal_S*load<SimdReal>(dyB);
+                const SimdReal tz_S = fscal_S*load<SimdReal>(dzB);
+
+                fix_S = fix_S + tx_S;
+                fiy_S = fiy_S + ty_S;
+                fiz_S = fiz_S + tz_S;
+                store(fB + XX*width, tx_S);
+                store(fB + YY*width, ty_S);
+                store(fB + ZZ*width, tz_S);
+                for (int s = 0; s < nlane; s++)
+                {
+                    const int j3 = 3*jB[s];
+#pragma omp atomic
+                    f[j3]   -= fB[XX*width + s];
+#pragma omp atomic
+                    f[j3+1] -= fB[YY*width + s];
+#pragma omp atomic
+                    f[j3+2] -= fB[ZZ*width + s];
+                }
+            }
+        }
+
+        dvdl_coul += reduce(dvdl_coul_S);
+        dvdl_vdw  += reduce(dvdl_vdw_S);
+
+        /* As in the scalar kernel, skip the expensive atomic
+         * i-reductions for i-particles without pairs in range.
+         */
+        if (npair_within_cutoff > 0)
+        {
+            if (bDoForces || bDoShiftForces)
+            {
+                const real fix = reduce(fix_S);
+                const real fiy = reduce(fiy_S);
+                const real fiz = reduce(fiz_S);
+
+                if (bDoForces)
+                {
+#pragma omp atomic
+                    f[ii3]        += fix;
+#pragma omp atomic
+                    f[ii3+1]      += fiy;
+#pragma omp atomic
+                    f[ii3+2]      += fiz;
+                }
+                if (bDoShiftForces)
+                {
+#pragma omp atomic
+                    fshift[is3]   += fix;
+#pragma omp atomic
+                    fshift[is3+1] += fiy;
+#pragma omp atomic
+                    fshift[is3+2] += fiz;
+                }
+            }
+            if (bDoPotential)
+            {
+                const int ggid = nlist->gid[n];
+#pragma omp atomic
+                kernel_data->energygrp_elec[ggid] += reduce(vctot_S);
+#pragma omp atomic
+                kernel_data->energygrp_vdw[ggid]  += reduce(vvtot_S);
+            }
+        }
+    }
+
+#pragma omp atomic
+    kernel_data->dvdl[efptCOUL] += dvdl_coul;
+#pragma omp atomic
+    kernel_data->dvdl[efptVDW]  += dvdl_vdw;
+
+#pragma omp atomic
+    inc_nrnb(nrnb, eNR_NBKERNEL_FREE_ENERGY, nlist->nri*12 + nlist->jindex[nlist->nri]*150);
+#undef STATE_A
+#undef STATE_B
+#undef NSTATES
+}
+#endif
 
 void
 gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
@@ -138,6 +612,14 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
     const real    six         = 6.0;
     const real    fourtyeight = 48.0;
 
+#if GMX_SIMD_HAVE_REAL
+    if (nb_free_energy_simd_supported(fr))
+    {
+        nb_free_energy_kernel_simd(nlist, xx, ff, fr, mdatoms, kernel_data, nrnb);
+        return;
+    }
+#endif
+
     /* Extract pointer to non-bonded interaction constants */
     const interaction_const_t *ic = fr->ic;
 
@@ -0,0 +1,373 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests the SIMD free-energy kernel against the plain C one.
+ *
+ * \ingroup module_gmxlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxlib/nonbonded/nb_free_energy.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/ewald/ewald-utils.h"
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/gmxlib/nonbonded/nb_kernel.h"
+#include "gromacs/gmxlib/nonbonded/nonbonded.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/nblist.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace
+{
+
+//! Number of atoms used in these tests, more than a SIMD width.
+const int c_numAtoms = 13;
+//! Number of atom types used in these tests.
+const int c_numTypes = 3;
+
+/*! \brief Free-energy kernel output for one set of parameters */
+struct FreeEnergyKernelOutput
+{
+    //! Coulomb energy
+    real              energyElec;
+    //! Van der Waals energy
+    real              energyVdw;
+    //! dV/dl for Coulomb and Van der Waals
+    real              dvdl[efptNR];
+    //! Forces
+    std::vector<RVec> f;
+    //! Shift forces
+    std::vector<RVec> fshift;
+};
+
+class FreeEnergyKernelTest : public ::testing::Test
+{
+    protected:
+        rvec                x_[c_numAtoms];
+        matrix              box_;
+        real                chargeA_[c_numAtoms];
+        real                chargeB_[c_numAtoms];
+        int                 typeA_[c_numAtoms];
+        int                 typeB_[c_numAtoms];
+        real                nbfp_[2*c_numTypes*c_numTypes];
+        real                nbfpGrid_[2*c_numTypes*c_numTypes];
+        t_nblist            nlist_;
+        std::vector<int>    iinr_;
+        std::vector<int>    jindex_;
+        std::vector<int>    jjnr_;
+        std::vector<int>    shift_;
+        std::vector<int>    gid_;
+        std::vector<char>   exclFep_;
+
+        FreeEnergyKernelTest() : nlist_()
+        {
+            /* Atoms on a distorted lattice with a minimum distance
+             * of about 0.3 nm, so LJ stays finite without soft-core.
+             */
+            for (int i = 0; i < c_numAtoms; i++)
+            {
+                x_[i][XX] = 0.2 + 0.4*(i % 3) + 0.03*((i*7) % 5);
+                x_[i][YY] = 0.2 + 0.4*((i/3) % 2) + 0.02*((i*3) % 4);
+                x_[i][ZZ] = 0.2 + 0.4*(i/6) + 0.025*((i*5) % 3);
+
+                chargeA_[i] = 0.1*((i % 5) - 2);
+                /* Perturb the charges of every other atom */
+                chargeB_[i] = (i % 2 == 0 ? 0 : chargeA_[i]);
+                typeA_[i]   = i % 2;
+                /* Decouple the LJ of every third atom with a dummy type */
+                typeB_[i]   = (i % 3 == 0 ? 2 : typeA_[i]);
+            }
+            clear_mat(box_);
+            box_[XX][XX] = 1.6;
+            box_[YY][YY] = 1.6;
+            box_[ZZ][ZZ] = 1.6;
+
+            const real c6[c_numTypes]  = { 2.6e-3, 1.5e-3, 0 };
+            const real c12[c_numTypes] = { 2.6e-6, 1.2e-6, 0 };
+            for (int ti = 0; ti < c_numTypes; ti++)
+            {
+                for (int tj = 0; tj < c_numTypes; tj++)
+                {
+                    const int t = 2*(ti*c_numTypes + tj);
+                    /* The kernels expect 6*C6 and 12*C12 */
+                    nbfp_[t]        = 6*std::sqrt(c6[ti]*c6[tj]);
+                    nbfp_[t + 1]    = 12*std::sqrt(c12[ti]*c12[tj]);
+                    nbfpGrid_[t]    = 0.9*nbfp_[t];
+                    nbfpGrid_[t + 1] = 0;
+                }
+            }
+
+            /* All pairs i <= j, including the self pairs, with every
+             * seventh pair and all self pairs excluded, as the Verlet
+             * scheme free-energy lists contain them.
+             */
+            const int shiftCentral = CENTRAL;
+            int       pairIndex    = 0;
+            jindex_.push_back(0);
+            for (int i = 0; i < c_numAtoms; i++)
+            {
+                iinr_.push_back(i);
+                shift_.push_back(shiftCentral);
+                gid_.push_back(0);
+                for (int j = i; j < c_numAtoms; j++)
+                {
+                    jjnr_.push_back(j);
+                    exclFep_.push_back((i == j || pairIndex % 7 == 3) ? 0 : 1);
+                    pairIndex++;
+                }
+                jindex_.push_back(jjnr_.size());
+            }
+            /* One more list with a shifted i-atom, partially beyond the cut-off */
+            ivec shiftVec = { 1, 0, 0 };
+            iinr_.push_back(0);
+            shift_.push_back(IVEC2IS(shiftVec));
+            gid_.push_back(0);
+            for (int j = 0; j < c_numAtoms; j++)
+            {
+                jjnr_.push_back(j);
+                exclFep_.push_back(1);
+            }
+            jindex_.push_back(jjnr_.size());
+
+            nlist_.nri      = iinr_.size();
+            nlist_.nrj      = jjnr_.size();
+            nlist_.iinr     = iinr_.data();
+            nlist_.jindex   = jindex_.data();
+            nlist_.jjnr     = jjnr_.data();
+            nlist_.shift    = shift_.data();
+            nlist_.gid      = gid_.data();
+            nlist_.excl_fep = exclFep_.data();
+        }
+
+        //! Runs the free-energy kernel with the setup in \p fr
+        FreeEnergyKernelOutput runKernel(t_forcerec *fr)
+        {
+            FreeEnergyKernelOutput out;
+            out.f.assign(c_numAtoms, RVec(0, 0, 0));
+            out.fshift.assign(SHIFTS, RVec(0, 0, 0));
+            out.energyElec = 0;
+            out.energyVdw  = 0;
+            for (int i = 0; i < efptNR; i++)
+            {
+                out.dvdl[i] = 0;
+            }
+
+            t_mdatoms md = {};
+            md.chargeA   = chargeA_;
+            md.chargeB   = chargeB_;
+            md.typeA     = typeA_;
+            md.typeB     = typeB_;
+
+            real lambda[efptNR] = { 0 };
+            lambda[efptCOUL]    = 0.4;
+            lambda[efptVDW]     = 0.6;
+
+            nb_kernel_data_t kernelData = {};
+            kernelData.flags            = (GMX_NONBONDED_DO_FORCE |
+                                           GMX_NONBONDED_DO_SHIFTFORCE |
+                                           GMX_NONBONDED_DO_POTENTIAL);
+            kernelData.lambda           = lambda;
+            kernelData.dvdl             = out.dvdl;
+            kernelData.energygrp_elec   = &out.energyElec;
+            kernelData.energygrp_vdw    = &out.energyVdw;
+
+            fr->fshift = as_rvec_array(out.fshift.data());
+
+            t_nrnb nrnb;
+            init_nrnb(&nrnb);
+            gmx_nb_free_energy_kernel(&nlist_, x_, as_rvec_array(out.f.data()),
+                                      fr, &md, &kernelData, &nrnb);
+
+            return out;
+        }
+
+        /*! \brief Runs the SIMD and plain C kernels and compares the output
+         *
+         * With LJ-PME \p eeltype should be PME, as mdrun requires.
+         */
+        void testKernels(int eeltype, int vdwtype, real scAlpha)
+        {
+            const real          rc = 1.0;
+
+            interaction_const_t ic = {};
+            ic.cutoff_scheme    = ecutsVERLET;
+            ic.eeltype          = eeltype;
+            ic.vdwtype          = vdwtype;
+            ic.coulomb_modifier = eintmodPOTSHIFT;
+            ic.vdw_modifier     = eintmodPOTSHIFT;
+            ic.rcoulomb         = rc;
+            ic.rvdw             = rc;
+            ic.epsfac           = ONE_4PI_EPS0;
+            ic.sh_invrc6        = 1/power6(rc);
+            if (EEL_RF(eeltype))
+            {
+                const real epsRF = 78;
+                ic.k_rf = (epsRF - 1)/((2*epsRF + 1)*power3(rc));
+                ic.c_rf = 1/rc + ic.k_rf*rc*rc;
+            }
+            if (EEL_PME_EWALD(eeltype))
+            {
+                ic.ewaldcoeff_q = calc_ewaldcoeff_q(rc, 1e-5);
+                ic.sh_ewald     = std::erfc(ic.ewaldcoeff_q*rc)/rc;
+            }
+            if (EVDW_PME(vdwtype))
+            {
+                ic.ewaldcoeff_lj = calc_ewaldcoeff_lj(rc, 1e-3);
+                real crc2        = square(ic.ewaldcoeff_lj*rc);
+                ic.sh_lj_ewald   = (std::exp(-crc2)*(1 + crc2 + 0.5*crc2*crc2) - 1)/power6(rc);
+            }
+            init_interaction_const_tables(nullptr, &ic, rc);
+
+            rvec          shiftVec[SHIFTS];
+            calc_shifts(box_, shiftVec);
+
+            t_forcerec   *fr = mk_forcerec();
+            fr->ic            = &ic;
+            fr->cutoff_scheme = ecutsVERLET;
+            fr->ntype         = c_numTypes;
+            fr->nbfp          = nbfp_;
+            fr->ljpme_c6grid  = nbfpGrid_;
+            fr->shift_vec     = shiftVec;
+            fr->sc_alphacoul  = scAlpha;
+            fr->sc_alphavdw   = scAlpha;
+            fr->sc_power      = 1;
+            fr->sc_r_power    = 6;
+            fr->sc_sigma6_def = power6(0.3);
+            fr->sc_sigma6_min = power6(0.3);
+
+            fr->use_simd_kernels = FALSE;
+            FreeEnergyKernelOutput ref  = runKernel(fr);
+            fr->use_simd_kernels = TRUE;
+            FreeEnergyKernelOutput test = runKernel(fr);
+
+            /* The kernels differ in their Ewald correction and in
+             * the order of summation, so we can not expect more than
+             * single-precision accuracy relative to the largest value.
+             */
+            real maxEnergy = std::max(std::abs(ref.energyElec), std::abs(ref.energyVdw));
+            real maxDvdl   = std::max(std::abs(ref.dvdl[efptCOUL]), std::abs(ref.dvdl[efptVDW]));
+            real maxForce  = 0;
+            for (const RVec &f : ref.f)
+            {
+                maxForce = std::max(maxForce, norm(f));
+            }
+            for (const RVec &f : ref.fshift)
+            {
+                maxForce = std::max(maxForce, norm(f));
+            }
+            EXPECT_GT(maxForce, 0);
+
+            const double relTol = 2e-5;
+            test::FloatingPointTolerance energyTolerance(test::relativeToleranceAsFloatingPoint(maxEnergy, relTol));
+            test::FloatingPointTolerance dvdlTolerance(test::relativeToleranceAsFloatingPoint(maxDvdl, relTol));
+            test::FloatingPointTolerance forceTolerance(test::relativeToleranceAsFloatingPoint(maxForce, relTol));
+
+            EXPECT_REAL_EQ_TOL(ref.energyElec, test.energyElec, energyTolerance);
+            EXPECT_REAL_EQ_TOL(ref.energyVdw, test.energyVdw, energyTolerance);
+            EXPECT_REAL_EQ_TOL(ref.dvdl[efptCOUL], test.dvdl[efptCOUL], dvdlTolerance);
+            EXPECT_REAL_EQ_TOL(ref.dvdl[efptVDW], test.dvdl[efptVDW], dvdlTolerance);
+            for (int i = 0; i < c_numAtoms; i++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(ref.f[i][d], test.f[i][d], forceTolerance) << "atom " << i << " dim " << d;
+                }
+            }
+            for (int i = 0; i < SHIFTS; i++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(ref.fshift[i][d], test.fshift[i][d], forceTolerance) << "shift " << i << " dim " << d;
+                }
+            }
+
+            sfree(fr);
+        }
+};
+
+TEST_F (FreeEnergyKernelTest, ReactionFieldWithoutSoftCore)
+{
+    testKernels(eelRF, evdwCUT, 0);
+}
+
+TEST_F (FreeEnergyKernelTest, ReactionFieldWithSoftCore)
+{
+    testKernels(eelRF, evdwCUT, 0.5);
+}
+
+TEST_F (FreeEnergyKernelTest, PmeWithoutSoftCore)
+{
+    testKernels(eelPME, evdwCUT, 0);
+}
+
+TEST_F (FreeEnergyKernelTest, PmeWithSoftCore)
+{
+    testKernels(eelPME, evdwCUT, 0.5);
+}
+
+TEST_F (FreeEnergyKernelTest, LJPmeWithoutSoftCore)
+{
+    testKernels(eelPME, evdwPME, 0);
+}
+
+TEST_F (FreeEnergyKernelTest, LJPmeWithSoftCore)
+{
+    testKernels(eelPME, evdwPME, 0.5);
+}
+
+}
+
+}
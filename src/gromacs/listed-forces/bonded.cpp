@@ -419,6 +419,181 @@ real bonds(int nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/*! \brief Add the shift force for a pair interaction to lane \p s
+ *
+ * Determines the shift index for the vector x[ai]-x[aj] in the same way
+ * as the plain-C kernels do and adds the pair force \p fij.
+ */
+static gmx_inline void
+add_pair_shift_force(int ai, int aj, const real *fij,
+                     const rvec x[], rvec fshift[],
+                     const t_pbc *pbc, const t_graph *g)
+{
+    int  ki;
+    rvec dx;
+    ivec dt;
+
+    if (g)
+    {
+        ivec_sub(SHIFT_IVEC(g, ai), SHIFT_IVEC(g, aj), dt);
+        ki = IVEC2IS(dt);
+    }
+    else
+    {
+        ki = pbc_rvec_sub(pbc, x[ai], x[aj], dx);
+    }
+    if (ki != CENTRAL)
+    {
+        rvec_inc(fshift[ki], fij);
+        rvec_dec(fshift[CENTRAL], fij);
+    }
+}
+
+/*! \brief Harmonic bonds using SIMD to calculate many bonds at once
+ *
+ * Uses only the A-state parameters. With computeEnergy=true the energy
+ * and shift forces are computed as well. The SIMD part computes
+ * the forces and energies, the shift indices are determined per bond.
+ */
+template <bool computeEnergy>
+static real
+bonds_simd_kernel(int nbonds,
+                  const t_iatom forceatoms[], const t_iparams forceparams[],
+                  const rvec x[], rvec4 f[], rvec fshift[],
+                  const t_pbc *pbc, const t_graph *g)
+{
+    const int            nfa1 = 3;
+    int                  i, iu, s;
+    int                  type;
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)    ai[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)    aj[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH)   coeff[2*GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH)   fbuf[DIM*GMX_SIMD_REAL_WIDTH];
+    SimdReal             xi_S, yi_S, zi_S;
+    SimdReal             xj_S, yj_S, zj_S;
+    SimdReal             dx_S, dy_S, dz_S;
+    SimdReal             k_S, r0_S;
+    SimdReal             dr2_S, rinv_S, delta_S, fbond_S;
+    SimdReal             fx_S, fy_S, fz_S;
+    SimdReal             half_S(0.5);
+    SimdReal             zero_S(0.0);
+    SimdReal             dr2_min_S(GMX_REAL_MIN);
+    SimdReal             vtot_S(0.0);
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH)    pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of bonds times nfa1, here we step GMX_SIMD_REAL_WIDTH bonds */
+    for (i = 0; (i < nbonds); i += GMX_SIMD_REAL_WIDTH*nfa1)
+    {
+        /* Collect atoms for GMX_SIMD_REAL_WIDTH bonds.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        iu = i;
+        for (s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            type  = forceatoms[iu];
+            ai[s] = forceatoms[iu+1];
+            aj[s] = forceatoms[iu+2];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s*nfa1 < nbonds)
+            {
+                coeff[s]                     = forceparams[type].harmonic.krA;
+                coeff[GMX_SIMD_REAL_WIDTH+s] = forceparams[type].harmonic.rA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                     = 0;
+                coeff[GMX_SIMD_REAL_WIDTH+s] = 0;
+            }
+        }
+
+        gatherLoadUTranspose<3>(reinterpret_cast<const real *>(x), ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real *>(x), aj, &xj_S, &yj_S, &zj_S);
+        dx_S = xi_S - xj_S;
+        dy_S = yi_S - yj_S;
+        dz_S = zi_S - zj_S;
+
+        pbc_correct_dx_simd(&dx_S, &dy_S, &dz_S, pbc_simd);
+
+        k_S     = load<SimdReal>(coeff);
+        r0_S    = load<SimdReal>(coeff+GMX_SIMD_REAL_WIDTH);
+
+        /* With atoms on top of each other the force is zero, but we need
+         * to avoid 1/0, since 0*inf would give NaN.
+         */
+        dr2_S   = norm2(dx_S, dy_S, dz_S);
+        rinv_S  = invsqrt(max(dr2_S, dr2_min_S));
+        delta_S = fms(dr2_S, rinv_S, r0_S);
+        fbond_S = -k_S * delta_S * rinv_S;
+
+        fx_S    = fbond_S * dx_S;
+        fy_S    = fbond_S * dy_S;
+        fz_S    = fbond_S * dz_S;
+
+        transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ai, fx_S, fy_S, fz_S);
+        transposeScatterDecrU<4>(reinterpret_cast<real *>(f), aj, fx_S, fy_S, fz_S);
+
+        if (computeEnergy)
+        {
+            /* As the plain-C code, we skip the energy for zero distance */
+            vtot_S = vtot_S + selectByNotMask(half_S * k_S * delta_S * delta_S,
+                                              dr2_S == zero_S);
+
+            store(fbuf + XX*GMX_SIMD_REAL_WIDTH, fx_S);
+            store(fbuf + YY*GMX_SIMD_REAL_WIDTH, fy_S);
+            store(fbuf + ZZ*GMX_SIMD_REAL_WIDTH, fz_S);
+            for (s = 0; s < GMX_SIMD_REAL_WIDTH && i + s*nfa1 < nbonds; s++)
+            {
+                rvec fij = {
+                    fbuf[XX*GMX_SIMD_REAL_WIDTH + s],
+                    fbuf[YY*GMX_SIMD_REAL_WIDTH + s],
+                    fbuf[ZZ*GMX_SIMD_REAL_WIDTH + s]
+                };
+                add_pair_shift_force(ai[s], aj[s], fij, x, fshift, pbc, g);
+            }
+        }
+    }
+
+    return computeEnergy ? reduce(vtot_S) : 0;
+}
+
+void
+bonds_noener_simd(int nbonds,
+                  const t_iatom forceatoms[], const t_iparams forceparams[],
+                  const rvec x[], rvec4 f[],
+                  const t_pbc *pbc, const t_graph gmx_unused *g,
+                  real gmx_unused lambda,
+                  const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                  int gmx_unused *global_atom_index)
+{
+    bonds_simd_kernel<false>(nbonds, forceatoms, forceparams,
+                             x, f, nullptr, pbc, nullptr);
+}
+
+real
+bonds_simd(int nbonds,
+           const t_iatom forceatoms[], const t_iparams forceparams[],
+           const rvec x[], rvec4 f[], rvec fshift[],
+           const t_pbc *pbc, const t_graph *g,
+           real gmx_unused lambda, real gmx_unused *dvdlambda,
+           const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+           int gmx_unused *global_atom_index)
+{
+    return bonds_simd_kernel<true>(nbonds, forceatoms, forceparams,
+                                   x, f, fshift, pbc, g);
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 real restraint_bonds(int nbonds,
                      const t_iatom forceatoms[], const t_iparams forceparams[],
                      const rvec x[], rvec4 f[], rvec fshift[],
@@ -1295,6 +1470,247 @@ real urey_bradley(int nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/*! \brief As urey_bradley, but using SIMD to calculate many interactions at once
+ *
+ * Uses only the A-state parameters. With computeEnergy=true the energy
+ * and shift forces are computed as well, the latter per interaction
+ * as in bonds_simd_kernel.
+ */
+template <bool computeEnergy>
+static real
+urey_bradley_simd_kernel(int nbonds,
+                         const t_iatom forceatoms[], const t_iparams forceparams[],
+                         const rvec x[], rvec4 f[], rvec fshift[],
+                         const t_pbc *pbc, const t_graph *g)
+{
+    const int            nfa1 = 4;
+    int                  i, iu, s;
+    int                  type;
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)    ai[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)    aj[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)    ak[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH)   coeff[4*GMX_SIMD_REAL_WIDTH];
+    SimdReal             deg2rad_S(DEG2RAD);
+    SimdReal             xi_S, yi_S, zi_S;
+    SimdReal             xj_S, yj_S, zj_S;
+    SimdReal             xk_S, yk_S, zk_S;
+    SimdReal             k_S, theta0_S, kUB_S, r13_S;
+    SimdReal             rijx_S, rijy_S, rijz_S;
+    SimdReal             rkjx_S, rkjy_S, rkjz_S;
+    SimdReal             rikx_S, riky_S, rikz_S;
+    SimdReal             one_S(1.0);
+    SimdReal             min_one_plus_eps_S(-1.0 + 2.0*GMX_REAL_EPS); // Smallest number > -1
+    SimdReal             dr2_min_S(GMX_REAL_MIN);
+
+    SimdReal             rij_rkj_S;
+    SimdReal             nrij2_S, nrij_1_S;
+    SimdReal             nrkj2_S, nrkj_1_S;
+    SimdReal             cos_S, invsin_S;
+    SimdReal             theta_S;
+    SimdReal             st_S, sth_S;
+    SimdReal             cik_S, cii_S, ckk_S;
+    SimdReal             nrik2_S, nrik_1_S, fbond_S;
+    SimdReal             f_ix_S, f_iy_S, f_iz_S;
+    SimdReal             f_kx_S, f_ky_S, f_kz_S;
+    SimdReal             dtheta_S, delta_S;
+    SimdReal             half_S(0.5);
+    SimdReal             zero_S(0.0);
+    SimdReal             vtot_S(0.0);
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH)    fbuf[3*DIM*GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH)    pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of angles times nfa1, here we step GMX_SIMD_REAL_WIDTH angles */
+    for (i = 0; (i < nbonds); i += GMX_SIMD_REAL_WIDTH*nfa1)
+    {
+        /* Collect atoms for GMX_SIMD_REAL_WIDTH angles.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        iu = i;
+        for (s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            type  = forceatoms[iu];
+            ai[s] = forceatoms[iu+1];
+            aj[s] = forceatoms[iu+2];
+            ak[s] = forceatoms[iu+3];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s*nfa1 < nbonds)
+            {
+                coeff[0*GMX_SIMD_REAL_WIDTH+s] = forceparams[type].u_b.kthetaA;
+                coeff[1*GMX_SIMD_REAL_WIDTH+s] = forceparams[type].u_b.thetaA;
+                coeff[2*GMX_SIMD_REAL_WIDTH+s] = forceparams[type].u_b.kUBA;
+                coeff[3*GMX_SIMD_REAL_WIDTH+s] = forceparams[type].u_b.r13A;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[0*GMX_SIMD_REAL_WIDTH+s] = 0;
+                coeff[1*GMX_SIMD_REAL_WIDTH+s] = 0;
+                coeff[2*GMX_SIMD_REAL_WIDTH+s] = 0;
+                coeff[3*GMX_SIMD_REAL_WIDTH+s] = 0;
+            }
+        }
+
+        /* Store the non PBC corrected distances packed and aligned */
+        gatherLoadUTranspose<3>(reinterpret_cast<const real *>(x), ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real *>(x), aj, &xj_S, &yj_S, &zj_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real *>(x), ak, &xk_S, &yk_S, &zk_S);
+        rijx_S = xi_S - xj_S;
+        rijy_S = yi_S - yj_S;
+        rijz_S = zi_S - zj_S;
+        rkjx_S = xk_S - xj_S;
+        rkjy_S = yk_S - yj_S;
+        rkjz_S = zk_S - zj_S;
+        rikx_S = xi_S - xk_S;
+        riky_S = yi_S - yk_S;
+        rikz_S = zi_S - zk_S;
+
+        k_S       = load<SimdReal>(coeff + 0*GMX_SIMD_REAL_WIDTH);
+        theta0_S  = load<SimdReal>(coeff + 1*GMX_SIMD_REAL_WIDTH) * deg2rad_S;
+        kUB_S     = load<SimdReal>(coeff + 2*GMX_SIMD_REAL_WIDTH);
+        r13_S     = load<SimdReal>(coeff + 3*GMX_SIMD_REAL_WIDTH);
+
+        pbc_correct_dx_simd(&rijx_S, &rijy_S, &rijz_S, pbc_simd);
+        pbc_correct_dx_simd(&rkjx_S, &rkjy_S, &rkjz_S, pbc_simd);
+        pbc_correct_dx_simd(&rikx_S, &riky_S, &rikz_S, pbc_simd);
+
+        rij_rkj_S = iprod(rijx_S, rijy_S, rijz_S,
+                          rkjx_S, rkjy_S, rkjz_S);
+
+        nrij2_S   = norm2(rijx_S, rijy_S, rijz_S);
+        nrkj2_S   = norm2(rkjx_S, rkjy_S, rkjz_S);
+
+        nrij_1_S  = invsqrt(nrij2_S);
+        nrkj_1_S  = invsqrt(nrkj2_S);
+
+        cos_S     = rij_rkj_S * nrij_1_S * nrkj_1_S;
+
+        /* As in angles_noener_simd, we avoid cos = -1 */
+        cos_S     = max(cos_S, min_one_plus_eps_S);
+
+        theta_S   = acos(cos_S);
+
+        invsin_S  = invsqrt( one_S - cos_S * cos_S );
+
+        dtheta_S  = theta0_S - theta_S;
+        st_S      = k_S * dtheta_S * invsin_S;
+        sth_S     = st_S * cos_S;
+
+        cik_S     = st_S  * nrij_1_S * nrkj_1_S;
+        cii_S     = sth_S * nrij_1_S * nrij_1_S;
+        ckk_S     = sth_S * nrkj_1_S * nrkj_1_S;
+
+        /* The Urey-Bradley 1-3 bond, as in bonds_simd_kernel */
+        nrik2_S   = norm2(rikx_S, riky_S, rikz_S);
+        nrik_1_S  = invsqrt(max(nrik2_S, dr2_min_S));
+        delta_S   = fms(nrik2_S, nrik_1_S, r13_S);
+        fbond_S   = -kUB_S * delta_S * nrik_1_S;
+
+        f_ix_S    = cii_S * rijx_S;
+        f_ix_S    = fnma(cik_S, rkjx_S, f_ix_S);
+        f_iy_S    = cii_S * rijy_S;
+        f_iy_S    = fnma(cik_S, rkjy_S, f_iy_S);
+        f_iz_S    = cii_S * rijz_S;
+        f_iz_S    = fnma(cik_S, rkjz_S, f_iz_S);
+        f_kx_S    = ckk_S * rkjx_S;
+        f_kx_S    = fnma(cik_S, rijx_S, f_kx_S);
+        f_ky_S    = ckk_S * rkjy_S;
+        f_ky_S    = fnma(cik_S, rijy_S, f_ky_S);
+        f_kz_S    = ckk_S * rkjz_S;
+        f_kz_S    = fnma(cik_S, rijz_S, f_kz_S);
+
+        /* The force on j only has contributions from the angle */
+        transposeScatterDecrU<4>(reinterpret_cast<real *>(f), aj, f_ix_S + f_kx_S, f_iy_S + f_ky_S, f_iz_S + f_kz_S);
+
+        if (computeEnergy)
+        {
+            /* As the plain-C code, we skip the bond energy for zero distance */
+            vtot_S = vtot_S + half_S * k_S * dtheta_S * dtheta_S;
+            vtot_S = vtot_S + selectByNotMask(half_S * kUB_S * delta_S * delta_S,
+                                              nrik2_S == zero_S);
+
+            store(fbuf + 0*GMX_SIMD_REAL_WIDTH, f_ix_S);
+            store(fbuf + 1*GMX_SIMD_REAL_WIDTH, f_iy_S);
+            store(fbuf + 2*GMX_SIMD_REAL_WIDTH, f_iz_S);
+            store(fbuf + 3*GMX_SIMD_REAL_WIDTH, f_kx_S);
+            store(fbuf + 4*GMX_SIMD_REAL_WIDTH, f_ky_S);
+            store(fbuf + 5*GMX_SIMD_REAL_WIDTH, f_kz_S);
+            store(fbuf + 6*GMX_SIMD_REAL_WIDTH, fbond_S * rikx_S);
+            store(fbuf + 7*GMX_SIMD_REAL_WIDTH, fbond_S * riky_S);
+            store(fbuf + 8*GMX_SIMD_REAL_WIDTH, fbond_S * rikz_S);
+        }
+
+        /* Add the bond force to the angle forces on i and k */
+        f_ix_S    = fma(fbond_S, rikx_S, f_ix_S);
+        f_iy_S    = fma(fbond_S, riky_S, f_iy_S);
+        f_iz_S    = fma(fbond_S, rikz_S, f_iz_S);
+        f_kx_S    = fnma(fbond_S, rikx_S, f_kx_S);
+        f_ky_S    = fnma(fbond_S, riky_S, f_ky_S);
+        f_kz_S    = fnma(fbond_S, rikz_S, f_kz_S);
+
+        transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ai, f_ix_S, f_iy_S, f_iz_S);
+        transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ak, f_kx_S, f_ky_S, f_kz_S);
+
+        if (computeEnergy)
+        {
+            /* The angle forces on i and k act along i-j and k-j,
+             * the bond force along i-k, as in urey_bradley.
+             */
+            for (s = 0; s < GMX_SIMD_REAL_WIDTH && i + s*nfa1 < nbonds; s++)
+            {
+                rvec f_i, f_k, fik;
+                for (int m = 0; m < DIM; m++)
+                {
+                    f_i[m] = fbuf[(0*DIM + m)*GMX_SIMD_REAL_WIDTH + s];
+                    f_k[m] = fbuf[(1*DIM + m)*GMX_SIMD_REAL_WIDTH + s];
+                    fik[m] = fbuf[(2*DIM + m)*GMX_SIMD_REAL_WIDTH + s];
+                }
+                add_pair_shift_force(ai[s], aj[s], f_i, x, fshift, pbc, g);
+                add_pair_shift_force(ak[s], aj[s], f_k, x, fshift, pbc, g);
+                add_pair_shift_force(ai[s], ak[s], fik, x, fshift, pbc, g);
+            }
+        }
+    }
+
+    return computeEnergy ? reduce(vtot_S) : 0;
+}
+
+void
+urey_bradley_noener_simd(int nbonds,
+                         const t_iatom forceatoms[], const t_iparams forceparams[],
+                         const rvec x[], rvec4 f[],
+                         const t_pbc *pbc, const t_graph gmx_unused *g,
+                         real gmx_unused lambda,
+                         const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                         int gmx_unused *global_atom_index)
+{
+    urey_bradley_simd_kernel<false>(nbonds, forceatoms, forceparams,
+                                    x, f, nullptr, pbc, nullptr);
+}
+
+real
+urey_bradley_simd(int nbonds,
+                  const t_iatom forceatoms[], const t_iparams forceparams[],
+                  const rvec x[], rvec4 f[], rvec fshift[],
+                  const t_pbc *pbc, const t_graph *g,
+                  real gmx_unused lambda, real gmx_unused *dvdlambda,
+                  const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                  int gmx_unused *global_atom_index)
+{
+    return urey_bradley_simd_kernel<true>(nbonds, forceatoms, forceparams,
+                                          x, f, fshift, pbc, g);
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 real quartic_angles(int nbonds,
                     const t_iatom forceatoms[], const t_iparams forceparams[],
                     const rvec x[], rvec4 f[], rvec fshift[],
@@ -2160,6 +2576,188 @@ real idihs(int nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/*! \brief As idihs, but using SIMD to calculate many dihedrals at once
+ *
+ * Uses only the A-state parameters. With computeEnergy=true the energy
+ * and shift forces are computed as well, the latter per dihedral
+ * as in bonds_simd_kernel.
+ */
+template <bool computeEnergy>
+static real
+idihs_simd_kernel(int nbonds,
+                  const t_iatom forceatoms[], const t_iparams forceparams[],
+                  const rvec x[], rvec4 f[], rvec fshift[],
+                  const t_pbc *pbc, const t_graph *g)
+{
+    const int             nfa1 = 5;
+    int                   i, iu, s;
+    int                   type;
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)    ai[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)    aj[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)    ak[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)    al[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH)  buf[2*GMX_SIMD_REAL_WIDTH];
+    real                 *kk, *phi0;
+    SimdReal              deg2rad_S(DEG2RAD);
+    SimdReal              two_pi_S(2*M_PI);
+    SimdReal              inv_two_pi_S(1/(2*M_PI));
+    SimdReal              p_S, q_S;
+    SimdReal              phi0_S, phi_S;
+    SimdReal              mx_S, my_S, mz_S;
+    SimdReal              nx_S, ny_S, nz_S;
+    SimdReal              nrkj_m2_S, nrkj_n2_S;
+    SimdReal              kk_S, dp_S;
+    SimdReal              mddphi_S;
+    SimdReal              sf_i_S, msf_l_S;
+    SimdReal              sx_S, sy_S, sz_S;
+    SimdReal              half_S(0.5);
+    SimdReal              vtot_S(0.0);
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH)    fbuf[3*DIM*GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH)    pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+
+    /* Extract aligned pointer for parameters and variables */
+    kk    = buf + 0*GMX_SIMD_REAL_WIDTH;
+    phi0  = buf + 1*GMX_SIMD_REAL_WIDTH;
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of dihedrals times nfa1, here we step GMX_SIMD_REAL_WIDTH dihs */
+    for (i = 0; (i < nbonds); i += GMX_SIMD_REAL_WIDTH*nfa1)
+    {
+        /* Collect atoms quadruplets for GMX_SIMD_REAL_WIDTH dihedrals.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        iu = i;
+        for (s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            type  = forceatoms[iu];
+            ai[s] = forceatoms[iu+1];
+            aj[s] = forceatoms[iu+2];
+            ak[s] = forceatoms[iu+3];
+            al[s] = forceatoms[iu+4];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s*nfa1 < nbonds)
+            {
+                kk[s]   = forceparams[type].harmonic.krA;
+                phi0[s] = forceparams[type].harmonic.rA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                kk[s]   = 0;
+                phi0[s] = 0;
+            }
+        }
+
+        /* Caclulate GMX_SIMD_REAL_WIDTH dihedral angles at once */
+        dih_angle_simd(x, ai, aj, ak, al, pbc_simd,
+                       &phi_S,
+                       &mx_S, &my_S, &mz_S,
+                       &nx_S, &ny_S, &nz_S,
+                       &nrkj_m2_S,
+                       &nrkj_n2_S,
+                       &p_S, &q_S);
+
+        kk_S     = load<SimdReal>(kk);
+        phi0_S   = load<SimdReal>(phi0) * deg2rad_S;
+
+        /* Put phi-phi0 in the range (-Pi,Pi), as make_dp_periodic does */
+        dp_S     = phi_S - phi0_S;
+        dp_S     = fnma(two_pi_S, round(dp_S * inv_two_pi_S), dp_S);
+
+        mddphi_S = -kk_S * dp_S;
+        sf_i_S   = mddphi_S * nrkj_m2_S;
+        msf_l_S  = mddphi_S * nrkj_n2_S;
+
+        /* After this m?_S will contain f[i] */
+        mx_S     = sf_i_S * mx_S;
+        my_S     = sf_i_S * my_S;
+        mz_S     = sf_i_S * mz_S;
+
+        /* After this m?_S will contain -f[l] */
+        nx_S     = msf_l_S * nx_S;
+        ny_S     = msf_l_S * ny_S;
+        nz_S     = msf_l_S * nz_S;
+
+        do_dih_fup_noshiftf_simd(ai, aj, ak, al,
+                                 p_S, q_S,
+                                 mx_S, my_S, mz_S,
+                                 nx_S, ny_S, nz_S,
+                                 f);
+
+        if (computeEnergy)
+        {
+            vtot_S = vtot_S + half_S * kk_S * dp_S * dp_S;
+
+            /* Store f[i], -f[k] and f[l], which act along i-j, k-j and l-j
+             * and give the same shift forces as do_dih_fup.
+             */
+            sx_S   = p_S * mx_S + q_S * nx_S;
+            sy_S   = p_S * my_S + q_S * ny_S;
+            sz_S   = p_S * mz_S + q_S * nz_S;
+            store(fbuf + 0*GMX_SIMD_REAL_WIDTH, mx_S);
+            store(fbuf + 1*GMX_SIMD_REAL_WIDTH, my_S);
+            store(fbuf + 2*GMX_SIMD_REAL_WIDTH, mz_S);
+            store(fbuf + 3*GMX_SIMD_REAL_WIDTH, nx_S - sx_S);
+            store(fbuf + 4*GMX_SIMD_REAL_WIDTH, ny_S - sy_S);
+            store(fbuf + 5*GMX_SIMD_REAL_WIDTH, nz_S - sz_S);
+            store(fbuf + 6*GMX_SIMD_REAL_WIDTH, -nx_S);
+            store(fbuf + 7*GMX_SIMD_REAL_WIDTH, -ny_S);
+            store(fbuf + 8*GMX_SIMD_REAL_WIDTH, -nz_S);
+            for (s = 0; s < GMX_SIMD_REAL_WIDTH && i + s*nfa1 < nbonds; s++)
+            {
+                rvec f_i, mf_k, f_l;
+                for (int m = 0; m < DIM; m++)
+                {
+                    f_i[m]  = fbuf[(0*DIM + m)*GMX_SIMD_REAL_WIDTH + s];
+                    mf_k[m] = fbuf[(1*DIM + m)*GMX_SIMD_REAL_WIDTH + s];
+                    f_l[m]  = fbuf[(2*DIM + m)*GMX_SIMD_REAL_WIDTH + s];
+                }
+                add_pair_shift_force(ai[s], aj[s], f_i, x, fshift, pbc, g);
+                add_pair_shift_force(ak[s], aj[s], mf_k, x, fshift, pbc, g);
+                add_pair_shift_force(al[s], aj[s], f_l, x, fshift, pbc, g);
+            }
+        }
+    }
+
+    return computeEnergy ? reduce(vtot_S) : 0;
+}
+
+void
+idihs_noener_simd(int nbonds,
+                  const t_iatom forceatoms[], const t_iparams forceparams[],
+                  const rvec x[], rvec4 f[],
+                  const t_pbc *pbc, const t_graph gmx_unused *g,
+                  real gmx_unused lambda,
+                  const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                  int gmx_unused *global_atom_index)
+{
+    idihs_simd_kernel<false>(nbonds, forceatoms, forceparams,
+                             x, f, nullptr, pbc, nullptr);
+}
+
+real
+idihs_simd(int nbonds,
+           const t_iatom forceatoms[], const t_iparams forceparams[],
+           const rvec x[], rvec4 f[], rvec fshift[],
+           const t_pbc *pbc, const t_graph *g,
+           real gmx_unused lambda, real gmx_unused *dvdlambda,
+           const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+           int gmx_unused *global_atom_index)
+{
+    return idihs_simd_kernel<true>(nbonds, forceatoms, forceparams,
+                                   x, f, fshift, pbc, g);
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 static real low_angres(int nbonds,
                        const t_iatom forceatoms[], const t_iparams forceparams[],
                        const rvec x[], rvec4 f[], rvec fshift[],
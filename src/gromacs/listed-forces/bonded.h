@@ -124,6 +124,63 @@ void
 
 /* TODO these declarations should be internal to the module */
 
+/* As bonds(), but using SIMD to calculate many bonds at once.
+ * This routines does not calculate energies and shift forces.
+ */
+void
+    bonds_noener_simd(int nbonds,
+                      const t_iatom forceatoms[], const t_iparams forceparams[],
+                      const rvec x[], rvec4 f[],
+                      const struct t_pbc *pbc,
+                      const struct t_graph gmx_unused *g,
+                      real gmx_unused lambda,
+                      const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                      int gmx_unused *global_atom_index);
+
+/* As bonds(), but using SIMD to calculate many bonds at once.
+ * Only uses the A-state parameters, so should not be used with
+ * free-energy perturbation. Does compute energies and shift forces.
+ */
+t_ifunc bonds_simd;
+
+/* As urey_bradley(), but using SIMD to calculate many interactions at once.
+ * This routines does not calculate energies and shift forces.
+ */
+void
+    urey_bradley_noener_simd(int nbonds,
+                             const t_iatom forceatoms[], const t_iparams forceparams[],
+                             const rvec x[], rvec4 f[],
+                             const struct t_pbc *pbc,
+                             const struct t_graph gmx_unused *g,
+                             real gmx_unused lambda,
+                             const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                             int gmx_unused *global_atom_index);
+
+/* As urey_bradley(), but using SIMD to calculate many interactions at once.
+ * Only uses the A-state parameters, so should not be used with
+ * free-energy perturbation. Does compute energies and shift forces.
+ */
+t_ifunc urey_bradley_simd;
+
+/* As idihs(), but using SIMD to calculate many dihedrals at once.
+ * This routines does not calculate energies and shift forces.
+ */
+void
+    idihs_noener_simd(int nbonds,
+                      const t_iatom forceatoms[], const t_iparams forceparams[],
+                      const rvec x[], rvec4 f[],
+                      const struct t_pbc *pbc,
+                      const struct t_graph gmx_unused *g,
+                      real gmx_unused lambda,
+                      const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                      int gmx_unused *global_atom_index);
+
+/* As idihs(), but using SIMD to calculate many dihedrals at once.
+ * Only uses the A-state parameters, so should not be used with
+ * free-energy perturbation. Does compute energies and shift forces.
+ */
+t_ifunc idihs_simd;
+
 /* As angles(), but using SIMD to calculate many angles at once.
  * This routines does not calculate energies and shift forces.
  */
@@ -364,7 +364,7 @@ void calc_disres_R_6(const t_commrec *cr,
     }
 
     /* NOTE: Rt_6 and Rtav_6 are stored consecutively in memory */
-    if (cr && DOMAINDECOMP(cr))
+    if (cr && havePPDomainDecomposition(cr))
     {
         gmx_sum(2*dd->nres, dd->Rt_6, cr);
     }
@@ -383,7 +383,7 @@ void calc_disres_R_6(const t_commrec *cr,
         GMX_ASSERT(cr != NULL && cr->ms != NULL, "We need multisim with nsystems>1");
         gmx_sum_sim(2*dd->nres, dd->Rt_6, cr->ms);
 
-        if (DOMAINDECOMP(cr))
+        if (havePPDomainDecomposition(cr))
         {
             gmx_bcast(2*dd->nres, dd->Rt_6, cr);
         }
@@ -59,6 +59,7 @@
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/force.h"
 #include "gromacs/mdlib/force_flags.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/mdtypes/fcdata.h"
 #include "gromacs/mdtypes/forcerec.h"
@@ -71,6 +72,7 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/smalloc.h"
 
 #include "listed-internal.h"
@@ -138,42 +140,40 @@ zero_thread_output(struct bonded_threading_t *bt, int thread)
  * never useful performance wise. */
 #define MAX_BONDED_THREADS 256
 
-/*! \brief Reduce thread-local force buffers */
-static void
-reduce_thread_forces(int n, rvec *f,
-                     struct bonded_threading_t *bt,
-                     int nthreads)
+/*! \brief The arguments of reduce_thread_forces() used by reduceThreadForcesThread() */
+struct ReduceThreadForcesTask
 {
-    if (nthreads > MAX_BONDED_THREADS)
-    {
-        gmx_fatal(FARGS, "Can not reduce bonded forces on more than %d threads",
-                  MAX_BONDED_THREADS);
-    }
+    int                              n;        //!< The number of atoms
+    rvec                            *f;        //!< The force output
+    const struct bonded_threading_t *bt;       //!< The bonded threading setup
+    int                              nthreads; //!< The number of reduction threads
+};
 
-    /* This reduction can run on any number of threads,
-     * independently of bt->nthreads.
-     * But if nthreads matches bt->nthreads (which it currently does)
-     * the uniform distribution of the touched blocks over nthreads will
-     * match the distribution of bonded over threads well in most cases,
-     * which means that threads mostly reduce their own data which increases
-     * the number of cache hits.
-     */
-#pragma omp parallel for num_threads(nthreads) schedule(static)
-    for (int b = 0; b < bt->nblock_used; b++)
+/*! \brief Reduces the thread-local force buffers for the blocks of thread \p th */
+static void
+reduceThreadForcesThread(int th, void *data)
+{
+    const ReduceThreadForcesTask    *task = static_cast<const ReduceThreadForcesTask *>(data);
+    int                              n    = task->n;
+    rvec                            *f    = task->f;
+    const struct bonded_threading_t *bt   = task->bt;
+    int                              b0   = (bt->nblock_used* th   )/task->nthreads;
+    int                              b1   = (bt->nblock_used*(th+1))/task->nthreads;
+
+    try
     {
-        try
+        for (int b = b0; b < b1; b++)
         {
             int    ind = bt->block_index[b];
             rvec4 *fp[MAX_BONDED_THREADS];
 
-            /* Determine which threads contribute to this block */
+            /* Get the threads that contribute to this block from the sparse
+             * list, so the cost does not scale with the number of threads.
+             */
             int nfb = 0;
-            for (int ft = 0; ft < bt->nthreads; ft++)
+            for (int i = bt->block_thread_start[b]; i < bt->block_thread_start[b + 1]; i++)
             {
-                if (bitmask_is_set(bt->mask[ind], ft))
-                {
-                    fp[nfb++] = bt->f_t[ft].f;
-                }
+                fp[nfb++] = bt->f_t[bt->block_thread[i]].f;
             }
             if (nfb > 0)
             {
@@ -191,8 +191,33 @@ reduce_thread_forces(int n, rvec *f,
                 }
             }
         }
-        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
+    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+}
+
+/*! \brief Reduce thread-local force buffers */
+static void
+reduce_thread_forces(int n, rvec *f,
+                     struct bonded_threading_t *bt,
+                     int nthreads)
+{
+    if (nthreads > MAX_BONDED_THREADS)
+    {
+        gmx_fatal(FARGS, "Can not reduce bonded forces on more than %d threads",
+                  MAX_BONDED_THREADS);
+    }
+
+    /* This reduction can run on any number of threads,
+     * independently of bt->nthreads.
+     * But if nthreads matches bt->nthreads (which it currently does)
+     * the uniform distribution of the touched blocks over nthreads will
+     * match the distribution of bonded over threads well in most cases,
+     * which means that threads mostly reduce their own data which increases
+     * the number of cache hits.
+     */
+    ReduceThreadForcesTask task = { n, f, bt, nthreads };
+
+    gmx_omp_nthreads_run(nthreads, reduceThreadForcesThread, &task);
 }
 
 /*! \brief Reduce thread-local forces, shift forces and energies */
@@ -309,6 +334,69 @@ calc_one_bond(int thread,
                           md, fcd, global_atom_index);
         }
 #if GMX_SIMD_HAVE_REAL
+        else if (ftype == F_BONDS && bUseSIMD && fr->efep == efepNO)
+        {
+            if (bCalcEnerVir)
+            {
+                v = bonds_simd(nbn, idef->il[ftype].iatoms+nb0,
+                               idef->iparams,
+                               x, f, fshift,
+                               pbc, g, lambda[efptFTYPE], &(dvdl[efptFTYPE]),
+                               md, fcd, global_atom_index);
+            }
+            else
+            {
+                /* No energies, shift forces, dvdl */
+                bonds_noener_simd(nbn, idef->il[ftype].iatoms+nb0,
+                                  idef->iparams,
+                                  x, f,
+                                  pbc, g, lambda[efptFTYPE], md, fcd,
+                                  global_atom_index);
+                v = 0;
+            }
+        }
+        else if (ftype == F_UREY_BRADLEY && bUseSIMD && fr->efep == efepNO)
+        {
+            if (bCalcEnerVir)
+            {
+                v = urey_bradley_simd(nbn, idef->il[ftype].iatoms+nb0,
+                                      idef->iparams,
+                                      x, f, fshift,
+                                      pbc, g, lambda[efptFTYPE], &(dvdl[efptFTYPE]),
+                                      md, fcd, global_atom_index);
+            }
+            else
+            {
+                /* No energies, shift forces, dvdl */
+                urey_bradley_noener_simd(nbn, idef->il[ftype].iatoms+nb0,
+                                         idef->iparams,
+                                         x, f,
+                                         pbc, g, lambda[efptFTYPE], md, fcd,
+                                         global_atom_index);
+                v = 0;
+            }
+        }
+        else if (ftype == F_IDIHS && bUseSIMD && fr->efep == efepNO)
+        {
+            if (bCalcEnerVir)
+            {
+                v = idihs_simd(nbn, idef->il[ftype].iatoms+nb0,
+                               idef->iparams,
+                               x, f, fshift,
+                               pbc, g, lambda[efptFTYPE], &(dvdl[efptFTYPE]),
+                               md, fcd, global_atom_index);
+            }
+            else
+            {
+                /* No energies, shift forces, dvdl */
+                idihs_noener_simd(nbn, idef->il[ftype].iatoms+nb0,
+                                  idef->iparams,
+                                  x, f,
+                                  pbc, g, lambda[efptFTYPE], md, fcd,
+                                  global_atom_index);
+                v = 0;
+            }
+        }
         else if (ftype == F_ANGLES && bUseSIMD &&
                  !bCalcEnerVir && fr->efep == efepNO)
         {
@@ -397,6 +485,105 @@ ftype_is_bonded_potential(int ftype)
         (ftype < F_GB12 || ftype > F_GB14);
 }
 
+/*! \brief Compute the bonded part of the listed forces for one thread
+ *
+ * Thread 0 writes its shift forces and energies directly to the output
+ * in fr and enerd and its dV/dl to \p dvdl, the other threads to their
+ * thread-local buffers.
+ */
+static void
+calcBondedForcesThread(int               thread,
+                       const t_idef     *idef,
+                       const rvec        x[],
+                       const t_forcerec *fr,
+                       const t_pbc      *pbc_null,
+                       const t_graph    *g,
+                       gmx_enerdata_t   *enerd,
+                       t_nrnb           *nrnb,
+                       const real       *lambda,
+                       real             *dvdl,
+                       const t_mdatoms  *md,
+                       t_fcdata         *fcd,
+                       gmx_bool          bCalcEnerVir,
+                       int              *global_atom_index)
+{
+    struct bonded_threading_t *bt = fr->bonded_threading;
+    int                        ftype;
+    real                      *epot, v;
+    /* thread stuff */
+    rvec4                     *ft;
+    rvec                      *fshift;
+    real                      *dvdlt;
+    gmx_grppairener_t         *grpp;
+
+    zero_thread_output(bt, thread);
+
+    ft = bt->f_t[thread].f;
+
+    if (thread == 0)
+    {
+        fshift = fr->fshift;
+        epot   = enerd->term;
+        grpp   = &enerd->grpp;
+        dvdlt  = dvdl;
+    }
+    else
+    {
+        fshift = bt->f_t[thread].fshift;
+        epot   = bt->f_t[thread].ener;
+        grpp   = &bt->f_t[thread].grpp;
+        dvdlt  = bt->f_t[thread].dvdl;
+    }
+    /* Loop over all bonded force types to calculate the bonded forces */
+    for (ftype = 0; (ftype < F_NRE); ftype++)
+    {
+        if (idef->il[ftype].nr > 0 && ftype_is_bonded_potential(ftype))
+        {
+            v = calc_one_bond(thread, ftype, idef, x,
+                              ft, fshift, fr, pbc_null, g, grpp,
+                              nrnb, lambda, dvdlt,
+                              md, fcd, bCalcEnerVir,
+                              global_atom_index);
+            epot[ftype] += v;
+        }
+    }
+}
+
+/*! \brief The arguments of calcBondedForces() used by calcBondedForcesTask() */
+struct CalcBondedForcesTask
+{
+    const t_idef     *idef;
+    const rvec       *x;
+    const t_forcerec *fr;
+    const t_pbc      *pbc_null;
+    const t_graph    *g;
+    gmx_enerdata_t   *enerd;
+    t_nrnb           *nrnb;
+    const real       *lambda;
+    real             *dvdl;
+    const t_mdatoms  *md;
+    t_fcdata         *fcd;
+    gmx_bool          bCalcEnerVir;
+    int              *global_atom_index;
+};
+
+/*! \brief Compute the bonded part of the listed forces for thread \p thread */
+static void
+calcBondedForcesTask(int thread, void *data)
+{
+    const CalcBondedForcesTask *task = static_cast<const CalcBondedForcesTask *>(data);
+
+    try
+    {
+        calcBondedForcesThread(thread, task->idef, task->x, task->fr,
+                               task->pbc_null, task->g, task->enerd,
+                               task->nrnb, task->lambda, task->dvdl,
+                               task->md, task->fcd, task->bCalcEnerVir,
+                               task->global_atom_index);
+    }
+    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+}
+
 /*! \brief Compute the bonded part of the listed forces, parallelized over threads
  */
 static void
@@ -413,56 +600,62 @@ calcBondedForces(const t_idef     *idef,
                  t_fcdata         *fcd,
                  gmx_bool          bCalcEnerVir,
                  int              *global_atom_index)
+{
+    CalcBondedForcesTask task = {
+        idef, x, fr, pbc_null, g, enerd, nrnb, lambda, dvdl, md, fcd,
+        bCalcEnerVir, global_atom_index
+    };
+
+    gmx_omp_nthreads_run(fr->bonded_threading->nthreads,
+                         calcBondedForcesTask, &task);
+}
+
+int prepare_listed_tasks(const t_forcerec *fr,
+                         const t_idef     *idef,
+                         const t_fcdata   *fcd,
+                         int               force_flags)
 {
     struct bonded_threading_t *bt = fr->bonded_threading;
 
-#pragma omp parallel for num_threads(bt->nthreads) schedule(static)
-    for (int thread = 0; thread < bt->nthreads; thread++)
+    /* Orientation and distance restraints need a pre-calculation
+     * step in calc_listed(), before the bonded forces are computed.
+     */
+    if (!(force_flags & GMX_FORCE_LISTED) || !bt->haveBondeds ||
+        fcd->orires.nr > 0 || fcd->disres.nres > 0)
     {
-        try
-        {
-            int                ftype;
-            real              *epot, v;
-            /* thread stuff */
-            rvec4             *ft;
-            rvec              *fshift;
-            real              *dvdlt;
-            gmx_grppairener_t *grpp;
+        return 0;
+    }
 
-            zero_thread_output(bt, thread);
+    GMX_RELEASE_ASSERT(bt->nthreads == idef->nthreads, "The bonded tasks should match the thread setup of idef");
 
-            ft = bt->f_t[thread].f;
+    bt->haveTaskOutput = true;
 
-            if (thread == 0)
-            {
-                fshift = fr->fshift;
-                epot   = enerd->term;
-                grpp   = &enerd->grpp;
-                dvdlt  = dvdl;
-            }
-            else
-            {
-                fshift = bt->f_t[thread].fshift;
-                epot   = bt->f_t[thread].ener;
-                grpp   = &bt->f_t[thread].grpp;
-                dvdlt  = bt->f_t[thread].dvdl;
-            }
-            /* Loop over all bonded force types to calculate the bonded forces */
-            for (ftype = 0; (ftype < F_NRE); ftype++)
-            {
-                if (idef->il[ftype].nr > 0 && ftype_is_bonded_potential(ftype))
-                {
-                    v = calc_one_bond(thread, ftype, idef, x,
-                                      ft, fshift, fr, pbc_null, g, grpp,
-                                      nrnb, lambda, dvdlt,
-                                      md, fcd, bCalcEnerVir,
-                                      global_atom_index);
-                    epot[ftype] += v;
-                }
-            }
-        }
-        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
-    }
+    return bt->nthreads;
+}
+
+void calc_listed_task(int                   task,
+                      const t_idef         *idef,
+                      const rvec            x[],
+                      const t_forcerec     *fr,
+                      const struct t_pbc   *pbc,
+                      const struct t_graph *g,
+                      gmx_enerdata_t       *enerd,
+                      t_nrnb               *nrnb,
+                      const real           *lambda,
+                      const t_mdatoms      *md,
+                      t_fcdata             *fcd,
+                      int                  *global_atom_index,
+                      int                   force_flags)
+{
+    struct bonded_threading_t *bt = fr->bonded_threading;
+
+    /* Task 0 stores its dV/dl in its own buffer, as we can not keep
+     * a local array until calc_listed() reduces the output.
+     */
+    calcBondedForcesThread(task, idef, x, fr, fr->bMolPBC ? pbc : nullptr, g,
+                           enerd, nrnb, lambda, bt->f_t[0].dvdl, md, fcd,
+                           force_flags & (GMX_FORCE_VIRIAL | GMX_FORCE_ENERGY),
+                           global_atom_index);
 }
 
 void calc_listed(const t_commrec             *cr,
@@ -554,13 +747,25 @@ void calc_listed(const t_commrec             *cr,
 
     if (bt->haveBondeds)
     {
-        wallcycle_sub_start(wcycle, ewcsLISTED);
         /* The dummy array is to have a place to store the dhdl at other values
            of lambda, which will be thrown away in the end */
         real dvdl[efptNR] = {0};
-        calcBondedForces(idef, x, fr, pbc_null, g, enerd, nrnb, lambda, dvdl, md,
-                         fcd, bCalcEnerVir, global_atom_index);
-        wallcycle_sub_stop(wcycle, ewcsLISTED);
+        if (bt->haveTaskOutput)
+        {
+            /* The forces have already been computed by calc_listed_task() */
+            for (int i = 0; i < efptNR; i++)
+            {
+                dvdl[i] = bt->f_t[0].dvdl[i];
+            }
+            bt->haveTaskOutput = false;
+        }
+        else
+        {
+            wallcycle_sub_start(wcycle, ewcsLISTED);
+            calcBondedForces(idef, x, fr, pbc_null, g, enerd, nrnb, lambda, dvdl, md,
+                             fcd, bCalcEnerVir, global_atom_index);
+            wallcycle_sub_stop(wcycle, ewcsLISTED);
+        }
 
         wallcycle_sub_start(wcycle, ewcsLISTED_BUF_OPS);
         reduce_thread_output(fr->natoms_force, f, fr->fshift,
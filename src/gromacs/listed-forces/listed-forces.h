@@ -114,6 +114,33 @@ void calc_listed(const t_commrec *cr,
                  struct t_fcdata *fcd, int *ddgatindex,
                  int force_flags);
 
+/*! \brief Prepares for computing the bonded forces with calc_listed_task()
+ *
+ * Returns the number of tasks to run, or 0 when the bonded forces
+ * should be computed by calc_listed() instead. When the return value
+ * is non-zero, all tasks should be run before calling calc_listed(),
+ * which then only reduces the task output and computes the restraints.
+ */
+int prepare_listed_tasks(const t_forcerec *fr,
+                         const t_idef *idef,
+                         const struct t_fcdata *fcd,
+                         int force_flags);
+
+/*! \brief Computes the bonded forces of one task into the thread-local output
+ *
+ * The tasks can run concurrently on any thread, in any order.
+ * The arguments should be the same as for the following calc_listed().
+ */
+void calc_listed_task(int task,
+                      const t_idef *idef,
+                      const rvec x[],
+                      const t_forcerec *fr,
+                      const struct t_pbc *pbc, const struct t_graph *g,
+                      gmx_enerdata_t *enerd, t_nrnb *nrnb, const real *lambda,
+                      const t_mdatoms *md,
+                      struct t_fcdata *fcd, int *global_atom_index,
+                      int force_flags);
+
 /*! \brief As calc_listed(), but only determines the potential energy
  * for the perturbed interactions.
  *
@@ -82,9 +82,14 @@ struct bonded_threading_t
     int            nblock_used;  /**< The number of force blocks to reduce */
     int           *block_index;  /**< Index of size nblock_used into mask */
     gmx_bitmask_t *mask;         /**< Mask array, one element corresponds to a block of reduction_block_size atoms of the force array, bit corresponding to thread indices set if a thread writes to that block */
-    int            block_nalloc; /**< Allocation size of block_index and mask */
+    int           *block_nthread;       /**< The number of threads contributing to each block */
+    int            block_nalloc;        /**< Allocation size of block_index, mask and block_nthread */
+    int           *block_thread_start;  /**< Start index in block_thread for each used block, size nblock_used+1 */
+    int           *block_thread;        /**< List of threads contributing to each used block, sparse version of mask */
+    int            block_thread_nalloc; /**< Allocation size of block_thread */
 
     bool           haveBondeds;  /**< true if we have and thus need to reduce bonded forces */
+    bool           haveTaskOutput; /**< true when calc_listed_task() computed the bonded forces of this step, which then only need to be reduced */
 
     /* There are two different ways to distribute the bonded force calculation
      * over the threads. We dedice which to use based on the number of threads.
@@ -422,35 +422,75 @@ void setup_bonded_threading(t_forcerec *fr, t_idef *idef)
     if (nblock_tot > bt->block_nalloc)
     {
         bt->block_nalloc = over_alloc_large(nblock_tot);
-        srenew(bt->block_index, bt->block_nalloc);
-        srenew(bt->mask,        bt->block_nalloc);
+        srenew(bt->block_index,        bt->block_nalloc);
+        srenew(bt->mask,               bt->block_nalloc);
+        srenew(bt->block_nthread,      bt->block_nalloc);
+        srenew(bt->block_thread_start, bt->block_nalloc + 1);
     }
-    bt->nblock_used = 0;
+
+    /* Generate the union over the threads of the bitmask. The cost of this
+     * is #blocks*#threads, so we spread it over the threads.
+     */
+#pragma omp parallel for num_threads(bt->nthreads) schedule(static)
     for (int b = 0; b < nblock_tot; b++)
     {
         gmx_bitmask_t *mask = &bt->mask[b];
+        int            c    = 0;
 
-        /* Generate the union over the threads of the bitmask */
         bitmask_clear(mask);
         for (int t = 0; t < bt->nthreads; t++)
         {
-            bitmask_union(mask, bt->f_t[t].mask[b]);
+            if (bitmask_is_set(bt->f_t[t].mask[b], t))
+            {
+                bitmask_set_bit(mask, t);
+                c++;
+            }
         }
-        if (!bitmask_is_zero(*mask))
+        bt->block_nthread[b] = c;
+    }
+
+    /* Make the index of the used blocks and the start of their thread lists */
+    bt->nblock_used           = 0;
+    bt->block_thread_start[0] = 0;
+    for (int b = 0; b < nblock_tot; b++)
+    {
+        if (bt->block_nthread[b] > 0)
         {
-            bt->block_index[bt->nblock_used++] = b;
+            bt->block_index[bt->nblock_used] = b;
+            bt->block_thread_start[bt->nblock_used + 1] =
+                bt->block_thread_start[bt->nblock_used] + bt->block_nthread[b];
+            bt->nblock_used++;
         }
+    }
 
-        if (debug)
+    int nthread_tot = bt->block_thread_start[bt->nblock_used];
+    if (nthread_tot > bt->block_thread_nalloc)
+    {
+        bt->block_thread_nalloc = over_alloc_large(nthread_tot);
+        srenew(bt->block_thread, bt->block_thread_nalloc);
+    }
+
+    /* Store the sparse list of contributing threads for each used block */
+#pragma omp parallel for num_threads(bt->nthreads) schedule(static)
+    for (int b = 0; b < bt->nblock_used; b++)
+    {
+        int i = bt->block_thread_start[b];
+        for (int t = 0; t < bt->nthreads; t++)
         {
-            int c = 0;
-            for (int t = 0; t < bt->nthreads; t++)
+            if (bitmask_is_set(bt->mask[bt->block_index[b]], t))
             {
-                if (bitmask_is_set(*mask, t))
-                {
-                    c++;
-                }
+                bt->block_thread[i++] = t;
             }
+        }
+    }
+
+    if (debug)
+    {
+        for (int b = 0; b < nblock_tot; b++)
+        {
+            gmx_bitmask_t *mask = &bt->mask[b];
+            int            c    = bt->block_nthread[b];
+
             ctot += c;
 
             if (gmx_debug_at)
@@ -466,9 +506,6 @@ void setup_bonded_threading(t_forcerec *fr, t_idef *idef)
                         b, flags.c_str(), c);
             }
         }
-    }
-    if (debug)
-    {
         fprintf(debug, "Number of %d atom blocks to reduce: %d\n",
                 reduction_block_size, bt->nblock_used);
         fprintf(debug, "Reduction density %.2f for touched blocks only %.2f\n",
@@ -494,6 +531,7 @@ void init_bonded_threading(FILE *fplog, int nenergrp,
      * is much larger than the reduction overhead.
      */
     bt->nthreads = gmx_omp_nthreads_get(emntBonded);
+    bt->haveTaskOutput = false;
 
     snew(bt->f_t, bt->nthreads);
 #pragma omp parallel for num_threads(bt->nthreads) schedule(static)
@@ -516,10 +554,14 @@ void init_bonded_threading(FILE *fplog, int nenergrp,
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
 
-    bt->nblock_used  = 0;
-    bt->block_index  = nullptr;
-    bt->mask         = nullptr;
-    bt->block_nalloc = 0;
+    bt->nblock_used         = 0;
+    bt->block_index         = nullptr;
+    bt->mask                = nullptr;
+    bt->block_nthread       = nullptr;
+    bt->block_nalloc        = 0;
+    bt->block_thread_start  = nullptr;
+    bt->block_thread        = nullptr;
+    bt->block_thread_nalloc = 0;
 
     /* The optimal value after which to switch from uniform to localized
      * bonded interaction distribution is 3, 4 or 5 depending on the system
@@ -93,6 +93,21 @@ warning_rlimit(const rvec *x, int ai, int aj, int * global_atom_index, real r, r
     }
 }
 
+/*! \brief Issue a warning with warning_rlimit, but only once */
+static void
+warning_rlimit_once(const rvec *x, int ai, int aj, int * global_atom_index, real r, real rlimit)
+{
+    static gmx_bool warned_rlimit = FALSE;
+
+    /* This check isn't race free. But it doesn't matter because if a race occurs the only
+     * disadvantage is that the warning is printed twice */
+    if (warned_rlimit == FALSE)
+    {
+        warning_rlimit(x, ai, aj, global_atom_index, r, rlimit);
+        warned_rlimit = TRUE;
+    }
+}
+
 /*! \brief Compute the energy and force for a single pair interaction */
 static real
 evaluate_single(real r2, real tabscale, real *vftab, real tableStride,
@@ -356,7 +371,6 @@ do_pairs_general(int ftype, int nbonds,
     real             fscal, velec, vvdw;
     real *           energygrp_elec;
     real *           energygrp_vdw;
-    static gmx_bool  warned_rlimit = FALSE;
     /* Free energy stuff */
     gmx_bool         bFreeEnergy;
     real             LFC[2], LFV[2], DLF[2], lfac_coul[2], lfac_vdw[2], dlfac_coul[2], dlfac_vdw[2];
@@ -477,13 +491,7 @@ do_pairs_general(int ftype, int nbonds,
 
         if (r2 >= fr->pairsTable->r*fr->pairsTable->r)
         {
-            /* This check isn't race free. But it doesn't matter because if a race occurs the only
-             * disadvantage is that the warning is printed twice */
-            if (warned_rlimit == FALSE)
-            {
-                warning_rlimit(x, ai, aj, global_atom_index, sqrt(r2), fr->pairsTable->r);
-                warned_rlimit = TRUE;
-            }
+            warning_rlimit_once(x, ai, aj, global_atom_index, sqrt(r2), fr->pairsTable->r);
             continue;
         }
 
@@ -533,28 +541,36 @@ do_pairs_general(int ftype, int nbonds,
 /*! \brief Calculate pairs, only for plain-LJ + plain Coulomb normal type.
  *
  * This function is templated for real/SimdReal and for optimization.
+ * With computeEnergyAndVirial=true, also the group pair energies and
+ * the shift forces are computed. The shift force indices are determined
+ * per pair, as in do_pairs_general.
  */
 template<typename T, int pack_size,
-         typename pbc_type>
+         typename pbc_type, bool computeEnergyAndVirial>
 static void
 do_pairs_simple(int nbonds,
                 const t_iatom iatoms[], const t_iparams iparams[],
-                const rvec x[], rvec4 f[],
+                const rvec x[], rvec4 f[], rvec fshift[],
                 const pbc_type pbc,
+                const t_pbc *pbcForShift, const t_graph *g,
                 const t_mdatoms *md,
-                const real scale_factor)
+                const real scale_factor,
+                real rlimit, gmx_grppairener_t *grppener,
+                int *global_atom_index)
 {
     const int nfa1 = 1 + 2;
 
     T         six(6);
     T         twelve(12);
     T         ef(scale_factor);
+    T         rlimit2(rlimit*rlimit);
 
     const int align = 16;
     GMX_ASSERT(pack_size <= align, "align should be increased");
     GMX_ALIGNED(int,  align)  ai[pack_size];
     GMX_ALIGNED(int,  align)  aj[pack_size];
     GMX_ALIGNED(real, align)  coeff[3*pack_size];
+    GMX_ALIGNED(real, align)  buf[6*pack_size];
 
     /* nbonds is #pairs*nfa1, here we step pack_size pairs */
     for (int i = 0; i < nbonds; i += pack_size*nfa1)
@@ -601,10 +617,6 @@ do_pairs_simple(int nbonds,
         T c12   = load<T>(coeff + 1*pack_size);
         T qq    = load<T>(coeff + 2*pack_size);
 
-        /* We could save these operations by storing 6*C6,12*C12 */
-        c6             = six*c6;
-        c12            = twelve*c12;
-
         T dr[DIM];
         pbc_dx_aiuc(pbc, xi, xj, dr);
 
@@ -613,11 +625,20 @@ do_pairs_simple(int nbonds,
         T rinv2 = rinv*rinv;
         T rinv6 = rinv2*rinv2*rinv2;
 
+        if (computeEnergyAndVirial)
+        {
+            /* As do_pairs_general, we skip pairs beyond the table limit */
+            auto withinLimit = (rsq < rlimit2);
+            c6               = selectByMask(c6, withinLimit);
+            c12              = selectByMask(c12, withinLimit);
+            qq               = selectByMask(qq, withinLimit);
+        }
+
         /* Calculate the Coulomb force * r */
         T cfr   = ef*qq*rinv;
 
         /* Calculate the LJ force * r and add it to the Coulomb part */
-        T fr    = gmx::fma(fms(c12, rinv6, c6), rinv6, cfr);
+        T fr    = gmx::fma(fms(twelve*c12, rinv6, six*c6), rinv6, cfr);
 
         T finvr = fr*rinv2;
         T fx    = finvr*dr[XX];
@@ -630,6 +651,56 @@ do_pairs_simple(int nbonds,
          */
         transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ai, fx, fy, fz);
         transposeScatterDecrU<4>(reinterpret_cast<real *>(f), aj, fx, fy, fz);
+
+        if (computeEnergyAndVirial)
+        {
+            /* The Coulomb energy is equal to the Coulomb force * r */
+            T vvdw = fms(c12, rinv6, c6)*rinv6;
+
+            store(buf + 0*pack_size, fx);
+            store(buf + 1*pack_size, fy);
+            store(buf + 2*pack_size, fz);
+            store(buf + 3*pack_size, cfr);
+            store(buf + 4*pack_size, vvdw);
+            store(buf + 5*pack_size, rsq);
+
+            for (int s = 0; s < pack_size && i + s*nfa1 < nbonds; s++)
+            {
+                if (buf[5*pack_size + s] >= rlimit*rlimit)
+                {
+                    warning_rlimit_once(x, ai[s], aj[s], global_atom_index,
+                                        std::sqrt(buf[5*pack_size + s]), rlimit);
+                    continue;
+                }
+
+                int gid = GID(md->cENER[ai[s]], md->cENER[aj[s]], md->nenergrp);
+                grppener->ener[egCOUL14][gid] += buf[3*pack_size + s];
+                grppener->ener[egLJ14][gid]   += buf[4*pack_size + s];
+
+                int  fshift_index;
+                rvec dx;
+                if (g)
+                {
+                    ivec dt;
+                    ivec_sub(SHIFT_IVEC(g, ai[s]), SHIFT_IVEC(g, aj[s]), dt);
+                    fshift_index = IVEC2IS(dt);
+                }
+                else if (pbcForShift)
+                {
+                    fshift_index = pbc_dx_aiuc(pbcForShift, x[ai[s]], x[aj[s]], dx);
+                }
+                else
+                {
+                    fshift_index = CENTRAL;
+                }
+                if (fshift_index != CENTRAL)
+                {
+                    rvec fij = { buf[0*pack_size + s], buf[1*pack_size + s], buf[2*pack_size + s] };
+                    rvec_inc(fshift[fshift_index], fij);
+                    rvec_dec(fshift[CENTRAL], fij);
+                }
+            }
+        }
     }
 }
 
@@ -647,24 +718,39 @@ do_pairs(int ftype, int nbonds,
 {
     if (ftype == F_LJ14 &&
         fr->ic->vdwtype != evdwUSER && !EEL_USER(fr->ic->eeltype) &&
-        !bCalcEnergyAndVirial && fr->efep == efepNO)
+        fr->efep == efepNO)
     {
         /* We use a fast code-path for plain LJ 1-4 without FEP.
          *
-         * TODO: Add support for energies (straightforward) and virial
-         * in the SIMD template. For the virial it's inconvenient to store
-         * the force sums for the shifts and we should directly calculate
-         * and sum the virial for the shifts. But we should do this
-         * at once for the angles and dihedrals as well.
+         * The energies and shift forces are computed per pair after
+         * the SIMD force calculation. It would be more efficient to
+         * directly calculate and sum the virial for the shifts, but we
+         * should do this at once for the angles and dihedrals as well.
          */
+        const t_pbc *pbcForShift = (fr->bMolPBC ? pbc : nullptr);
+        const real   rlimit      = fr->pairsTable->r;
 #if GMX_SIMD
         GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) pbc_simd[9*GMX_SIMD_REAL_WIDTH];
         set_pbc_simd(pbc, pbc_simd);
 
-        do_pairs_simple<SimdReal, GMX_SIMD_REAL_WIDTH,
-                        const real *>(nbonds, iatoms, iparams,
-                                      x, f, pbc_simd,
-                                      md, fr->ic->epsfac*fr->fudgeQQ);
+        if (bCalcEnergyAndVirial)
+        {
+            do_pairs_simple<SimdReal, GMX_SIMD_REAL_WIDTH,
+                            const real *, true>(nbonds, iatoms, iparams,
+                                                x, f, fshift, pbc_simd,
+                                                pbcForShift, g,
+                                                md, fr->ic->epsfac*fr->fudgeQQ,
+                                                rlimit, grppener, global_atom_index);
+        }
+        else
+        {
+            do_pairs_simple<SimdReal, GMX_SIMD_REAL_WIDTH,
+                            const real *, false>(nbonds, iatoms, iparams,
+                                                 x, f, fshift, pbc_simd,
+                                                 pbcForShift, g,
+                                                 md, fr->ic->epsfac*fr->fudgeQQ,
+                                                 rlimit, grppener, global_atom_index);
+        }
 #else
         /* This construct is needed because pbc_dx_aiuc doesn't accept pbc=NULL */
         t_pbc        pbc_no;
@@ -680,10 +766,24 @@ do_pairs(int ftype, int nbonds,
             pbc_nonnull   = &pbc_no;
         }
 
-        do_pairs_simple<real, 1,
-                        const t_pbc *>(nbonds, iatoms, iparams,
-                                       x, f, pbc_nonnull,
-                                       md, fr->ic->epsfac*fr->fudgeQQ);
+        if (bCalcEnergyAndVirial)
+        {
+            do_pairs_simple<real, 1,
+                            const t_pbc *, true>(nbonds, iatoms, iparams,
+                                                 x, f, fshift, pbc_nonnull,
+                                                 pbcForShift, g,
+                                                 md, fr->ic->epsfac*fr->fudgeQQ,
+                                                 rlimit, grppener, global_atom_index);
+        }
+        else
+        {
+            do_pairs_simple<real, 1,
+                            const t_pbc *, false>(nbonds, iatoms, iparams,
+                                                  x, f, fshift, pbc_nonnull,
+                                                  pbcForShift, g,
+                                                  md, fr->ic->epsfac*fr->fudgeQQ,
+                                                  rlimit, grppener, global_atom_index);
+        }
 #endif
     }
     else
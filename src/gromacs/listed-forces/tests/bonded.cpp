@@ -49,9 +49,19 @@
 
 #include <gtest/gtest.h>
 
+#include "gromacs/listed-forces/pairs.h"
 #include "gromacs/math/units.h"
+#include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/nblist.h"
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/tables/forcetable.h"
+#include "gromacs/utility/smalloc.h"
 
 #include "testutils/refdata.h"
 #include "testutils/testasserts.h"
@@ -155,6 +165,212 @@ class BondedTest : public ::testing::Test
             checker_.checkReal(energy, interaction_function[ftype].longname);
         }
 
+        //! Checks that a SIMD kernel gives the same forces as the plain-C ifunc.
+        void testSimdForces(int                         ftype,
+                            t_ifunc                    *simdIfunc,
+                            const std::vector<t_iatom> &iatoms,
+                            const t_iparams             iparams[],
+                            int                         epbc)
+        {
+            real  dvdlambda = 0;
+            rvec4 fRef[NATOMS], fSimd[NATOMS];
+            rvec  fshiftRef[N_IVEC], fshiftSimd[N_IVEC];
+            for (int i = 0; i < NATOMS; i++)
+            {
+                for (int j = 0; j < 4; j++)
+                {
+                    fRef[i][j]  = 0;
+                    fSimd[i][j] = 0;
+                }
+            }
+            clear_rvecs(N_IVEC, fshiftRef);
+            clear_rvecs(N_IVEC, fshiftSimd);
+            t_pbc pbc;
+            set_pbc(&pbc, epbc, box);
+            int   ddgatindex = 0;
+            real  energyRef  = interaction_function[ftype].ifunc(iatoms.size(), iatoms.data(), iparams,
+                                                                 x, fRef, fshiftRef, &pbc, nullptr,
+                                                                 0, &dvdlambda, nullptr, nullptr,
+                                                                 &ddgatindex);
+            real  energySimd = simdIfunc(iatoms.size(), iatoms.data(), iparams,
+                                         x, fSimd, fshiftSimd, &pbc, nullptr,
+                                         0, &dvdlambda, nullptr, nullptr,
+                                         &ddgatindex);
+
+            checker_.checkReal(energySimd, interaction_function[ftype].longname);
+            test::FloatingPointTolerance tolerance(test::relativeToleranceAsFloatingPoint(100.0, 1e-5));
+            EXPECT_REAL_EQ_TOL(energyRef, energySimd, tolerance);
+            for (int i = 0; i < NATOMS; i++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(fRef[i][d], fSimd[i][d], tolerance);
+                }
+            }
+            for (int i = 0; i < N_IVEC; i++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(fshiftRef[i][d], fshiftSimd[i][d], tolerance);
+                }
+            }
+        }
+
+        //! Checks that a SIMD kernel without energies gives the same forces as the plain-C ifunc.
+        void testSimdNoEnergyForces(int                         ftype,
+                                    void (*simdFunc)(int, const t_iatom[], const t_iparams[],
+                                                     const rvec[], rvec4[],
+                                                     const t_pbc *, const t_graph *,
+                                                     real, const t_mdatoms *, t_fcdata *,
+                                                     int *),
+                                    const std::vector<t_iatom> &iatoms,
+                                    const t_iparams             iparams[],
+                                    int                         epbc)
+        {
+            real  dvdlambda = 0;
+            rvec4 fRef[NATOMS], fSimd[NATOMS];
+            rvec  fshiftRef[N_IVEC];
+            for (int i = 0; i < NATOMS; i++)
+            {
+                for (int j = 0; j < 4; j++)
+                {
+                    fRef[i][j]  = 0;
+                    fSimd[i][j] = 0;
+                }
+            }
+            clear_rvecs(N_IVEC, fshiftRef);
+            t_pbc pbc;
+            set_pbc(&pbc, epbc, box);
+            int   ddgatindex = 0;
+            interaction_function[ftype].ifunc(iatoms.size(), iatoms.data(), iparams,
+                                              x, fRef, fshiftRef, &pbc, nullptr,
+                                              0, &dvdlambda, nullptr, nullptr,
+                                              &ddgatindex);
+            simdFunc(iatoms.size(), iatoms.data(), iparams,
+                     x, fSimd, &pbc, nullptr,
+                     0, nullptr, nullptr,
+                     &ddgatindex);
+
+            test::TestReferenceChecker   forceChecker(checker_.checkCompound("Forces", "Forces"));
+            test::FloatingPointTolerance tolerance(test::relativeToleranceAsFloatingPoint(100.0, 1e-5));
+            forceChecker.setDefaultTolerance(tolerance);
+            for (int i = 0; i < NATOMS; i++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(fRef[i][d], fSimd[i][d], tolerance);
+                }
+                forceChecker.checkVector(fSimd[i], nullptr);
+            }
+        }
+
+        /*! \brief Checks the LJ-14 fast path with energies against the tabulated kernel
+         *
+         * Without perturbed atoms or parameters, the free-energy setting
+         * only selects the general tabulated code path, which we use
+         * as a reference for energies, forces and shift forces.
+         */
+        void testPairsEnergies(int epbc)
+        {
+            const int            nenergrp = 2;
+            real                 chargeA[NATOMS] = { 0.5, -0.3, 0.4, -0.6 };
+            unsigned short       cENER[NATOMS]   = { 0, 0, 1, 1 };
+            std::vector<t_iatom> iatoms          = { 0, 0, 2, 0, 1, 3, 0, 0, 3 };
+            t_iparams            iparams;
+            iparams.lj14.c6A  = iparams.lj14.c6B  = 1e-3;
+            iparams.lj14.c12A = iparams.lj14.c12B = 1e-6;
+
+            t_mdatoms            md = {};
+            md.chargeA  = chargeA;
+            md.chargeB  = chargeA;
+            md.cENER    = cENER;
+            md.nenergrp = nenergrp;
+
+            interaction_const_t  ic = {};
+            ic.eeltype  = eelCUT;
+            ic.vdwtype  = evdwCUT;
+            ic.reppow   = 12;
+            ic.rcoulomb = 1;
+            ic.rvdw     = 1;
+            ic.epsfac   = ONE_4PI_EPS0;
+
+            t_forcerec          *fr = mk_forcerec();
+            fr->ic          = &ic;
+            fr->fudgeQQ     = 0.5;
+            fr->bMolPBC     = (epbc != epbcNONE);
+            fr->sc_power    = 1;
+            fr->sc_r_power  = 6;
+            fr->pairsTable  = make_tables(nullptr, &ic, nullptr, 2, GMX_MAKETABLES_14ONLY);
+
+            t_pbc                pbc;
+            set_pbc(&pbc, epbc, box);
+
+            rvec4                f[2][NATOMS];
+            rvec                 fshift[2][N_IVEC];
+            real                 ener[2][egNR][nenergrp*nenergrp];
+            for (int k = 0; k < 2; k++)
+            {
+                for (int i = 0; i < NATOMS; i++)
+                {
+                    for (int j = 0; j < 4; j++)
+                    {
+                        f[k][i][j] = 0;
+                    }
+                }
+                clear_rvecs(N_IVEC, fshift[k]);
+                gmx_grppairener_t grppener;
+                grppener.nener = nenergrp*nenergrp;
+                for (int e = 0; e < egNR; e++)
+                {
+                    for (int g = 0; g < grppener.nener; g++)
+                    {
+                        ener[k][e][g] = 0;
+                    }
+                    grppener.ener[e] = ener[k][e];
+                }
+                real lambda[efptNR] = { 0 };
+                real dvdl[efptNR]   = { 0 };
+                int  ddgatindex     = 0;
+
+                /* The first pass uses the fast path, the second the general one */
+                fr->efep = (k == 0 ? efepNO : efepYES);
+                do_pairs(F_LJ14, iatoms.size(), iatoms.data(), &iparams,
+                         x, f[k], fshift[k], &pbc, nullptr,
+                         lambda, dvdl, &md, fr, TRUE, &grppener, &ddgatindex);
+            }
+
+            test::FloatingPointTolerance tolerance(test::relativeToleranceAsFloatingPoint(100.0, 1e-5));
+            real                         energyCoul = 0;
+            real                         energyLJ   = 0;
+            for (int g = 0; g < nenergrp*nenergrp; g++)
+            {
+                EXPECT_REAL_EQ_TOL(ener[1][egCOUL14][g], ener[0][egCOUL14][g], tolerance);
+                EXPECT_REAL_EQ_TOL(ener[1][egLJ14][g], ener[0][egLJ14][g], tolerance);
+                energyCoul += ener[0][egCOUL14][g];
+                energyLJ   += ener[0][egLJ14][g];
+            }
+            checker_.checkReal(energyCoul, interaction_function[F_COUL14].longname);
+            checker_.checkReal(energyLJ, interaction_function[F_LJ14].longname);
+            for (int i = 0; i < NATOMS; i++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(f[1][i][d], f[0][i][d], tolerance);
+                }
+            }
+            for (int i = 0; i < N_IVEC; i++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(fshift[1][i][d], fshift[0][i][d], tolerance);
+                }
+            }
+
+            sfree_aligned(fr->pairsTable->data);
+            sfree(fr->pairsTable);
+            sfree(fr);
+        }
+
 };
 
 TEST_F (BondedTest, BondAnglePbcNone)
@@ -274,6 +490,116 @@ TEST_F (BondedTest, IfuncProperDihedralsPbcXyz)
     testIfunc(F_PDIHS, iatoms, &iparams, epbcXYZ);
 }
 
+#if GMX_SIMD_HAVE_REAL
+TEST_F (BondedTest, SimdBondsPbcNo)
+{
+    std::vector<t_iatom> iatoms = { 0, 0, 1, 0, 1, 2, 0, 2, 3 };
+    t_iparams            iparams;
+    iparams.harmonic.rA  = iparams.harmonic.rB  = 0.8;
+    iparams.harmonic.krA = iparams.harmonic.krB = 50;
+    testSimdForces(F_BONDS, bonds_simd, iatoms, &iparams, epbcNONE);
+}
+
+TEST_F (BondedTest, SimdBondsPbcXyz)
+{
+    std::vector<t_iatom> iatoms = { 0, 0, 1, 0, 1, 2, 0, 2, 3 };
+    t_iparams            iparams;
+    iparams.harmonic.rA  = iparams.harmonic.rB  = 0.8;
+    iparams.harmonic.krA = iparams.harmonic.krB = 50;
+    testSimdForces(F_BONDS, bonds_simd, iatoms, &iparams, epbcXYZ);
+}
+
+TEST_F (BondedTest, SimdUreyBradleyPbcNo)
+{
+    std::vector<t_iatom> iatoms = { 0, 0, 1, 2, 0, 1, 2, 3, 0, 0, 1, 3 };
+    t_iparams            iparams;
+    iparams.u_b.thetaA  = iparams.u_b.thetaB  = 100;
+    iparams.u_b.kthetaA = iparams.u_b.kthetaB = 50;
+    iparams.u_b.r13A    = iparams.u_b.r13B    = 1.2;
+    iparams.u_b.kUBA    = iparams.u_b.kUBB    = 100;
+    testSimdNoEnergyForces(F_UREY_BRADLEY, urey_bradley_noener_simd, iatoms, &iparams, epbcNONE);
+}
+
+TEST_F (BondedTest, SimdUreyBradleyPbcXyz)
+{
+    std::vector<t_iatom> iatoms = { 0, 0, 1, 2, 0, 1, 2, 3, 0, 0, 1, 3 };
+    t_iparams            iparams;
+    iparams.u_b.thetaA  = iparams.u_b.thetaB  = 100;
+    iparams.u_b.kthetaA = iparams.u_b.kthetaB = 50;
+    iparams.u_b.r13A    = iparams.u_b.r13B    = 1.2;
+    iparams.u_b.kUBA    = iparams.u_b.kUBB    = 100;
+    testSimdNoEnergyForces(F_UREY_BRADLEY, urey_bradley_noener_simd, iatoms, &iparams, epbcXYZ);
+}
+
+TEST_F (BondedTest, SimdImproperDihedralsPbcNo)
+{
+    std::vector<t_iatom> iatoms = { 0, 0, 1, 2, 3, 0, 3, 2, 1, 0 };
+    t_iparams            iparams;
+    iparams.harmonic.rA  = iparams.harmonic.rB  = -80;
+    iparams.harmonic.krA = iparams.harmonic.krB = 10;
+    testSimdNoEnergyForces(F_IDIHS, idihs_noener_simd, iatoms, &iparams, epbcNONE);
+}
+
+TEST_F (BondedTest, SimdImproperDihedralsPbcXyz)
+{
+    std::vector<t_iatom> iatoms = { 0, 0, 1, 2, 3, 0, 3, 2, 1, 0 };
+    t_iparams            iparams;
+    iparams.harmonic.rA  = iparams.harmonic.rB  = -80;
+    iparams.harmonic.krA = iparams.harmonic.krB = 10;
+    testSimdNoEnergyForces(F_IDIHS, idihs_noener_simd, iatoms, &iparams, epbcXYZ);
+}
+
+TEST_F (BondedTest, SimdUreyBradleyWithEnergiesPbcNo)
+{
+    std::vector<t_iatom> iatoms = { 0, 0, 1, 2, 0, 1, 2, 3, 0, 0, 1, 3 };
+    t_iparams            iparams;
+    iparams.u_b.thetaA  = iparams.u_b.thetaB  = 100;
+    iparams.u_b.kthetaA = iparams.u_b.kthetaB = 50;
+    iparams.u_b.r13A    = iparams.u_b.r13B    = 1.2;
+    iparams.u_b.kUBA    = iparams.u_b.kUBB    = 100;
+    testSimdForces(F_UREY_BRADLEY, urey_bradley_simd, iatoms, &iparams, epbcNONE);
+}
+
+TEST_F (BondedTest, SimdUreyBradleyWithEnergiesPbcXyz)
+{
+    std::vector<t_iatom> iatoms = { 0, 0, 1, 2, 0, 1, 2, 3, 0, 0, 1, 3 };
+    t_iparams            iparams;
+    iparams.u_b.thetaA  = iparams.u_b.thetaB  = 100;
+    iparams.u_b.kthetaA = iparams.u_b.kthetaB = 50;
+    iparams.u_b.r13A    = iparams.u_b.r13B    = 1.2;
+    iparams.u_b.kUBA    = iparams.u_b.kUBB    = 100;
+    testSimdForces(F_UREY_BRADLEY, urey_bradley_simd, iatoms, &iparams, epbcXYZ);
+}
+
+TEST_F (BondedTest, SimdImproperDihedralsWithEnergiesPbcNo)
+{
+    std::vector<t_iatom> iatoms = { 0, 0, 1, 2, 3, 0, 3, 2, 1, 0 };
+    t_iparams            iparams;
+    iparams.harmonic.rA  = iparams.harmonic.rB  = -80;
+    iparams.harmonic.krA = iparams.harmonic.krB = 10;
+    testSimdForces(F_IDIHS, idihs_simd, iatoms, &iparams, epbcNONE);
+}
+
+TEST_F (BondedTest, SimdImproperDihedralsWithEnergiesPbcXyz)
+{
+    std::vector<t_iatom> iatoms = { 0, 0, 1, 2, 3, 0, 3, 2, 1, 0 };
+    t_iparams            iparams;
+    iparams.harmonic.rA  = iparams.harmonic.rB  = -80;
+    iparams.harmonic.krA = iparams.harmonic.krB = 10;
+    testSimdForces(F_IDIHS, idihs_simd, iatoms, &iparams, epbcXYZ);
+}
+#endif
+
+TEST_F (BondedTest, PairsEnergiesPbcNo)
+{
+    testPairsEnergies(epbcNONE);
+}
+
+TEST_F (BondedTest, PairsEnergiesPbcXyz)
+{
+    testPairsEnergies(epbcXYZ);
+}
+
 }
 
 }
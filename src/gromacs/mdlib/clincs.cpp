@@ -88,6 +88,11 @@ typedef struct {
     int    nind_r;     /* number of indices */
     int   *ind_r;      /* constraint index for updating atom data */
     int    ind_nalloc; /* allocation size of ind and ind_r */
+    int    nblock_int;   /* number of SIMD blocks without communicated atoms */
+    int   *block_int;    /* first constraint index of those blocks */
+    int    nblock_bnd;   /* number of SIMD blocks with communicated atoms */
+    int   *block_bnd;    /* first constraint index of those blocks */
+    int    block_nalloc; /* allocation size of block_int and block_bnd */
     tensor vir_r_m_dr; /* temporary variable for virial calculation */
     real   dhdlambda;  /* temporary variable for lambda derivative */
 } lincs_task_t;
@@ -117,6 +122,8 @@ typedef struct gmx_lincsdata {
     int             ntriangle;    /* the local number of constraints in triangles */
     int             ncc_triangle; /* the number of constraint connections in triangles */
     gmx_bool        bCommIter;    /* communicate before each LINCS interation */
+    gmx_bool        bCommOverlap; /* overlap the iteration communication with the interior constraints */
+    int             at_comm;      /* atoms >= at_comm are set by the communication */
     real           *blmf;         /* matrix of mass factors for constraint connections */
     real           *blmf1;        /* as blmf, but with all masses 1 */
     real           *bllen;        /* the reference bond length */
@@ -156,6 +163,11 @@ real *lincs_rmsd_data(struct gmx_lincsdata *lincsd)
     return lincsd->rmsd_data;
 }
 
+int lincs_ntask(struct gmx_lincsdata *lincsd)
+{
+    return lincsd->ntask;
+}
+
 real lincs_rmsd(struct gmx_lincsdata *lincsd)
 {
     if (lincsd->rmsd_data[0] > 0)
@@ -884,6 +896,42 @@ calc_dist_iter_simd(int                       b0,
 }
 #endif // GMX_SIMD_HAVE_REAL
 
+/* Determine the distances and right-hand side for the next iteration
+ * for the nblock constraint blocks of simd_width starting at block[].
+ */
+static void calc_dist_iter_blocks(int                       nblock,
+                                  const int                *block,
+                                  const int                *bla,
+                                  const rvec * gmx_restrict xp,
+                                  const real * gmx_restrict bllen,
+                                  const real * gmx_restrict blc,
+                                  const t_pbc              *pbc,
+                                  const real               *pbc_simd,
+                                  real                      wfac,
+                                  real * gmx_restrict       rhs,
+                                  real * gmx_restrict       sol,
+                                  gmx_bool                 *bWarn)
+{
+#if GMX_SIMD_HAVE_REAL
+    GMX_UNUSED_VALUE(pbc);
+#else
+    GMX_UNUSED_VALUE(pbc_simd);
+#endif
+
+    for (int k = 0; k < nblock; k++)
+    {
+        int bs = block[k];
+
+#if GMX_SIMD_HAVE_REAL
+        calc_dist_iter_simd(bs, bs + simd_width, bla, xp, bllen, blc, pbc_simd, wfac,
+                            rhs, sol, bWarn);
+#else
+        calc_dist_iter(bs, bs + simd_width, bla, xp, bllen, blc, pbc, wfac,
+                       rhs, sol, bWarn);
+#endif
+    }
+}
+
 static void do_lincs(rvec *x, rvec *xp, matrix box, t_pbc *pbc,
                      struct gmx_lincsdata *lincsd, int th,
                      const real *invmass,
@@ -1033,34 +1081,64 @@ static void do_lincs(rvec *x, rvec *xp, matrix box, t_pbc *pbc,
     wfac = std::cos(DEG2RAD*wangle);
     wfac = wfac*wfac;
 
+#if !GMX_SIMD_HAVE_REAL
+    const real *pbc_simd = nullptr;
+#endif
+
     for (iter = 0; iter < lincsd->nIter; iter++)
     {
-        if ((lincsd->bCommIter && DOMAINDECOMP(cr) && cr->dd->constraints))
+        if (lincsd->bCommOverlap && DOMAINDECOMP(cr) && cr->dd->constraints)
         {
+            lincs_task_t *li_task = &lincsd->task[th];
+
+            /* All threads should be done updating xp before communicating */
 #pragma omp barrier
 #pragma omp master
             {
                 /* Communicate the corrected non-local coordinates */
-                if (DOMAINDECOMP(cr))
-                {
-                    dd_move_x_constraints(cr->dd, box, xp, nullptr, FALSE);
-                }
+                dd_move_x_constraints(cr->dd, box, xp, nullptr, FALSE);
             }
+
+            /* The other threads do not wait for the communication,
+             * but compute the constraints without communicated atoms.
+             */
+            calc_dist_iter_blocks(li_task->nblock_int, li_task->block_int,
+                                  bla, xp, bllen, blc, pbc, pbc_simd, wfac,
+                                  rhs1, sol, bWarn);
 #pragma omp barrier
+            calc_dist_iter_blocks(li_task->nblock_bnd, li_task->block_bnd,
+                                  bla, xp, bllen, blc, pbc, pbc_simd, wfac,
+                                  rhs1, sol, bWarn);
         }
-        else if (lincsd->bTaskDep)
+        else
         {
+            if ((lincsd->bCommIter && DOMAINDECOMP(cr) && cr->dd->constraints))
+            {
 #pragma omp barrier
-        }
+#pragma omp master
+                {
+                    /* Communicate the corrected non-local coordinates */
+                    if (DOMAINDECOMP(cr))
+                    {
+                        dd_move_x_constraints(cr->dd, box, xp, nullptr, FALSE);
+                    }
+                }
+#pragma omp barrier
+            }
+            else if (lincsd->bTaskDep)
+            {
+#pragma omp barrier
+            }
 
 #if GMX_SIMD_HAVE_REAL
-        calc_dist_iter_simd(b0, b1, bla, xp, bllen, blc, pbc_simd, wfac,
-                            rhs1, sol, bWarn);
+            calc_dist_iter_simd(b0, b1, bla, xp, bllen, blc, pbc_simd, wfac,
+                                rhs1, sol, bWarn);
 #else
-        calc_dist_iter(b0, b1, bla, xp, bllen, blc, pbc, wfac,
-                       rhs1, sol, bWarn);
-        /* 20*ncons flops */
-#endif  // GMX_SIMD_HAVE_REAL
+            calc_dist_iter(b0, b1, bla, xp, bllen, blc, pbc, wfac,
+                           rhs1, sol, bWarn);
+            /* 20*ncons flops */
+#endif      // GMX_SIMD_HAVE_REAL
+        }
 
         lincs_matrix_expand(lincsd, &lincsd->task[th], blcc, rhs1, rhs2, sol);
         /* nrec*(ncons+2*nrtot) flops */
@@ -1483,6 +1561,10 @@ gmx_lincsdata_t init_lincs(FILE *fplog, const gmx_mtop_t *mtop,
      */
     li->ntask    = gmx_omp_nthreads_get(emntLINCS);
     li->bTaskDep = (li->ntask > 1 && bMoreThanTwoSeq);
+    /* With multiple threads, the threads that do not communicate can
+     * work on constraints that do not involve communicated atoms.
+     */
+    li->bCommOverlap = (li->bCommIter && li->ntask > 1);
     if (debug)
     {
         fprintf(debug, "LINCS: using %d threads, tasks are %sdependent\n",
@@ -1890,6 +1972,43 @@ static void set_matrix_indices(struct gmx_lincsdata *li,
     }
 }
 
+/* Sorts the constraint blocks of task li_task into blocks with and
+ * without atoms that are set by the communication between iterations.
+ */
+static void set_comm_blocks(const gmx_lincsdata *li, lincs_task_t *li_task)
+{
+    int nblock = (li_task->b1 - li_task->b0 + simd_width - 1)/simd_width;
+    if (nblock > li_task->block_nalloc)
+    {
+        li_task->block_nalloc = over_alloc_large(nblock);
+        srenew(li_task->block_int, li_task->block_nalloc);
+        srenew(li_task->block_bnd, li_task->block_nalloc);
+    }
+
+    li_task->nblock_int = 0;
+    li_task->nblock_bnd = 0;
+    for (int bs = li_task->b0; bs < li_task->b1; bs += simd_width)
+    {
+        bool bComm = false;
+        /* The SIMD padding entries are copies, so we can check them too */
+        for (int b = bs; b < bs + simd_width; b++)
+        {
+            if (li->bla[2*b] >= li->at_comm || li->bla[2*b + 1] >= li->at_comm)
+            {
+                bComm = true;
+            }
+        }
+        if (bComm)
+        {
+            li_task->block_bnd[li_task->nblock_bnd++] = bs;
+        }
+        else
+        {
+            li_task->block_int[li_task->nblock_int++] = bs;
+        }
+    }
+}
+
 void set_lincs(const t_idef         *idef,
                const t_mdatoms      *md,
                gmx_bool              bDynamics,
@@ -1936,18 +2055,18 @@ void set_lincs(const t_idef         *idef,
     {
         if (cr->dd->constraints)
         {
-            int start;
-
-            dd_get_constraint_range(cr->dd, &start, &natoms);
+            dd_get_constraint_range(cr->dd, &li->at_comm, &natoms);
         }
         else
         {
-            natoms = cr->dd->nat_home;
+            natoms      = cr->dd->nat_home;
+            li->at_comm = natoms;
         }
     }
     else
     {
-        natoms = md->homenr;
+        natoms      = md->homenr;
+        li->at_comm = natoms;
     }
     at2con = make_at2con(0, natoms, idef->il, idef->iparams, bDynamics,
                          &nflexcon);
@@ -2148,6 +2267,11 @@ void set_lincs(const t_idef         *idef,
             }
 
             set_matrix_indices(li, li_task, &at2con, bSortMatrix);
+
+            if (li->bCommOverlap && DOMAINDECOMP(cr) && cr->dd->constraints)
+            {
+                set_comm_blocks(li, li_task);
+            }
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
@@ -2322,6 +2446,21 @@ static void cconerr(const struct gmx_lincsdata *lincsd,
     *imax      = im;
 }
 
+/* Runs concurrentWork on the LINCS threads, without overlap with LINCS */
+static void runConcurrentWork(const gmx_lincsdata              *lincsd,
+                              const lincs_concurrent_work_t    *concurrentWork)
+{
+#pragma omp parallel num_threads(lincsd->ntask)
+    {
+        try
+        {
+            concurrentWork->func(concurrentWork->data, lincsd->ntask,
+                                 gmx_omp_get_thread_num());
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+}
+
 gmx_bool constrain_lincs(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
                          t_inputrec *ir,
                          gmx_int64_t step,
@@ -2334,7 +2473,8 @@ gmx_bool constrain_lincs(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
                          gmx_bool bCalcVir, tensor vir_r_m_dr,
                          int econq,
                          t_nrnb *nrnb,
-                         int maxwarn, int *warncount)
+                         int maxwarn, int *warncount,
+                         const lincs_concurrent_work_t *concurrentWork)
 {
     gmx_bool  bCalcDHDL;
     char      buf[STRLEN], buf2[22], buf3[STRLEN];
@@ -2359,6 +2499,11 @@ gmx_bool constrain_lincs(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
             lincsd->rmsd_data[1] = 0;
         }
 
+        if (concurrentWork != nullptr)
+        {
+            runConcurrentWork(lincsd, concurrentWork);
+        }
+
         return bOK;
     }
 
@@ -2420,6 +2565,13 @@ gmx_bool constrain_lincs(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
          */
         bWarn = FALSE;
 
+        /* When LINCS communicates coordinates between the iterations,
+         * the master thread might send coordinates of atoms that are
+         * updated by the concurrent work, so we can not overlap then.
+         */
+        bool bOverlapWork = (concurrentWork != nullptr &&
+                             !(cr->dd != nullptr && lincsd->bCommIter));
+
         /* The OpenMP parallel region of constrain_lincs for coords */
 #pragma omp parallel num_threads(lincsd->ntask)
         {
@@ -2435,10 +2587,23 @@ gmx_bool constrain_lincs(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
                          ir->LincsWarnAngle, &bWarn,
                          invdt, v, bCalcVir,
                          th == 0 ? vir_r_m_dr : lincsd->task[th].vir_r_m_dr);
+
+                /* do_lincs ends without a barrier, so a thread can start
+                 * on the extra work while other threads are still busy.
+                 */
+                if (bOverlapWork)
+                {
+                    concurrentWork->func(concurrentWork->data, lincsd->ntask, th);
+                }
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
         }
 
+        if (concurrentWork != nullptr && !bOverlapWork)
+        {
+            runConcurrentWork(lincsd, concurrentWork);
+        }
+
         if (bLog && fplog && lincsd->nc > 0)
         {
             fprintf(fplog, "   Rel. Constraint Deviation:  RMS         MAX     between atoms\n");
@@ -271,6 +271,42 @@ static void pr_sortblock(FILE *fp, const char *title, int nsb, t_sortblock sb[])
     }
 }
 
+/* The data needed for constraining coordinates with SETTLE */
+typedef struct {
+    gmx_constr_t  constr;
+    const t_pbc  *pbc;
+    const rvec   *x;
+    rvec         *xprime;
+    real          invdt;
+    rvec         *v;
+    bool          bCalcVir;
+    rvec         *vir_r_m_dr;
+    bool         *bSettleErrorHasOccurred;
+} settle_coord_work_t;
+
+/* Constrains the coordinates with SETTLE for thread th out of nth,
+ * data should point to a settle_coord_work_t struct.
+ */
+static void settle_coord_thread(void *data, int nth, int th)
+{
+    const settle_coord_work_t *work   = static_cast<const settle_coord_work_t *>(data);
+    gmx_constr_t               constr = work->constr;
+
+    if (th > 0)
+    {
+        clear_mat(constr->vir_r_m_dr_th[th]);
+    }
+
+    csettle(constr->settled,
+            nth, th,
+            work->pbc,
+            work->x[0], work->xprime[0],
+            work->invdt, work->v ? work->v[0] : nullptr,
+            work->bCalcVir,
+            th == 0 ? work->vir_r_m_dr : constr->vir_r_m_dr_th[th],
+            th == 0 ? work->bSettleErrorHasOccurred : &constr->bSettleErrorHasOccurred[th]);
+}
+
 gmx_bool constrain(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
                    struct gmx_constr *constr,
                    t_idef *idef, t_inputrec *ir,
@@ -384,6 +420,31 @@ gmx_bool constrain(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
         }
     }
 
+    /* SETTLE and LINCS act on disjoint sets of atoms. When they use
+     * the same number of threads, we let each LINCS thread continue
+     * with its part of SETTLE as soon as it is done with LINCS.
+     */
+    bool                    bSettleErrorHasOccurred = false;
+    bool                    bSettleWithLincs        =
+        (nsettle > 0 && econq == econqCoord &&
+         constr->lincsd != nullptr && lincs_ntask(constr->lincsd) == nth);
+    settle_coord_work_t     settleWorkData;
+    lincs_concurrent_work_t settleWork;
+    if (bSettleWithLincs)
+    {
+        settleWorkData.constr                  = constr;
+        settleWorkData.pbc                     = pbc_null;
+        settleWorkData.x                       = x;
+        settleWorkData.xprime                  = xprime;
+        settleWorkData.invdt                   = invdt;
+        settleWorkData.v                       = v;
+        settleWorkData.bCalcVir                = (vir != nullptr);
+        settleWorkData.vir_r_m_dr              = vir_r_m_dr;
+        settleWorkData.bSettleErrorHasOccurred = &bSettleErrorHasOccurred;
+        settleWork.func                        = settle_coord_thread;
+        settleWork.data                        = &settleWorkData;
+    }
+
     if (constr->lincsd != nullptr)
     {
         bOK = constrain_lincs(fplog, bLog, bEner, ir, step, constr->lincsd, md, cr,
@@ -391,7 +452,8 @@ gmx_bool constrain(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
                               box, pbc_null, lambda, dvdlambda,
                               invdt, v, vir != nullptr, vir_r_m_dr,
                               econq, nrnb,
-                              constr->maxwarn, &constr->warncount_lincs);
+                              constr->maxwarn, &constr->warncount_lincs,
+                              bSettleWithLincs ? &settleWork : nullptr);
         if (!bOK && constr->maxwarn < INT_MAX)
         {
             if (fplog != nullptr)
@@ -441,31 +503,31 @@ gmx_bool constrain(FILE *fplog, gmx_bool bLog, gmx_bool bEner,
 
     if (nsettle > 0)
     {
-        bool bSettleErrorHasOccurred = false;
-
         switch (econq)
         {
             case econqCoord:
-#pragma omp parallel for num_threads(nth) schedule(static)
-                for (th = 0; th < nth; th++)
+                if (!bSettleWithLincs)
                 {
-                    try
+                    settle_coord_work_t work;
+                    work.constr                  = constr;
+                    work.pbc                     = pbc_null;
+                    work.x                       = x;
+                    work.xprime                  = xprime;
+                    work.invdt                   = invdt;
+                    work.v                       = v;
+                    work.bCalcVir                = (vir != nullptr);
+                    work.vir_r_m_dr              = vir_r_m_dr;
+                    work.bSettleErrorHasOccurred = &bSettleErrorHasOccurred;
+
+#pragma omp parallel for num_threads(nth) schedule(static)
+                    for (th = 0; th < nth; th++)
                     {
-                        if (th > 0)
+                        try
                         {
-                            clear_mat(constr->vir_r_m_dr_th[th]);
+                            settle_coord_thread(&work, nth, th);
                         }
-
-                        csettle(constr->settled,
-                                nth, th,
-                                pbc_null,
-                                x[0], xprime[0],
-                                invdt, v ? v[0] : nullptr,
-                                vir != nullptr,
-                                th == 0 ? vir_r_m_dr : constr->vir_r_m_dr_th[th],
-                                th == 0 ? &bSettleErrorHasOccurred : &constr->bSettleErrorHasOccurred[th]);
+                        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
                     }
-                    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
                 }
                 inc_nrnb(nrnb, eNR_SETTLE, nsettle);
                 if (v != nullptr)
@@ -263,6 +263,9 @@ real *lincs_rmsd_data(gmx_lincsdata_t lincsd);
 real lincs_rmsd(gmx_lincsdata_t lincsd);
 /* Return the RMSD of the constraint */
 
+int lincs_ntask(gmx_lincsdata_t lincsd);
+/* Return the number of LINCS tasks, equal to the number of LINCS threads */
+
 gmx_lincsdata_t init_lincs(FILE *fplog, const gmx_mtop_t *mtop,
                            int nflexcon_global, const t_blocka *at2con,
                            gmx_bool bPLINCS, int nIter, int nProjOrder);
@@ -281,6 +284,17 @@ real constr_r_max(FILE *fplog, const gmx_mtop_t *mtop, const t_inputrec *ir);
  * required for LINCS.
  */
 
+/* Work that the LINCS threads can run when they are done with their own
+ * LINCS task, without waiting for the other LINCS threads. This is used
+ * to run SETTLE concurrently with LINCS. func is called once for each
+ * LINCS thread with data, the number of threads and the thread index.
+ * The work should not touch atoms that are constrained by LINCS.
+ */
+typedef struct {
+    void (*func)(void *data, int nthread, int thread);
+    void  *data;
+} lincs_concurrent_work_t;
+
 gmx_bool
 constrain_lincs(FILE *log, gmx_bool bLog, gmx_bool bEner,
                 t_inputrec *ir,
@@ -294,8 +308,12 @@ constrain_lincs(FILE *log, gmx_bool bLog, gmx_bool bEner,
                 gmx_bool bCalcVir, tensor vir_r_m_dr,
                 int econ,
                 t_nrnb *nrnb,
-                int maxwarn, int *warncount);
-/* Returns if the constraining succeeded */
+                int maxwarn, int *warncount,
+                const lincs_concurrent_work_t *concurrentWork);
+/* Returns if the constraining succeeded.
+ * When concurrentWork!=NULL, econ should be econqCoord and the work
+ * is executed, when possible overlapping with the LINCS iterations.
+ */
 
 
 /* helper functions for andersen temperature control, because the
@@ -2164,6 +2164,7 @@ static void init_nb_verlet(FILE                *fp,
 
     nbv->emulateGpu = ((getenv("GMX_EMULATE_GPU") != nullptr) ? EmulateGpuNonbonded::Yes : EmulateGpuNonbonded::No);
     nbv->bUseGPU    = deviceInfo != nullptr;
+    nbv->bListedForceTasks = (getenv("GMX_NO_LISTED_NB_TASKS") == nullptr);
 
     GMX_RELEASE_ASSERT(!(nbv->emulateGpu == EmulateGpuNonbonded::Yes && nbv->bUseGPU), "When GPU emulation is active, there cannot be a GPU assignment");
 
@@ -43,6 +43,17 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if HAVE_SCHED_AFFINITY
+#  include <sched.h>
+#endif
+
 #include "gromacs/gmxlib/network.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/utility/cstringutil.h"
@@ -567,3 +578,258 @@ gmx_omp_nthreads_set(int mod, int nthreads)
 
     modth.nth[mod] = nthreads;
 }
+
+namespace
+{
+
+/*! \brief The number of spin-wait iterations of an idle pool worker
+ * before it goes to sleep.
+ *
+ * With MD steps of tens of microseconds, workers keep spinning between
+ * the tasks of a step, but sleep during longer serial parts, such as
+ * output, and when OpenMP regions need the cores.
+ */
+const int c_threadPoolSpinCount = 20000;
+
+/*! \brief The number of bits of the pool command word storing the number of threads
+ *
+ * This limits the pool to less than 2^c_threadPoolThreadBits threads.
+ */
+const int c_threadPoolThreadBits = 12;
+
+#if HAVE_SCHED_AFFINITY
+//! The CPU set type of the pool worker affinities
+typedef cpu_set_t AffinitySet;
+#else
+//! Placeholder for the CPU set type, affinities are not set
+typedef int AffinitySet;
+#endif
+
+/*! \brief A pool of persistent, pinned threads for running short tasks
+ *
+ * A dispatch is published as a single atomic command word holding
+ * a generation count and the number of threads of the dispatch,
+ * so a worker always sees a consistent pair. Workers spin on the command
+ * word for a while and then sleep on a condition variable.
+ */
+class ThreadPool
+{
+    public:
+        ThreadPool(int numThreads, const std::vector<const AffinitySet *> &affinity) :
+            task_(nullptr), data_(nullptr), isRunning_(false), command_(0),
+            numRemaining_(0), numSleeping_(0), stop_(false)
+        {
+            for (int th = 1; th < numThreads; th++)
+            {
+                workers_.push_back(std::thread(&ThreadPool::runWorker, this, th,
+                                               affinity.empty() ? nullptr : affinity[th]));
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_.store(true);
+                cv_.notify_all();
+            }
+            for (std::thread &worker : workers_)
+            {
+                worker.join();
+            }
+        }
+
+        //! Returns the number of threads, including the master thread
+        int numThreads() const { return static_cast<int>(workers_.size()) + 1; }
+
+        //! Returns whether the pool is running tasks, only valid on the master thread
+        bool isRunning() const { return isRunning_; }
+
+        //! Runs \p task for threads 0 to \p numThreads-1, see gmx_omp_nthreads_run()
+        void run(int numThreads, gmx_thread_task_t task, void *data)
+        {
+            isRunning_ = true;
+            task_      = task;
+            data_      = data;
+            numRemaining_.store(numThreads - 1, std::memory_order_relaxed);
+
+            /* Publishing a new command also releases task_ and data_ */
+            unsigned int generation = (command_.load(std::memory_order_relaxed) >> c_threadPoolThreadBits) + 1;
+            command_.store((generation << c_threadPoolThreadBits) | numThreads);
+            if (numSleeping_.load() > 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                cv_.notify_all();
+            }
+
+            task(0, data);
+
+            int spin = 0;
+            while (numRemaining_.load(std::memory_order_acquire) > 0)
+            {
+                if (spin < c_threadPoolSpinCount)
+                {
+                    gmx_pause();
+                    spin++;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+            isRunning_ = false;
+        }
+
+    private:
+        //! The loop run by the worker thread with index \p thread
+        void runWorker(int thread, const AffinitySet *affinity)
+        {
+#if HAVE_SCHED_AFFINITY
+            if (affinity != nullptr)
+            {
+                /* Failure only affects performance, so we ignore it */
+                sched_setaffinity(0, sizeof(cpu_set_t), affinity);
+            }
+#else
+            GMX_UNUSED_VALUE(affinity);
+#endif
+            /* Start from the initial command, not the current one, as
+             * the master might already have published the first dispatch.
+             */
+            unsigned int command = 0;
+
+            while (true)
+            {
+                unsigned int newCommand;
+                int          spin = 0;
+
+                while ((newCommand = command_.load(std::memory_order_acquire)) == command &&
+                       !stop_.load(std::memory_order_relaxed))
+                {
+                    if (spin < c_threadPoolSpinCount)
+                    {
+                        gmx_pause();
+                        spin++;
+                    }
+                    else
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        numSleeping_++;
+                        while (command_.load() == command && !stop_.load())
+                        {
+                            cv_.wait(lock);
+                        }
+                        numSleeping_--;
+                    }
+                }
+                if (stop_.load())
+                {
+                    break;
+                }
+                command = newCommand;
+
+                int numThreads = command & ((1U << c_threadPoolThreadBits) - 1);
+                if (thread < numThreads)
+                {
+                    task_(thread, data_);
+                    numRemaining_.fetch_sub(1, std::memory_order_release);
+                }
+            }
+        }
+
+        std::vector<std::thread>  workers_;
+        gmx_thread_task_t         task_;
+        void                     *data_;
+        bool                      isRunning_;
+        std::atomic<unsigned int> command_;
+        std::atomic<int>          numRemaining_;
+        std::atomic<int>          numSleeping_;
+        std::atomic<bool>         stop_;
+        std::mutex                mutex_;
+        std::condition_variable   cv_;
+};
+
+//! The thread pool of the rank of the current thread, nullptr when not used
+thread_local ThreadPool *threadPool = nullptr;
+
+} // namespace
+
+void gmx_omp_nthreads_init_thread_pool(const gmx::MDLogger &mdlog,
+                                       const t_commrec     *cr,
+                                       int                  nthreads,
+                                       int                  nthreads_hw_avail)
+{
+    GMX_RELEASE_ASSERT(threadPool == nullptr, "The thread pool should only be initialized once");
+
+    if (getenv("GMX_THREAD_POOL") == nullptr || nthreads <= 1 ||
+        nthreads >= (1 << c_threadPoolThreadBits))
+    {
+        return;
+    }
+    if (cr->nrank_intranode*nthreads > nthreads_hw_avail)
+    {
+        if (MASTER(cr))
+        {
+            GMX_LOG(mdlog.warning).asParagraph().appendText(
+                    "NOTE: GMX_THREAD_POOL is set, but the thread pool is not used\n"
+                    "      because the threads oversubscribe the CPU cores.");
+        }
+        return;
+    }
+
+    /* Pin the workers to the cores of the OpenMP threads, when these are set */
+    std::vector<AffinitySet>         affinitySets;
+    std::vector<const AffinitySet *> affinity;
+#if HAVE_SCHED_AFFINITY
+    affinitySets.resize(nthreads);
+    std::vector<int> haveAffinity(nthreads);
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+    for (int th = 0; th < nthreads; th++)
+    {
+        haveAffinity[th] = (sched_getaffinity(0, sizeof(cpu_set_t), &affinitySets[th]) == 0);
+    }
+    if (std::find(haveAffinity.begin(), haveAffinity.end(), 0) == haveAffinity.end())
+    {
+        for (const AffinitySet &set : affinitySets)
+        {
+            affinity.push_back(&set);
+        }
+    }
+#endif
+
+    threadPool = new ThreadPool(nthreads, affinity);
+
+    if (MASTER(cr))
+    {
+        GMX_LOG(mdlog.info).appendTextFormatted(
+                "Using a persistent pool of %d threads per rank for short parallel tasks",
+                nthreads);
+    }
+}
+
+void gmx_omp_nthreads_finish_thread_pool()
+{
+    delete threadPool;
+    threadPool = nullptr;
+}
+
+void gmx_omp_nthreads_run(int nthreads, gmx_thread_task_t task, void *data)
+{
+    if (nthreads == 1)
+    {
+        task(0, data);
+    }
+    else if (threadPool != nullptr && nthreads <= threadPool->numThreads() &&
+             !threadPool->isRunning())
+    {
+        threadPool->run(nthreads, task, data);
+    }
+    else
+    {
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+        for (int th = 0; th < nthreads; th++)
+        {
+            task(th, data);
+        }
+    }
+}
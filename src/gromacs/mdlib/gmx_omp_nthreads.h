@@ -113,6 +113,44 @@ static inline int gmx_omp_nthreads_get_simple_rvec_task(int mod, int nrvec)
  * Intended for use in testing. */
 void gmx_omp_nthreads_set(int mod, int nthreads);
 
+/*! \brief Function type for tasks run by gmx_omp_nthreads_run()
+ *
+ * \p thread is the thread index in the range [0, number of threads),
+ * \p data is the pointer passed to gmx_omp_nthreads_run(). */
+typedef void (*gmx_thread_task_t)(int thread, void *data);
+
+/*! \brief
+ * Starts the persistent thread pool of this rank, when requested by the user.
+ *
+ * The pool avoids the fork/join overhead of OpenMP parallel regions for
+ * the short, per MD step tasks dispatched with gmx_omp_nthreads_run().
+ * The pool workers are pinned to the same cores as the OpenMP threads
+ * with the same index, so this should be called after the thread
+ * affinity has been set. Should be called by the master thread of
+ * each rank that will call gmx_omp_nthreads_run(). The pool is not used
+ * when the threads of all ranks on the node oversubscribe the
+ * \p nthreads_hw_avail hardware threads, as spinning would then
+ * take time from the other threads. */
+void gmx_omp_nthreads_init_thread_pool(const gmx::MDLogger &mdlog,
+                                       const t_commrec     *cr,
+                                       int                  nthreads,
+                                       int                  nthreads_hw_avail);
+
+/*! \brief
+ * Stops and joins the threads of the thread pool of this rank, if any. */
+void gmx_omp_nthreads_finish_thread_pool();
+
+/*! \brief
+ * Runs \p task in parallel for thread indices 0 to \p nthreads-1.
+ *
+ * Thread index 0 is run by the calling thread. When this rank has
+ * a thread pool with at least \p nthreads threads, the other indices
+ * are run by the pool, otherwise an OpenMP parallel loop is used.
+ * The tasks should not use OpenMP constructs, in particular barriers,
+ * and should not let exceptions escape. Returns when all tasks have
+ * completed. */
+void gmx_omp_nthreads_run(int nthreads, gmx_thread_task_t task, void *data);
+
 /*! \brief
  * Read the OMP_NUM_THREADS env. var. and check against the value set on the
  * command line. */
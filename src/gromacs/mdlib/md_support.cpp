@@ -44,6 +44,7 @@
 #include <algorithm>
 
 #include "gromacs/domdec/domdec.h"
+#include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/gmxlib/network.h"
 #include "gromacs/gmxlib/nrnb.h"
 #include "gromacs/math/vec.h"
@@ -230,6 +231,11 @@ void compute_globals(FILE *fplog, gmx_global_stat *gstat, t_commrec *cr, t_input
                             *bSumEkinhOld, flags);
                 wallcycle_stop(wcycle, ewcMoveE);
             }
+            else if (DOMAINDECOMP(cr) && (flags & CGLO_CHECK_NUMBER_OF_BONDED_INTERACTIONS))
+            {
+                /* With a single domain there is nothing to sum */
+                *totalNumberOfBondedInteractions = cr->dd->nbonded_local;
+            }
             signalCoordinator->finalizeSignals();
             *bSumEkinhOld = FALSE;
         }
@@ -36,6 +36,17 @@
 
 #include "mdoutf.h"
 
+#include <cstdlib>
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/domdec/domdec_struct.h"
@@ -45,6 +56,7 @@
 #include "gromacs/fileio/trrio.h"
 #include "gromacs/fileio/xtcio.h"
 #include "gromacs/fileio/xvgr.h"
+#include "gromacs/gmxlib/network.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/mdrun.h"
 #include "gromacs/mdlib/trajectory_writing.h"
@@ -54,10 +66,18 @@
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/mdtypes/state.h"
 #include "gromacs/timing/wallcycle.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/pleasecite.h"
 #include "gromacs/utility/smalloc.h"
 
+namespace
+{
+
+class TrajectoryWriterThread;
+
+} // namespace
+
 struct gmx_mdoutf {
     t_fileio               *fp_trn;
     t_fileio               *fp_xtc;
@@ -67,6 +87,7 @@ struct gmx_mdoutf {
     ener_file_t             fp_ene;
     const char             *fn_cpt;
     gmx_bool                bKeepAndNumCPT;
+    gmx_bool                bCptAtomSections; /* Write the checkpoint atoms per rank */
     int                     eIntegrator;
     gmx_bool                bExpanded;
     int                     elamstats;
@@ -78,8 +99,298 @@ struct gmx_mdoutf {
     gmx_wallcycle_t         wcycle;
     rvec                   *f_global;
     gmx::IMDOutputProvider *outputProvider;
+    TrajectoryWriterThread *writer; /* Writes frames asynchronously, can be NULL */
+};
+
+/*! \brief Writes a frame to the trajectory files that are open
+ *
+ * x, v and f are used for MDOF_X, MDOF_V and MDOF_F in mdof_flags and
+ * contain natoms_global atoms, xCompressed is used for MDOF_X_COMPRESSED
+ * and contains natoms_x_compressed atoms.
+ *
+ * \throws gmx::FileIOError when a frame can not be written.
+ */
+static void write_frame_to_files(gmx_mdoutf_t of, int mdof_flags,
+                                 gmx_int64_t step, double t, real lambda,
+                                 const matrix box,
+                                 const rvec *x, const rvec *v, const rvec *f,
+                                 const rvec *xCompressed)
+{
+    if (mdof_flags & (MDOF_X | MDOF_V | MDOF_F))
+    {
+        x = (mdof_flags & MDOF_X) ? x : nullptr;
+        v = (mdof_flags & MDOF_V) ? v : nullptr;
+        f = (mdof_flags & MDOF_F) ? f : nullptr;
+
+        if (of->fp_trn)
+        {
+            gmx_trr_write_frame(of->fp_trn, step, t, lambda,
+                                box, of->natoms_global,
+                                x, v, f);
+            if (gmx_fio_flush(of->fp_trn) != 0)
+            {
+                GMX_THROW(gmx::FileIOError("Cannot write trajectory; maybe you are out of disk space?"));
+            }
+        }
+
+        /* If a TNG file is open for uncompressed coordinate output also write
+           velocities and forces to it. */
+        else if (of->tng)
+        {
+            gmx_fwrite_tng(of->tng, FALSE, step, t, lambda,
+                           box,
+                           of->natoms_global,
+                           x, v, f);
+        }
+        /* If only a TNG file is open for compressed coordinate output (no uncompressed
+           coordinate output) also write forces and velocities to it. */
+        else if (of->tng_low_prec)
+        {
+            gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, lambda,
+                           box,
+                           of->natoms_global,
+                           x, v, f);
+        }
+    }
+    if (mdof_flags & MDOF_X_COMPRESSED)
+    {
+        if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t,
+                      box, xCompressed, of->x_compression_precision) == 0)
+        {
+            GMX_THROW(gmx::FileIOError("XTC error - maybe you are out of disk space?"));
+        }
+        gmx_fwrite_tng(of->tng_low_prec,
+                       TRUE,
+                       step,
+                       t,
+                       lambda,
+                       box,
+                       of->natoms_x_compressed,
+                       xCompressed,
+                       nullptr,
+                       nullptr);
+    }
+}
+
+/*! \brief Copies the compressed output group of x to xCompressed */
+static void copy_x_compressed(const gmx_mdoutf *of, const rvec *x, rvec *xCompressed)
+{
+    int j = 0;
+    for (int i = 0; i < of->natoms_global; i++)
+    {
+        if (ggrpnr(of->groups, egcCompressedX, i) == 0)
+        {
+            copy_rvec(x[i], xCompressed[j++]);
+        }
+    }
+}
+
+namespace
+{
+
+/*! \internal \brief
+ * A trajectory frame staged for writing by the output thread
+ */
+struct StagedFrame
+{
+    int                    flags;      //!< The MDOF_* flags of the data to write
+    gmx_int64_t            step;       //!< The MD step
+    double                 t;          //!< The time
+    real                   lambda;     //!< The FEP lambda
+    matrix                 box;        //!< The box
+    std::vector<gmx::RVec> x;          //!< Copy of the coordinates
+    std::vector<gmx::RVec> v;          //!< Copy of the velocities
+    std::vector<gmx::RVec> f;          //!< Copy of the forces
+    std::vector<gmx::RVec> xCompressed; //!< Copy of the compressed output group
+};
+
+/*! \internal \brief
+ * Thread that writes trajectory frames while the simulation continues
+ *
+ * The master rank copies the collected frame into one of two staging
+ * buffers and continues with the next MD steps, while this thread
+ * compresses and writes the frame. When both buffers are in use,
+ * the master waits for the oldest frame to be written.
+ *
+ * An error while writing is stored and rethrown on the master thread
+ * by the next call to getFreeFrame() or waitUntilIdle(). Frames queued
+ * after a failed frame are discarded.
+ */
+class TrajectoryWriterThread
+{
+    public:
+        //! Starts the thread that writes to the files of \p of
+        explicit TrajectoryWriterThread(gmx_mdoutf_t of) :
+            of_(of), stop_(false), numInFlight_(0), bFailed_(false)
+        {
+            for (auto &frame : frames_)
+            {
+                free_.push_back(&frame);
+            }
+            thread_ = std::thread(&TrajectoryWriterThread::run, this);
+        }
+
+        //! Writes all staged frames and stops the thread
+        ~TrajectoryWriterThread()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            thread_.join();
+        }
+
+        //! Returns a free staging buffer, waits until one is available
+        StagedFrame *getFreeFrame()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !free_.empty(); });
+            rethrowIfFailed();
+            StagedFrame *frame = free_.back();
+            free_.pop_back();
+
+            return frame;
+        }
+
+        //! Queues \p frame for writing
+        void submit(StagedFrame *frame)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queue_.push_back(frame);
+                numInFlight_++;
+            }
+            cv_.notify_all();
+        }
+
+        //! Waits until all queued frames have been written
+        void waitUntilIdle()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return numInFlight_ == 0; });
+            rethrowIfFailed();
+        }
+
+    private:
+        //! Rethrows the error of a failed write, should be called with mutex_ locked
+        void rethrowIfFailed()
+        {
+            if (error_)
+            {
+                std::exception_ptr error = error_;
+                error_                   = nullptr;
+                std::rethrow_exception(error);
+            }
+        }
+
+        //! The loop executed by the writer thread
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true)
+            {
+                cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                if (queue_.empty())
+                {
+                    /* stop_ is set and all frames have been written */
+                    break;
+                }
+                StagedFrame *frame = queue_.front();
+                queue_.pop_front();
+                const bool   skip  = bFailed_;
+                lock.unlock();
+
+                std::exception_ptr error;
+                if (!skip)
+                {
+                    try
+                    {
+                        write_frame_to_files(of_, frame->flags,
+                                             frame->step, frame->t, frame->lambda,
+                                             frame->box,
+                                             as_rvec_array(frame->x.data()),
+                                             as_rvec_array(frame->v.data()),
+                                             as_rvec_array(frame->f.data()),
+                                             as_rvec_array(frame->xCompressed.data()));
+                    }
+                    catch (...)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+
+                lock.lock();
+                if (error)
+                {
+                    error_   = error;
+                    bFailed_ = true;
+                }
+                free_.push_back(frame);
+                numInFlight_--;
+                cv_.notify_all();
+            }
+        }
+
+        gmx_mdoutf_t               of_;
+        std::array<StagedFrame, 2> frames_;
+        std::vector<StagedFrame *> free_;
+        std::deque<StagedFrame *>  queue_;
+        std::mutex                 mutex_;
+        std::condition_variable    cv_;
+        bool                       stop_;
+        int                        numInFlight_;
+        bool                       bFailed_;
+        std::exception_ptr         error_;
+        std::thread                thread_;
 };
 
+} // namespace
+
+/*! \brief Copies \p n elements of \p src to \p dest, resizing \p dest */
+static void stage_rvecs(const rvec *src, int n, std::vector<gmx::RVec> *dest)
+{
+    dest->resize(n);
+    rvec *d = as_rvec_array(dest->data());
+    for (int i = 0; i < n; i++)
+    {
+        copy_rvec(src[i], d[i]);
+    }
+}
+
+
+/* Set the TNG writing settings, which can be changed with environment variables */
+static void get_tng_write_settings(gmx_tng_write_settings_t *settings)
+{
+    const char *env;
+
+    gmx_tng_write_settings_init(settings);
+    if ((env = getenv("GMX_TNG_FRAMES_PER_FRAME_SET")) != nullptr)
+    {
+        settings->framesPerFrameSet = strtol(env, nullptr, 10);
+    }
+    if ((env = getenv("GMX_TNG_COMPRESSION")) != nullptr)
+    {
+        int c;
+
+        for (c = 0; c < etngcompNR; c++)
+        {
+            if (gmx_strcasecmp(env, etngcomp_names[c]) == 0)
+            {
+                break;
+            }
+        }
+        if (c == etngcompNR)
+        {
+            gmx_fatal(FARGS, "Unknown TNG compression '%s' set by GMX_TNG_COMPRESSION, use 'gzip' or 'none'", env);
+        }
+        settings->compression = c;
+    }
+    if (getenv("GMX_TNG_NO_WRITE_THREAD") != nullptr)
+    {
+        settings->bThreadedWriting = FALSE;
+    }
+}
 
 gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
                          const MdrunOptions &mdrunOptions,
@@ -88,10 +399,12 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
                          const t_inputrec *ir, gmx_mtop_t *top_global,
                          const gmx_output_env_t *oenv, gmx_wallcycle_t wcycle)
 {
-    gmx_mdoutf_t   of;
-    const char    *appendMode = "a+", *writeMode = "w+", *filemode;
-    gmx_bool       bAppendFiles, bCiteTng = FALSE;
-    int            i;
+    gmx_mdoutf_t             of;
+    const char              *appendMode = "a+", *writeMode = "w+", *filemode;
+    gmx_bool                 bAppendFiles, bCiteTng = FALSE;
+    gmx_bool                 bWriterThread;
+    gmx_tng_write_settings_t tngSettings;
+    int                      i;
 
     snew(of, 1);
 
@@ -110,6 +423,9 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
     of->wcycle                  = wcycle;
     of->f_global                = nullptr;
     of->outputProvider          = outputProvider;
+    of->writer                  = nullptr;
+    of->fn_cpt                  = opt2fn("-cpo", nfile, fnm);
+    of->bCptAtomSections        = mdrunOptions.checkpointOptions.writeAtomSections;
 
     if (MASTER(cr))
     {
@@ -119,6 +435,20 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
 
         filemode = bAppendFiles ? appendMode : writeMode;
 
+        /* Let a separate thread compress and write the trajectory frames,
+           so the simulation does not wait for the output. */
+        bWriterThread = (EI_DYNAMICS(ir->eI) &&
+                         getenv("GMX_NO_TRAJ_OUTPUT_THREAD") == nullptr);
+
+        get_tng_write_settings(&tngSettings);
+        if (bWriterThread)
+        {
+            /* The TNG files are already written off the MD loop by the
+               writer thread, an extra thread per TNG file would only
+               add another copy and handoff of every frame. */
+            tngSettings.bThreadedWriting = FALSE;
+        }
+
         if (EI_DYNAMICS(ir->eI) &&
             ir->nstxout_compressed > 0)
         {
@@ -133,7 +463,11 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
                     gmx_tng_open(filename, filemode[0], &of->tng_low_prec);
                     if (filemode[0] == 'w')
                     {
-                        gmx_tng_prepare_low_prec_writing(of->tng_low_prec, top_global, ir);
+                        gmx_tng_prepare_low_prec_writing(of->tng_low_prec, top_global, ir, &tngSettings);
+                    }
+                    else if (tngSettings.bThreadedWriting)
+                    {
+                        gmx_tng_start_write_thread(of->tng_low_prec);
                     }
                     bCiteTng = TRUE;
                     break;
@@ -170,7 +504,11 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
                     gmx_tng_open(filename, filemode[0], &of->tng);
                     if (filemode[0] == 'w')
                     {
-                        gmx_tng_prepare_md_writing(of->tng, top_global, ir);
+                        gmx_tng_prepare_md_writing(of->tng, top_global, ir, &tngSettings);
+                    }
+                    else if (tngSettings.bThreadedWriting)
+                    {
+                        gmx_tng_start_write_thread(of->tng);
                     }
                     bCiteTng = TRUE;
                     break;
@@ -182,7 +520,6 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
         {
             of->fp_ene = open_enx(ftp2fn(efEDR, nfile, fnm), filemode);
         }
-        of->fn_cpt = opt2fn("-cpo", nfile, fnm);
 
         if ((ir->efep != efepNO || ir->bSimTemp) && ir->fepvals->nstdhdl > 0 &&
             (ir->fepvals->separate_dhdl_file == esepdhdlfileYES ) &&
@@ -219,6 +556,12 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
         {
             snew(of->f_global, top_global->natoms);
         }
+
+        if (bWriterThread &&
+            (of->fp_trn || of->fp_xtc || of->tng || of->tng_low_prec))
+        {
+            of->writer = new TrajectoryWriterThread(of);
+        }
     }
 
     if (bCiteTng)
@@ -247,7 +590,7 @@ gmx_wallcycle_t mdoutf_get_wcycle(gmx_mdoutf_t of)
 void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
                                       gmx_mdoutf_t of,
                                       int mdof_flags,
-                                      gmx_mtop_t *top_global,
+                                      gmx_mtop_t gmx_unused *top_global,
                                       gmx_int64_t step, double t,
                                       t_state *state_local, t_state *state_global,
                                       ObservablesHistory *observablesHistory,
@@ -257,12 +600,17 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
 
     if (DOMAINDECOMP(cr))
     {
-        if (mdof_flags & MDOF_CPT)
+        if ((mdof_flags & MDOF_CPT) && !of->bCptAtomSections)
         {
             dd_collect_state(cr->dd, state_local, state_global);
         }
         else
         {
+            if (mdof_flags & MDOF_CPT)
+            {
+                /* The atoms are written per rank below */
+                dd_collect_state_globals(cr->dd, state_local, state_global);
+            }
             if (mdof_flags & (MDOF_X | MDOF_X_COMPRESSED))
             {
                 dd_collect_vec(cr->dd, state_local, &state_local->x,
@@ -288,10 +636,40 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
         f_global     = as_rvec_array(f_local->data());
     }
 
+    int nCptAtomSections = 0;
+    if ((mdof_flags & MDOF_CPT) && of->bCptAtomSections)
+    {
+        /* Each rank writes the state of its home atoms, in parallel */
+        if (DOMAINDECOMP(cr))
+        {
+            nCptAtomSections = cr->dd->nnodes;
+            write_checkpoint_atom_section(of->fn_cpt, cr->dd->rank, nCptAtomSections, step,
+                                          cr->dd->nat_home, cr->dd->gatindex, state_local);
+        }
+        else
+        {
+            nCptAtomSections = 1;
+            write_checkpoint_atom_section(of->fn_cpt, 0, nCptAtomSections, step,
+                                          state_local->natoms, nullptr, state_local);
+        }
+        /* The master rank renames the sections along with the checkpoint */
+        if (PAR(cr))
+        {
+            gmx_barrier(cr);
+        }
+    }
+
     if (MASTER(cr))
     {
         if (mdof_flags & MDOF_CPT)
         {
+            /* The checkpoint stores the trajectory file positions,
+             * so all earlier frames should have been written.
+             */
+            if (of->writer != nullptr)
+            {
+                of->writer->waitUntilIdle();
+            }
             fflush_tng(of->tng);
             fflush_tng(of->tng_low_prec);
             ivec one_ivec = { 1, 1, 1 };
@@ -301,87 +679,81 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
                              DOMAINDECOMP(cr) ? cr->dd->nnodes : cr->nnodes,
                              of->eIntegrator, of->simulation_part,
                              of->bExpanded, of->elamstats, step, t,
-                             state_global, observablesHistory);
+                             nCptAtomSections, state_global, observablesHistory);
         }
 
-        if (mdof_flags & (MDOF_X | MDOF_V | MDOF_F))
+        int frameFlags = mdof_flags & (MDOF_X | MDOF_V | MDOF_F | MDOF_X_COMPRESSED);
+        if (frameFlags != 0 && of->writer != nullptr)
         {
-            const rvec *x = (mdof_flags & MDOF_X) ? as_rvec_array(state_global->x.data()) : nullptr;
-            const rvec *v = (mdof_flags & MDOF_V) ? as_rvec_array(state_global->v.data()) : nullptr;
-            const rvec *f = (mdof_flags & MDOF_F) ? f_global : nullptr;
-
-            if (of->fp_trn)
+            /* Stage a copy of the frame and let the writer thread
+             * compress and write it while we continue with MD.
+             */
+            StagedFrame *frame = of->writer->getFreeFrame();
+
+            frame->flags  = frameFlags;
+            frame->step   = step;
+            frame->t      = t;
+            frame->lambda = state_local->lambda[efptFEP];
+            copy_mat(state_local->box, frame->box);
+            if (frameFlags & MDOF_X)
             {
-                gmx_trr_write_frame(of->fp_trn, step, t, state_local->lambda[efptFEP],
-                                    state_local->box, top_global->natoms,
-                                    x, v, f);
-                if (gmx_fio_flush(of->fp_trn) != 0)
-                {
-                    gmx_file("Cannot write trajectory; maybe you are out of disk space?");
-                }
+                stage_rvecs(as_rvec_array(state_global->x.data()), of->natoms_global, &frame->x);
             }
-
-            /* If a TNG file is open for uncompressed coordinate output also write
-               velocities and forces to it. */
-            else if (of->tng)
+            if (frameFlags & MDOF_V)
             {
-                gmx_fwrite_tng(of->tng, FALSE, step, t, state_local->lambda[efptFEP],
-                               state_local->box,
-                               top_global->natoms,
-                               x, v, f);
+                stage_rvecs(as_rvec_array(state_global->v.data()), of->natoms_global, &frame->v);
             }
-            /* If only a TNG file is open for compressed coordinate output (no uncompressed
-               coordinate output) also write forces and velocities to it. */
-            else if (of->tng_low_prec)
+            if (frameFlags & MDOF_F)
             {
-                gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, state_local->lambda[efptFEP],
-                               state_local->box,
-                               top_global->natoms,
-                               x, v, f);
+                stage_rvecs(f_global, of->natoms_global, &frame->f);
             }
+            if (frameFlags & MDOF_X_COMPRESSED)
+            {
+                if (of->natoms_x_compressed == of->natoms_global)
+                {
+                    stage_rvecs(as_rvec_array(state_global->x.data()), of->natoms_global, &frame->xCompressed);
+                }
+                else
+                {
+                    frame->xCompressed.resize(of->natoms_x_compressed);
+                    copy_x_compressed(of, as_rvec_array(state_global->x.data()),
+                                      as_rvec_array(frame->xCompressed.data()));
+                }
+            }
+
+            of->writer->submit(frame);
         }
-        if (mdof_flags & MDOF_X_COMPRESSED)
+        else if (frameFlags != 0)
         {
             rvec *xxtc = nullptr;
 
-            if (of->natoms_x_compressed == of->natoms_global)
+            if (mdof_flags & MDOF_X_COMPRESSED)
             {
-                /* We are writing the positions of all of the atoms to
-                   the compressed output */
-                xxtc = as_rvec_array(state_global->x.data());
-            }
-            else
-            {
-                /* We are writing the positions of only a subset of
-                   the atoms to the compressed output, so we have to
-                   make a copy of the subset of coordinates. */
-                int i, j;
-
-                snew(xxtc, of->natoms_x_compressed);
-                for (i = 0, j = 0; (i < of->natoms_global); i++)
+                if (of->natoms_x_compressed == of->natoms_global)
                 {
-                    if (ggrpnr(of->groups, egcCompressedX, i) == 0)
-                    {
-                        copy_rvec(state_global->x[i], xxtc[j++]);
-                    }
+                    /* We are writing the positions of all of the atoms to
+                       the compressed output */
+                    xxtc = as_rvec_array(state_global->x.data());
+                }
+                else
+                {
+                    /* We are writing the positions of only a subset of
+                       the atoms to the compressed output, so we have to
+                       make a copy of the subset of coordinates. */
+                    snew(xxtc, of->natoms_x_compressed);
+                    copy_x_compressed(of, as_rvec_array(state_global->x.data()), xxtc);
                 }
             }
-            if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t,
-                          state_local->box, xxtc, of->x_compression_precision) == 0)
-            {
-                gmx_fatal(FARGS, "XTC error - maybe you are out of disk space?");
-            }
-            gmx_fwrite_tng(of->tng_low_prec,
-                           TRUE,
-                           step,
-                           t,
-                           state_local->lambda[efptFEP],
-                           state_local->box,
-                           of->natoms_x_compressed,
-                           xxtc,
-                           nullptr,
-                           nullptr);
-            if (of->natoms_x_compressed != of->natoms_global)
+
+            write_frame_to_files(of, frameFlags, step, t,
+                                 state_local->lambda[efptFEP], state_local->box,
+                                 as_rvec_array(state_global->x.data()),
+                                 as_rvec_array(state_global->v.data()),
+                                 f_global,
+                                 xxtc);
+
+            if ((mdof_flags & MDOF_X_COMPRESSED) &&
+                of->natoms_x_compressed != of->natoms_global)
             {
                 sfree(xxtc);
             }
@@ -389,8 +761,28 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
     }
 }
 
+/*! \brief Writes the queued frames and stops the writer thread of \p of, if any
+ *
+ * The thread is joined and freed also when writing a frame failed.
+ *
+ * \throws gmx::FileIOError when a queued frame could not be written.
+ */
+static void stop_writer_thread(gmx_mdoutf_t of)
+{
+    /* The destructor joins the thread, also when waitUntilIdle() throws */
+    std::unique_ptr<TrajectoryWriterThread> writer(of->writer);
+    of->writer = nullptr;
+    if (writer)
+    {
+        writer->waitUntilIdle();
+    }
+}
+
 void mdoutf_tng_close(gmx_mdoutf_t of)
 {
+    /* Write the remaining frames before closing */
+    stop_writer_thread(of);
+
     if (of->tng || of->tng_low_prec)
     {
         wallcycle_start(of->wcycle, ewcTRAJ);
@@ -402,6 +794,8 @@ void mdoutf_tng_close(gmx_mdoutf_t of)
 
 void done_mdoutf(gmx_mdoutf_t of)
 {
+    stop_writer_thread(of);
+
     if (of->fp_ene != nullptr)
     {
         close_enx(of->fp_ene);
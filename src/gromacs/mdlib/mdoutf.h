@@ -100,6 +100,13 @@ void done_mdoutf(gmx_mdoutf_t of);
  * determined by the mdof_flags defined below. Data is collected to
  * the master node only when necessary. Without domain decomposition
  * only data from state_local is used and state_global is ignored.
+ * Unless GMX_NO_TRAJ_OUTPUT_THREAD is set, the master rank stages a copy
+ * of the frame and the writing is done by a separate thread; all staged
+ * frames are written before writing a checkpoint or closing the files.
+ * A write error of the thread is thrown by a later call of this function,
+ * mdoutf_tng_close() or done_mdoutf().
+ *
+ * \throws gmx::FileIOError when a trajectory frame can not be written.
  */
 void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
                                       gmx_mdoutf_t of,
@@ -81,12 +81,15 @@ struct CheckpointOptions
     //! \brief Constructor
     CheckpointOptions() :
         keepAndNumberCheckpointFiles(FALSE),
+        writeAtomSections(FALSE),
         period(15)
     {
     }
 
     //! True means keep all checkpoint file and add the step number to the name
     gmx_bool keepAndNumberCheckpointFiles;
+    //! True means each rank writes the state of its atoms to a separate file in parallel
+    gmx_bool writeAtomSections;
     //! The period in minutes for writing checkpoint files
     real     period;
 };
@@ -53,6 +53,7 @@
 #include <ctime>
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 
 #include "gromacs/commandline/filenm.h"
@@ -883,7 +884,10 @@ static double reorder_partsum(t_commrec *cr, t_grpopts *opts, t_mdatoms *mdatoms
             i++;
         }
     }
-    gmx_sum(top_global->natoms*3, fmg[0], cr);
+    if (PAR(cr))
+    {
+        gmx_sum(top_global->natoms*3, fmg[0], cr);
+    }
 
     /* Now we will determine the part of the sum for the cgs in state s_b */
     ncg         = s_b->s.cg_gl.size();
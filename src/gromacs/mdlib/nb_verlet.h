@@ -200,6 +200,7 @@ typedef struct nonbonded_verlet_t {
     gmx_nbnxn_gpu_t                     *gpu_nbv;         /**< pointer to GPU nb verlet data     */
     int                                  min_ci_balanced; /**< pair list balancing parameter
                                                                used for the 8x8x8 GPU kernels    */
+    gmx_bool                             bListedForceTasks; /**< TRUE when the CPU kernel may run as tasks together with the bonded forces */
 } nonbonded_verlet_t;
 
 /*! \brief Getter for bUseGPU */
@@ -1055,6 +1055,69 @@ void nbnxn_atomdata_copy_shiftvec(gmx_bool          bDynamicBox,
     }
 }
 
+/* The arguments of nbnxn_atomdata_copy_x_to_nbat_x() used by copy_x_to_nbat_x_thread() */
+struct copy_x_to_nbat_x_task_t
+{
+    const nbnxn_search_t  nbs;
+    int                   g0, g1;
+    gmx_bool              FillLocal;
+    const rvec           *x;
+    nbnxn_atomdata_t     *nbat;
+    int                   nth;
+};
+
+/* Copies the coordinates of the grid columns of thread th */
+static void copy_x_to_nbat_x_thread(int th, void *data)
+{
+    const copy_x_to_nbat_x_task_t *task      = static_cast<const copy_x_to_nbat_x_task_t *>(data);
+    const nbnxn_search_t           nbs       = task->nbs;
+    int                            g0        = task->g0;
+    int                            g1        = task->g1;
+    gmx_bool                       FillLocal = task->FillLocal;
+    const rvec                    *x         = task->x;
+    nbnxn_atomdata_t              *nbat      = task->nbat;
+    int                            nth       = task->nth;
+
+    try
+    {
+        for (int g = g0; g < g1; g++)
+        {
+            const nbnxn_grid_t *grid;
+            int                 cxy0, cxy1;
+
+            grid = &nbs->grid[g];
+
+            cxy0 = (grid->ncx*grid->ncy* th   +nth-1)/nth;
+            cxy1 = (grid->ncx*grid->ncy*(th+1)+nth-1)/nth;
+
+            for (int cxy = cxy0; cxy < cxy1; cxy++)
+            {
+                int na, ash, na_fill;
+
+                na  = grid->cxy_na[cxy];
+                ash = (grid->cell0 + grid->cxy_ind[cxy])*grid->na_sc;
+
+                if (g == 0 && FillLocal)
+                {
+                    na_fill =
+                        (grid->cxy_ind[cxy+1] - grid->cxy_ind[cxy])*grid->na_sc;
+                }
+                else
+                {
+                    /* We fill only the real particle locations.
+                     * We assume the filling entries at the end have been
+                     * properly set before during pair-list generation.
+                     */
+                    na_fill = na;
+                }
+                copy_rvec_to_nbat_real(nbs->a+ash, na, na_fill, x,
+                                       nbat->XFormat, nbat->x, ash);
+            }
+        }
+    }
+    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+}
+
 /* Copies (and reorders) the coordinates to nbnxn_atomdata_t */
 void nbnxn_atomdata_copy_x_to_nbat_x(const nbnxn_search_t nbs,
                                      int                  locality,
@@ -1063,7 +1126,7 @@ void nbnxn_atomdata_copy_x_to_nbat_x(const nbnxn_search_t nbs,
                                      nbnxn_atomdata_t    *nbat)
 {
     int g0 = 0, g1 = 0;
-    int nth, th;
+    int nth;
 
     switch (locality)
     {
@@ -1088,48 +1151,9 @@ void nbnxn_atomdata_copy_x_to_nbat_x(const nbnxn_search_t nbs,
 
     nth = gmx_omp_nthreads_get(emntPairsearch);
 
-#pragma omp parallel for num_threads(nth) schedule(static)
-    for (th = 0; th < nth; th++)
-    {
-        try
-        {
-            for (int g = g0; g < g1; g++)
-            {
-                const nbnxn_grid_t *grid;
-                int                 cxy0, cxy1;
-
-                grid = &nbs->grid[g];
+    copy_x_to_nbat_x_task_t task = { nbs, g0, g1, FillLocal, x, nbat, nth };
 
-                cxy0 = (grid->ncx*grid->ncy* th   +nth-1)/nth;
-                cxy1 = (grid->ncx*grid->ncy*(th+1)+nth-1)/nth;
-
-                for (int cxy = cxy0; cxy < cxy1; cxy++)
-                {
-                    int na, ash, na_fill;
-
-                    na  = grid->cxy_na[cxy];
-                    ash = (grid->cell0 + grid->cxy_ind[cxy])*grid->na_sc;
-
-                    if (g == 0 && FillLocal)
-                    {
-                        na_fill =
-                            (grid->cxy_ind[cxy+1] - grid->cxy_ind[cxy])*grid->na_sc;
-                    }
-                    else
-                    {
-                        /* We fill only the real particle locations.
-                         * We assume the filling entries at the end have been
-                         * properly set before during pair-list generation.
-                         */
-                        na_fill = na;
-                    }
-                    copy_rvec_to_nbat_real(nbs->a+ash, na, na_fill, x,
-                                           nbat->XFormat, nbat->x, ash);
-                }
-            }
-        }
-        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
-    }
+    gmx_omp_nthreads_run(nth, copy_x_to_nbat_x_thread, &task);
 }
 
 static void
@@ -1459,58 +1483,88 @@ static void nbnxn_atomdata_add_nbat_f_to_f_treereduce(const nbnxn_atomdata_t *nb
 }
 
 
-static void nbnxn_atomdata_add_nbat_f_to_f_stdreduce(const nbnxn_atomdata_t *nbat,
-                                                     int                     nth)
+/* The arguments of the force reduction tasks */
+struct add_nbat_f_to_f_task_t
 {
-#pragma omp parallel for num_threads(nth) schedule(static)
-    for (int th = 0; th < nth; th++)
+    const nbnxn_search_t    nbs;
+    const nbnxn_atomdata_t *nbat;
+    int                     a0, na;
+    rvec                   *f;
+    int                     nth;
+};
+
+/* Reduces the force output buffers for the cell-block range of thread th */
+static void nbnxn_atomdata_add_nbat_f_to_f_stdreduce_thread(int th, void *data)
+{
+    const add_nbat_f_to_f_task_t *task = static_cast<const add_nbat_f_to_f_task_t *>(data);
+    const nbnxn_atomdata_t       *nbat = task->nbat;
+    int                           nth  = task->nth;
+
+    try
     {
-        try
-        {
-            const nbnxn_buffer_flags_t *flags;
-            int   nfptr;
-            real *fptr[NBNXN_BUFFERFLAG_MAX_THREADS];
+        const nbnxn_buffer_flags_t *flags;
+        int   nfptr;
+        real *fptr[NBNXN_BUFFERFLAG_MAX_THREADS];
 
-            flags = &nbat->buffer_flags;
+        flags = &nbat->buffer_flags;
 
-            /* Calculate the cell-block range for our thread */
-            int b0 = (flags->nflag* th   )/nth;
-            int b1 = (flags->nflag*(th+1))/nth;
+        /* Calculate the cell-block range for our thread */
+        int b0 = (flags->nflag* th   )/nth;
+        int b1 = (flags->nflag*(th+1))/nth;
 
-            for (int b = b0; b < b1; b++)
-            {
-                int i0 =  b   *NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
-                int i1 = (b+1)*NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
+        for (int b = b0; b < b1; b++)
+        {
+            int i0 =  b   *NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
+            int i1 = (b+1)*NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
 
-                nfptr = 0;
-                for (int out = 1; out < nbat->nout; out++)
+            nfptr = 0;
+            for (int out = 1; out < nbat->nout; out++)
+            {
+                if (bitmask_is_set(flags->flag[b], out))
                 {
-                    if (bitmask_is_set(flags->flag[b], out))
-                    {
-                        fptr[nfptr++] = nbat->out[out].f;
-                    }
+                    fptr[nfptr++] = nbat->out[out].f;
                 }
-                if (nfptr > 0)
-                {
+            }
+            if (nfptr > 0)
+            {
 #if GMX_SIMD
-                    nbnxn_atomdata_reduce_reals_simd
+                nbnxn_atomdata_reduce_reals_simd
 #else
-                    nbnxn_atomdata_reduce_reals
+                nbnxn_atomdata_reduce_reals
 #endif
-                        (nbat->out[0].f,
-                        bitmask_is_set(flags->flag[b], 0),
-                        fptr, nfptr,
-                        i0, i1);
-                }
-                else if (!bitmask_is_set(flags->flag[b], 0))
-                {
-                    nbnxn_atomdata_clear_reals(nbat->out[0].f,
-                                               i0, i1);
-                }
+                    (nbat->out[0].f,
+                    bitmask_is_set(flags->flag[b], 0),
+                    fptr, nfptr,
+                    i0, i1);
+            }
+            else if (!bitmask_is_set(flags->flag[b], 0))
+            {
+                nbnxn_atomdata_clear_reals(nbat->out[0].f,
+                                           i0, i1);
             }
         }
-        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
+    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+}
+
+/* Adds the force output buffer of the atom range of thread th to f */
+static void nbnxn_atomdata_add_nbat_f_to_f_thread(int th, void *data)
+{
+    const add_nbat_f_to_f_task_t *task = static_cast<const add_nbat_f_to_f_task_t *>(data);
+    int                           a0   = task->a0;
+    int                           na   = task->na;
+    int                           nth  = task->nth;
+
+    try
+    {
+        nbnxn_atomdata_add_nbat_f_to_f_part(task->nbs, task->nbat,
+                                            task->nbat->out,
+                                            1,
+                                            a0+((th+0)*na)/nth,
+                                            a0+((th+1)*na)/nth,
+                                            task->f);
+    }
+    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
 }
 
 /* Add the force array(s) from nbnxn_atomdata_t to f */
@@ -1539,7 +1593,8 @@ void nbnxn_atomdata_add_nbat_f_to_f(const nbnxn_search_t    nbs,
             break;
     }
 
-    int nth = gmx_omp_nthreads_get(emntNonbonded);
+    int                    nth  = gmx_omp_nthreads_get(emntNonbonded);
+    add_nbat_f_to_f_task_t task = { nbs, nbat, a0, na, f, nth };
 
     if (nbat->nout > 1)
     {
@@ -1557,24 +1612,12 @@ void nbnxn_atomdata_add_nbat_f_to_f(const nbnxn_search_t    nbs,
         }
         else
         {
-            nbnxn_atomdata_add_nbat_f_to_f_stdreduce(nbat, nth);
-        }
-    }
-#pragma omp parallel for num_threads(nth) schedule(static)
-    for (int th = 0; th < nth; th++)
-    {
-        try
-        {
-            nbnxn_atomdata_add_nbat_f_to_f_part(nbs, nbat,
-                                                nbat->out,
-                                                1,
-                                                a0+((th+0)*na)/nth,
-                                                a0+((th+1)*na)/nth,
-                                                f);
+            gmx_omp_nthreads_run(nth, nbnxn_atomdata_add_nbat_f_to_f_stdreduce_thread, &task);
         }
-        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
 
+    gmx_omp_nthreads_run(nth, nbnxn_atomdata_add_nbat_f_to_f_thread, &task);
+
     nbs_cycle_stop(&nbs->cc[enbsCCreducef]);
 }
 
@@ -403,6 +403,68 @@ static void sort_atoms(int dim, gmx_bool Backwards,
     }
 }
 
+/* The maximum number of element shifts per particle we allow in
+ * sort_atoms_incremental before falling back to sort_atoms.
+ */
+#define SORT_INCREMENTAL_MAX_SHIFTS 4
+
+/* Sort particle index a on coordinates x along dim in increasing order.
+ * The order is identical to that of sort_atoms with Backwards=FALSE:
+ * on increasing coordinate and on increasing index for equal coordinates.
+ * When the particles are put on the grid in the order of the previous
+ * search, a is nearly sorted and an insertion sort, which scales with
+ * the number of displaced particles, is much cheaper than sort_atoms.
+ * When it turns out that the input is far from sorted, we fall back
+ * to sort_atoms, so the parameters after x are only used then.
+ */
+static void sort_atoms_incremental(int dim, int dd_zone,
+                                   int *a, int n, rvec *x,
+                                   real h0, real invh, int n_per_h,
+                                   int *sort)
+{
+    int nshift_max = SORT_INCREMENTAL_MAX_SHIFTS*n;
+    int nshift     = 0;
+
+    for (int i = 1; i < n; i++)
+    {
+        int  ai = a[i];
+        real xi = x[ai][dim];
+        int  j  = i;
+        while (j > 0 && (x[a[j - 1]][dim] > xi ||
+                         (x[a[j - 1]][dim] == xi && a[j - 1] > ai)))
+        {
+            a[j] = a[j - 1];
+            j--;
+        }
+        a[j]    = ai;
+        nshift += i - j;
+
+        if (nshift > nshift_max)
+        {
+            /* a is still a permutation of the input, sort it fully */
+            sort_atoms(dim, FALSE, dd_zone, a, n, x, h0, invh, n_per_h, sort);
+
+            return;
+        }
+    }
+}
+
+/* Sort the atoms in a grid column along z, see sort_atoms */
+static void sort_column_z(const nbnxn_search_t nbs, int dd_zone,
+                          int *a, int n, rvec *x,
+                          real h0, real invh, int n_per_h,
+                          int *sort)
+{
+    if (nbs->bIncrGrid)
+    {
+        sort_atoms_incremental(ZZ, dd_zone, a, n, x, h0, invh, n_per_h, sort);
+    }
+    else
+    {
+        sort_atoms(ZZ, FALSE, dd_zone, a, n, x, h0, invh, n_per_h, sort);
+    }
+}
+
 #if GMX_DOUBLE
 #define R2F_D(x) ((float)((x) >= 0 ? ((1-GMX_FLOAT_EPS)*(x)) : ((1+GMX_FLOAT_EPS)*(x))))
 #define R2F_U(x) ((float)((x) >= 0 ? ((1+GMX_FLOAT_EPS)*(x)) : ((1-GMX_FLOAT_EPS)*(x))))
@@ -989,11 +1051,11 @@ static void sort_columns_simple(const nbnxn_search_t nbs,
         int ash = (grid->cell0 + grid->cxy_ind[cxy])*grid->na_sc;
 
         /* Sort the atoms within each x,y column on z coordinate */
-        sort_atoms(ZZ, FALSE, dd_zone,
-                   nbs->a+ash, na, x,
-                   grid->c0[ZZ],
-                   1.0/grid->size[ZZ], ncz*grid->na_sc,
-                   sort_work);
+        sort_column_z(nbs, dd_zone,
+                      nbs->a+ash, na, x,
+                      grid->c0[ZZ],
+                      1.0/grid->size[ZZ], ncz*grid->na_sc,
+                      sort_work);
 
         /* Fill the ncz cells in this column */
         cfilled = grid->cxy_ind[cxy];
@@ -1064,11 +1126,11 @@ static void sort_columns_supersub(const nbnxn_search_t nbs,
         int ash = (grid->cell0 + grid->cxy_ind[cxy])*grid->na_sc;
 
         /* Sort the atoms within each x,y column on z coordinate */
-        sort_atoms(ZZ, FALSE, dd_zone,
-                   nbs->a + ash, na, x,
-                   grid->c0[ZZ],
-                   1.0/grid->size[ZZ], ncz*grid->na_sc,
-                   sort_work);
+        sort_column_z(nbs, dd_zone,
+                      nbs->a + ash, na, x,
+                      grid->c0[ZZ],
+                      1.0/grid->size[ZZ], ncz*grid->na_sc,
+                      sort_work);
 
         /* This loop goes over the supercells and subcells along z at once */
         for (int sub_z = 0; sub_z < ncz*c_gpuNumClusterPerCellZ; sub_z++)
@@ -1230,6 +1292,41 @@ static void calc_column_indices(nbnxn_grid_t *grid,
     }
 }
 
+/* Stores the atom order of the previous search on grid in nbs->a_prev.
+ * Returns whether the previous order contains exactly the atoms a0 to a1,
+ * so it can be used as the order for putting the atoms in the columns.
+ * Note that this should be called before grid->nc is updated.
+ */
+static gmx_bool store_previous_atom_order(nbnxn_search_t      nbs,
+                                          const nbnxn_grid_t *grid,
+                                          int a0, int a1)
+{
+    int nslot = grid->nc*grid->na_sc;
+
+    if (a1 - a0 > nbs->a_prev_nalloc)
+    {
+        nbs->a_prev_nalloc = over_alloc_large(a1 - a0);
+        srenew(nbs->a_prev, nbs->a_prev_nalloc);
+    }
+
+    const int *a_grid = nbs->a + grid->cell0*grid->na_sc;
+    int        n      = 0;
+    for (int i = 0; i < nslot; i++)
+    {
+        if (a_grid[i] >= a0 && a_grid[i] < a1 && n < a1 - a0)
+        {
+            nbs->a_prev[n++] = a_grid[i];
+        }
+        else if (a_grid[i] >= 0)
+        {
+            /* This atom is not part of the current atom range */
+            return FALSE;
+        }
+    }
+
+    return (n == a1 - a0);
+}
+
 /* Determine in which grid cells the atoms should go */
 static void calc_cell_indices(const nbnxn_search_t nbs,
                               int dd_zone,
@@ -1247,6 +1344,16 @@ static void calc_cell_indices(const nbnxn_search_t nbs,
 
     nthread = gmx_omp_nthreads_get(emntPairsearch);
 
+    /* Without domain decomposition the atom indices do not change between
+     * searches, so we can put the atoms in the columns in the order of
+     * the previous search. Then the columns are nearly sorted along z.
+     * With domain decomposition the home atoms are already reordered
+     * according to the previous search, so we use the index order.
+     */
+    gmx_bool usePreviousOrder =
+        (nbs->bIncrGrid && !nbs->DomDec && move == nullptr &&
+         store_previous_atom_order(nbs, grid, a0, a1));
+
 #pragma omp parallel for num_threads(nthread) schedule(static)
     for (int thread = 0; thread < nthread; thread++)
     {
@@ -1332,11 +1439,25 @@ static void calc_cell_indices(const nbnxn_search_t nbs,
     /* Now we know the dimensions we can fill the grid.
      * This is the first, unsorted fill. We sort the columns after this.
      */
-    for (int i = a0; i < a1; i++)
+    if (usePreviousOrder)
     {
-        /* At this point nbs->cell contains the local grid x,y indices */
-        cxy = nbs->cell[i];
-        nbs->a[(grid->cell0 + grid->cxy_ind[cxy])*grid->na_sc + grid->cxy_na[cxy]++] = i;
+        for (int ind = 0; ind < a1 - a0; ind++)
+        {
+            int i = nbs->a_prev[ind];
+
+            /* At this point nbs->cell contains the local grid x,y indices */
+            cxy = nbs->cell[i];
+            nbs->a[(grid->cell0 + grid->cxy_ind[cxy])*grid->na_sc + grid->cxy_na[cxy]++] = i;
+        }
+    }
+    else
+    {
+        for (int i = a0; i < a1; i++)
+        {
+            /* At this point nbs->cell contains the local grid x,y indices */
+            cxy = nbs->cell[i];
+            nbs->a[(grid->cell0 + grid->cxy_ind[cxy])*grid->na_sc + grid->cxy_na[cxy]++] = i;
+        }
     }
 
     if (dd_zone == 0)
@@ -270,6 +270,9 @@ typedef struct nbnxn_search {
     int                        cell_nalloc;     /* Allocation size of cell                    */
     int                       *a;               /* Atom index for grid, the inverse of cell   */
     int                        a_nalloc;        /* Allocation size of a                       */
+    gmx_bool                   bIncrGrid;       /* Use the previous order when gridding?     */
+    int                       *a_prev;          /* The atom order of the previous grid        */
+    int                        a_prev_nalloc;   /* Allocation size of a_prev                  */
 
     int                        natoms_local;    /* The local atoms run from 0 to natoms_local */
     int                        natoms_nonlocal; /* The non-local atoms run from natoms_local
@@ -132,18 +132,21 @@ reduceGroupEnergySimdBuffers(int                       numGroups,
     }
 }
 
-void
-nbnxn_kernel_cpu(nonbonded_verlet_group_t  *nbvg,
-                 const nbnxn_atomdata_t    *nbat,
-                 const interaction_const_t *ic,
-                 rvec                      *shiftVectors,
-                 int                        forceFlags,
-                 int                        clearF,
-                 real                      *fshift,
-                 real                      *vCoulomb,
-                 real                      *vVdw)
+/*! \brief Returns the Coulomb and VdW kernel types to use
+ *
+ * \param[in]  nbvg    The group (local/non-local) to compute interaction for
+ * \param[in]  nbat    The atomdata for the interactions
+ * \param[in]  ic      Non-bonded interaction constants
+ * \param[out] coulktp The Coulomb kernel type
+ * \param[out] vdwktp  The VdW kernel type
+ */
+static void
+getKernelTypes(const nonbonded_verlet_group_t *nbvg,
+               const nbnxn_atomdata_t         *nbat,
+               const interaction_const_t      *ic,
+               int                            *coulktp,
+               int                            *vdwktp)
 {
-
     int                      coulkt;
     if (EEL_RF(ic->eeltype) || ic->eeltype == eelCUT)
     {
@@ -219,195 +222,239 @@ nbnxn_kernel_cpu(nonbonded_verlet_group_t  *nbvg,
         GMX_RELEASE_ASSERT(false, "Unsupported VdW interaction type");
     }
 
+    *coulktp = coulkt;
+    *vdwktp  = vdwkt;
+}
+
+void
+nbnxn_kernel_cpu_list(nonbonded_verlet_group_t  *nbvg,
+                      const nbnxn_atomdata_t    *nbat,
+                      const interaction_const_t *ic,
+                      rvec                      *shiftVectors,
+                      int                        forceFlags,
+                      int                        clearF,
+                      real                      *fshift,
+                      int                        nb)
+{
+    int                coulkt, vdwkt;
     int                nnbl = nbvg->nbl_lists.nnbl;
     nbnxn_pairlist_t **nbl  = nbvg->nbl_lists.nbl;
 
-    GMX_ASSERT(nbl[0]->nci >= 0, "nci<0, which signals an invalid pair-list");
+    getKernelTypes(nbvg, nbat, ic, &coulkt, &vdwkt);
 
-    // cppcheck-suppress unreadVariable
-    int gmx_unused nthreads = gmx_omp_nthreads_get(emntNonbonded);
-#pragma omp parallel for schedule(static) num_threads(nthreads)
-    for (int nb = 0; nb < nnbl; nb++)
+    // Presently, the kernels do not call C++ code that can throw,
+    // so no need for a try/catch pair in the calling OpenMP regions.
+    nbnxn_atomdata_output_t *out = &nbat->out[nb];
+
+    if (clearF == enbvClearFYes)
     {
-        // Presently, the kernels do not call C++ code that can throw,
-        // so no need for a try/catch pair in this OpenMP region.
-        nbnxn_atomdata_output_t *out = &nbat->out[nb];
+        clear_f(nbat, nb, out->f);
+    }
+
+    real *fshift_p;
+    if ((forceFlags & GMX_FORCE_VIRIAL) && nnbl == 1)
+    {
+        fshift_p = fshift;
+    }
+    else
+    {
+        fshift_p = out->fshift;
 
         if (clearF == enbvClearFYes)
         {
-            clear_f(nbat, nb, out->f);
+            clear_fshift(fshift_p);
         }
+    }
 
-        real *fshift_p;
-        if ((forceFlags & GMX_FORCE_VIRIAL) && nnbl == 1)
-        {
-            fshift_p = fshift;
-        }
-        else
+    if (!(forceFlags & GMX_FORCE_ENERGY))
+    {
+        /* Don't calculate energies */
+        switch (nbvg->kernel_type)
         {
-            fshift_p = out->fshift;
-
-            if (clearF == enbvClearFYes)
-            {
-                clear_fshift(fshift_p);
-            }
+            case nbnxnk4x4_PlainC:
+                nbnxn_kernel_noener_ref[coulkt][vdwkt](nbl[nb], nbat,
+                                                       ic,
+                                                       shiftVectors,
+                                                       out->f,
+                                                       fshift_p);
+                break;
+#ifdef GMX_NBNXN_SIMD_2XNN
+            case nbnxnk4xN_SIMD_2xNN:
+                nbnxn_kernel_noener_simd_2xnn[coulkt][vdwkt](nbl[nb], nbat,
+                                                             ic,
+                                                             shiftVectors,
+                                                             out->f,
+                                                             fshift_p);
+                break;
+#endif
+#ifdef GMX_NBNXN_SIMD_4XN
+            case nbnxnk4xN_SIMD_4xN:
+                nbnxn_kernel_noener_simd_4xn[coulkt][vdwkt](nbl[nb], nbat,
+                                                            ic,
+                                                            shiftVectors,
+                                                            out->f,
+                                                            fshift_p);
+                break;
+#endif
+            default:
+                GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
         }
+    }
+    else if (out->nV == 1)
+    {
+        /* A single energy group (pair) */
+        out->Vvdw[0] = 0;
+        out->Vc[0]   = 0;
 
-        if (!(forceFlags & GMX_FORCE_ENERGY))
+        switch (nbvg->kernel_type)
         {
-            /* Don't calculate energies */
-            switch (nbvg->kernel_type)
-            {
-                case nbnxnk4x4_PlainC:
-                    nbnxn_kernel_noener_ref[coulkt][vdwkt](nbl[nb], nbat,
+            case nbnxnk4x4_PlainC:
+                nbnxn_kernel_ener_ref[coulkt][vdwkt](nbl[nb], nbat,
+                                                     ic,
+                                                     shiftVectors,
+                                                     out->f,
+                                                     fshift_p,
+                                                     out->Vvdw,
+                                                     out->Vc);
+                break;
+#ifdef GMX_NBNXN_SIMD_2XNN
+            case nbnxnk4xN_SIMD_2xNN:
+                nbnxn_kernel_ener_simd_2xnn[coulkt][vdwkt](nbl[nb], nbat,
                                                            ic,
                                                            shiftVectors,
                                                            out->f,
-                                                           fshift_p);
-                    break;
-#ifdef GMX_NBNXN_SIMD_2XNN
-                case nbnxnk4xN_SIMD_2xNN:
-                    nbnxn_kernel_noener_simd_2xnn[coulkt][vdwkt](nbl[nb], nbat,
-                                                                 ic,
-                                                                 shiftVectors,
-                                                                 out->f,
-                                                                 fshift_p);
-                    break;
+                                                           fshift_p,
+                                                           out->Vvdw,
+                                                           out->Vc);
+                break;
 #endif
 #ifdef GMX_NBNXN_SIMD_4XN
-                case nbnxnk4xN_SIMD_4xN:
-                    nbnxn_kernel_noener_simd_4xn[coulkt][vdwkt](nbl[nb], nbat,
-                                                                ic,
-                                                                shiftVectors,
-                                                                out->f,
-                                                                fshift_p);
-                    break;
+            case nbnxnk4xN_SIMD_4xN:
+                nbnxn_kernel_ener_simd_4xn[coulkt][vdwkt](nbl[nb], nbat,
+                                                          ic,
+                                                          shiftVectors,
+                                                          out->f,
+                                                          fshift_p,
+                                                          out->Vvdw,
+                                                          out->Vc);
+                break;
 #endif
-                default:
-                    GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
-            }
+            default:
+                GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
         }
-        else if (out->nV == 1)
-        {
-            /* A single energy group (pair) */
-            out->Vvdw[0] = 0;
-            out->Vc[0]   = 0;
+    }
+    else
+    {
+        /* Calculate energy group contributions */
+        clearGroupEnergies(out);
 
-            switch (nbvg->kernel_type)
-            {
-                case nbnxnk4x4_PlainC:
-                    nbnxn_kernel_ener_ref[coulkt][vdwkt](nbl[nb], nbat,
-                                                         ic,
-                                                         shiftVectors,
-                                                         out->f,
-                                                         fshift_p,
-                                                         out->Vvdw,
-                                                         out->Vc);
-                    break;
+        int unrollj = 0;
+
+        switch (nbvg->kernel_type)
+        {
+            case nbnxnk4x4_PlainC:
+                unrollj = NBNXN_CPU_CLUSTER_I_SIZE;
+                nbnxn_kernel_energrp_ref[coulkt][vdwkt](nbl[nb], nbat,
+                                                        ic,
+                                                        shiftVectors,
+                                                        out->f,
+                                                        fshift_p,
+                                                        out->Vvdw,
+                                                        out->Vc);
+                break;
 #ifdef GMX_NBNXN_SIMD_2XNN
-                case nbnxnk4xN_SIMD_2xNN:
-                    nbnxn_kernel_ener_simd_2xnn[coulkt][vdwkt](nbl[nb], nbat,
-                                                               ic,
-                                                               shiftVectors,
-                                                               out->f,
-                                                               fshift_p,
-                                                               out->Vvdw,
-                                                               out->Vc);
-                    break;
-#endif
-#ifdef GMX_NBNXN_SIMD_4XN
-                case nbnxnk4xN_SIMD_4xN:
-                    nbnxn_kernel_ener_simd_4xn[coulkt][vdwkt](nbl[nb], nbat,
+            case nbnxnk4xN_SIMD_2xNN:
+                unrollj = GMX_SIMD_REAL_WIDTH/2;
+                nbnxn_kernel_energrp_simd_2xnn[coulkt][vdwkt](nbl[nb], nbat,
                                                               ic,
                                                               shiftVectors,
                                                               out->f,
                                                               fshift_p,
-                                                              out->Vvdw,
-                                                              out->Vc);
-                    break;
+                                                              out->VSvdw,
+                                                              out->VSc);
+                break;
 #endif
-                default:
-                    GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
-            }
+#ifdef GMX_NBNXN_SIMD_4XN
+            case nbnxnk4xN_SIMD_4xN:
+                unrollj = GMX_SIMD_REAL_WIDTH;
+                nbnxn_kernel_energrp_simd_4xn[coulkt][vdwkt](nbl[nb], nbat,
+                                                             ic,
+                                                             shiftVectors,
+                                                             out->f,
+                                                             fshift_p,
+                                                             out->VSvdw,
+                                                             out->VSc);
+                break;
+#endif
+            default:
+                GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
         }
-        else
-        {
-            /* Calculate energy group contributions */
-            clearGroupEnergies(out);
-
-            int unrollj = 0;
 
-            switch (nbvg->kernel_type)
+        if (nbvg->kernel_type != nbnxnk4x4_PlainC)
+        {
+            switch (unrollj)
             {
-                case nbnxnk4x4_PlainC:
-                    unrollj = NBNXN_CPU_CLUSTER_I_SIZE;
-                    nbnxn_kernel_energrp_ref[coulkt][vdwkt](nbl[nb], nbat,
-                                                            ic,
-                                                            shiftVectors,
-                                                            out->f,
-                                                            fshift_p,
-                                                            out->Vvdw,
-                                                            out->Vc);
+                case 2:
+                    reduceGroupEnergySimdBuffers<2>(nbat->nenergrp,
+                                                    nbat->neg_2log,
+                                                    out->VSvdw, out->VSc,
+                                                    out->Vvdw, out->Vc);
                     break;
-#ifdef GMX_NBNXN_SIMD_2XNN
-                case nbnxnk4xN_SIMD_2xNN:
-                    unrollj = GMX_SIMD_REAL_WIDTH/2;
-                    nbnxn_kernel_energrp_simd_2xnn[coulkt][vdwkt](nbl[nb], nbat,
-                                                                  ic,
-                                                                  shiftVectors,
-                                                                  out->f,
-                                                                  fshift_p,
-                                                                  out->VSvdw,
-                                                                  out->VSc);
+                case 4:
+                    reduceGroupEnergySimdBuffers<4>(nbat->nenergrp,
+                                                    nbat->neg_2log,
+                                                    out->VSvdw, out->VSc,
+                                                    out->Vvdw, out->Vc);
                     break;
-#endif
-#ifdef GMX_NBNXN_SIMD_4XN
-                case nbnxnk4xN_SIMD_4xN:
-                    unrollj = GMX_SIMD_REAL_WIDTH;
-                    nbnxn_kernel_energrp_simd_4xn[coulkt][vdwkt](nbl[nb], nbat,
-                                                                 ic,
-                                                                 shiftVectors,
-                                                                 out->f,
-                                                                 fshift_p,
-                                                                 out->VSvdw,
-                                                                 out->VSc);
+                case 8:
+                    reduceGroupEnergySimdBuffers<8>(nbat->nenergrp,
+                                                    nbat->neg_2log,
+                                                    out->VSvdw, out->VSc,
+                                                    out->Vvdw, out->Vc);
                     break;
-#endif
                 default:
-                    GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
-            }
-
-            if (nbvg->kernel_type != nbnxnk4x4_PlainC)
-            {
-                switch (unrollj)
-                {
-                    case 2:
-                        reduceGroupEnergySimdBuffers<2>(nbat->nenergrp,
-                                                        nbat->neg_2log,
-                                                        out->VSvdw, out->VSc,
-                                                        out->Vvdw, out->Vc);
-                        break;
-                    case 4:
-                        reduceGroupEnergySimdBuffers<4>(nbat->nenergrp,
-                                                        nbat->neg_2log,
-                                                        out->VSvdw, out->VSc,
-                                                        out->Vvdw, out->Vc);
-                        break;
-                    case 8:
-                        reduceGroupEnergySimdBuffers<8>(nbat->nenergrp,
-                                                        nbat->neg_2log,
-                                                        out->VSvdw, out->VSc,
-                                                        out->Vvdw, out->Vc);
-                        break;
-                    default:
-                        GMX_RELEASE_ASSERT(false, "Unsupported j-unroll size");
-                }
+                    GMX_RELEASE_ASSERT(false, "Unsupported j-unroll size");
             }
         }
     }
+}
 
+void
+nbnxn_kernel_cpu_reduce_energies(const nonbonded_verlet_group_t *nbvg,
+                                 const nbnxn_atomdata_t         *nbat,
+                                 int                             forceFlags,
+                                 real                           *vCoulomb,
+                                 real                           *vVdw)
+{
     if (forceFlags & GMX_FORCE_ENERGY)
     {
-        reduce_energies_over_lists(nbat, nnbl, vVdw, vCoulomb);
+        reduce_energies_over_lists(nbat, nbvg->nbl_lists.nnbl, vVdw, vCoulomb);
+    }
+}
+
+void
+nbnxn_kernel_cpu(nonbonded_verlet_group_t  *nbvg,
+                 const nbnxn_atomdata_t    *nbat,
+                 const interaction_const_t *ic,
+                 rvec                      *shiftVectors,
+                 int                        forceFlags,
+                 int                        clearF,
+                 real                      *fshift,
+                 real                      *vCoulomb,
+                 real                      *vVdw)
+{
+    int nnbl = nbvg->nbl_lists.nnbl;
+
+    GMX_ASSERT(nbvg->nbl_lists.nbl[0]->nci >= 0, "nci<0, which signals an invalid pair-list");
+
+    // cppcheck-suppress unreadVariable
+    int gmx_unused nthreads = gmx_omp_nthreads_get(emntNonbonded);
+#pragma omp parallel for schedule(static) num_threads(nthreads)
+    for (int nb = 0; nb < nnbl; nb++)
+    {
+        nbnxn_kernel_cpu_list(nbvg, nbat, ic, shiftVectors, forceFlags, clearF,
+                              fshift, nb);
     }
+
+    nbnxn_kernel_cpu_reduce_energies(nbvg, nbat, forceFlags, vCoulomb, vVdw);
 }
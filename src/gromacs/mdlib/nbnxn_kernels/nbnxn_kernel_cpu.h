@@ -78,4 +78,45 @@ nbnxn_kernel_cpu(nonbonded_verlet_group_t  *nbvg,
                  real                      *vCoulomb,
                  real                      *vVdw);
 
+/*! \brief Runs the non-bonded CPU kernel for pair list \p nb of \p nbvg
+ *
+ * This is the work nbnxn_kernel_cpu() does for one list, without
+ * OpenMP parallelization. The lists can be computed concurrently
+ * on any thread, in any order. After all lists are done, the energies
+ * should be reduced with nbnxn_kernel_cpu_reduce_energies().
+ *
+ * \param[in,out] nbvg          The group (local/non-local) to compute interaction for
+ * \param[in]     nbat          The atomdata for the interactions
+ * \param[in]     ic            Non-bonded interaction constants
+ * \param[in]     shiftVectors  The PBC shift vectors
+ * \param[in]     forceFlags    Flags that tell what to compute
+ * \param[in]     clearF        Enum that tells if to clear the force output buffer
+ * \param[out]    fshift        Shift force output buffer, only used with a single list
+ * \param[in]     nb            The index of the pair list to compute
+ */
+void
+nbnxn_kernel_cpu_list(nonbonded_verlet_group_t  *nbvg,
+                      const nbnxn_atomdata_t    *nbat,
+                      const interaction_const_t *ic,
+                      rvec                      *shiftVectors,
+                      int                        forceFlags,
+                      int                        clearF,
+                      real                      *fshift,
+                      int                        nb);
+
+/*! \brief Reduces the energies of all pair lists of \p nbvg
+ *
+ * \param[in]     nbvg          The group (local/non-local) the interactions were computed for
+ * \param[in]     nbat          The atomdata for the interactions
+ * \param[in]     forceFlags    Flags that tell what was computed
+ * \param[out]    vCoulomb      Output buffer for Coulomb energies
+ * \param[out]    vVdw          Output buffer for Van der Waals energies
+ */
+void
+nbnxn_kernel_cpu_reduce_energies(const nonbonded_verlet_group_t *nbvg,
+                                 const nbnxn_atomdata_t         *nbat,
+                                 int                             forceFlags,
+                                 real                           *vCoulomb,
+                                 real                           *vVdw);
+
 #endif
@@ -319,6 +319,13 @@ void nbnxn_init_search(nbnxn_search_t           * nbs_ptr,
     nbs->a           = nullptr;
     nbs->a_nalloc    = 0;
 
+    /* Incremental gridding gives the same atom order as a full sort,
+     * the environment variable is only useful for checking performance.
+     */
+    nbs->bIncrGrid     = (getenv("GMX_NBNXN_NO_INCREMENTAL_GRID") == nullptr);
+    nbs->a_prev        = nullptr;
+    nbs->a_prev_nalloc = 0;
+
     nbs->nthread_max = nthread_max;
 
     /* Initialize the work data structures for each thread */
@@ -52,8 +52,10 @@
 
 #include <algorithm>
 #include <string>
+#include <vector>
 
 #include "gromacs/domdec/domdec.h"
+#include "gromacs/gmxlib/network.h"
 #include "gromacs/hardware/cpuinfo.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/calc_verletbuf.h"
@@ -64,6 +66,7 @@
 #include "gromacs/mdtypes/interaction_const.h"
 #include "gromacs/mdtypes/state.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/timing/wallcycle.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
@@ -475,7 +478,8 @@ void setupDynamicPairlistPruning(FILE                      *fplog,
             static_assert(c_nbnxnDynamicListPruningMinLifetime % c_nbnxnGpuRollingListPruningInterval == 0,
                           "c_nbnxnDynamicListPruningMinLifetime sets the starting value for nstlistPrune, which should be divisible by the rolling pruning interval for efficiency reasons.");
 
-            // TODO: Use auto-tuning to determine nstlistPrune
+            // On the CPU this initial choice is refined by doPairlistPruneTuning()
+            // TODO: Use auto-tuning to determine nstlistPrune on the GPU
             listParams->nstlistPrune = c_nbnxnDynamicListPruningMinLifetime;
         }
 
@@ -513,3 +517,296 @@ void setupDynamicPairlistPruning(FILE                      *fplog,
         }
     }
 }
+
+/*! \brief The maximum number of pruning setups we time during tuning */
+static const int  c_pruneTuningMaxNumSetups = 6;
+/*! \brief Successive nstlistPrune values to try differ at least by this factor */
+static const real c_pruneTuningNstlistPruneFactor = 1.5;
+/*! \brief The number of nstlist periods each setup is timed, the fastest is used */
+static const int  c_pruneTuningNumMeasurements = 2;
+/*! \brief Only switch away from the heuristic setup when the gain is more than 2% */
+static const real c_pruneTuningMinRelativeGain = 1.02;
+
+/*! \brief One dynamic pruning setup to try */
+struct PairlistPruneSetup
+{
+    int    nstlistPrune;   //!< The pruning interval
+    real   rbufCoulomb;    //!< The inner list buffer with respect to the Coulomb cut-off
+    real   rbufVdw;        //!< The inner list buffer with respect to the VdW cut-off
+    int    count;          //!< The number of times this setup has been timed
+    double cycles;         //!< The fastest time for this setup in cycles per step
+};
+
+/*! \brief Data for the online tuning of the dynamic pruning setup */
+struct PairlistPruneTuner
+{
+    bool                            isActive;           //!< Is the tuning still active?
+    bool                            hasStarted;         //!< Did we start timing setups?
+    std::vector<PairlistPruneSetup> setups;             //!< The setups, setups[0] is the heuristic choice
+    int                             cur;                //!< Index of the setup currently in use
+    int                             cyclesCount;        //!< Step cycle counter cumulative count
+    double                          cyclesSum;          //!< Step cycle counter cumulative cycles
+};
+
+/*! \brief Returns the inner pair-list cut-off for \p setup with the current cut-off's in \p ic */
+static real pruneSetupRlistInner(const PairlistPruneSetup  &setup,
+                                 const interaction_const_t *ic,
+                                 const NbnxnListParameters *listParams)
+{
+    real rlistInner = std::max(ic->rcoulomb + setup.rbufCoulomb,
+                               ic->rvdw + setup.rbufVdw);
+
+    return std::min(rlistInner, listParams->rlistOuter);
+}
+
+void initPairlistPruneTuning(PairlistPruneTuner        **tunerPtr,
+                             FILE                       *fplog,
+                             const t_inputrec           *ir,
+                             const gmx_mtop_t           *mtop,
+                             const matrix                box,
+                             bool                        useGpu,
+                             bool                        reproducible,
+                             const NbnxnListParameters  *listParams)
+{
+    PairlistPruneTuner *tuner = new PairlistPruneTuner;
+
+    tuner->isActive    = false;
+    tuner->hasStarted  = false;
+    tuner->cur         = 0;
+    tuner->cyclesCount = 0;
+    tuner->cyclesSum   = 0;
+
+    *tunerPtr = tuner;
+
+    /* We only tune the CPU setup. On the GPU the pruning is rolling
+     * and overlaps with CPU work, so timing steps tells us little.
+     * We don't tune when the user set nstlistPrune, or when running
+     * reproducibly, since the tuning is based on timings.
+     */
+    if (!listParams->useDynamicPruning || useGpu || reproducible ||
+        getenv("GMX_NSTLIST_DYNAMICPRUNING") != nullptr ||
+        getenv("GMX_DISABLE_DYNAMICPRUNING_TUNING") != nullptr)
+    {
+        return;
+    }
+
+    verletbuf_list_setup_t ls;
+    verletbuf_get_list_setup(TRUE, TRUE, &ls);
+
+    const real rlistInc = nbnxn_get_rlist_effective_inc(ls.cluster_size_j,
+                                                        mtop->natoms/det(box));
+
+    /* The first setup is the heuristic one. We try longer pruning
+     * intervals with larger inner buffers, since shorter intervals
+     * than the heuristic choice would only add pruning work.
+     */
+    int nstlistPrune = listParams->nstlistPrune;
+    while (nstlistPrune < ir->nstlist - 1 &&
+           static_cast<int>(tuner->setups.size()) < c_pruneTuningMaxNumSetups)
+    {
+        real rlistInner;
+        calc_verlet_buffer_size(mtop, det(box), ir,
+                                nstlistPrune, nstlistPrune - 1,
+                                -1, &ls, nullptr,
+                                &rlistInner);
+
+        /* Only consider setups that actually reduce the list size */
+        if (tuner->setups.empty() ||
+            rlistInner + rlistInc < 0.99*(listParams->rlistOuter + rlistInc))
+        {
+            PairlistPruneSetup setup;
+            setup.nstlistPrune = nstlistPrune;
+            setup.rbufCoulomb  = rlistInner - ir->rcoulomb;
+            setup.rbufVdw      = rlistInner - ir->rvdw;
+            setup.count        = 0;
+            setup.cycles       = 0;
+            tuner->setups.push_back(setup);
+        }
+
+        nstlistPrune = std::max(nstlistPrune + 1,
+                                static_cast<int>(nstlistPrune*c_pruneTuningNstlistPruneFactor + 0.5));
+    }
+
+    tuner->isActive = (tuner->setups.size() > 1);
+
+    if (fplog && tuner->isActive)
+    {
+        fprintf(fplog, "Will tune the dynamic pruning interval online, trying %zu setups with nstlistPrune in %d-%d\n\n",
+                tuner->setups.size(),
+                tuner->setups.front().nstlistPrune,
+                tuner->setups.back().nstlistPrune);
+    }
+}
+
+bool pairlistPruneTuningIsActive(const PairlistPruneTuner *tuner)
+{
+    return tuner != nullptr && tuner->isActive;
+}
+
+/*! \brief Switch the pair-list parameters to setup \p index */
+static void setPruneSetup(PairlistPruneTuner        *tuner,
+                          int                        index,
+                          const interaction_const_t *ic,
+                          NbnxnListParameters       *listParams)
+{
+    tuner->cur               = index;
+    listParams->nstlistPrune = tuner->setups[index].nstlistPrune;
+    listParams->rlistInner   = pruneSetupRlistInner(tuner->setups[index], ic, listParams);
+}
+
+void doPairlistPruneTuning(PairlistPruneTuner        *tuner,
+                           FILE                      *fplog,
+                           const t_commrec           *cr,
+                           const t_inputrec          *ir,
+                           const interaction_const_t *ic,
+                           NbnxnListParameters       *listParams,
+                           gmx_wallcycle_t            wcycle,
+                           gmx_int64_t                step,
+                           bool                       waitForOtherTuning)
+{
+    if (!pairlistPruneTuningIsActive(tuner))
+    {
+        return;
+    }
+    if (wcycle == nullptr)
+    {
+        tuner->isActive = false;
+        return;
+    }
+
+    int    stepCount;
+    double stepCycles;
+    wallcycle_get(wcycle, ewcSTEP, &stepCount, &stepCycles);
+
+    doPairlistPruneTuningWithCycles(tuner, fplog, cr, ir, ic, listParams,
+                                    stepCount, stepCycles,
+                                    step, waitForOtherTuning);
+}
+
+void doPairlistPruneTuningWithCycles(PairlistPruneTuner        *tuner,
+                                     FILE                      *fplog,
+                                     const t_commrec           *cr,
+                                     const t_inputrec          *ir,
+                                     const interaction_const_t *ic,
+                                     NbnxnListParameters       *listParams,
+                                     int                        stepCount,
+                                     double                     stepCycles,
+                                     gmx_int64_t                step,
+                                     bool                       waitForOtherTuning)
+{
+    if (!pairlistPruneTuningIsActive(tuner))
+    {
+        return;
+    }
+
+    int    countPrev  = tuner->cyclesCount;
+    double cyclesPrev = tuner->cyclesSum;
+    tuner->cyclesCount = stepCount;
+    tuner->cyclesSum   = stepCycles;
+
+    if (waitForOtherTuning)
+    {
+        /* The cut-off's might still change, wait until they are fixed */
+        return;
+    }
+
+    if (!tuner->hasStarted)
+    {
+        /* The inner cut-off might have been changed by PME tuning,
+         * so set it from our buffers, also for the initial setup.
+         * We skip the current period, which might contain
+         * setup and allocation overhead or tuning by others.
+         */
+        tuner->hasStarted = true;
+        setPruneSetup(tuner, 0, ic, listParams);
+
+        return;
+    }
+
+    /* Since we are called just before the search, the last nstlist steps
+     * all used the current setup. We skip intervals with a different
+     * number of steps, e.g. due to a counter reset, and time again.
+     */
+    if (tuner->cyclesCount - countPrev != ir->nstlist)
+    {
+        return;
+    }
+
+    double cycles = (tuner->cyclesSum - cyclesPrev)/ir->nstlist;
+    if (PAR(cr))
+    {
+        /* All ranks need to make the same choice */
+        gmx_sumd(1, &cycles, cr);
+        cycles /= cr->nnodes;
+    }
+
+    PairlistPruneSetup &setup = tuner->setups[tuner->cur];
+    if (setup.count == 0 || cycles < setup.cycles)
+    {
+        setup.cycles = cycles;
+    }
+    setup.count++;
+
+    if (debug)
+    {
+        char buf[STEPSTRSIZE];
+        fprintf(debug, "step %s: nstlistPrune %d rlistInner %.3f: %.1f M-cycles per step\n",
+                gmx_step_str(step, buf),
+                setup.nstlistPrune, listParams->rlistInner, cycles*1e-6);
+    }
+
+    /* Cycle through the setups, so slow drifts in performance
+     * affect all setups similarly.
+     */
+    int next = (tuner->cur + 1) % tuner->setups.size();
+    if (tuner->setups[next].count < c_pruneTuningNumMeasurements)
+    {
+        setPruneSetup(tuner, next, ic, listParams);
+
+        return;
+    }
+
+    /* All setups have been timed often enough, lock in the fastest */
+    int fastest = 0;
+    for (size_t i = 1; i < tuner->setups.size(); i++)
+    {
+        if (tuner->setups[i].cycles*c_pruneTuningMinRelativeGain < tuner->setups[fastest].cycles)
+        {
+            fastest = i;
+        }
+    }
+    setPruneSetup(tuner, fastest, ic, listParams);
+    tuner->isActive = false;
+
+    if (fplog)
+    {
+        char buf[STEPSTRSIZE];
+        fprintf(fplog, "\nStep %s: dynamic pruning tuning finished, timed per step:\n",
+                gmx_step_str(step, buf));
+        for (size_t i = 0; i < tuner->setups.size(); i++)
+        {
+            fprintf(fplog, "  nstlistPrune %3d, rlist inner %.3f nm: %.2f M-cycles%s\n",
+                    tuner->setups[i].nstlistPrune,
+                    pruneSetupRlistInner(tuner->setups[i], ic, listParams),
+                    tuner->setups[i].cycles*1e-6,
+                    static_cast<int>(i) == fastest ? " (selected)" : "");
+        }
+        fprintf(fplog, "\n");
+    }
+}
+
+void donePairlistPruneTuning(PairlistPruneTuner *tuner,
+                             FILE               *fplog)
+{
+    if (tuner == nullptr)
+    {
+        return;
+    }
+
+    if (fplog && tuner->hasStarted && tuner->isActive)
+    {
+        fprintf(fplog, "\nNOTE: The run ended before the dynamic pruning tuning finished.\n\n");
+    }
+
+    delete tuner;
+}
@@ -49,6 +49,7 @@
 #include <stdio.h>
 
 #include "gromacs/math/vectypes.h"
+#include "gromacs/timing/wallcycle.h"
 
 namespace gmx
 {
@@ -58,6 +59,7 @@ class CpuInfo;
 struct gmx_mtop_t;
 struct interaction_const_t;
 struct NbnxnListParameters;
+struct PairlistPruneTuner;
 struct t_commrec;
 struct t_inputrec;
 
@@ -97,4 +99,99 @@ void setupDynamicPairlistPruning(FILE                      *fplog,
                                  const interaction_const_t *ic,
                                  NbnxnListParameters       *listParams);
 
+/*! \brief Initialize the online tuning of the dynamic pruning setup
+ *
+ * setupDynamicPairlistPruning() chooses nstlistPrune with a fixed cost
+ * model. This sets up a tuner that, during the run, times several
+ * (nstlistPrune, rlistInner) combinations that all obey the Verlet buffer
+ * tolerance and locks in the fastest one. The outer list, and therefore
+ * nstlist and rlistOuter, are not changed.
+ * When tuning is not supported or not useful, \p *tunerPtr is set
+ * to a tuner that is never active.
+ *
+ * \param[out]    tunerPtr      Pointer to the tuning data to be allocated
+ * \param[in,out] fplog         Log file
+ * \param[in]     ir            The input parameter record
+ * \param[in]     mtop          The global topology
+ * \param[in]     box           The unit cell
+ * \param[in]     useGpu        Tells if we are using a GPU for non-bondeds
+ * \param[in]     reproducible  Tells if mdrun was requested to run reproducibly
+ * \param[in]     listParams    The list setup parameters
+ */
+void initPairlistPruneTuning(PairlistPruneTuner        **tunerPtr,
+                             FILE                       *fplog,
+                             const t_inputrec           *ir,
+                             const gmx_mtop_t           *mtop,
+                             const matrix                box,
+                             bool                        useGpu,
+                             bool                        reproducible,
+                             const NbnxnListParameters  *listParams);
+
+/*! \brief Return whether the dynamic pruning tuning is still active
+ *
+ * \param[in] tuner  The tuning data, can be nullptr
+ */
+bool pairlistPruneTuningIsActive(const PairlistPruneTuner *tuner);
+
+/*! \brief Time the last nstlist steps and possibly switch pruning setup
+ *
+ * Should be called at every search step, before the force calculation.
+ * Cycles are taken from the ewcSTEP counter and averaged over all
+ * PP ranks, so all ranks take the same decisions.
+ *
+ * \param[in,out] tuner       The tuning data
+ * \param[in,out] fplog       Log file
+ * \param[in]     cr          The communication record
+ * \param[in]     ir          The input parameter record
+ * \param[in]     ic          The nonbonded interactions constants
+ * \param[in,out] listParams  The list setup parameters
+ * \param[in]     wcycle      The wallcycle counters
+ * \param[in]     step        The current MD step
+ * \param[in]     waitForOtherTuning  When true, other tuning (e.g. PME load balancing) is active and we should not start yet
+ */
+void doPairlistPruneTuning(PairlistPruneTuner        *tuner,
+                           FILE                      *fplog,
+                           const t_commrec           *cr,
+                           const t_inputrec          *ir,
+                           const interaction_const_t *ic,
+                           NbnxnListParameters       *listParams,
+                           gmx_wallcycle_t            wcycle,
+                           gmx_int64_t                step,
+                           bool                       waitForOtherTuning);
+
+/*! \brief As doPairlistPruneTuning(), but with the step cycle counts passed in
+ *
+ * This is the tuning logic without the wallcycle dependency,
+ * which allows driving the tuner with given timings in tests.
+ *
+ * \param[in,out] tuner       The tuning data
+ * \param[in,out] fplog       Log file
+ * \param[in]     cr          The communication record
+ * \param[in]     ir          The input parameter record
+ * \param[in]     ic          The nonbonded interactions constants
+ * \param[in,out] listParams  The list setup parameters
+ * \param[in]     stepCount   The cumulative number of timed MD steps
+ * \param[in]     stepCycles  The cumulative cycles of the timed MD steps
+ * \param[in]     step        The current MD step
+ * \param[in]     waitForOtherTuning  When true, other tuning (e.g. PME load balancing) is active and we should not start yet
+ */
+void doPairlistPruneTuningWithCycles(PairlistPruneTuner        *tuner,
+                                     FILE                      *fplog,
+                                     const t_commrec           *cr,
+                                     const t_inputrec          *ir,
+                                     const interaction_const_t *ic,
+                                     NbnxnListParameters       *listParams,
+                                     int                        stepCount,
+                                     double                     stepCycles,
+                                     gmx_int64_t                step,
+                                     bool                       waitForOtherTuning);
+
+/*! \brief Print the final tuning results to the log file and free the tuning data
+ *
+ * \param[in]     tuner       The tuning data, can be nullptr
+ * \param[in,out] fplog       Log file
+ */
+void donePairlistPruneTuning(PairlistPruneTuner *tuner,
+                             FILE               *fplog);
+
 #endif /* NBNXN_TUNING_H */
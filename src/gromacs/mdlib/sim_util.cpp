@@ -48,6 +48,7 @@
 #include <cstdint>
 
 #include <array>
+#include <atomic>
 
 #include "gromacs/domdec/dlbtiming.h"
 #include "gromacs/domdec/domdec.h"
@@ -63,6 +64,7 @@
 #include "gromacs/imd/imd.h"
 #include "gromacs/listed-forces/bonded.h"
 #include "gromacs/listed-forces/disre.h"
+#include "gromacs/listed-forces/listed-forces.h"
 #include "gromacs/listed-forces/orires.h"
 #include "gromacs/math/functions.h"
 #include "gromacs/math/units.h"
@@ -406,6 +408,84 @@ static void post_process_forces(t_commrec *cr,
     }
 }
 
+/* The arguments for computing the bonded forces as tasks together
+ * with the non-bonded CPU kernel, see do_nb_verlet().
+ */
+struct ListedForceTasks
+{
+    int              numTasks;        /* The number of bonded tasks, 0 when not used */
+    const t_idef    *idef;            /* The local interaction definitions */
+    const rvec      *x;               /* The coordinates */
+    t_pbc            pbc;             /* The PBC setup for the listed interactions */
+    const t_mdatoms *mdatoms;         /* The atom data */
+    const real      *lambda;          /* The lambda values */
+    t_fcdata        *fcd;             /* The restraint data */
+    int             *globalAtomIndex; /* The global atom indices with DD, nullptr otherwise */
+};
+
+/* Runs the non-bonded CPU kernel for all pair lists of nbvg, and the bonded
+ * force tasks, as one set of independent tasks in a single parallel region.
+ * Threads claim the tasks dynamically, so threads that finish early continue
+ * with the remaining tasks instead of waiting at a barrier between the
+ * non-bonded and bonded phases. The non-bonded lists are claimed first,
+ * as these are usually the larger tasks. The reductions depend on all
+ * tasks and are done afterwards: the energies here, the forces by
+ * the caller and by calc_listed().
+ */
+static void do_nb_listed_cpu_tasks(nonbonded_verlet_group_t *nbvg,
+                                   const nbnxn_atomdata_t   *nbat,
+                                   t_forcerec               *fr,
+                                   interaction_const_t      *ic,
+                                   gmx_enerdata_t           *enerd,
+                                   int flags, int clearF,
+                                   const ListedForceTasks   *listedTasks,
+                                   t_nrnb                   *nrnb)
+{
+    const int        numNonbondedTasks = nbvg->nbl_lists.nnbl;
+    const int        numTasks          = numNonbondedTasks + listedTasks->numTasks;
+    std::atomic<int> nextTask(0);
+
+    GMX_ASSERT(nbvg->nbl_lists.nbl[0]->nci >= 0, "nci<0, which signals an invalid pair-list");
+    GMX_ASSERT(numNonbondedTasks > 1, "With a single list the kernel and the bonded tasks both write to fr->fshift");
+
+#pragma omp parallel num_threads(gmx_omp_nthreads_get(emntNonbonded))
+    {
+        try
+        {
+            int task;
+
+            while ((task = nextTask.fetch_add(1, std::memory_order_relaxed)) < numTasks)
+            {
+                if (task < numNonbondedTasks)
+                {
+                    nbnxn_kernel_cpu_list(nbvg, nbat, ic, fr->shift_vec, flags,
+                                          clearF, fr->fshift[0], task);
+                }
+                else
+                {
+                    calc_listed_task(task - numNonbondedTasks,
+                                     listedTasks->idef, listedTasks->x, fr,
+                                     &listedTasks->pbc, nullptr, enerd, nrnb,
+                                     listedTasks->lambda, listedTasks->mdatoms,
+                                     listedTasks->fcd, listedTasks->globalAtomIndex,
+                                     flags);
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    nbnxn_kernel_cpu_reduce_energies(nbvg, nbat, flags,
+                                     enerd->grpp.ener[egCOULSR],
+                                     fr->bBHAM ?
+                                     enerd->grpp.ener[egBHAMSR] :
+                                     enerd->grpp.ener[egLJSR]);
+}
+
+/* Computes the non-bonded interactions of locality ilocality.
+ * When listedTasks is not nullptr and has tasks, the bonded forces
+ * are computed together with the CPU kernel.
+ */
 static void do_nb_verlet(t_forcerec *fr,
                          interaction_const_t *ic,
                          gmx_enerdata_t *enerd,
@@ -413,7 +493,8 @@ static void do_nb_verlet(t_forcerec *fr,
                          int clearF,
                          gmx_int64_t step,
                          t_nrnb *nrnb,
-                         gmx_wallcycle_t wcycle)
+                         gmx_wallcycle_t wcycle,
+                         const ListedForceTasks *listedTasks = nullptr)
 {
     if (!(flags & GMX_FORCE_NONBONDED))
     {
@@ -431,6 +512,7 @@ static void do_nb_verlet(t_forcerec *fr,
     }
 
     bool bUsingGpuKernels = (nbvg->kernel_type == nbnxnk8x8x8_GPU);
+    bool bListedTasks     = (listedTasks != nullptr && listedTasks->numTasks > 0);
 
     if (!bUsingGpuKernels)
     {
@@ -448,7 +530,7 @@ static void do_nb_verlet(t_forcerec *fr,
             wallcycle_sub_stop(wcycle, ewcsNONBONDED_PRUNING);
         }
 
-        wallcycle_sub_start(wcycle, ewcsNONBONDED);
+        wallcycle_sub_start(wcycle, bListedTasks ? ewcsNONBONDED_LISTED : ewcsNONBONDED);
     }
 
     switch (nbvg->kernel_type)
@@ -456,6 +538,12 @@ static void do_nb_verlet(t_forcerec *fr,
         case nbnxnk4x4_PlainC:
         case nbnxnk4xN_SIMD_4xN:
         case nbnxnk4xN_SIMD_2xNN:
+            if (bListedTasks)
+            {
+                do_nb_listed_cpu_tasks(nbvg, nbv->nbat, fr, ic, enerd,
+                                       flags, clearF, listedTasks, nrnb);
+                break;
+            }
             nbnxn_kernel_cpu(nbvg,
                              nbv->nbat,
                              ic,
@@ -493,7 +581,7 @@ static void do_nb_verlet(t_forcerec *fr,
     }
     if (!bUsingGpuKernels)
     {
-        wallcycle_sub_stop(wcycle, ewcsNONBONDED);
+        wallcycle_sub_stop(wcycle, bListedTasks ? ewcsNONBONDED_LISTED : ewcsNONBONDED);
     }
 
     int enr_nbnxn_kernel_ljc, enr_nbnxn_kernel_lj;
@@ -1248,8 +1336,39 @@ static void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
 
     if (!bUseOrEmulGPU)
     {
+        /* Compute the bonded forces together with the local non-bonded
+         * forces, when the bonded setup allows this. The restraints and
+         * the reduction of the bonded forces are still done in
+         * do_force_lowlevel.
+         */
+        ListedForceTasks listedTasks;
+
+        listedTasks.numTasks = 0;
+        if (nbv->bListedForceTasks && graph == nullptr &&
+            (flags & GMX_FORCE_NONBONDED) &&
+            nbv->grp[eintLocal].nbl_lists.nnbl > 1)
+        {
+            listedTasks.numTasks = prepare_listed_tasks(fr, &top->idef, fcd, flags);
+        }
+        if (listedTasks.numTasks > 0)
+        {
+            listedTasks.idef            = &top->idef;
+            listedTasks.x               = x;
+            listedTasks.mdatoms         = mdatoms;
+            listedTasks.lambda          = lambda;
+            listedTasks.fcd             = fcd;
+            listedTasks.globalAtomIndex = DOMAINDECOMP(cr) ? cr->dd->gatindex : nullptr;
+            /* Set up PBC as do_force_lowlevel does for the listed forces */
+            set_pbc(&listedTasks.pbc, fr->ePBC, box);
+            if (fr->bMolPBC)
+            {
+                set_pbc_dd(&listedTasks.pbc, fr->ePBC,
+                           DOMAINDECOMP(cr) ? cr->dd->nc : nullptr, TRUE, box);
+            }
+        }
+
         do_nb_verlet(fr, ic, enerd, flags, eintLocal, enbvClearFYes,
-                     step, nrnb, wcycle);
+                     step, nrnb, wcycle, &listedTasks);
     }
 
     if (fr->efep != efepNO)
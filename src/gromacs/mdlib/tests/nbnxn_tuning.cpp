@@ -0,0 +1,258 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for the online tuning of the dynamic pair-list pruning.
+ *
+ * The tuner is driven with synthetic step timings, so we can check
+ * which setup it locks in and that the inner pair-list cut-off
+ * is set consistently with the chosen pruning interval.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/nbnxn_tuning.h"
+
+#include <functional>
+#include <map>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/calc_verletbuf.h"
+#include "gromacs/mdlib/nbnxn_pairlist.h"
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Returns the cycles per step for a given pruning interval
+typedef std::function<double(int nstlistPrune)> StepCostFunction;
+
+class PairlistPruneTuningTest : public ::testing::Test
+{
+    public:
+        PairlistPruneTuningTest() : listParams_(0), tuner_(nullptr)
+        {
+            /* A charged Lennard-Jones liquid with the density of water */
+            const int  numAtoms = 3000;
+            const real boxSize  = 4.5;
+
+            init_mtop(&mtop_);
+            mtop_.ffparams.atnr   = 1;
+            mtop_.ffparams.ntypes = 1;
+            mtop_.ffparams.reppow = 12;
+            snew(mtop_.ffparams.functype, 1);
+            snew(mtop_.ffparams.iparams, 1);
+            mtop_.ffparams.functype[0]       = F_LJ;
+            mtop_.ffparams.iparams[0].lj.c6  = 2.6e-3;
+            mtop_.ffparams.iparams[0].lj.c12 = 2.6e-6;
+            mtop_.nmoltype = 1;
+            snew(mtop_.moltype, 1);
+            init_t_atoms(&mtop_.moltype[0].atoms, 1, FALSE);
+            mtop_.moltype[0].atoms.atom[0].m    = 18;
+            mtop_.moltype[0].atoms.atom[0].q    = 0.5;
+            mtop_.moltype[0].atoms.atom[0].type = 0;
+            mtop_.nmolblock = 1;
+            snew(mtop_.molblock, 1);
+            mtop_.molblock[0].type       = 0;
+            mtop_.molblock[0].nmol       = numAtoms;
+            mtop_.molblock[0].natoms_mol = 1;
+            mtop_.natoms                 = numAtoms;
+
+            clear_mat(box_);
+            box_[XX][XX] = boxSize;
+            box_[YY][YY] = boxSize;
+            box_[ZZ][ZZ] = boxSize;
+
+            ir_.eI            = eiMD;
+            ir_.delta_t       = 0.002;
+            ir_.nstlist       = 40;
+            ir_.cutoff_scheme = ecutsVERLET;
+            ir_.verletbuf_tol = 0.005;
+            ir_.etc           = etcVRESCALE;
+            ir_.vdwtype       = evdwCUT;
+            ir_.vdw_modifier  = eintmodPOTSHIFT;
+            ir_.rvdw          = 1.0;
+            ir_.coulombtype   = eelCUT;
+            ir_.epsilon_r     = 1;
+            ir_.rcoulomb      = 1.0;
+            ir_.opts.ngtc     = 1;
+            snew(ir_.opts.ref_t, 1);
+            snew(ir_.opts.tau_t, 1);
+            ir_.opts.ref_t[0] = 300;
+            ir_.opts.tau_t[0] = 0.1;
+
+            ic_.rvdw     = ir_.rvdw;
+            ic_.rcoulomb = ir_.rcoulomb;
+
+            verletbuf_list_setup_t ls;
+            verletbuf_get_list_setup(TRUE, TRUE, &ls);
+            calc_verlet_buffer_size(&mtop_, det(box_), &ir_,
+                                    ir_.nstlist, ir_.nstlist - 1,
+                                    -1, &ls, nullptr,
+                                    &listParams_.rlistOuter);
+            listParams_.rlistInner = listParams_.rlistOuter;
+
+            setupDynamicPairlistPruning(nullptr, &ir_, &mtop_, box_, false,
+                                        &ic_, &listParams_);
+            initPairlistPruneTuning(&tuner_, nullptr, &ir_, &mtop_, box_,
+                                    false, false, &listParams_);
+
+            cr_.nnodes = 1;
+        }
+        ~PairlistPruneTuningTest()
+        {
+            donePairlistPruneTuning(tuner_, nullptr);
+            done_mtop(&mtop_);
+        }
+
+        /*! \brief Drives the tuner until it finishes
+         *
+         * Each nstlist period costs \p stepCost for the currently
+         * used pruning interval. Records the inner cut-off used
+         * for each pruning interval in rlistInnerUsed_.
+         */
+        void runTuning(const StepCostFunction &stepCost)
+        {
+            int    stepCount  = 0;
+            double stepCycles = 0;
+            for (int period = 0; period < 100 && pairlistPruneTuningIsActive(tuner_); period++)
+            {
+                doPairlistPruneTuningWithCycles(tuner_, nullptr, &cr_, &ir_, &ic_,
+                                                &listParams_,
+                                                stepCount, stepCycles,
+                                                period*ir_.nstlist, false);
+                rlistInnerUsed_[listParams_.nstlistPrune] = listParams_.rlistInner;
+
+                stepCount  += ir_.nstlist;
+                stepCycles += ir_.nstlist*stepCost(listParams_.nstlistPrune);
+            }
+            EXPECT_FALSE(pairlistPruneTuningIsActive(tuner_)) << "Tuning should have finished";
+        }
+
+        gmx_mtop_t               mtop_;
+        matrix                   box_;
+        t_inputrec               ir_;
+        interaction_const_t      ic_ = {};
+        t_commrec                cr_ = {};
+        NbnxnListParameters      listParams_;
+        PairlistPruneTuner      *tuner_;
+        //! The inner list cut-off used for each tried pruning interval
+        std::map<int, real>      rlistInnerUsed_;
+};
+
+TEST_F(PairlistPruneTuningTest, SelectsFastestSetup)
+{
+    ASSERT_TRUE(listParams_.useDynamicPruning);
+    ASSERT_TRUE(pairlistPruneTuningIsActive(tuner_));
+
+    const int  nstlistPruneHeuristic = listParams_.nstlistPrune;
+    const real rlistInnerHeuristic   = listParams_.rlistInner;
+
+    /* Make longer pruning intervals faster */
+    runTuning([](int nstlistPrune) { return 1e6*(1 + 10.0/nstlistPrune); });
+
+    ASSERT_GT(rlistInnerUsed_.size(), 1U) << "Multiple setups should have been tried";
+    const int nstlistPruneLongest = rlistInnerUsed_.rbegin()->first;
+    EXPECT_EQ(nstlistPruneLongest, listParams_.nstlistPrune);
+    EXPECT_GT(listParams_.nstlistPrune, nstlistPruneHeuristic);
+    EXPECT_LT(listParams_.nstlistPrune, ir_.nstlist);
+    EXPECT_REAL_EQ_TOL(rlistInnerUsed_[nstlistPruneLongest], listParams_.rlistInner, test::defaultRealTolerance());
+    /* A longer pruning interval needs a larger inner buffer */
+    EXPECT_GT(listParams_.rlistInner, rlistInnerHeuristic);
+    EXPECT_LE(listParams_.rlistInner, listParams_.rlistOuter);
+}
+
+TEST_F(PairlistPruneTuningTest, KeepsHeuristicSetupWithoutSignificantGain)
+{
+    ASSERT_TRUE(pairlistPruneTuningIsActive(tuner_));
+
+    const int  nstlistPruneHeuristic = listParams_.nstlistPrune;
+    const real rlistInnerHeuristic   = listParams_.rlistInner;
+
+    /* Other setups are only 1% faster, below the switching threshold */
+    runTuning([nstlistPruneHeuristic](int nstlistPrune) {
+                  return (nstlistPrune == nstlistPruneHeuristic ? 1.01e6 : 1e6);
+              });
+
+    EXPECT_EQ(nstlistPruneHeuristic, listParams_.nstlistPrune);
+    EXPECT_REAL_EQ_TOL(rlistInnerHeuristic, listParams_.rlistInner, test::defaultRealTolerance());
+}
+
+TEST_F(PairlistPruneTuningTest, RecomputesRlistInnerForChangedCutoffs)
+{
+    ASSERT_TRUE(pairlistPruneTuningIsActive(tuner_));
+
+    /* The timed periods do not start while other tuning is active */
+    doPairlistPruneTuningWithCycles(tuner_, nullptr, &cr_, &ir_, &ic_,
+                                    &listParams_, 0, 0, 0, true);
+
+    /* Mimic PME load balancing scaling up the cut-off's and rlist */
+    const real cutoffIncrease = 0.1;
+    ic_.rcoulomb           += cutoffIncrease;
+    ic_.rvdw               += cutoffIncrease;
+    listParams_.rlistOuter += cutoffIncrease;
+
+    const int  nstlistPruneHeuristic = listParams_.nstlistPrune;
+    const real rlistInnerHeuristic   = listParams_.rlistInner;
+
+    runTuning([](int nstlistPrune) { return 1e6*(1 + 10.0/nstlistPrune); });
+
+    /* Each setup keeps its buffer, but with respect to the new cut-off's */
+    ASSERT_EQ(1U, rlistInnerUsed_.count(nstlistPruneHeuristic));
+    EXPECT_REAL_EQ_TOL(rlistInnerHeuristic + cutoffIncrease,
+                       rlistInnerUsed_[nstlistPruneHeuristic],
+                       test::relativeToleranceAsFloatingPoint(1, 1e-5));
+    for (const auto &used : rlistInnerUsed_)
+    {
+        EXPECT_GT(used.second, ic_.rvdw) << "nstlistPrune " << used.first;
+        EXPECT_LE(used.second, listParams_.rlistOuter) << "nstlistPrune " << used.first;
+    }
+    EXPECT_REAL_EQ_TOL(rlistInnerUsed_[listParams_.nstlistPrune], listParams_.rlistInner, test::defaultRealTolerance());
+}
+
+} // namespace
+
+} // namespace gmx
@@ -0,0 +1,281 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for running tasks with gmx_omp_nthreads_run() with and without
+ * the thread pool.
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+
+#include <cstdlib>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/utility/logger.h"
+
+namespace gmx
+{
+
+namespace test
+{
+
+namespace
+{
+
+//! The maximum number of threads used in these tests
+const int c_maxThreads = 4;
+
+//! Data for the test tasks, indexed by thread index
+struct TaskData
+{
+    //! The number of times each thread index was run
+    std::atomic<int>  count[2*c_maxThreads];
+    //! The thread that ran each thread index last, when recorded
+    std::thread::id   id[2*c_maxThreads];
+    //! Whether to record the ids, not done for nested dispatches that run concurrently
+    bool              bRecordIds;
+    //! The number of threads of the nested dispatch, 0 for none
+    int               numNestedThreads;
+    //! Data for the nested dispatches
+    TaskData         *nested;
+
+    TaskData() : bRecordIds(true), numNestedThreads(0), nested(nullptr)
+    {
+        for (std::atomic<int> &c : count)
+        {
+            c.store(0);
+        }
+    }
+};
+
+//! Counts the run of \p thread and does the nested dispatch, if any
+void countTask(int thread, void *data)
+{
+    TaskData *taskData = static_cast<TaskData *>(data);
+
+    taskData->count[thread]++;
+    if (taskData->bRecordIds)
+    {
+        taskData->id[thread] = std::this_thread::get_id();
+    }
+    if (taskData->numNestedThreads > 0)
+    {
+        gmx_omp_nthreads_run(taskData->numNestedThreads, countTask, taskData->nested);
+    }
+}
+
+//! Sets or unsets the GMX_THREAD_POOL environment variable
+void setThreadPoolEnv(bool bSet)
+{
+#ifdef _MSC_VER
+    _putenv(bSet ? "GMX_THREAD_POOL=1" : "GMX_THREAD_POOL=");
+#else
+    if (bSet)
+    {
+        setenv("GMX_THREAD_POOL", "1", 1);
+    }
+    else
+    {
+        unsetenv("GMX_THREAD_POOL");
+    }
+#endif
+}
+
+//! Test fixture for gmx_omp_nthreads_run()
+class ThreadPoolTest : public ::testing::Test
+{
+    public:
+        ThreadPoolTest() : cr_()
+        {
+            cr_.nnodes          = 1;
+            cr_.nrank_intranode = 1;
+        }
+        ~ThreadPoolTest()
+        {
+            gmx_omp_nthreads_finish_thread_pool();
+            setThreadPoolEnv(false);
+        }
+
+        //! Starts a pool of \p numThreads threads
+        void initThreadPool(int numThreads)
+        {
+            setThreadPoolEnv(true);
+            gmx_omp_nthreads_init_thread_pool(mdlog_, &cr_, numThreads, numThreads);
+        }
+
+        /*! \brief Runs \p numRuns dispatches of \p numThreads threads
+         * and checks that each thread index ran once per dispatch.
+         *
+         * With \p bSleep, pauses long enough between some dispatches
+         * for idle pool workers to go from spinning to sleeping.
+         */
+        void runAndCheck(int numThreads, int numRuns, bool bSleep, TaskData *data)
+        {
+            for (int run = 0; run < numRuns; run++)
+            {
+                if (bSleep && run % 20 == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                }
+                gmx_omp_nthreads_run(numThreads, countTask, data);
+            }
+            for (int th = 0; th < 2*c_maxThreads; th++)
+            {
+                EXPECT_EQ(th < numThreads ? numRuns : 0, data->count[th].load()) << "thread index " << th;
+            }
+            EXPECT_EQ(std::this_thread::get_id(), data->id[0]);
+        }
+
+        //! Default object for logging, without output
+        MDLogger  mdlog_;
+        //! Communication record of a single rank
+        t_commrec cr_;
+};
+
+TEST_F(ThreadPoolTest, RunsTasksWithoutPool)
+{
+    for (int numThreads = 1; numThreads <= c_maxThreads; numThreads++)
+    {
+        TaskData data;
+        runAndCheck(numThreads, 200, false, &data);
+    }
+}
+
+TEST_F(ThreadPoolTest, RunsTasksWithPool)
+{
+    initThreadPool(c_maxThreads);
+
+    TaskData data;
+    gmx_omp_nthreads_run(c_maxThreads, countTask, &data);
+    std::vector<std::thread::id> workerIds(data.id, data.id + c_maxThreads);
+    for (int th = 1; th < c_maxThreads; th++)
+    {
+        EXPECT_NE(std::this_thread::get_id(), workerIds[th]);
+    }
+
+    TaskData dataRuns;
+    runAndCheck(c_maxThreads, 1000, false, &dataRuns);
+    /* The same persistent workers run all dispatches */
+    for (int th = 0; th < c_maxThreads; th++)
+    {
+        EXPECT_EQ(workerIds[th], dataRuns.id[th]) << "thread index " << th;
+    }
+}
+
+TEST_F(ThreadPoolTest, WakesUpSleepingWorkers)
+{
+    initThreadPool(c_maxThreads);
+
+    TaskData data;
+    runAndCheck(c_maxThreads, 100, true, &data);
+}
+
+TEST_F(ThreadPoolTest, RunsFewerThreadsThanThePool)
+{
+    initThreadPool(c_maxThreads);
+
+    /* Alternate dispatches of different size, so idle workers
+     * should skip the dispatches not for them.
+     */
+    TaskData dataFew;
+    TaskData dataAll;
+    for (int run = 0; run < 500; run++)
+    {
+        gmx_omp_nthreads_run(2, countTask, &dataFew);
+        gmx_omp_nthreads_run(c_maxThreads, countTask, &dataAll);
+    }
+    for (int th = 0; th < 2*c_maxThreads; th++)
+    {
+        EXPECT_EQ(th < 2 ? 500 : 0, dataFew.count[th].load()) << "thread index " << th;
+        EXPECT_EQ(th < c_maxThreads ? 500 : 0, dataAll.count[th].load()) << "thread index " << th;
+    }
+}
+
+TEST_F(ThreadPoolTest, FallsBackForMoreThreadsThanThePool)
+{
+    initThreadPool(c_maxThreads);
+
+    TaskData data;
+    runAndCheck(2*c_maxThreads, 100, false, &data);
+}
+
+TEST_F(ThreadPoolTest, FallsBackForNestedCalls)
+{
+    initThreadPool(c_maxThreads);
+
+    TaskData nested;
+    TaskData data;
+    nested.bRecordIds     = false;
+    data.numNestedThreads = 2;
+    data.nested           = &nested;
+    runAndCheck(c_maxThreads, 100, false, &data);
+    for (int th = 0; th < 2*c_maxThreads; th++)
+    {
+        EXPECT_EQ(th < 2 ? 100*c_maxThreads : 0, nested.count[th].load()) << "thread index " << th;
+    }
+}
+
+TEST_F(ThreadPoolTest, RunsTasksAfterShutdown)
+{
+    initThreadPool(c_maxThreads);
+
+    TaskData dataBefore;
+    runAndCheck(c_maxThreads, 100, false, &dataBefore);
+    gmx_omp_nthreads_finish_thread_pool();
+
+    TaskData dataAfter;
+    runAndCheck(c_maxThreads, 100, false, &dataAfter);
+
+    /* A new pool can be started after shutdown */
+    initThreadPool(c_maxThreads);
+    TaskData dataRestart;
+    runAndCheck(c_maxThreads, 100, true, &dataRestart);
+}
+
+} // namespace
+
+} // namespace test
+
+} // namespace gmx
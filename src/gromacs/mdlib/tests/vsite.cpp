@@ -0,0 +1,240 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests the SIMD construction of virtual sites against the plain C one.
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/vsite.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+
+namespace test
+{
+
+namespace
+{
+
+//! Number of vsites per type, more than a SIMD width and not a multiple of it
+const int c_numVsitesPerType = 11;
+
+//! The vsite types that are constructed with SIMD
+const int c_simdVsiteTypes[] = { F_VSITE3, F_VSITE3FD, F_VSITE3OUT, F_VSITE4FDN };
+
+//! Test fixture for vsite construction
+class VsiteConstructionTest : public ::testing::Test
+{
+    public:
+        VsiteConstructionTest()
+        {
+            /* Parameters for the types, in the order of c_simdVsiteTypes */
+            const real a[] = { 0.3, 0.4, 0.2, 0.9 };
+            const real b[] = { 0.4, 0.08, 0.3, 1.1 };
+            const real c[] = { 0, 0, 1.5, 0.06 };
+
+            for (int t = 0; t < 4; t++)
+            {
+                t_iparams params;
+                params.vsite.a = a[t];
+                params.vsite.b = b[t];
+                params.vsite.c = c[t];
+                params.vsite.d = 0;
+                params.vsite.e = 0;
+                params.vsite.f = 0;
+                iparams_.push_back(params);
+            }
+
+            /* Each vsite has its own four constructing atoms around
+             * a center, spread over a 2 nm box.
+             */
+            for (int t = 0; t < 4; t++)
+            {
+                const int ftype = c_simdVsiteTypes[t];
+                for (int n = 0; n < c_numVsitesPerType; n++)
+                {
+                    const int  first = x_.size();
+                    const real s     = 0.01*((n*7 + t*3) % 5);
+                    const rvec center = { real(0.17*(n + 3*t)), real(0.31*((n + t) % 7)), real(0.23*((2*n + t) % 9)) };
+                    /* The vsite, followed by up to four constructing atoms */
+                    const rvec offset[] = {
+                        { 0.05, 0.05, 0.05 }, { 0, 0, 0 }, { real(0.1 + s), 0.02, -0.01 },
+                        { -0.02, 0.1, real(0.03 + s) }, { 0.03, real(-0.04 - s), 0.1 }
+                    };
+                    for (const rvec &dx : offset)
+                    {
+                        RVec xa;
+                        rvec_add(center, dx, xa);
+                        x_.push_back(xa);
+                    }
+
+                    std::vector<t_iatom> &iatoms = iatoms_[t];
+                    iatoms.push_back(t);
+                    for (int a = 0; a < NRAL(ftype); a++)
+                    {
+                        iatoms.push_back(first + a);
+                    }
+                }
+            }
+        }
+
+        /*! \brief Constructs the vsites with and without SIMD and compares
+         *
+         * With PBC, the atoms are put in the box, so many constructions
+         * cross the box boundaries, and every third vsite is shifted
+         * by a box vector to test putting it in its old image.
+         */
+        void testConstruction(int ePBC, const matrix box, bool bSetVelocities)
+        {
+            std::vector<RVec> x = x_;
+            if (ePBC != epbcNONE)
+            {
+                put_atoms_in_box(ePBC, box, x.size(), as_rvec_array(x.data()));
+                for (int t = 0; t < 4; t++)
+                {
+                    const std::vector<t_iatom> &iatoms = iatoms_[t];
+                    const int                   inc    = 1 + NRAL(c_simdVsiteTypes[t]);
+                    for (size_t i = 0; i < iatoms.size(); i += 3*inc)
+                    {
+                        rvec_inc(x[iatoms[i + 1]], box[XX]);
+                    }
+                }
+            }
+
+            t_ilist ilist[F_NRE] = {};
+            for (int t = 0; t < 4; t++)
+            {
+                ilist[c_simdVsiteTypes[t]].nr     = iatoms_[t].size();
+                ilist[c_simdVsiteTypes[t]].iatoms = iatoms_[t].data();
+            }
+
+            const real        dt = 0.002;
+            std::vector<RVec> xRef(x), xSimd(x);
+            std::vector<RVec> vRef(x.size(), RVec(0, 0, 0)), vSimd(x.size(), RVec(0, 0, 0));
+
+            gmx_vsite_t       vsite = {};
+            vsite.nthreads        = 1;
+            vsite.n_intercg_vsite = c_numVsitesPerType;
+            construct_vsites(&vsite, as_rvec_array(xRef.data()), dt,
+                             bSetVelocities ? as_rvec_array(vRef.data()) : nullptr,
+                             iparams_.data(), ilist, ePBC, TRUE, nullptr, box);
+            for (int ftype : c_simdVsiteTypes)
+            {
+                vsite.useSimd[ftype] = GMX_SIMD_HAVE_REAL;
+            }
+            construct_vsites(&vsite, as_rvec_array(xSimd.data()), dt,
+                             bSetVelocities ? as_rvec_array(vSimd.data()) : nullptr,
+                             iparams_.data(), ilist, ePBC, TRUE, nullptr, box);
+
+            /* The SIMD invsqrt and the order of operations differ */
+            const real             xTolerance = 1e-5;
+            FloatingPointTolerance tolX(absoluteTolerance(xTolerance));
+            FloatingPointTolerance tolV(absoluteTolerance(xTolerance/dt));
+            for (size_t i = 0; i < x.size(); i++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(xRef[i][d], xSimd[i][d], tolX) << "atom " << i << " dim " << d;
+                    if (bSetVelocities)
+                    {
+                        EXPECT_REAL_EQ_TOL(vRef[i][d], vSimd[i][d], tolV) << "atom " << i << " dim " << d;
+                    }
+                }
+            }
+            /* Check that the vsites were actually constructed */
+            for (int t = 0; t < 4; t++)
+            {
+                EXPECT_GT(distance2(x[iatoms_[t][1]], xRef[iatoms_[t][1]]), 0);
+            }
+        }
+
+        //! Coordinates of the vsites and constructing atoms
+        std::vector<RVec>      x_;
+        //! Parameters, one per vsite type
+        std::vector<t_iparams> iparams_;
+        //! The vsite interactions, per vsite type
+        std::vector<t_iatom>   iatoms_[4];
+};
+
+TEST_F(VsiteConstructionTest, SimdMatchesWithoutPbc)
+{
+    matrix box = {{ 0 }};
+    testConstruction(epbcNONE, box, false);
+}
+
+TEST_F(VsiteConstructionTest, SimdMatchesWithoutPbcWithVelocities)
+{
+    matrix box = {{ 0 }};
+    testConstruction(epbcNONE, box, true);
+}
+
+TEST_F(VsiteConstructionTest, SimdMatchesWithPbc)
+{
+    matrix box = {{ 2, 0, 0 }, { 0, 2, 0 }, { 0, 0, 2 }};
+    testConstruction(epbcXYZ, box, false);
+}
+
+TEST_F(VsiteConstructionTest, SimdMatchesWithPbcWithVelocities)
+{
+    matrix box = {{ 2, 0, 0 }, { 0, 2, 0 }, { 0, 0, 2 }};
+    testConstruction(epbcXYZ, box, true);
+}
+
+TEST_F(VsiteConstructionTest, SimdMatchesWithTriclinicPbcWithVelocities)
+{
+    matrix box = {{ 2, 0, 0 }, { 0.4, 2, 0 }, { -0.3, 0.5, 2 }};
+    testConstruction(epbcXYZ, box, true);
+}
+
+} // namespace
+
+} // namespace test
+
+} // namespace gmx
@@ -113,6 +113,9 @@ struct gmx_update_t
     /* Variables for the deform algorithm */
     gmx_int64_t       deformref_step;
     matrix            deformref_box;
+
+    /* When set, accumulate ekinh here during the final update pass */
+    gmx_ekindata_t   *ekindFused;
 };
 
 static bool isTemperatureCouplingStep(gmx_int64_t step, const t_inputrec *ir)
@@ -824,6 +827,8 @@ gmx_update_t *init_update(const t_inputrec *ir)
 
     upd->xp.resize(0);
 
+    upd->ekindFused = nullptr;
+
     return upd;
 }
 
@@ -1067,12 +1072,73 @@ static void dump_it_all(FILE gmx_unused *fp, const char gmx_unused *title,
 #endif
 }
 
+/* The number of atoms per block for the fused update and kinetic energy pass */
+static const int c_fusedEkinBlockSize = 256;
+
+/* Clears the kinetic energy accumulation buffers of thread */
+static void clear_ekin_thread(const t_grpopts *opts, gmx_ekindata_t *ekind, int thread)
+{
+    for (int gt = 0; gt < opts->ngtc; gt++)
+    {
+        clear_mat(ekind->ekin_work[thread][gt]);
+    }
+    *ekind->dekindl_work[thread] = 0.0;
+}
+
+/* Adds the kinetic energy of atoms start to end to the buffers of thread */
+static void add_ekin_range(int start, int end, const rvec v[],
+                           const t_mdatoms *md,
+                           gmx_ekindata_t *ekind, int thread)
+{
+    // This only loops over arrays and does not call any functions
+    // or memory allocation. It should not be able to throw, so for now
+    // we do not need a try/catch wrapper in the OpenMP callers.
+    const t_grp_acc *grpstat     = ekind->grpstat;
+    matrix          *ekin_sum    = ekind->ekin_work[thread];
+    real            *dekindl_sum = ekind->dekindl_work[thread];
+    int              ga          = 0;
+    int              gt          = 0;
+
+    for (int n = start; n < end; n++)
+    {
+        rvec v_corrt;
+        real hm;
+
+        if (md->cACC)
+        {
+            ga = md->cACC[n];
+        }
+        if (md->cTC)
+        {
+            gt = md->cTC[n];
+        }
+        hm   = 0.5*md->massT[n];
+
+        for (int d = 0; (d < DIM); d++)
+        {
+            v_corrt[d]  = v[n][d]  - grpstat[ga].u[d];
+        }
+        for (int d = 0; (d < DIM); d++)
+        {
+            for (int m = 0; (m < DIM); m++)
+            {
+                /* if we're computing a full step velocity, v_corrt[d] has v(t).  Otherwise, v(t+dt/2) */
+                ekin_sum[gt][m][d] += hm*v_corrt[m]*v_corrt[d];
+            }
+        }
+        if (md->nMassPerturbed && md->bPerturbed[n])
+        {
+            *dekindl_sum +=
+                0.5*(md->massB[n] - md->massA[n])*iprod(v_corrt, v_corrt);
+        }
+    }
+}
+
 static void calc_ke_part_normal(rvec v[], t_grpopts *opts, t_mdatoms *md,
                                 gmx_ekindata_t *ekind, t_nrnb *nrnb, gmx_bool bEkinAveVel)
 {
     int           g;
     t_grp_tcstat *tcstat  = ekind->tcstat;
-    t_grp_acc    *grpstat = ekind->grpstat;
     int           nthread, thread;
 
     /* three main: VV with AveVel, vv with AveEkin, leap with AveEkin.  Leap with AveVel is also
@@ -1100,63 +1166,22 @@ static void calc_ke_part_normal(rvec v[], t_grpopts *opts, t_mdatoms *md,
     ekind->dekindl_old = ekind->dekindl;
     nthread            = gmx_omp_nthreads_get(emntUpdate);
 
-#pragma omp parallel for num_threads(nthread) schedule(static)
-    for (thread = 0; thread < nthread; thread++)
+    if (ekind->bEkinhFused)
     {
-        // This OpenMP only loops over arrays and does not call any functions
-        // or memory allocation. It should not be able to throw, so for now
-        // we do not need a try/catch wrapper.
-        int     start_t, end_t, n;
-        int     ga, gt;
-        rvec    v_corrt;
-        real    hm;
-        int     d, m;
-        matrix *ekin_sum;
-        real   *dekindl_sum;
-
-        start_t = ((thread+0)*md->homenr)/nthread;
-        end_t   = ((thread+1)*md->homenr)/nthread;
-
-        ekin_sum    = ekind->ekin_work[thread];
-        dekindl_sum = ekind->dekindl_work[thread];
-
-        for (gt = 0; gt < opts->ngtc; gt++)
-        {
-            clear_mat(ekin_sum[gt]);
-        }
-        *dekindl_sum = 0.0;
-
-        ga = 0;
-        gt = 0;
-        for (n = start_t; n < end_t; n++)
+        /* The thread contributions were accumulated in update_constraints */
+        GMX_ASSERT(!bEkinAveVel, "The fused kinetic energy is only computed at half steps");
+        ekind->bEkinhFused = FALSE;
+    }
+    else
+    {
+#pragma omp parallel for num_threads(nthread) schedule(static)
+        for (thread = 0; thread < nthread; thread++)
         {
-            if (md->cACC)
-            {
-                ga = md->cACC[n];
-            }
-            if (md->cTC)
-            {
-                gt = md->cTC[n];
-            }
-            hm   = 0.5*md->massT[n];
+            int start_t = ((thread+0)*md->homenr)/nthread;
+            int end_t   = ((thread+1)*md->homenr)/nthread;
 
-            for (d = 0; (d < DIM); d++)
-            {
-                v_corrt[d]  = v[n][d]  - grpstat[ga].u[d];
-            }
-            for (d = 0; (d < DIM); d++)
-            {
-                for (m = 0; (m < DIM); m++)
-                {
-                    /* if we're computing a full step velocity, v_corrt[d] has v(t).  Otherwise, v(t+dt/2) */
-                    ekin_sum[gt][m][d] += hm*v_corrt[m]*v_corrt[d];
-                }
-            }
-            if (md->nMassPerturbed && md->bPerturbed[n])
-            {
-                *dekindl_sum +=
-                    0.5*(md->massB[n] - md->massA[n])*iprod(v_corrt, v_corrt);
-            }
+            clear_ekin_thread(opts, ekind, thread);
+            add_ekin_range(start_t, end_t, v, md, ekind, thread);
         }
     }
 
@@ -1256,6 +1281,16 @@ static void calc_ke_part_visc(matrix box, rvec x[], rvec v[],
     inc_nrnb(nrnb, eNR_EKIN, homenr);
 }
 
+void update_request_fused_ekinh(gmx_update_t     *upd,
+                                const t_inputrec *ir,
+                                gmx_ekindata_t   *ekind)
+{
+    if (ir->eI == eiMD && ekind->cosacc.cos_accel == 0 && !ekind->bNEMD)
+    {
+        upd->ekindFused = ekind;
+    }
+}
+
 void calc_ke_part(t_state *state, t_grpopts *opts, t_mdatoms *md,
                   gmx_ekindata_t *ekind, t_nrnb *nrnb, gmx_bool bEkinAveVel)
 {
@@ -1729,15 +1764,48 @@ void update_constraints(FILE             *fplog,
             // cppcheck-suppress unreadVariable
             nth = gmx_omp_nthreads_get(emntUpdate);
 #endif
+            if (upd->ekindFused != nullptr)
+            {
+                /* Accumulate the half-step kinetic energy in the same pass,
+                 * saving a separate pass over v in calc_ke_part().
+                 */
+                gmx_ekindata_t *ekind = upd->ekindFused;
+                const rvec     *v     = as_rvec_array(state->v.data());
+
 #pragma omp parallel for num_threads(nth) schedule(static)
-            for (int i = 0; i < homenr; i++)
+                for (th = 0; th < nth; th++)
+                {
+                    // Only loops over arrays, does not throw
+                    int start_th, end_th;
+                    getThreadAtomRange(nth, th, homenr, &start_th, &end_th);
+
+                    clear_ekin_thread(&inputrec->opts, ekind, th);
+                    for (int b0 = start_th; b0 < end_th; b0 += c_fusedEkinBlockSize)
+                    {
+                        int b1 = std::min(b0 + c_fusedEkinBlockSize, end_th);
+                        for (int i = b0; i < b1; i++)
+                        {
+                            copy_rvec(xp[i], state->x[i]);
+                        }
+                        add_ekin_range(b0, b1, v, md, ekind, th);
+                    }
+                }
+                ekind->bEkinhFused = TRUE;
+            }
+            else
             {
-                // Trivial statement, does not throw
-                copy_rvec(xp[i], state->x[i]);
+#pragma omp parallel for num_threads(nth) schedule(static)
+                for (int i = 0; i < homenr; i++)
+                {
+                    // Trivial statement, does not throw
+                    copy_rvec(xp[i], state->x[i]);
+                }
             }
         }
         wallcycle_stop(wcycle, ewcUPDATE);
 
+        upd->ekindFused = nullptr;
+
         dump_it_all(fplog, "After unshift",
                     state->natoms, &state->x, &upd->xp, &state->v, force);
     }
@@ -1845,6 +1913,131 @@ void update_pcouple_after_coordinates(FILE             *fplog,
                 state->natoms, &state->x, &upd->xp, &state->v, nullptr);
 }
 
+/*! \brief The arguments of update_coords() used by updateCoordsThread() */
+struct UpdateCoordsTask
+{
+    gmx_int64_t       step;
+    const t_inputrec *inputrec;
+    const t_mdatoms  *md;
+    t_state          *state;
+    PaddedRVecVector *f;
+    gmx_ekindata_t   *ekind;
+    rvec             *M;
+    gmx_update_t     *upd;
+    int               UpdatePart;
+    const t_commrec  *cr;
+    gmx_bool          bDoConstr;
+    int               nth;
+};
+
+/*! \brief Updates the coordinates of the atom range of thread \p th */
+static void updateCoordsThread(int th, void *data)
+{
+    const UpdateCoordsTask *task       = static_cast<const UpdateCoordsTask *>(data);
+    gmx_int64_t             step       = task->step;
+    const t_inputrec       *inputrec   = task->inputrec;
+    const t_mdatoms        *md         = task->md;
+    t_state                *state      = task->state;
+    PaddedRVecVector       *f          = task->f;
+    gmx_ekindata_t         *ekind      = task->ekind;
+    rvec                   *M          = task->M;
+    gmx_update_t           *upd        = task->upd;
+    int                     UpdatePart = task->UpdatePart;
+    const t_commrec        *cr         = task->cr;
+    gmx_bool                bDoConstr  = task->bDoConstr;
+    int                     nth        = task->nth;
+    int                     homenr     = md->homenr;
+    /* Cast to real for faster code, no loss in precision (see comment above) */
+    real                    dt         = inputrec->delta_t;
+
+    try
+    {
+        int start_th, end_th;
+        getThreadAtomRange(nth, th, homenr, &start_th, &end_th);
+
+#ifndef NDEBUG
+        /* Strictly speaking, we would only need this check with SIMD
+         * and for the actual SIMD width. But since the code currently
+         * always adds padding for GMX_REAL_MAX_SIMD_WIDTH, we check that.
+         */
+        size_t homenrSimdPadded = ((homenr + GMX_REAL_MAX_SIMD_WIDTH - 1)/GMX_REAL_MAX_SIMD_WIDTH)*GMX_REAL_MAX_SIMD_WIDTH;
+        GMX_ASSERT(state->x.size() >= homenrSimdPadded, "state->x needs to be padded for SIMD access");
+        GMX_ASSERT(upd->xp.size()  >= homenrSimdPadded, "upd->xp needs to be padded for SIMD access");
+        GMX_ASSERT(state->v.size() >= homenrSimdPadded, "state->v needs to be padded for SIMD access");
+        GMX_ASSERT(f->size()       >= homenrSimdPadded, "f needs to be padded for SIMD access");
+#endif
+
+        const rvec *x_rvec  = as_rvec_array(state->x.data());
+        rvec       *xp_rvec = as_rvec_array(upd->xp.data());
+        rvec       *v_rvec  = as_rvec_array(state->v.data());
+        const rvec *f_rvec  = as_rvec_array(f->data());
+
+        switch (inputrec->eI)
+        {
+            case (eiMD):
+                do_update_md(start_th, end_th, step, dt,
+                             inputrec, md, ekind, state->box,
+                             x_rvec, xp_rvec, v_rvec, f_rvec,
+                             state->nosehoover_vxi.data(), M);
+                break;
+            case (eiSD1):
+                /* With constraints, the SD1 update is done in 2 parts */
+                do_update_sd1(upd->sd,
+                              start_th, end_th, dt,
+                              inputrec->opts.acc, inputrec->opts.nFreeze,
+                              md->invmass, md->ptype,
+                              md->cFREEZE, md->cACC, md->cTC,
+                              x_rvec, xp_rvec, v_rvec, f_rvec,
+                              bDoConstr, TRUE,
+                              step, inputrec->ld_seed, DOMAINDECOMP(cr) ? cr->dd->gatindex : nullptr);
+                break;
+            case (eiBD):
+                do_update_bd(start_th, end_th, dt,
+                             inputrec->opts.nFreeze, md->invmass, md->ptype,
+                             md->cFREEZE, md->cTC,
+                             x_rvec, xp_rvec, v_rvec, f_rvec,
+                             inputrec->bd_fric,
+                             upd->sd->bd_rf,
+                             step, inputrec->ld_seed, DOMAINDECOMP(cr) ? cr->dd->gatindex : nullptr);
+                break;
+            case (eiVV):
+            case (eiVVAK):
+            {
+                gmx_bool bExtended = (inputrec->etc == etcNOSEHOOVER ||
+                                      inputrec->epc == epcPARRINELLORAHMAN ||
+                                      inputrec->epc == epcMTTK);
+
+                /* assuming barostat coupled to group 0 */
+                real alpha = 1.0 + DIM/static_cast<real>(inputrec->opts.nrdf[0]);
+                switch (UpdatePart)
+                {
+                    case etrtVELOCITY1:
+                    case etrtVELOCITY2:
+                        do_update_vv_vel(start_th, end_th, dt,
+                                         inputrec->opts.acc, inputrec->opts.nFreeze,
+                                         md->invmass, md->ptype,
+                                         md->cFREEZE, md->cACC,
+                                         v_rvec, f_rvec,
+                                         bExtended, state->veta, alpha);
+                        break;
+                    case etrtPOSITION:
+                        do_update_vv_pos(start_th, end_th, dt,
+                                         inputrec->opts.nFreeze,
+                                         md->ptype, md->cFREEZE,
+                                         x_rvec, xp_rvec, v_rvec,
+                                         bExtended, state->veta);
+                        break;
+                }
+                break;
+            }
+            default:
+                gmx_fatal(FARGS, "Don't know how to update coordinates");
+                break;
+        }
+    }
+    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+}
+
 void update_coords(FILE             *fplog,
                    gmx_int64_t       step,
                    t_inputrec       *inputrec,  /* input record and box stuff	*/
@@ -1868,11 +2061,6 @@ void update_coords(FILE             *fplog,
         gmx_incons("update_coords called for velocity without VV integrator");
     }
 
-    int  homenr = md->homenr;
-
-    /* Cast to real for faster code, no loss in precision (see comment above) */
-    real dt     = inputrec->delta_t;
-
     /* We need to update the NMR restraint history when time averaging is used */
     if (state->flags & (1<<estDISRE_RM3TAV))
     {
@@ -1888,99 +2076,21 @@ void update_coords(FILE             *fplog,
     dump_it_all(fplog, "Before update",
                 state->natoms, &state->x, &upd->xp, &state->v, f);
 
-    int nth = gmx_omp_nthreads_get(emntUpdate);
-
-#pragma omp parallel for num_threads(nth) schedule(static)
-    for (int th = 0; th < nth; th++)
-    {
-        try
-        {
-            int start_th, end_th;
-            getThreadAtomRange(nth, th, homenr, &start_th, &end_th);
-
-#ifndef NDEBUG
-            /* Strictly speaking, we would only need this check with SIMD
-             * and for the actual SIMD width. But since the code currently
-             * always adds padding for GMX_REAL_MAX_SIMD_WIDTH, we check that.
-             */
-            size_t homenrSimdPadded = ((homenr + GMX_REAL_MAX_SIMD_WIDTH - 1)/GMX_REAL_MAX_SIMD_WIDTH)*GMX_REAL_MAX_SIMD_WIDTH;
-            GMX_ASSERT(state->x.size() >= homenrSimdPadded, "state->x needs to be padded for SIMD access");
-            GMX_ASSERT(upd->xp.size()  >= homenrSimdPadded, "upd->xp needs to be padded for SIMD access");
-            GMX_ASSERT(state->v.size() >= homenrSimdPadded, "state->v needs to be padded for SIMD access");
-            GMX_ASSERT(f->size()       >= homenrSimdPadded, "f needs to be padded for SIMD access");
-#endif
-
-            const rvec *x_rvec  = as_rvec_array(state->x.data());
-            rvec       *xp_rvec = as_rvec_array(upd->xp.data());
-            rvec       *v_rvec  = as_rvec_array(state->v.data());
-            const rvec *f_rvec  = as_rvec_array(f->data());
-
-            switch (inputrec->eI)
-            {
-                case (eiMD):
-                    do_update_md(start_th, end_th, step, dt,
-                                 inputrec, md, ekind, state->box,
-                                 x_rvec, xp_rvec, v_rvec, f_rvec,
-                                 state->nosehoover_vxi.data(), M);
-                    break;
-                case (eiSD1):
-                    /* With constraints, the SD1 update is done in 2 parts */
-                    do_update_sd1(upd->sd,
-                                  start_th, end_th, dt,
-                                  inputrec->opts.acc, inputrec->opts.nFreeze,
-                                  md->invmass, md->ptype,
-                                  md->cFREEZE, md->cACC, md->cTC,
-                                  x_rvec, xp_rvec, v_rvec, f_rvec,
-                                  bDoConstr, TRUE,
-                                  step, inputrec->ld_seed, DOMAINDECOMP(cr) ? cr->dd->gatindex : nullptr);
-                    break;
-                case (eiBD):
-                    do_update_bd(start_th, end_th, dt,
-                                 inputrec->opts.nFreeze, md->invmass, md->ptype,
-                                 md->cFREEZE, md->cTC,
-                                 x_rvec, xp_rvec, v_rvec, f_rvec,
-                                 inputrec->bd_fric,
-                                 upd->sd->bd_rf,
-                                 step, inputrec->ld_seed, DOMAINDECOMP(cr) ? cr->dd->gatindex : nullptr);
-                    break;
-                case (eiVV):
-                case (eiVVAK):
-                {
-                    gmx_bool bExtended = (inputrec->etc == etcNOSEHOOVER ||
-                                          inputrec->epc == epcPARRINELLORAHMAN ||
-                                          inputrec->epc == epcMTTK);
-
-                    /* assuming barostat coupled to group 0 */
-                    real alpha = 1.0 + DIM/static_cast<real>(inputrec->opts.nrdf[0]);
-                    switch (UpdatePart)
-                    {
-                        case etrtVELOCITY1:
-                        case etrtVELOCITY2:
-                            do_update_vv_vel(start_th, end_th, dt,
-                                             inputrec->opts.acc, inputrec->opts.nFreeze,
-                                             md->invmass, md->ptype,
-                                             md->cFREEZE, md->cACC,
-                                             v_rvec, f_rvec,
-                                             bExtended, state->veta, alpha);
-                            break;
-                        case etrtPOSITION:
-                            do_update_vv_pos(start_th, end_th, dt,
-                                             inputrec->opts.nFreeze,
-                                             md->ptype, md->cFREEZE,
-                                             x_rvec, xp_rvec, v_rvec,
-                                             bExtended, state->veta);
-                            break;
-                    }
-                    break;
-                }
-                default:
-                    gmx_fatal(FARGS, "Don't know how to update coordinates");
-                    break;
-            }
-        }
-        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
-    }
-
+    UpdateCoordsTask task;
+    task.step       = step;
+    task.inputrec   = inputrec;
+    task.md         = md;
+    task.state      = state;
+    task.f          = f;
+    task.ekind      = ekind;
+    task.M          = M;
+    task.upd        = upd;
+    task.UpdatePart = UpdatePart;
+    task.cr         = cr;
+    task.bDoConstr  = bDoConstr;
+    task.nth        = gmx_omp_nthreads_get(emntUpdate);
+
+    gmx_omp_nthreads_run(task.nth, updateCoordsThread, &task);
 }
 
 
@@ -152,6 +152,17 @@ void update_constraints(FILE              *fplog,
 
 /* Return TRUE if OK, FALSE in case of Shake Error */
 
+void update_request_fused_ekinh(gmx_update_t     *upd,
+                                const t_inputrec *ir,
+                                gmx_ekindata_t   *ekind);
+/* Request that the next call to update_constraints() accumulates the
+ * half-step kinetic energy while copying the updated coordinates,
+ * so the next call to calc_ke_part() only needs to reduce the thread
+ * contributions. Should only be called when calc_ke_part() will be
+ * called after the update. Ignored for setups other than leap-frog
+ * without cosine acceleration or NEMD.
+ */
+
 void calc_ke_part(t_state *state, t_grpopts *opts, t_mdatoms *md,
                   gmx_ekindata_t *ekind, t_nrnb *nrnb, gmx_bool bEkinAveVel);
 /*
@@ -39,6 +39,7 @@
 #include "vsite.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <algorithm>
 #include <vector>
@@ -51,9 +52,14 @@
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/commrec.h"
+#include "gromacs/mdtypes/mdatom.h"
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/pbcutil/mshift.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/pbcutil/pbc-simd.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/simd/simd_math.h"
+#include "gromacs/simd/vector_operations.h"
 #include "gromacs/topology/ifunc.h"
 #include "gromacs/topology/mtop_util.h"
 #include "gromacs/utility/exceptions.h"
@@ -455,6 +461,189 @@ static PbcMode getPbcMode(const t_pbc       *pbcPtr,
     }
 }
 
+/*! \brief Returns whether vsites of type \p ftype can be constructed with SIMD
+ *
+ * Only the construction uses SIMD. The force spreading stays scalar, since
+ * the vsites in a SIMD batch can share constructing atoms, e.g. with
+ * multiple vsites in a molecule, and the scattered force updates would
+ * then conflict.
+ */
+static bool vsiteTypeHasSimdConstruction(int ftype)
+{
+    return (ftype == F_VSITE3 || ftype == F_VSITE3FD ||
+            ftype == F_VSITE3OUT || ftype == F_VSITE4FDN);
+}
+
+#if GMX_SIMD_HAVE_REAL
+
+using namespace gmx; // TODO: Remove when this file is moved into gmx namespace
+
+/*! \brief Constructs the \p nr/(1+NRAL(ftype)) vsites in \p ia using SIMD
+ *
+ * Constructs GMX_SIMD_REAL_WIDTH vsites at once, so the vsites in \p ia
+ * should not be constructed from each other. The atom indices and
+ * parameters are packed per type into aligned arrays. At the end of
+ * the list the last vsite is repeated, which is harmless since it is
+ * constructed to the same position.
+ * Distances are corrected for PBC with \p pbc_simd, which sets no PBC
+ * when it was set up without PBC. With \p keepOldImage, each vsite is put
+ * in the periodic image closest to its old position.
+ * Velocities are set when \p v != nullptr.
+ */
+static void construct_vsites_simd(int ftype, int nr, const t_iatom *ia,
+                                  const t_iparams ip[],
+                                  rvec x[], rvec *v, real inv_dt,
+                                  const real *pbc_simd, bool keepOldImage)
+{
+    const int                              inc = 1 + NRAL(ftype);
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)  av[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)  ai[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)  aj[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)  ak[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(int, GMX_SIMD_REAL_WIDTH)  al[GMX_SIMD_REAL_WIDTH];
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) coeff[3*GMX_SIMD_REAL_WIDTH];
+    real                                  *xr = x[0];
+    SimdReal                               inv_dt_S(inv_dt);
+
+    for (int i = 0; i < nr; i += GMX_SIMD_REAL_WIDTH*inc)
+    {
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const t_iatom   *iatoms = ia + iu;
+            const t_iparams &params = ip[iatoms[0]];
+
+            av[s] = iatoms[1];
+            ai[s] = iatoms[2];
+            aj[s] = iatoms[3];
+            ak[s] = iatoms[4];
+            al[s] = (ftype == F_VSITE4FDN ? iatoms[5] : iatoms[4]);
+            coeff[                      s] = params.vsite.a;
+            coeff[  GMX_SIMD_REAL_WIDTH+s] = params.vsite.b;
+            coeff[2*GMX_SIMD_REAL_WIDTH+s] = params.vsite.c;
+
+            if (iu + inc < nr)
+            {
+                iu += inc;
+            }
+        }
+
+        SimdReal xi_S, yi_S, zi_S;
+        SimdReal xj_S, yj_S, zj_S;
+        SimdReal xk_S, yk_S, zk_S;
+        gatherLoadUTranspose<3>(xr, ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(xr, aj, &xj_S, &yj_S, &zj_S);
+        gatherLoadUTranspose<3>(xr, ak, &xk_S, &yk_S, &zk_S);
+
+        SimdReal a_S = load<SimdReal>(coeff);
+        SimdReal b_S = load<SimdReal>(coeff + GMX_SIMD_REAL_WIDTH);
+        SimdReal c_S = load<SimdReal>(coeff + 2*GMX_SIMD_REAL_WIDTH);
+
+        SimdReal xv_S, yv_S, zv_S;
+        switch (ftype)
+        {
+            case F_VSITE3:
+            {
+                SimdReal dxj_S = xj_S - xi_S, dyj_S = yj_S - yi_S, dzj_S = zj_S - zi_S;
+                SimdReal dxk_S = xk_S - xi_S, dyk_S = yk_S - yi_S, dzk_S = zk_S - zi_S;
+                pbc_correct_dx_simd(&dxj_S, &dyj_S, &dzj_S, pbc_simd);
+                pbc_correct_dx_simd(&dxk_S, &dyk_S, &dzk_S, pbc_simd);
+                xv_S = fma(a_S, dxj_S, fma(b_S, dxk_S, xi_S));
+                yv_S = fma(a_S, dyj_S, fma(b_S, dyk_S, yi_S));
+                zv_S = fma(a_S, dzj_S, fma(b_S, dzk_S, zi_S));
+                break;
+            }
+            case F_VSITE3FD:
+            {
+                SimdReal xij_S = xj_S - xi_S, yij_S = yj_S - yi_S, zij_S = zj_S - zi_S;
+                SimdReal xjk_S = xk_S - xj_S, yjk_S = yk_S - yj_S, zjk_S = zk_S - zj_S;
+                pbc_correct_dx_simd(&xij_S, &yij_S, &zij_S, pbc_simd);
+                pbc_correct_dx_simd(&xjk_S, &yjk_S, &zjk_S, pbc_simd);
+                /* temp goes from i to a point on the line jk */
+                SimdReal xt_S  = fma(a_S, xjk_S, xij_S);
+                SimdReal yt_S  = fma(a_S, yjk_S, yij_S);
+                SimdReal zt_S  = fma(a_S, zjk_S, zij_S);
+                SimdReal c1_S  = b_S*invsqrt(norm2(xt_S, yt_S, zt_S));
+                xv_S = fma(c1_S, xt_S, xi_S);
+                yv_S = fma(c1_S, yt_S, yi_S);
+                zv_S = fma(c1_S, zt_S, zi_S);
+                break;
+            }
+            case F_VSITE3OUT:
+            {
+                SimdReal xij_S = xj_S - xi_S, yij_S = yj_S - yi_S, zij_S = zj_S - zi_S;
+                SimdReal xik_S = xk_S - xi_S, yik_S = yk_S - yi_S, zik_S = zk_S - zi_S;
+                pbc_correct_dx_simd(&xij_S, &yij_S, &zij_S, pbc_simd);
+                pbc_correct_dx_simd(&xik_S, &yik_S, &zik_S, pbc_simd);
+                SimdReal xt_S, yt_S, zt_S;
+                cprod(xij_S, yij_S, zij_S, xik_S, yik_S, zik_S, &xt_S, &yt_S, &zt_S);
+                xv_S = fma(a_S, xij_S, fma(b_S, xik_S, fma(c_S, xt_S, xi_S)));
+                yv_S = fma(a_S, yij_S, fma(b_S, yik_S, fma(c_S, yt_S, yi_S)));
+                zv_S = fma(a_S, zij_S, fma(b_S, zik_S, fma(c_S, zt_S, zi_S)));
+                break;
+            }
+            case F_VSITE4FDN:
+            {
+                SimdReal xl_S, yl_S, zl_S;
+                gatherLoadUTranspose<3>(xr, al, &xl_S, &yl_S, &zl_S);
+                SimdReal xij_S = xj_S - xi_S, yij_S = yj_S - yi_S, zij_S = zj_S - zi_S;
+                SimdReal xik_S = xk_S - xi_S, yik_S = yk_S - yi_S, zik_S = zk_S - zi_S;
+                SimdReal xil_S = xl_S - xi_S, yil_S = yl_S - yi_S, zil_S = zl_S - zi_S;
+                pbc_correct_dx_simd(&xij_S, &yij_S, &zij_S, pbc_simd);
+                pbc_correct_dx_simd(&xik_S, &yik_S, &zik_S, pbc_simd);
+                pbc_correct_dx_simd(&xil_S, &yil_S, &zil_S, pbc_simd);
+                /* rja = a*xik - xij, rjb = b*xil - xij */
+                SimdReal xja_S = fms(a_S, xik_S, xij_S);
+                SimdReal yja_S = fms(a_S, yik_S, yij_S);
+                SimdReal zja_S = fms(a_S, zik_S, zij_S);
+                SimdReal xjb_S = fms(b_S, xil_S, xij_S);
+                SimdReal yjb_S = fms(b_S, yil_S, yij_S);
+                SimdReal zjb_S = fms(b_S, zil_S, zij_S);
+                SimdReal xm_S, ym_S, zm_S;
+                cprod(xja_S, yja_S, zja_S, xjb_S, yjb_S, zjb_S, &xm_S, &ym_S, &zm_S);
+                SimdReal d_S = c_S*invsqrt(norm2(xm_S, ym_S, zm_S));
+                xv_S = fma(d_S, xm_S, xi_S);
+                yv_S = fma(d_S, ym_S, yi_S);
+                zv_S = fma(d_S, zm_S, zi_S);
+                break;
+            }
+            default:
+                gmx_incons("construct_vsites_simd called with an unsupported vsite type");
+        }
+
+        if (keepOldImage || v != nullptr)
+        {
+            /* Get the old vsite positions */
+            SimdReal xo_S, yo_S, zo_S;
+            gatherLoadUTranspose<3>(xr, av, &xo_S, &yo_S, &zo_S);
+
+            if (keepOldImage)
+            {
+                /* Put the vsite in the image closest to its old position */
+                SimdReal dx_S = xv_S - xo_S, dy_S = yv_S - yo_S, dz_S = zv_S - zo_S;
+                SimdReal cx_S = dx_S, cy_S = dy_S, cz_S = dz_S;
+                pbc_correct_dx_simd(&cx_S, &cy_S, &cz_S, pbc_simd);
+                SimdBool shifted = (cx_S != dx_S || cy_S != dy_S || cz_S != dz_S);
+                xv_S = blend(xv_S, xo_S + cx_S, shifted);
+                yv_S = blend(yv_S, yo_S + cy_S, shifted);
+                zv_S = blend(zv_S, zo_S + cz_S, shifted);
+            }
+            if (v != nullptr)
+            {
+                /* Calculate velocity of vsite... */
+                transposeScatterStoreU<3>(v[0], av,
+                                          (xv_S - xo_S)*inv_dt_S,
+                                          (yv_S - yo_S)*inv_dt_S,
+                                          (zv_S - zo_S)*inv_dt_S);
+            }
+        }
+
+        transposeScatterStoreU<3>(xr, av, xv_S, yv_S, zv_S);
+    }
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 static void construct_vsites_thread(const gmx_vsite_t *vsite,
                                     rvec x[],
                                     real dt, rvec *v,
@@ -476,6 +665,11 @@ static void construct_vsites_thread(const gmx_vsite_t *vsite,
     const t_pbc   *pbc_null2 = pbc_null;
     const int     *vsite_pbc = nullptr;
 
+#if GMX_SIMD_HAVE_REAL
+    GMX_ALIGNED(real, GMX_SIMD_REAL_WIDTH) pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+    set_pbc_simd(pbc_null, pbc_simd);
+#endif
+
     for (int ftype = c_ftypeVsiteStart; ftype < c_ftypeVsiteEnd; ftype++)
     {
         if (ilist[ftype].nr == 0)
@@ -483,6 +677,17 @@ static void construct_vsites_thread(const gmx_vsite_t *vsite,
             continue;
         }
 
+#if GMX_SIMD_HAVE_REAL
+        if (vsite != nullptr && vsite->useSimd[ftype] &&
+            pbcMode != PbcMode::chargeGroup)
+        {
+            construct_vsites_simd(ftype, ilist[ftype].nr, ilist[ftype].iatoms,
+                                  ip, x, v, inv_dt,
+                                  pbc_simd, pbcMode == PbcMode::all);
+            continue;
+        }
+#endif
+
         {   // TODO remove me
             int            nra = interaction_function[ftype].nratoms;
             int            inc = 1 + nra;
@@ -2044,6 +2249,15 @@ gmx_vsite_t *initVsite(const gmx_mtop_t &mtop,
 
     vsite->useDomdec         = (DOMAINDECOMP(cr) && cr->dd->nnodes > 1);
 
+    vsite->simdEnabled       = (GMX_SIMD_HAVE_REAL &&
+                                getenv("GMX_DISABLE_SIMD_KERNELS") == nullptr);
+
+    /* Set by setVsiteSimdUse() when the local vsites are known */
+    for (int ftype = 0; ftype < F_NRE; ftype++)
+    {
+        vsite->useSimd[ftype] = false;
+    }
+
     /* If we don't have charge groups, the vsite follows its own pbc.
      *
      * With charge groups, each vsite needs to follow the pbc of the charge
@@ -2320,6 +2534,40 @@ static void assignVsitesToSingleTask(VsiteThread     *tData,
     }
 }
 
+/*! \brief Sets per vsite type whether the vsites can be constructed with SIMD
+ *
+ * The SIMD construction constructs multiple vsites of the same type
+ * at once, so it can only be used when none of the vsites of a type
+ * is constructed from other vsites.
+ */
+static void setVsiteSimdUse(const t_ilist   *ilist,
+                            const t_mdatoms *mdatoms,
+                            gmx_vsite_t     *vsite)
+{
+    for (int ftype = c_ftypeVsiteStart; ftype < c_ftypeVsiteEnd; ftype++)
+    {
+        bool useSimd = (vsite->simdEnabled && vsiteTypeHasSimdConstruction(ftype));
+
+        if (useSimd)
+        {
+            int            nral1 = 1 + NRAL(ftype);
+            const t_iatom *iat   = ilist[ftype].iatoms;
+            for (int i = 0; i < ilist[ftype].nr && useSimd; i += nral1)
+            {
+                for (int j = i + 2; j < i + nral1; j++)
+                {
+                    if (mdatoms->ptype[iat[j]] == eptVSite)
+                    {
+                        useSimd = false;
+                    }
+                }
+            }
+        }
+
+        vsite->useSimd[ftype] = useSimd;
+    }
+}
+
 void split_vsites_over_threads(const t_ilist   *ilist,
                                const t_iparams *ip,
                                const t_mdatoms *mdatoms,
@@ -2327,6 +2575,8 @@ void split_vsites_over_threads(const t_ilist   *ilist,
 {
     int      vsite_atom_range, natperthread;
 
+    setVsiteSimdUse(ilist, mdatoms, vsite);
+
     if (vsite->nthreads == 1)
     {
         /* Nothing to do */
@@ -2602,14 +2852,11 @@ void set_vsite_top(gmx_vsite_t          *vsite,
                                              top->cgs);
     }
 
-    if (vsite->nthreads > 1)
+    if (vsite->nthreads > 1 && vsite->bHaveChargeGroups)
     {
-        if (vsite->bHaveChargeGroups)
-        {
-            gmx_fatal(FARGS, "The combination of threading, virtual sites and charge groups is not implemented");
-        }
-
-        split_vsites_over_threads(top->idef.il, top->idef.iparams,
-                                  md, vsite);
+        gmx_fatal(FARGS, "The combination of threading, virtual sites and charge groups is not implemented");
     }
+
+    split_vsites_over_threads(top->idef.il, top->idef.iparams,
+                              md, vsite);
 }
@@ -64,6 +64,8 @@ typedef struct gmx_vsite_t {
     int                 *taskIndex;            /* Work array                              */
     int                  taskIndexNalloc;      /* Size of taskIndex                       */
     bool                 useDomdec;            /* Tells whether we use domain decomposition with more than 1 DD rank */
+    bool                 simdEnabled;          /* Whether SIMD construction can be used at all */
+    bool                 useSimd[F_NRE];       /* Per vsite type, whether the vsites are constructed with SIMD */
 
 } gmx_vsite_t;
 
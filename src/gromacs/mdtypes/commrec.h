@@ -174,10 +174,24 @@ inline bool thisRankHasDuty(const t_commrec *cr, int duty)
  *
  * Note that even with particle decomposition removed, the use of
  * non-DD parallelization in TPI, NM and multi-simulations means that
- * PAR(cr) and DOMAINDECOMP(cr) are not universally synonymous. In
- * particular, DOMAINDECOMP(cr) == true indicates that there is more
- * than one domain, not just that the dd algorithm is active. */
-#define DOMAINDECOMP(cr)   (((cr)->dd != NULL) && PAR(cr))
+ * PAR(cr) and DOMAINDECOMP(cr) are not universally synonymous.
+ * Conversely, with GMX_DD_SINGLE_RANK a single rank can use the dd
+ * algorithm with one domain, so DOMAINDECOMP(cr) == true does not
+ * imply that there is more than one domain. */
+#define DOMAINDECOMP(cr)   ((cr)->dd != NULL)
+
+/*! \brief Returns whether we use domain decomposition over more than one rank
+ *
+ * This is what DOMAINDECOMP(cr) meant before single-rank domain
+ * decomposition was supported. Collective communication within
+ * the decomposition should be guarded by this, not DOMAINDECOMP(cr).
+ *
+ * \param[in] cr  Communication record
+ */
+inline bool havePPDomainDecomposition(const t_commrec *cr)
+{
+    return DOMAINDECOMP(cr) && PAR(cr);
+}
 
 //! Are we doing multiple independent simulations
 #define MULTISIM(cr)       ((cr)->ms)
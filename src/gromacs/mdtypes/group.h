@@ -74,6 +74,7 @@ typedef struct gmx_ekindata_t {
     tensor         **ekin_work_alloc; /* Allocated locations for *_work members */
     tensor         **ekin_work;       /* Work arrays for tcstat per thread    */
     real           **dekindl_work;    /* Work location for dekindl per thread */
+    gmx_bool         bEkinhFused;     /* *_work was filled during the update  */
     int              ngacc;           /* The number of acceleration groups    */
     t_grp_acc       *grpstat;         /* Acceleration data			*/
     tensor           ekin;            /* overall kinetic energy               */
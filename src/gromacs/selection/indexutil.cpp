@@ -1375,6 +1375,43 @@ gmx_ana_indexmap_copy(gmx_ana_indexmap_t *dest, gmx_ana_indexmap_t *src, bool bF
     dest->bStatic = src->bStatic;
 }
 
+/*!
+ * \param[in,out] dest Destination data structure.
+ * \param[in]     src  Source mapping.
+ *
+ * Unlike gmx_ana_indexmap_copy(), all arrays in \p dest are owned by \p dest,
+ * also the mapped atoms that \p src may only reference, so the copy stays
+ * valid when \p src is updated for another frame.
+ * Memory already allocated for \p dest is reused, so this function can be
+ * called repeatedly with the same \p dest.
+ *
+ * \p dest should have been initialized somehow (calloc() is enough).
+ */
+void
+gmx_ana_indexmap_copy_detached(gmx_ana_indexmap_t       *dest,
+                               const gmx_ana_indexmap_t *src)
+{
+    gmx_ana_indexmap_reserve(dest, std::max(src->b.nr, src->mapb.nr), src->b.nra);
+    dest->type       = src->type;
+    dest->b.nr       = src->b.nr;
+    dest->b.nra      = src->b.nra;
+    std::memcpy(dest->orgid,      src->orgid,      dest->b.nr*sizeof(*dest->orgid));
+    std::memcpy(dest->b.index,    src->b.index,   (dest->b.nr+1)*sizeof(*dest->b.index));
+    std::memcpy(dest->b.a,        src->b.a,        dest->b.nra*sizeof(*dest->b.a));
+    if (dest->mapb.nalloc_a < src->mapb.nra)
+    {
+        srenew(dest->mapb.a, src->mapb.nra);
+        dest->mapb.nalloc_a = src->mapb.nra;
+    }
+    dest->mapb.nr    = src->mapb.nr;
+    dest->mapb.nra   = src->mapb.nra;
+    std::memcpy(dest->mapb.a,     src->mapb.a,     dest->mapb.nra*sizeof(*dest->mapb.a));
+    std::memcpy(dest->refid,      src->refid,      dest->mapb.nr*sizeof(*dest->refid));
+    std::memcpy(dest->mapid,      src->mapid,      dest->mapb.nr*sizeof(*dest->mapid));
+    std::memcpy(dest->mapb.index, src->mapb.index, (dest->mapb.nr+1)*sizeof(*dest->mapb.index));
+    dest->bStatic = src->bStatic;
+}
+
 /*! \brief
  * Helper function to set the source atoms in an index map.
  *
@@ -386,6 +386,10 @@ gmx_ana_indexmap_deinit(gmx_ana_indexmap_t *m);
 /** Makes a deep copy of an index group mapping. */
 void
 gmx_ana_indexmap_copy(gmx_ana_indexmap_t *dest, gmx_ana_indexmap_t *src, bool bFirst);
+/** Copies the current state of an index group mapping into separate memory. */
+void
+gmx_ana_indexmap_copy_detached(gmx_ana_indexmap_t       *dest,
+                               const gmx_ana_indexmap_t *src);
 /** Updates an index group mapping. */
 void
 gmx_ana_indexmap_update(gmx_ana_indexmap_t *m, gmx_ana_index_t *g, bool bMaskOnly);
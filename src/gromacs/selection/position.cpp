@@ -224,6 +224,41 @@ gmx_ana_pos_copy(gmx_ana_pos_t *dest, gmx_ana_pos_t *src, bool bFirst)
     gmx_ana_indexmap_copy(&dest->m, &src->m, bFirst);
 }
 
+/*!
+ * \param[in,out] dest   Destination positions.
+ * \param[in]     src    Source positions.
+ *
+ * Makes a full copy of the current positions in \p src, such that \p dest
+ * does not reference any memory in \p src (see
+ * gmx_ana_indexmap_copy_detached()).  Memory already allocated for \p dest
+ * is reused.
+ *
+ * \p dest should have been initialized somehow (calloc() is enough).
+ */
+void
+gmx_ana_pos_copy_detached(gmx_ana_pos_t *dest, const gmx_ana_pos_t *src)
+{
+    gmx_ana_pos_reserve(dest, src->count(), -1);
+    if (src->v)
+    {
+        gmx_ana_pos_reserve_velocities(dest);
+    }
+    if (src->f)
+    {
+        gmx_ana_pos_reserve_forces(dest);
+    }
+    memcpy(dest->x, src->x, src->count()*sizeof(*dest->x));
+    if (src->v)
+    {
+        memcpy(dest->v, src->v, src->count()*sizeof(*dest->v));
+    }
+    if (src->f)
+    {
+        memcpy(dest->f, src->f, src->count()*sizeof(*dest->f));
+    }
+    gmx_ana_indexmap_copy_detached(&dest->m, &src->m);
+}
+
 /*!
  * \param[in,out] pos  Position data structure.
  * \param[in]     nr   Number of positions.
@@ -99,6 +99,9 @@ gmx_ana_pos_init_const(gmx_ana_pos_t *pos, const rvec x);
 /** Copies the evaluated positions to a preallocated data structure. */
 void
 gmx_ana_pos_copy(gmx_ana_pos_t *dest, gmx_ana_pos_t *src, bool bFirst);
+/** Copies the evaluated positions into memory not shared with the source. */
+void
+gmx_ana_pos_copy_detached(gmx_ana_pos_t *dest, const gmx_ana_pos_t *src);
 
 /** Sets the number of positions in a position structure. */
 void
@@ -121,6 +121,18 @@ SelectionData::SelectionData(SelectionTreeElement *elem,
 }
 
 
+SelectionData::SelectionData(const SelectionData *source)
+    : name_(source->name_), selectionText_(source->selectionText_),
+      flags_(source->flags_), rootElement_(source->rootElement_),
+      coveredFractionType_(source->coveredFractionType_),
+      coveredFraction_(source->coveredFraction_),
+      averageCoveredFraction_(source->averageCoveredFraction_),
+      bDynamic_(source->bDynamic_),
+      bDynamicCoveredFraction_(source->bDynamicCoveredFraction_)
+{
+}
+
+
 SelectionData::~SelectionData()
 {
 }
@@ -265,6 +277,17 @@ SelectionData::restoreOriginalPositions(const gmx_mtop_t *top)
     }
 }
 
+
+void
+SelectionData::copyFrameState(const SelectionData &source)
+{
+    gmx_ana_pos_copy_detached(&rawPositions_, &source.rawPositions_);
+    posMass_         = source.posMass_;
+    posCharge_       = source.posCharge_;
+    flags_           = source.flags_;
+    coveredFraction_ = source.coveredFraction_;
+}
+
 }   // namespace internal
 
 /********************************************************************
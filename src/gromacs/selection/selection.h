@@ -93,6 +93,18 @@ class SelectionData
          * \throws    std::bad_alloc if out of memory.
          */
         SelectionData(SelectionTreeElement *elem, const char *selstr);
+        /*! \brief
+         * Creates a frame-local copy of another selection.
+         *
+         * \param[in] source Selection to copy.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * The copy refers to the evaluation tree of \p source, but it is not
+         * updated when the selections are evaluated; copyFrameState()
+         * needs to be called instead.
+         * Used by SelectionCollection::copyEvaluatedSelections().
+         */
+        explicit SelectionData(const SelectionData *source);
         ~SelectionData();
 
         //! Returns the name for this selection.
@@ -186,6 +198,16 @@ class SelectionData
          * Called by SelectionEvaluator::evaluateFinal().
          */
         void restoreOriginalPositions(const gmx_mtop_t *top);
+        /*! \brief
+         * Copies the evaluated state of another selection for the current frame.
+         *
+         * \param[in] source Selection to copy the positions from.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * The copy does not share any memory with \p source, so it remains
+         * valid while \p source is evaluated for the next frame.
+         */
+        void copyFrameState(const SelectionData &source);
 
     private:
         //! Name of the selection.
@@ -580,6 +602,10 @@ class Selection
          * Needed to access the data to adjust flags.
          */
         friend class SelectionOptionStorage;
+        /*! \brief
+         * Needed to map selections to their frame-local copies.
+         */
+        friend class SelectionCollection;
 };
 
 /*! \brief
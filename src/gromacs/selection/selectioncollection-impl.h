@@ -187,6 +187,14 @@ class SelectionCollection::Impl
         bool                    bExternalGroupsSet_;
         //! External index groups (can be NULL).
         gmx_ana_indexgrps_t    *grps_;
+        /*! \brief
+         * Frame-local copies of selections from another collection.
+         *
+         * \see SelectionCollection::copyEvaluatedSelections()
+         */
+        SelectionDataList       frameCopies_;
+        //! Selections that the items in \a frameCopies_ were copied from.
+        std::vector<const internal::SelectionData *> frameCopySources_;
 };
 
 /*! \internal
@@ -915,6 +915,48 @@ SelectionCollection::evaluateFinal(int nframes)
 }
 
 
+void
+SelectionCollection::copyEvaluatedSelections(const SelectionCollection &source)
+{
+    const SelectionDataList &sourceList = source.impl_->sc_.sel;
+    if (impl_->frameCopies_.empty())
+    {
+        impl_->frameCopies_.reserve(sourceList.size());
+        impl_->frameCopySources_.reserve(sourceList.size());
+        for (const auto &sel : sourceList)
+        {
+            impl_->frameCopies_.emplace_back(new internal::SelectionData(sel.get()));
+            impl_->frameCopySources_.push_back(sel.get());
+        }
+    }
+    GMX_RELEASE_ASSERT(impl_->frameCopies_.size() == sourceList.size(),
+                       "Selections copied from a different collection");
+    for (size_t i = 0; i < sourceList.size(); ++i)
+    {
+        impl_->frameCopies_[i]->copyFrameState(*sourceList[i]);
+    }
+}
+
+
+Selection
+SelectionCollection::correspondingSelection(const Selection &selection) const
+{
+    if (impl_->frameCopySources_.empty())
+    {
+        return selection;
+    }
+    for (size_t i = 0; i < impl_->frameCopySources_.size(); ++i)
+    {
+        if (impl_->frameCopySources_[i] == selection.sel_)
+        {
+            return Selection(impl_->frameCopies_[i].get());
+        }
+    }
+    GMX_ASSERT(false, "Selection not found in the copied collection");
+    return selection;
+}
+
+
 void
 SelectionCollection::printTree(FILE *fp, bool bValues) const
 {
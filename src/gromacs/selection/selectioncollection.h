@@ -388,6 +388,36 @@ class SelectionCollection
          * Does not throw.
          */
         void evaluateFinal(int nframes);
+        /*! \brief
+         * Copies the evaluated selections from another collection.
+         *
+         * \param[in] source Collection whose selections to copy.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * After the call, this collection holds a frame-local copy of each
+         * selection in \p source in the state it was evaluated for the
+         * current frame, and correspondingSelection() returns these copies.
+         * The copies remain valid when \p source is evaluated for other
+         * frames, which allows analyzing a frame in one thread while the next
+         * frame is evaluated in another.
+         * This collection should not be used for anything else, and
+         * \p source should be compiled and stay alive while the copies are
+         * used.
+         * Memory allocated in earlier calls is reused.
+         */
+        void copyEvaluatedSelections(const SelectionCollection &source);
+        /*! \brief
+         * Returns the selection in this collection that corresponds to a
+         * given selection.
+         *
+         * \param[in] selection Selection from the collection passed to
+         *      copyEvaluatedSelections().
+         * \returns   Frame-local copy of \p selection, or \p selection
+         *      itself if copyEvaluatedSelections() has not been called.
+         *
+         * Does not throw.
+         */
+        Selection correspondingSelection(const Selection &selection) const;
 
         /*! \brief
          * Prints a human-readable version of the internal selection element
@@ -689,6 +689,38 @@ TEST_F(SelectionCollectionTest, HandlesFramesWithTooSmallAtomSubsets4)
 
 // TODO: Tests for more evaluation errors
 
+TEST_F(SelectionCollectionTest, CopiesEvaluatedSelections)
+{
+    ASSERT_NO_THROW_GMX(sel_ = sc_.parseFromString("x < 1.5"));
+    ASSERT_NO_FATAL_FAILURE(loadTopology("simple.gro"));
+    ASSERT_NO_THROW_GMX(sc_.compile());
+    t_trxframe *frame = topManager_.frame();
+    ASSERT_NO_THROW_GMX(sc_.evaluate(frame, nullptr));
+
+    gmx::SelectionCollection copies;
+    ASSERT_NO_THROW_GMX(copies.copyEvaluatedSelections(sc_));
+    const gmx::Selection     copy = copies.correspondingSelection(sel_[0]);
+    EXPECT_TRUE(copy != sel_[0]);
+    const std::vector<int>   atoms(sel_[0].atomIndices().begin(),
+                                   sel_[0].atomIndices().end());
+    ASSERT_EQ(4U, atoms.size());
+
+    // Move all atoms out of the selection, and check that the copy still
+    // has the state from the first evaluation.
+    for (int i = 0; i < frame->natoms; ++i)
+    {
+        frame->x[i][XX] += 10.0;
+    }
+    ASSERT_NO_THROW_GMX(sc_.evaluate(frame, nullptr));
+    EXPECT_EQ(0, sel_[0].posCount());
+    ASSERT_EQ(4, copy.posCount());
+    for (int i = 0; i < copy.posCount(); ++i)
+    {
+        EXPECT_EQ(atoms[i], copy.position(i).atomIndices()[0]);
+        EXPECT_REAL_EQ_TOL(1.0, copy.position(i).x()[XX], gmx::test::defaultRealTolerance());
+    }
+}
+
 /********************************************************************
  * Tests for interactive selection input
  */
@@ -122,6 +122,7 @@ static const char *wcsn[ewcsNR] =
     "Listed buffer ops.",
     "Nonbonded pruning",
     "Nonbonded F",
+    "Nonbonded+bonded F",
     "Launch NB GPU tasks",
     "Launch PME GPU tasks",
     "Ewald F correction",
@@ -69,6 +69,7 @@ enum {
     ewcsLISTED_BUF_OPS,
     ewcsNONBONDED_PRUNING,
     ewcsNONBONDED,
+    ewcsNONBONDED_LISTED,
     ewcsLAUNCH_GPU_NONBONDED,
     ewcsLAUNCH_GPU_PME,
     ewcsEWALD_CORRECTION,
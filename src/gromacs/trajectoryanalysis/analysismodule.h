@@ -196,6 +196,8 @@ typedef std::unique_ptr<TrajectoryAnalysisModuleData>
  * stored in a class derived from TrajectoryAnalysisModuleData that is passed
  * to the other methods.  The default implementation of startFrames() can be
  * used if only data handles and selections need to be thread-local.
+ * Frames are only analyzed in parallel for modules that set
+ * TrajectoryAnalysisSettings::efAllowParallelFrames.
  *
  * To get the full benefit from this class,
  * \ref module_analysisdata "analysis data objects" and
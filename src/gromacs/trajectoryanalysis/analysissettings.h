@@ -121,6 +121,20 @@ class TrajectoryAnalysisSettings
              * \see setRmPBC()
              */
             efNoUserRmPBC    = 1<<5,
+            /*! \brief
+             * Allows analyzing multiple frames concurrently.
+             *
+             * Should only be specified if the module accesses frame-local
+             * data only through TrajectoryAnalysisModuleData in
+             * TrajectoryAnalysisModule::analyzeFrame(), and does not modify
+             * the module object there.
+             * If this flag is specified in TrajectoryAnalysisModule::initOptions(),
+             * the user can set the number of threads for the analysis with
+             * `-nt`.  The flag can be cleared in
+             * TrajectoryAnalysisModule::optionsFinished() to analyze the
+             * frames serially with option combinations that need it.
+             */
+            efAllowParallelFrames = 1<<6,
         };
 
         //! Initializes default settings.
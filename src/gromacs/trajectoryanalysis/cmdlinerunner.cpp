@@ -43,9 +43,17 @@
 
 #include "cmdlinerunner.h"
 
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/commandline/cmdlinemodulemanager.h"
 #include "gromacs/commandline/cmdlineoptionsmodule.h"
+#include "gromacs/math/vectypes.h"
 #include "gromacs/options/ioptionscontainer.h"
 #include "gromacs/options/timeunitmanager.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -66,6 +74,261 @@ namespace gmx
 namespace
 {
 
+/********************************************************************
+ * FrameParallelAnalyzer
+ */
+
+/*! \brief
+ * Runs TrajectoryAnalysisModule::analyzeFrame() for several frames at once.
+ *
+ * Frames are read and selections evaluated in the calling thread, as in the
+ * serial case.  analyzeFrame() then receives a copy of the frame and of the
+ * evaluated selections, and runs in one of the worker threads, each of which
+ * has its own TrajectoryAnalysisModuleData.
+ * Frame \c i is always analyzed by worker \c i%n, and the calling thread
+ * waits for that worker to finish frame \c i-n before it hands out frame
+ * \c i.  This keeps at most \c n frames in progress, as required by the
+ * parallelization factor given to the data objects, and lets
+ * finishFrameSerial() be called in order from the calling thread.
+ */
+class FrameParallelAnalyzer
+{
+    public:
+        /*! \brief
+         * Creates the thread-local data and starts the worker threads.
+         *
+         * \param[in] module      Module to run.
+         * \param[in] selections  Selections that are evaluated for each frame.
+         * \param[in] threadCount Number of worker threads.
+         */
+        FrameParallelAnalyzer(TrajectoryAnalysisModule  *module,
+                              const SelectionCollection &selections,
+                              int                        threadCount);
+        //! Stops the worker threads.
+        ~FrameParallelAnalyzer();
+
+        /*! \brief
+         * Starts analysis of a frame for which the selections are evaluated.
+         *
+         * Can rethrow exceptions from the analysis of earlier frames.
+         */
+        void analyzeFrame(int frameIndex, const t_trxframe &frame,
+                          const t_pbc *pbc);
+        //! Waits for all frames to finish and finishes the thread-local data.
+        void finish();
+
+    private:
+        //! State for a single worker thread.
+        struct Worker
+        {
+            Worker() : frame(), pbc(), bPBC(false), frameIndex(-1), bPending(false) {}
+
+            //! Copies of the selections for the frame being analyzed.
+            SelectionCollection                 selections;
+            //! Thread-local data for the module.
+            TrajectoryAnalysisModuleDataPointer pdata;
+            //! Copy of the frame being analyzed.
+            t_trxframe                          frame;
+            //! Storage for coordinates in \a frame.
+            std::vector<RVec>                   x;
+            //! Storage for velocities in \a frame.
+            std::vector<RVec>                   v;
+            //! Storage for forces in \a frame.
+            std::vector<RVec>                   f;
+            //! PBC information for the frame.
+            t_pbc                               pbc;
+            //! Whether \a pbc should be passed to the module.
+            bool                                bPBC;
+            //! Index of the frame assigned to this worker (-1 if none).
+            int                                 frameIndex;
+            //! Whether the assigned frame has not been analyzed yet.
+            bool                                bPending;
+            //! Exception thrown while analyzing the frame.
+            std::exception_ptr                  error;
+            //! The thread itself.
+            std::thread                         thread;
+        };
+
+        //! Main loop for the worker threads.
+        void runWorker(Worker *worker);
+        /*! \brief
+         * Waits for the frame assigned to \p worker and finishes it.
+         *
+         * Rethrows any exception that occurred during analysis of the frame.
+         */
+        void finishWorkerFrame(Worker *worker);
+        //! Stops and joins all worker threads.
+        void stopWorkers();
+
+        TrajectoryAnalysisModule            *module_;
+        const SelectionCollection           &selections_;
+        std::vector<std::unique_ptr<Worker> > workers_;
+        //! Index of the next frame to be passed to analyzeFrame().
+        int                                  nextFrameIndex_;
+        //! Protects \a bPending in workers, and \a bStop_.
+        std::mutex                           mutex_;
+        //! Signals changes in \a bPending or \a bStop_.
+        std::condition_variable              cv_;
+        //! Whether the worker threads should exit.
+        bool                                 bStop_;
+};
+
+FrameParallelAnalyzer::FrameParallelAnalyzer(
+        TrajectoryAnalysisModule  *module,
+        const SelectionCollection &selections,
+        int                        threadCount)
+    : module_(module), selections_(selections), nextFrameIndex_(0),
+      bStop_(false)
+{
+    AnalysisDataParallelOptions dataOptions(threadCount);
+    for (int i = 0; i < threadCount; ++i)
+    {
+        workers_.emplace_back(new Worker);
+        Worker &worker = *workers_.back();
+        worker.selections.copyEvaluatedSelections(selections_);
+        worker.pdata = module_->startFrames(dataOptions, worker.selections);
+    }
+    try
+    {
+        for (auto &worker : workers_)
+        {
+            worker->thread = std::thread(&FrameParallelAnalyzer::runWorker,
+                                         this, worker.get());
+        }
+    }
+    catch (...)
+    {
+        stopWorkers();
+        throw;
+    }
+}
+
+FrameParallelAnalyzer::~FrameParallelAnalyzer()
+{
+    stopWorkers();
+}
+
+void FrameParallelAnalyzer::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bStop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_)
+    {
+        if (worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+}
+
+void FrameParallelAnalyzer::runWorker(Worker *worker)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        cv_.wait(lock, [this, worker] { return worker->bPending || bStop_; });
+        if (!worker->bPending)
+        {
+            return;
+        }
+        lock.unlock();
+        try
+        {
+            module_->analyzeFrame(worker->frameIndex, worker->frame,
+                                  worker->bPBC ? &worker->pbc : nullptr,
+                                  worker->pdata.get());
+        }
+        catch (...)
+        {
+            worker->error = std::current_exception();
+        }
+        lock.lock();
+        worker->bPending = false;
+        cv_.notify_all();
+    }
+}
+
+void FrameParallelAnalyzer::finishWorkerFrame(Worker *worker)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [worker] { return !worker->bPending; });
+    }
+    if (worker->frameIndex < 0)
+    {
+        return;
+    }
+    if (worker->error)
+    {
+        std::rethrow_exception(worker->error);
+    }
+    module_->finishFrameSerial(worker->frameIndex);
+    worker->frameIndex = -1;
+}
+
+//! Copies \p count vectors from \p source into \p storage.
+rvec *copyFrameVectors(const rvec *source, int count,
+                       std::vector<RVec> *storage)
+{
+    if (source == nullptr)
+    {
+        return nullptr;
+    }
+    storage->assign(source, source + count);
+    return as_rvec_array(storage->data());
+}
+
+void FrameParallelAnalyzer::analyzeFrame(int frameIndex, const t_trxframe &frame,
+                                         const t_pbc *pbc)
+{
+    GMX_RELEASE_ASSERT(frameIndex == nextFrameIndex_, "Frames out of order");
+    Worker &worker = *workers_[frameIndex % workers_.size()];
+    finishWorkerFrame(&worker);
+
+    worker.frame   = frame;
+    worker.frame.x = copyFrameVectors(frame.x, frame.natoms, &worker.x);
+    worker.frame.v = copyFrameVectors(frame.v, frame.natoms, &worker.v);
+    worker.frame.f = copyFrameVectors(frame.f, frame.natoms, &worker.f);
+    worker.bPBC    = (pbc != nullptr);
+    if (worker.bPBC)
+    {
+        worker.pbc = *pbc;
+    }
+    worker.selections.copyEvaluatedSelections(selections_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        worker.frameIndex = frameIndex;
+        worker.bPending   = true;
+    }
+    cv_.notify_all();
+    ++nextFrameIndex_;
+}
+
+void FrameParallelAnalyzer::finish()
+{
+    const int threadCount = workers_.size();
+    for (int i = 0; i < threadCount; ++i)
+    {
+        finishWorkerFrame(workers_[(nextFrameIndex_ + i) % threadCount].get());
+    }
+    stopWorkers();
+    for (auto &worker : workers_)
+    {
+        module_->finishFrames(worker->pdata.get());
+    }
+    for (auto &worker : workers_)
+    {
+        if (worker->pdata != nullptr)
+        {
+            worker->pdata->finish();
+        }
+        worker->pdata.reset();
+    }
+}
+
 /********************************************************************
  * RunnerModule
  */
@@ -131,9 +394,18 @@ int RunnerModule::run()
     t_pbc *ppbc = settings_.hasPBC() ? &pbc : nullptr;
 
     int    nframes = 0;
-    AnalysisDataParallelOptions         dataOptions;
-    TrajectoryAnalysisModuleDataPointer pdata(
-            module_->startFrames(dataOptions, selections_));
+    std::unique_ptr<FrameParallelAnalyzer> parallelAnalyzer;
+    TrajectoryAnalysisModuleDataPointer    pdata;
+    if (common_.threadCount() > 1)
+    {
+        parallelAnalyzer.reset(new FrameParallelAnalyzer(
+                                       module_.get(), selections_, common_.threadCount()));
+    }
+    else
+    {
+        AnalysisDataParallelOptions dataOptions;
+        pdata = module_->startFrames(dataOptions, selections_);
+    }
     do
     {
         common_.initFrame();
@@ -144,18 +416,33 @@ int RunnerModule::run()
         }
 
         selections_.evaluate(&frame, ppbc);
-        module_->analyzeFrame(nframes, frame, ppbc, pdata.get());
-        module_->finishFrameSerial(nframes);
+        if (parallelAnalyzer)
+        {
+            parallelAnalyzer->analyzeFrame(nframes, frame, ppbc);
+        }
+        else
+        {
+            module_->analyzeFrame(nframes, frame, ppbc, pdata.get());
+            module_->finishFrameSerial(nframes);
+        }
 
         ++nframes;
     }
     while (common_.readNextFrame());
-    module_->finishFrames(pdata.get());
-    if (pdata.get() != nullptr)
+    if (parallelAnalyzer)
+    {
+        parallelAnalyzer->finish();
+        parallelAnalyzer.reset();
+    }
+    else
     {
-        pdata->finish();
+        module_->finishFrames(pdata.get());
+        if (pdata.get() != nullptr)
+        {
+            pdata->finish();
+        }
+        pdata.reset();
     }
-    pdata.reset();
 
     if (common_.hasTrajectory())
     {
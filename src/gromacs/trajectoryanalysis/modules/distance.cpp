@@ -156,6 +156,7 @@ Distance::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *se
     };
 
     settings->setHelpText(desc);
+    settings->setFlag(TrajectoryAnalysisSettings::efAllowParallelFrames);
 
     options->addOption(FileNameOption("oav").filetype(eftPlot).outputFile()
                            .store(&fnAverage_).defaultBasename("distave")
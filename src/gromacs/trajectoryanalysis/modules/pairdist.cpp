@@ -214,6 +214,7 @@ PairDistance::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings
     };
 
     settings->setHelpText(desc);
+    settings->setFlag(TrajectoryAnalysisSettings::efAllowParallelFrames);
 
     options->addOption(FileNameOption("o").filetype(eftPlot).outputFile().required()
                            .store(&fnDist_).defaultBasename("dist")
@@ -445,6 +445,7 @@ Sasa::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *settin
     };
 
     settings->setHelpText(desc);
+    settings->setFlag(TrajectoryAnalysisSettings::efAllowParallelFrames);
 
     options->addOption(FileNameOption("o").filetype(eftPlot).outputFile().required()
                            .store(&fnArea_).defaultBasename("area")
@@ -421,6 +421,7 @@ Select::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *sett
     };
 
     settings->setHelpText(desc);
+    settings->setFlag(TrajectoryAnalysisSettings::efAllowParallelFrames);
 
     options->addOption(FileNameOption("os").filetype(eftPlot).outputFile()
                            .store(&fnSize_).defaultBasename("size")
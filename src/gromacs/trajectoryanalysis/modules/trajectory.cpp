@@ -125,6 +125,7 @@ Trajectory::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings *
     };
 
     settings->setHelpText(desc);
+    settings->setFlag(TrajectoryAnalysisSettings::efAllowParallelFrames);
 
     options->addOption(FileNameOption("ox").filetype(eftPlot).outputFile()
                            .store(&fnX_).defaultBasename("coord")
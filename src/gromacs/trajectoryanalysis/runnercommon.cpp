@@ -125,6 +125,8 @@ class TrajectoryAnalysisRunnerCommon::Impl : public ITopologyProvider
         bool                        bStartTimeSet_;
         bool                        bEndTimeSet_;
         bool                        bDeltaTimeSet_;
+        //! Number of threads for analyzing frames concurrently.
+        int                         threadCount_;
 
         bool                        bTrajOpen_;
         //! The current frame, or \p NULL if no frame loaded yet.
@@ -140,7 +142,7 @@ TrajectoryAnalysisRunnerCommon::Impl::Impl(TrajectoryAnalysisSettings *settings)
     : settings_(*settings),
       startTime_(0.0), endTime_(0.0), deltaTime_(0.0),
       bStartTimeSet_(false), bEndTimeSet_(false), bDeltaTimeSet_(false),
-      bTrajOpen_(false), fr(nullptr), gpbc_(nullptr), status_(nullptr), oenv_(nullptr)
+      threadCount_(1), bTrajOpen_(false), fr(nullptr), gpbc_(nullptr), status_(nullptr), oenv_(nullptr)
 {
 }
 
@@ -389,6 +391,11 @@ TrajectoryAnalysisRunnerCommon::initOptions(IOptionsContainer *options,
         options->addOption(BooleanOption("pbc").store(&settings.impl_->bPBC)
                                .description("Use periodic boundary conditions for distance calculation"));
     }
+    if (settings.hasFlag(TrajectoryAnalysisSettings::efAllowParallelFrames))
+    {
+        options->addOption(IntegerOption("nt").store(&impl_->threadCount_)
+                               .description("Number of threads for analyzing frames in parallel"));
+    }
 }
 
 
@@ -405,6 +412,11 @@ TrajectoryAnalysisRunnerCommon::optionsFinished()
         GMX_THROW(InconsistentInputError("-fgroup only makes sense together with a trajectory (-f)"));
     }
 
+    if (impl_->threadCount_ < 1)
+    {
+        GMX_THROW(InvalidInputError("-nt should be at least one"));
+    }
+
     impl_->settings_.impl_->plotSettings.setTimeUnit(impl_->settings_.timeUnit());
 
     if (impl_->bStartTimeSet_)
@@ -471,6 +483,17 @@ TrajectoryAnalysisRunnerCommon::initFrame()
 }
 
 
+int
+TrajectoryAnalysisRunnerCommon::threadCount() const
+{
+    if (!impl_->settings_.hasFlag(TrajectoryAnalysisSettings::efAllowParallelFrames))
+    {
+        return 1;
+    }
+    return impl_->threadCount_;
+}
+
+
 bool
 TrajectoryAnalysisRunnerCommon::hasTrajectory() const
 {
@@ -118,6 +118,8 @@ class TrajectoryAnalysisRunnerCommon
          */
         void initFrame();
 
+        //! Returns the number of threads to use for analyzing frames.
+        int threadCount() const;
         //! Returns true if input data comes from a trajectory.
         bool hasTrajectory() const;
         //! Returns the topology information object.
@@ -144,6 +144,33 @@ TEST_F(TrajectoryAnalysisCommandLineRunnerTest, RunsWithSubsetTrajectory)
     EXPECT_NO_THROW_GMX(runTest(CommandLine(cmdline)));
 }
 
+//! Initializes options for tests that analyze frames in parallel.
+void initParallelOptions(gmx::IOptionsContainer          * /*options*/,
+                         gmx::TrajectoryAnalysisSettings *settings)
+{
+    settings->setFlag(gmx::TrajectoryAnalysisSettings::efAllowParallelFrames);
+}
+
+TEST_F(TrajectoryAnalysisCommandLineRunnerTest, RunsWithParallelFrames)
+{
+    const char *const cmdline[] = {
+        "-fgroup", "atomnr 4 5 6 10 to 14", "-nt", "2"
+    };
+
+    using ::testing::_;
+    using ::testing::Invoke;
+    EXPECT_CALL(*mockModule_, initOptions(_, _)).WillOnce(Invoke(&initParallelOptions));
+    EXPECT_CALL(*mockModule_, initAnalysis(_, _));
+    EXPECT_CALL(*mockModule_, analyzeFrame(0, _, _, _));
+    EXPECT_CALL(*mockModule_, analyzeFrame(1, _, _, _));
+    EXPECT_CALL(*mockModule_, finishAnalysis(2));
+    EXPECT_CALL(*mockModule_, writeOutput());
+
+    setInputFile("-s", "simple.gro");
+    setInputFile("-f", "simple-subset.gro");
+    EXPECT_NO_THROW_GMX(runTest(CommandLine(cmdline)));
+}
+
 TEST_F(TrajectoryAnalysisCommandLineRunnerTest, DetectsIncorrectTrajectorySubset)
 {
     const char *const cmdline[] = {
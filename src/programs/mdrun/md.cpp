@@ -81,6 +81,7 @@
 #include "gromacs/mdlib/mdsetup.h"
 #include "gromacs/mdlib/nb_verlet.h"
 #include "gromacs/mdlib/nbnxn_gpu_data_mgmt.h"
+#include "gromacs/mdlib/nbnxn_tuning.h"
 #include "gromacs/mdlib/ns.h"
 #include "gromacs/mdlib/shellfc.h"
 #include "gromacs/mdlib/sighandler.h"
@@ -366,6 +367,9 @@ double gmx::do_md(FILE *fplog, t_commrec *cr, const gmx::MDLogger &mdlog,
     gmx_bool              bPMETune         = FALSE;
     gmx_bool              bPMETunePrinting = FALSE;
 
+    /* Online tuning of the dynamic pair-list pruning setup */
+    PairlistPruneTuner   *pruneTuner       = nullptr;
+
     /* Interactive MD */
     gmx_bool          bIMDstep = FALSE;
 
@@ -611,6 +615,13 @@ double gmx::do_md(FILE *fplog, t_commrec *cr, const gmx::MDLogger &mdlog,
                          &bPMETunePrinting);
     }
 
+    if (ir->cutoff_scheme == ecutsVERLET && !bRerunMD)
+    {
+        initPairlistPruneTuning(&pruneTuner, fplog, ir, top_global, state->box,
+                                use_GPU(fr->nbv), mdrunOptions.reproducible,
+                                fr->nbv->listParams.get());
+    }
+
     if (!ir->bContinuation && !bRerunMD)
     {
         if (state->flags & (1 << estV))
@@ -924,6 +935,14 @@ double gmx::do_md(FILE *fplog, t_commrec *cr, const gmx::MDLogger &mdlog,
                            &bPMETunePrinting);
         }
 
+        if (bNStList && pairlistPruneTuningIsActive(pruneTuner))
+        {
+            /* Dynamic pruning interval optimization, after PME tuning */
+            doPairlistPruneTuning(pruneTuner, fplog, cr, ir, fr->ic,
+                                  fr->nbv->listParams.get(), wcycle, step,
+                                  pme_loadbal_is_active(pme_loadbal));
+        }
+
         wallcycle_start(wcycle, ewcSTEP);
 
         if (bRerunMD)
@@ -1513,6 +1532,16 @@ double gmx::do_md(FILE *fplog, t_commrec *cr, const gmx::MDLogger &mdlog,
                 copy_rvecn(as_rvec_array(state->x.data()), cbuf, 0, state->natoms);
             }
 
+            if (!EI_VV(ir->eI) && !bRerunMD &&
+                (bGStat || do_per_step(step+1, nstglobalcomm) ||
+                 (!bFirstStep && bDoReplEx) || bUsingEnsembleRestraints))
+            {
+                /* compute_globals below computes the kinetic energy,
+                 * let the update accumulate it on the fly.
+                 */
+                update_request_fused_ekinh(upd, ir, ekind);
+            }
+
             update_coords(fplog, step, ir, mdatoms, state, &f, fcd,
                           ekind, M, upd, etrtPOSITION, cr, constr);
             wallcycle_stop(wcycle, ewcUPDATE);
@@ -1925,6 +1954,7 @@ double gmx::do_md(FILE *fplog, t_commrec *cr, const gmx::MDLogger &mdlog,
     {
         pme_loadbal_done(pme_loadbal, fplog, mdlog, use_GPU(fr->nbv));
     }
+    donePairlistPruneTuning(pruneTuner, fplog);
 
     done_shellfc(fplog, shellfc, step_rel);
 
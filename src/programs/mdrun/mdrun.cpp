@@ -322,6 +322,8 @@ int Mdrunner::mainFunction(int argc, char *argv[])
           "Checkpoint interval (minutes)" },
         { "-cpnum",   FALSE, etBOOL, {&mdrunOptions.checkpointOptions.keepAndNumberCheckpointFiles},
           "Keep and number checkpoint files" },
+        { "-cpsplit", FALSE, etBOOL, {&mdrunOptions.checkpointOptions.writeAtomSections},
+          "Let each rank write the coordinates and velocities of its atoms to a separate checkpoint file in parallel" },
         { "-append",  FALSE, etBOOL, {&bTryToAppendFiles},
           "Append to previous output files when continuing from checkpoint instead of adding the simulation part number to all file names" },
         { "-nsteps",  FALSE, etINT64, {&mdrunOptions.numStepsCommandline},
@@ -177,9 +177,11 @@ init_replica_exchange(FILE                            *fplog,
          * is true!
          *
          * Since we are using a dynamical integrator, the only
-         * decomposition is DD, so PAR(cr) and DOMAINDECOMP(cr) are
-         * synonymous. The only way for cr->nnodes > 1 to be true is
-         * if we are using DD. */
+         * decomposition is DD, so PAR(cr) implies DOMAINDECOMP(cr).
+         * The converse does not hold, because with GMX_DD_SINGLE_RANK
+         * a single rank uses DD with one domain. Use
+         * havePPDomainDecomposition(cr) to test for DD over more
+         * than one rank. */
     }
 
     snew(re, 1);
@@ -1235,7 +1237,7 @@ gmx_bool replica_exchange(FILE *fplog, const t_commrec *cr, struct gmx_repl_ex *
      * each simulation know whether they need to participate in
      * collecting the state. Otherwise, they might as well get on with
      * the next thing to do. */
-    if (DOMAINDECOMP(cr))
+    if (havePPDomainDecomposition(cr))
     {
 #if GMX_MPI
         MPI_Bcast(&bThisReplicaExchanged, sizeof(gmx_bool), MPI_BYTE, MASTERRANK(cr),
@@ -786,8 +786,17 @@ int Mdrunner::mdrunner()
                               nonbondedOnGpu || (emulateGpuNonbonded == EmulateGpuNonbonded::Yes), *hwinfo->cpuInfo);
     }
 
-    if (PAR(cr) && !(EI_TPI(inputrec->eI) ||
-                     inputrec->eI == eiNM))
+    /* With the Verlet scheme a single rank can also use domain
+     * decomposition with one domain. Then the local state is sorted
+     * in the order of the non-bonded grid at every search step,
+     * so the coordinate and force conversions access memory linearly.
+     */
+    bool useSingleRankDD = (!PAR(cr) &&
+                            inputrec->cutoff_scheme == ecutsVERLET &&
+                            getenv("GMX_DD_SINGLE_RANK") != nullptr);
+
+    if ((PAR(cr) || useSingleRankDD) && !(EI_TPI(inputrec->eI) ||
+                                          inputrec->eI == eiNM))
     {
         const rvec *xOnMaster = (SIMMASTER(cr) ? as_rvec_array(globalState->x.data()) : nullptr);
 
@@ -919,7 +928,7 @@ int Mdrunner::mdrunner()
         }
     }
 
-    if (DOMAINDECOMP(cr))
+    if (havePPDomainDecomposition(cr))
     {
         /* When we share GPUs over ranks, we need to know this for the DLB */
         dd_setup_dlb_resource_sharing(cr, shortRangedDeviceId);
@@ -1056,6 +1065,14 @@ int Mdrunner::mdrunner()
                                 nthread_local, nullptr);
     }
 
+    if (thisRankHasDuty(cr, DUTY_PP))
+    {
+        /* Start the thread pool, if requested, after setting the affinity,
+         * so the pool threads can use the affinity of the OpenMP threads */
+        gmx_omp_nthreads_init_thread_pool(mdlog, cr, gmx_omp_nthreads_get(emntDefault),
+                                          hwinfo->nthreads_hw_avail);
+    }
+
     /* Initiate PME if necessary,
      * either on all nodes or on dedicated PME nodes only. */
     if (EEL_PME(inputrec->coulombtype) || EVDW_PME(inputrec->vdwtype))
@@ -1197,6 +1214,8 @@ int Mdrunner::mdrunner()
         pmedata = nullptr;
     }
 
+    gmx_omp_nthreads_finish_thread_pool();
+
     /* Free GPU memory and context */
     free_gpu_resources(fr, cr, shortRangedDeviceInfo);
 
@@ -0,0 +1,194 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2017, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ * \brief
+ * Tests that domain decomposition with a single domain on a single
+ * rank (GMX_DD_SINGLE_RANK) reproduces a run without domain
+ * decomposition
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <cstdlib>
+
+#include <string>
+#include <tuple>
+
+#include <gtest/gtest.h>
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/testasserts.h"
+
+#include "energyreader.h"
+#include "mdruncomparisonfixture.h"
+#include "trajectoryreader.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Sets or unsets the GMX_DD_SINGLE_RANK environment variable
+void setSingleRankDDEnv(bool bSet)
+{
+#ifdef _MSC_VER
+    _putenv(bSet ? "GMX_DD_SINGLE_RANK=1" : "GMX_DD_SINGLE_RANK=");
+#else
+    if (bSet)
+    {
+        setenv("GMX_DD_SINGLE_RANK", "1", 1);
+    }
+    else
+    {
+        unsetenv("GMX_DD_SINGLE_RANK");
+    }
+#endif
+}
+
+//! Test fixture for comparing runs with and without single-rank domain decomposition
+class SingleRankDomainDecompositionTest : public MdrunComparisonFixture,
+                                          public ::testing::WithParamInterface<const char *>
+{
+    public:
+        //! Use the convenience overload that makes the grompp command line
+        using MdrunComparisonFixture::runTest;
+        //! Implement pure virtual method of MdrunComparisonFixture
+        virtual void runTest(const CommandLine     &gromppCallerRef,
+                             const char            *simulationName,
+                             const char            *integrator,
+                             const char            *tcoupl,
+                             const char            *pcoupl,
+                             FloatingPointTolerance tolerance);
+};
+
+void
+SingleRankDomainDecompositionTest::runTest(const CommandLine     &gromppCallerRef,
+                                           const char            *simulationName,
+                                           const char            *integrator,
+                                           const char            *tcoupl,
+                                           const char            *pcoupl,
+                                           FloatingPointTolerance tolerance)
+{
+    CommandLine gromppCaller(gromppCallerRef);
+
+    /* The atom order differs between the runs, so positions differ
+     * at rounding level. Use interactions with forces that go to zero
+     * at the cut-off, so a pair crossing it does not cause a jump. */
+    auto mdpFieldValues = prepareMdpFieldValues(simulationName);
+    mdpFieldValues["other"] += ("coulombtype  = reaction-field\n"
+                                "epsilon-rf   = 0\n"
+                                "vdw-modifier = force-switch\n"
+                                "rvdw-switch  = 0.5\n");
+    prepareMdpFile(mdpFieldValues, integrator, tcoupl, pcoupl);
+    runner_.useTopGroAndNdxFromDatabase(simulationName);
+    EXPECT_EQ(0, runner_.callGrompp(gromppCaller));
+
+    // Do a normal mdrun, which uses no domain decomposition on a single rank
+    std::string noDDEdrFileName              = fileManager_.getTemporaryFilePath("noDD.edr");
+    std::string noDDTrajectoryFileName       = fileManager_.getTemporaryFilePath("noDD.trr");
+    runner_.edrFileName_                     = noDDEdrFileName;
+    runner_.fullPrecisionTrajectoryFileName_ = noDDTrajectoryFileName;
+    setSingleRankDDEnv(false);
+    ASSERT_EQ(0, runner_.callMdrun());
+
+    // Do an mdrun that uses domain decomposition with a single domain
+    std::string singleRankDDEdrFileName        = fileManager_.getTemporaryFilePath("singleRankDD.edr");
+    std::string singleRankDDTrajectoryFileName = fileManager_.getTemporaryFilePath("singleRankDD.trr");
+    runner_.edrFileName_                       = singleRankDDEdrFileName;
+    runner_.fullPrecisionTrajectoryFileName_   = singleRankDDTrajectoryFileName;
+    setSingleRankDDEnv(true);
+    int singleRankDDExitCode = runner_.callMdrun();
+    setSingleRankDDEnv(false);
+    ASSERT_EQ(0, singleRankDDExitCode);
+
+    // Only the summation order of forces and energies differs, so
+    // the runs should match closely over the few steps done
+    auto noDDEnergyReader         = openEnergyFileToReadFields(noDDEdrFileName, {{"Potential"}, {"Kinetic En."}});
+    auto singleRankDDEnergyReader = openEnergyFileToReadFields(singleRankDDEdrFileName, {{"Potential"}, {"Kinetic En."}});
+    int  numEnergyFrames          = 0;
+    while (noDDEnergyReader->readNextFrame())
+    {
+        ASSERT_TRUE(singleRankDDEnergyReader->readNextFrame()) << "single-rank DD run wrote fewer energy frames";
+        compareFrames(std::make_pair(noDDEnergyReader->frame(),
+                                     singleRankDDEnergyReader->frame()),
+                      tolerance);
+        numEnergyFrames++;
+    }
+    EXPECT_FALSE(singleRankDDEnergyReader->readNextFrame()) << "single-rank DD run wrote more energy frames";
+    EXPECT_LT(1, numEnergyFrames);
+
+    TrajectoryFrameReader noDDTrajectoryReader(noDDTrajectoryFileName);
+    TrajectoryFrameReader singleRankDDTrajectoryReader(singleRankDDTrajectoryFileName);
+    int                   numTrajectoryFrames = 0;
+    while (noDDTrajectoryReader.readNextFrame())
+    {
+        ASSERT_TRUE(singleRankDDTrajectoryReader.readNextFrame()) << "single-rank DD run wrote fewer trajectory frames";
+        compareFrames(std::make_pair(noDDTrajectoryReader.frame(),
+                                     singleRankDDTrajectoryReader.frame()),
+                      tolerance);
+        numTrajectoryFrames++;
+    }
+    EXPECT_FALSE(singleRankDDTrajectoryReader.readNextFrame()) << "single-rank DD run wrote more trajectory frames";
+    EXPECT_LT(1, numTrajectoryFrames);
+}
+
+TEST_P(SingleRankDomainDecompositionTest, ReproducesRunWithoutDD)
+{
+    /* Forces of order one in condensed phase are sums of terms of
+     * order a thousand, so their rounding differences are
+     * well above what the magnitude of the result would suggest. */
+    runTest(GetParam(), "md", "no", "no", relativeToleranceAsFloatingPoint(10, 1e-3));
+}
+
+/*! \brief Helper array of simulations from the database, with and
+ * without constraints, virtual sites and free-energy perturbation */
+const char *const simulationNames[] = {
+    "argon12",
+    "spc216",
+    "alanine_vsite_vacuo",
+    "alanine_vsite_solvated"
+};
+
+INSTANTIATE_TEST_CASE_P(NormalMdWith,
+                        SingleRankDomainDecompositionTest,
+                            ::testing::ValuesIn(simulationNames));
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -81,5 +81,21 @@ TEST_F(MdrunTerminationTest, WritesCheckpointAfterMaxhTerminationAndThenRestarts
     helper.runSecondMdrun();
 }
 
+TEST_F(MdrunTerminationTest, WritesCheckpointAtomSectionsAndThenRestarts)
+{
+    CommandLine       mdrunCaller;
+    mdrunCaller.append("mdrun");
+    mdrunCaller.append("-cpsplit");
+    TerminationHelper helper(&fileManager_, &mdrunCaller, &runner_);
+    std::string       sectionFileName = fileManager_.getTemporaryFilePath("rank0.cpt");
+    fileManager_.getTemporaryFilePath("prev_rank0.cpt");
+
+    organizeMdpFile(&runner_);
+    EXPECT_EQ(0, runner_.callGrompp());
+
+    helper.runFirstMdrun(sectionFileName);
+    helper.runSecondMdrun();
+}
+
 } // namespace
 } // namespace